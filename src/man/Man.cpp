@@ -36,6 +36,10 @@ using namespace boost::assign;
 using namespace std;
 using boost::shared_ptr;
 
+#ifdef USE_TIME_PROFILING
+// where the profiling statistics are dumped when Man stops
+static const char *PROFILE_DUMP_PATH = "/home/nao/naoqi/log/profile.tsv";
+#endif
 
 /////////////////////////////////////////
 //                                     //
@@ -89,6 +93,9 @@ Man::Man (shared_ptr<Sensors> _sensors,
   noggin = shared_ptr<Noggin>(new Noggin(profiler,vision,comm,guardian,
                                          sensors, motion->getInterface()));
 #endif// USE_NOGGIN
+#ifdef USE_PIPELINED_BRAIN
+  brain = shared_ptr<BrainThread>(new BrainThread(synchro, this));
+#endif
   PROF_ENTER(profiler.get(), P_GETIMAGE);
 }
 
@@ -124,6 +131,13 @@ void Man::startSubThreads() {
   else
     guardian->getTrigger()->await_on();
 
+#ifdef USE_PIPELINED_BRAIN
+  if (brain->start() != 0)
+    cerr << "Brain failed to start" << endl;
+  else
+    brain->getTrigger()->await_on();
+#endif
+
 
 #ifdef DEBUG_MAN_THREADING
   cout << "  run :: Signalling start" << endl;
@@ -132,6 +146,14 @@ void Man::startSubThreads() {
 
 void Man::stopSubThreads() {
 
+#ifdef USE_PIPELINED_BRAIN
+  brain->stop();
+  brain->getTrigger()->await_off();
+#ifdef DEBUG_MAN_THREADING
+  cout << "  Brain thread is stopped" << endl;
+#endif
+#endif
+
   guardian->stop();
   guardian->getTrigger()->await_off();
 #ifdef DEBUG_MAN_THREADING
@@ -158,6 +180,11 @@ void Man::stopSubThreads() {
 #ifdef DEBUG_MAN_THREADING
   cout << "  Comm thread is stopped" << endl;
 #endif
+
+#ifdef USE_TIME_PROFILING
+  // every profiling thread is stopped, so the dump has all their events
+  profiler->dumpStats(PROFILE_DUMP_PATH);
+#endif
 }
 
 void
@@ -170,6 +197,13 @@ Man::processFrame ()
 #endif
 
 
+  // frames come in on the image transcriber's thread
+  static bool registered = false;
+  if (!registered) {
+    profiler->registerThread("vision");
+    registered = true;
+  }
+
   PROF_ENTER(profiler.get(), P_FINAL);
   PROF_EXIT(profiler.get(), P_GETIMAGE);
 #ifdef USE_VISION
@@ -180,17 +214,27 @@ Man::processFrame ()
   //vision->notifyImage();
 #endif
 
-  // run Python behaviors
+  // run Python behaviors, either right here or on the brain thread
+#ifdef USE_PIPELINED_BRAIN
+  brain->frameReady();
+#else
+  processBrain();
+#endif
+
+  PROF_ENTER(profiler.get(), P_GETIMAGE);
+  PROF_EXIT(profiler.get(), P_FINAL);
+  PROF_NFRAME(profiler.get());
+}
+
+void
+Man::processBrain ()
+{
 #ifdef USE_NOGGIN
   noggin->runStep();
 #endif
   PROF_ENTER(profiler.get(), P_LIGHTS);
   lights->sendLights();
   PROF_EXIT(profiler.get(), P_LIGHTS);
-
-  PROF_ENTER(profiler.get(), P_GETIMAGE);
-  PROF_EXIT(profiler.get(), P_FINAL);
-  PROF_NFRAME(profiler.get());
 }
 
 
@@ -212,3 +256,60 @@ void Man::notifyNextVisionImage() {
   // Make sure messages are printed
   fflush(stdout);
 }
+
+
+#ifdef USE_PIPELINED_BRAIN
+
+BrainThread::BrainThread (shared_ptr<Synchro> _synchro, Man *_man)
+  : Thread(_synchro, "Brain"), man(_man), frame_pending(false)
+{
+  pthread_mutex_init(&frame_mutex, NULL);
+  pthread_cond_init(&frame_cond, NULL);
+}
+
+BrainThread::~BrainThread ()
+{
+  pthread_cond_destroy(&frame_cond);
+  pthread_mutex_destroy(&frame_mutex);
+}
+
+void BrainThread::run ()
+{
+  Thread::running = true;
+  Thread::trigger->on();
+
+  man->profiler->registerThread("brain");
+
+  while (Thread::running) {
+    pthread_mutex_lock(&frame_mutex);
+    while (!frame_pending && Thread::running)
+      pthread_cond_wait(&frame_cond, &frame_mutex);
+    frame_pending = false;
+    pthread_mutex_unlock(&frame_mutex);
+
+    if (!Thread::running)
+      break;
+
+    man->processBrain();
+  }
+
+  Thread::trigger->off();
+}
+
+void BrainThread::stop ()
+{
+  pthread_mutex_lock(&frame_mutex);
+  Thread::stop();
+  pthread_cond_signal(&frame_cond);
+  pthread_mutex_unlock(&frame_mutex);
+}
+
+void BrainThread::frameReady ()
+{
+  pthread_mutex_lock(&frame_mutex);
+  frame_pending = true;
+  pthread_cond_signal(&frame_cond);
+  pthread_mutex_unlock(&frame_mutex);
+}
+
+#endif // USE_PIPELINED_BRAIN
@@ -48,6 +48,37 @@
 #include "PySensors.h"
 #include "PyLights.h"
 
+#ifdef USE_PIPELINED_BRAIN
+class Man;
+
+/**
+ * Runs the behavior half of a frame (Noggin and the lights) on its own
+ * thread, so vision can start on the next image while Python is still
+ * busy with the last one.  Vision hands its results over through the
+ * TripleBuffer in Vision, and frameReady() wakes this thread up.  If
+ * vision finishes two frames before Noggin gets to run, Noggin just sees
+ * the newer one.
+ */
+class BrainThread : public Thread
+{
+public:
+    BrainThread(boost::shared_ptr<Synchro> _synchro, Man *_man);
+    virtual ~BrainThread();
+
+    void run();
+    void stop();
+
+    // Called by the vision thread after each frame is published
+    void frameReady();
+
+private:
+    Man *man;
+    pthread_mutex_t frame_mutex;
+    pthread_cond_t frame_cond;
+    bool frame_pending;
+};
+#endif
+
 /**
  * The Naoqi module to run our main Nao robot system.
  *
@@ -56,6 +87,10 @@
  */
 class Man : public ImageSubscriber
 {
+#ifdef USE_PIPELINED_BRAIN
+    friend class BrainThread;
+#endif
+
 public:
 
     // contructors
@@ -89,6 +124,8 @@ public:
 private:
     // run Vision and call Noggin's main loop function
     void processFrame(void);
+    // run Noggin and send the lights, on the brain thread if pipelined
+    void processBrain(void);
 
     void notifyNextVisionImage();
 
@@ -119,6 +156,9 @@ public:
     boost::shared_ptr<Noggin> noggin;
 #endif// USE_NOGGIN
     boost::shared_ptr<Lights> lights;
+#ifdef USE_PIPELINED_BRAIN
+    boost::shared_ptr<BrainThread> brain;
+#endif
 
 };
 
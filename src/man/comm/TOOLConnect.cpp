@@ -1,6 +1,7 @@
 #include "Common.h"
 
 #include <sys/utsname.h> // uname()
+#include <cstring>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/assign/std/vector.hpp>
@@ -180,10 +181,17 @@ TOOLConnect::handle_request (DataRequest &r) throw(socket_error&)
 		sensors->releaseImage();
     }
 
-    if (r.thresh)
-        // send thresholded image
-        serial.write_bytes(&vision->thresh->thresholded[0][0],
-                           IMAGE_WIDTH * IMAGE_HEIGHT);
+    if (r.thresh) {
+        // send thresholded image, in the row major order the TOOL expects.
+        // Vision is running on another thread, so don't read thresh
+        // directly or we can get half of one frame and half of the next.
+        // If vision never gave us a whole frame, send the last one again.
+        static byte copying[IMAGE_WIDTH * IMAGE_HEIGHT];
+        static byte thresholded[IMAGE_WIDTH * IMAGE_HEIGHT];
+        if (vision->copyThresholdedImage(copying))
+            memcpy(thresholded, copying, IMAGE_WIDTH * IMAGE_HEIGHT);
+        serial.write_bytes(thresholded, IMAGE_WIDTH * IMAGE_HEIGHT);
+    }
 
 	if (r.objects) {
 		if (loc.get()) {
@@ -232,8 +240,8 @@ TOOLConnect::handle_request (DataRequest &r) throw(socket_error&)
 
 	if (r.mmekf){
 #ifdef USE_MM_LOC_EKF
-		const list<LocEKF*> models = loc->getModels();
-		list<LocEKF*>::const_iterator model;
+		const list<const LocEKF*> models = loc->getModels();
+		list<const LocEKF*>::const_iterator model;
 		vector<float> mm_values;
 
 		for(model = models.begin(); model != models.end() ; ++model){
@@ -75,7 +75,7 @@ void ALEnactor::sendCommands(){
 
 void ALEnactor::sendJoints(){
     // Get the angles we want to go to this frame from the switchboard
-    motionCommandAngles = switchboard->getNextJoints();
+    switchboard->getNextJoints(&motionCommandAngles[0]);
 
 #ifdef DEBUG_ENACTOR_JOINTS
     for (unsigned int i=0; i<motionCommandAngles.size();i++)
@@ -91,7 +91,7 @@ void ALEnactor::sendJoints(){
 
 void ALEnactor::sendHardness(){
     //Get the hardness we need to send on to lower level
-    motionCommandStiffness = switchboard->getNextStiffness();
+    switchboard->getNextStiffness(&motionCommandStiffness[0]);
 
     //NOTE: in AL Enactor, we set each joint stiffness individually - this is
     //      probably quite slow
@@ -45,7 +45,10 @@ public:
               AL::ALPtr<AL::ALBroker> _pbroker )
         : ThreadedMotionEnactor(synchro,"ALEnactor"),
           broker(_pbroker), sensors(s),
-          transcriber(t), almotion_link(false){
+          transcriber(t),
+          motionCommandAngles(Kinematics::NUM_JOINTS, 0.0f),
+          motionCommandStiffness(Kinematics::NUM_JOINTS, 0.0f),
+          almotion_link(false){
 
         try {
             almotion = broker->getMotionProxy();
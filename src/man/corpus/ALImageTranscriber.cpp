@@ -83,7 +83,7 @@ ALImageTranscriber::ALImageTranscriber(shared_ptr<Synchro> synchro,
                                        ALPtr<ALBroker> broker)
     : ThreadedImageTranscriber(s,synchro,"ALImageTranscriber"),
       log(), camera(), lem_name(""), camera_active(false),
-      image(new unsigned char[IMAGE_BYTE_SIZE])
+      frames(IMAGE_BYTE_SIZE), image(NULL)
 {
     try {
         log = broker->getLoggerProxy();
@@ -110,7 +110,6 @@ ALImageTranscriber::ALImageTranscriber(shared_ptr<Synchro> synchro,
 }
 
 ALImageTranscriber::~ALImageTranscriber() {
-    delete [] image;
     stop();
 }
 
@@ -119,10 +118,27 @@ int ALImageTranscriber::start() {
     return Thread::start();
 }
 
+/**
+ * Vision's side of the transcriber.  With the camera running, frames come
+ * from the capture thread (see capture()), so getting the next image off
+ * the camera overlaps with processing this one; vision just takes the
+ * newest frame from the ring and gives it back in releaseImage().  Without
+ * a camera we keep calling vision at the frame rate on whatever image it
+ * has.
+ */
 void ALImageTranscriber::run() {
     Thread::running = true;
     Thread::trigger->on();
 
+    bool capturing = false;
+    if (camera_active) {
+        capturing = pthread_create(&captureThread, NULL, runCapture,
+                                   static_cast<void*>(this)) == 0;
+        if (!capturing)
+            std::cout << "Failed to start the camera capture thread"
+                      << std::endl;
+    }
+
     long long lastProcessTimeAvg = VISION_FRAME_LENGTH_uS;
 
     struct timespec interval, remainder;
@@ -130,8 +146,21 @@ void ALImageTranscriber::run() {
         //start timer
         const long long startTime = micro_time();
 
-        if (camera_active)
-            waitForImage();
+        if (capturing) {
+            image = frames.acquireForRead(VISION_FRAME_LENGTH_PRINT_THRESH_uS);
+            if (image == NULL) {
+#ifdef DEBUG_ALIMAGE_LOOP
+                std::cout << "No frame from the camera in "
+                          << VISION_FRAME_LENGTH_PRINT_THRESH_uS << "us"
+                          << std::endl;
+#endif
+                continue;
+            }
+            // Update Sensors image pointer
+            sensors->lockImage();
+            sensors->setImage(image);
+            sensors->releaseImage();
+        }
         subscriber->notifyNextVisionImage();
 
         //stop timer
@@ -148,7 +177,8 @@ void ALImageTranscriber::run() {
 #endif
             }
             //Don't sleep at all
-        } else{
+        } else if (!capturing) {
+            // (with the camera running, the ring paces us instead)
             const long int microSleepTime = (VISION_FRAME_LENGTH_uS -
                                              processTime);
             const long int nanoSleepTime =
@@ -165,12 +195,50 @@ void ALImageTranscriber::run() {
             nanosleep(&interval, &remainder);
         }
     }
+    if (capturing)
+        pthread_join(captureThread, NULL);
     Thread::trigger->off();
 }
 
+void* ALImageTranscriber::runCapture(void *_this)
+{
+    reinterpret_cast<ALImageTranscriber*>(_this)->capture();
+    pthread_exit(NULL);
+}
+
+/**
+ * The capture thread.  Copies each camera frame into a free buffer from the
+ * ring and gives NaoQi its buffer back right away, instead of holding on to
+ * it until vision and the brain are done.  Sleeps out the rest of the frame
+ * so we don't ask for images faster than the camera makes them.
+ */
+void ALImageTranscriber::capture()
+{
+    struct timespec interval, remainder;
+    while (Thread::running) {
+        const long long startTime = micro_time();
+
+        unsigned char *buffer = frames.acquireForWrite();
+        if (waitForImage(buffer))
+            frames.publish(buffer, startTime);
+        else
+            frames.release(buffer);
+
+        const long long captureTime = micro_time() - startTime;
+        if (captureTime < VISION_FRAME_LENGTH_uS) {
+            const long int microSleepTime = (VISION_FRAME_LENGTH_uS -
+                                             captureTime);
+            interval.tv_sec = microSleepTime / (1000*1000);
+            interval.tv_nsec = (microSleepTime %(1000 * 1000)) * 1000;
+            nanosleep(&interval, &remainder);
+        }
+    }
+}
+
 void ALImageTranscriber::stop() {
     std::cout << "Stopping ALImageTranscriber" << std::endl;
     running = false;
+    frames.wake();
 #ifdef USE_VISION
     if(camera_active){
         std::cout << "lem_name = " << lem_name << std::endl;
@@ -465,8 +533,13 @@ void ALImageTranscriber::initCameraSettings(int whichCam){
 }
 
 
-void ALImageTranscriber::waitForImage ()
+/**
+ * Copies the next camera frame into buffer.
+ * @return     whether we got a frame
+ */
+bool ALImageTranscriber::waitForImage (unsigned char *buffer)
 {
+    bool gotImage = false;
     try {
 #ifndef MAN_IS_REMOTE
 #ifdef DEBUG_IMAGE_REQUESTS
@@ -483,7 +556,18 @@ void ALImageTranscriber::waitForImage ()
                        "NaoCam module");
         }
         if (ALimage != NULL) {
-            memcpy(&image[0], ALimage->getFrame(), IMAGE_BYTE_SIZE);
+            memcpy(&buffer[0], ALimage->getFrame(), IMAGE_BYTE_SIZE);
+            gotImage = true;
+
+            //Now you have finished with the image, you have to release it in
+            //the V.I.M.
+            try {
+                camera->call<int>( "releaseDirectRawImage", lem_name );
+            }catch( ALError& e) {
+                log->error( "ALImageTranscriber",
+                            "could not call the releaseImage method of the "
+                            "NaoCam module" );
+            }
         }
         else
             std::cout << "\tALImage from camera was null!!" << std::endl;
@@ -519,7 +603,8 @@ void ALImageTranscriber::waitForImage ()
         }
 
         //image = static_cast<const unsigned char*>(ALimage[6].GetBinary());
-        memcpy(&image[0], ALimage[6].GetBinary(), IMAGE_BYTE_SIZE);
+        memcpy(&buffer[0], ALimage[6].GetBinary(), IMAGE_BYTE_SIZE);
+        gotImage = true;
 #ifdef DEBUG_IMAGE_REQUESTS
         //You can get some informations of the image.
         int width = (int) ALimage[0];
@@ -536,32 +621,21 @@ void ALImageTranscriber::waitForImage ()
 
 #endif//IS_REMOTE
 
-        if (image != NULL) {
-            // Update Sensors image pointer
-            sensors->lockImage();
-            sensors->setImage(image);
-            sensors->releaseImage();
-        }
-
     }catch (ALError &e) {
         log->error("NaoMain", "Caught an error in run():\n" + e.toString());
     }
+    return gotImage;
 }
 
 
+/**
+ * Vision is done with its frame.  The camera's own buffer was already given
+ * back in waitForImage(), this hands ours back to the capture thread.
+ */
 void ALImageTranscriber::releaseImage(){
-#ifndef MAN_IS_REMOTE
-    if (!camera_active)
+    if (image == NULL)
         return;
 
-    //Now you have finished with the image, you have to release it in the V.I.M.
-    try
-        {
-            camera->call<int>( "releaseDirectRawImage", lem_name );
-        }catch( ALError& e)
-        {
-            log->error( "ALImageTranscriber",
-                        "could not call the releaseImage method of the NaoCam module" );
-        }
-#endif
+    frames.release(image);
+    image = NULL;
 }
@@ -7,6 +7,7 @@
 #include "alloggerproxy.h"
 
 #include "ThreadedImageTranscriber.h"
+#include "FrameRing.h"
 #include "synchro.h"
 
 class ALImageTranscriber : public ThreadedImageTranscriber {
@@ -30,7 +31,9 @@ public:
 private: // helper methods
     void registerCamera(AL::ALPtr<AL::ALBroker> broker);
     void initCameraSettings(int whichCam);
-    void waitForImage();
+    bool waitForImage(unsigned char *buffer);
+    void capture();
+    static void* runCapture(void *_this);
 
 private: // member variables
     // Interfaces/Proxies to robot
@@ -42,9 +45,12 @@ private: // member variables
 
     bool camera_active;
 
-    // Keep a local copy of the image because accessing the one from NaoQi is
-    // from the kernel and thus very slow.
-    unsigned char *image;
+    // Keep local copies of the images because accessing the ones from NaoQi
+    // is from the kernel and thus very slow.  The capture thread copies the
+    // camera's frames in and hands them to vision through the ring.
+    FrameRing frames;
+    unsigned char *image;   // the frame vision has, NULL between frames
+    pthread_t captureThread;
 
 private: // nBites Camera Constants
     // Camera identification
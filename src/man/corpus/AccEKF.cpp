@@ -2,7 +2,6 @@
 
 #include "AccEKF.h"
 #include "BasicWorldConstants.h"
-using namespace boost::numeric;
 
 const int AccEKF::num_dimensions = ACC_NUM_DIMENSIONS;
 const float AccEKF::beta = 0.2f;
@@ -46,15 +45,13 @@ void AccEKF::update(const float accX,
     timeUpdate(0); // update model? we don't have one. it's an int. don't care.
 
     AccelMeasurement m = { accX, accY, accZ };
-    // we create a vector of size 1 and default value m
-    std::vector<AccelMeasurement> z(1,m);
-    correctionStep(z);
+    singleCorrectionStep(m);
 }
 
 EKF<AccelMeasurement, int, 3, 3>::StateVector
 AccEKF::associateTimeUpdate(int u_k)
 {
-    return ublas::zero_vector<float>(num_dimensions);
+    return StateVector(num_dimensions, 0.0f);
 }
 
 const float AccEKF::scale(const float x) {
@@ -101,13 +98,12 @@ const float AccEKF::getVariance(float delta, float divergence) {
     return dont_trust;
 }
 
-void AccEKF::incorporateMeasurement(AccelMeasurement z,
+void AccEKF::incorporateMeasurement(const AccelMeasurement& z,
                                     StateMeasurementMatrix &H_k,
                                     MeasurementMatrix &R_k,
                                     MeasurementVector &V_k)
 {
-    static MeasurementVector last_measurement(
-        ublas::scalar_vector<float>(num_dimensions, 0.0f));
+    static MeasurementVector last_measurement(num_dimensions, 0.0f);
 
     MeasurementVector z_x(num_dimensions);
     z_x(0) = z.x;
@@ -50,7 +50,7 @@ public:
 private:
     // Core functions
     virtual StateVector associateTimeUpdate(int u_k);
-    virtual void incorporateMeasurement(AccelMeasurement z,
+    virtual void incorporateMeasurement(const AccelMeasurement& z,
                                         StateMeasurementMatrix &H_k,
                                         MeasurementMatrix &R_k,
                                         MeasurementVector &V_k);
@@ -2,7 +2,6 @@
 
 #include "AngleEKF.h"
 #include "BasicWorldConstants.h"
-using namespace boost::numeric;
 
 const int AngleEKF::num_dimensions = ANGLE_NUM_DIMENSIONS;
 const float AngleEKF::beta = 3.0f;
@@ -45,15 +44,13 @@ void AngleEKF::update(const float angleX,
     timeUpdate(0); // update model? we don't have one. it's an int. don't care.
 
     AngleMeasurement m = { angleX, angleY };
-    // we create a vector of size 1 and default value m
-    std::vector<AngleMeasurement> z(1,m);
-    correctionStep(z);
+    singleCorrectionStep(m);
 }
 
 EKF<AngleMeasurement, int, 2, 2>::StateVector
 AngleEKF::associateTimeUpdate(int u_k)
 {
-    return ublas::zero_vector<float>(num_dimensions);
+    return StateVector(num_dimensions, 0.0f);
 }
 
 const float AngleEKF::scale(const float x) {
@@ -100,13 +97,12 @@ const float AngleEKF::getVariance(float delta, float divergence) {
     return dont_trust;
 }
 
-void AngleEKF::incorporateMeasurement(AngleMeasurement z,
+void AngleEKF::incorporateMeasurement(const AngleMeasurement& z,
                                     StateMeasurementMatrix &H_k,
                                     MeasurementMatrix &R_k,
                                     MeasurementVector &V_k)
 {
-    static MeasurementVector last_measurement(
-        ublas::scalar_vector<float>(num_dimensions, 0.0f));
+    static MeasurementVector last_measurement(num_dimensions, 0.0f);
 
     MeasurementVector z_x(num_dimensions);
     z_x(0) = z.angleX;
@@ -48,7 +48,7 @@ public:
 private:
     // Core functions
     virtual StateVector associateTimeUpdate(int u_k);
-    virtual void incorporateMeasurement(AngleMeasurement z,
+    virtual void incorporateMeasurement(const AngleMeasurement& z,
                                         StateMeasurementMatrix &H_k,
                                         MeasurementMatrix &R_k,
                                         MeasurementVector &V_k);
@@ -0,0 +1,198 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <dirent.h>
+
+#include "FakeImageTranscriber.h"
+#include "VisionDef.h"
+
+using boost::shared_ptr;
+using namespace std;
+
+static const string FRAME_EXTENSION(".NBFRM");
+
+// Sort frames by their number, 2.NBFRM before 10.NBFRM
+static bool frameBefore(const string& a, const string& b)
+{
+    const string::size_type slashA = a.rfind('/'), slashB = b.rfind('/');
+    const int numA = atoi(a.c_str() + slashA + 1);
+    const int numB = atoi(b.c_str() + slashB + 1);
+    if (numA != numB)
+        return numA < numB;
+    return a < b;
+}
+
+FakeImageTranscriber::FakeImageTranscriber(shared_ptr<Synchro> synchro,
+                                           shared_ptr<Sensors> s,
+                                           const string& frameDirectory,
+                                           bool _loop)
+    : ThreadedImageTranscriber(s, synchro, "FakeImageTranscriber"),
+      framePaths(), nextFrame(0), loop(_loop), frames(FRAME_BYTES),
+      image(NULL)
+{
+    findFrames(frameDirectory);
+    cout << "FakeImageTranscriber: playing " << framePaths.size()
+         << " frames from " << frameDirectory << endl;
+}
+
+FakeImageTranscriber::~FakeImageTranscriber()
+{
+    stop();
+}
+
+void FakeImageTranscriber::findFrames(const string& frameDirectory)
+{
+    DIR *dir = opendir(frameDirectory.c_str());
+    if (dir == NULL) {
+        cout << "FakeImageTranscriber: couldn't open " << frameDirectory
+             << endl;
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const string name(entry->d_name);
+        if (name.size() > FRAME_EXTENSION.size() &&
+            name.compare(name.size() - FRAME_EXTENSION.size(),
+                         FRAME_EXTENSION.size(), FRAME_EXTENSION) == 0) {
+            framePaths.push_back(frameDirectory + "/" + name);
+        }
+    }
+    closedir(dir);
+
+    sort(framePaths.begin(), framePaths.end(), frameBefore);
+}
+
+/**
+ * Reads one .NBFRM: the raw image, then as text the format version, the
+ * joint angles and the sensors (which we don't need).
+ */
+bool FakeImageTranscriber::readFrame(const string& path,
+                                     unsigned char *buffer)
+{
+    ifstream in(path.c_str(), ios::in | ios::binary);
+    if (!in.read(reinterpret_cast<char*>(buffer), IMAGE_BYTE_SIZE)) {
+        cout << "FakeImageTranscriber: " << path << " is too short" << endl;
+        return false;
+    }
+
+    float *joints = reinterpret_cast<float*>(buffer + IMAGE_BYTE_SIZE);
+    int version;
+    in >> version;
+    for (int i = 0; i < Kinematics::NUM_JOINTS; i++) {
+        if (!(in >> joints[i]))
+            joints[i] = 0.0f;
+    }
+    return true;
+}
+
+int FakeImageTranscriber::start()
+{
+    return Thread::start();
+}
+
+void FakeImageTranscriber::run()
+{
+    Thread::running = true;
+    Thread::trigger->on();
+
+    const bool capturing = !framePaths.empty() &&
+        pthread_create(&captureThread, NULL, runCapture,
+                       static_cast<void*>(this)) == 0;
+
+    vector<float> bodyAngles(Kinematics::NUM_JOINTS);
+    while (Thread::running && capturing) {
+        image = frames.acquireForRead(VISION_FRAME_LENGTH_PRINT_THRESH_uS);
+        if (image == NULL)
+            continue;
+
+        const float *joints =
+            reinterpret_cast<const float*>(image + IMAGE_BYTE_SIZE);
+        bodyAngles.assign(joints, joints + Kinematics::NUM_JOINTS);
+        sensors->setVisionBodyAngles(bodyAngles);
+
+        sensors->lockImage();
+        sensors->setImage(image);
+        sensors->releaseImage();
+
+        subscriber->notifyNextVisionImage();
+    }
+
+    if (capturing)
+        pthread_join(captureThread, NULL);
+    Thread::trigger->off();
+}
+
+void* FakeImageTranscriber::runCapture(void *_this)
+{
+    reinterpret_cast<FakeImageTranscriber*>(_this)->capture();
+    pthread_exit(NULL);
+}
+
+/**
+ * Stands in for the camera: one frame from disk every frame length.
+ */
+void FakeImageTranscriber::capture()
+{
+    struct timespec interval, remainder;
+    while (Thread::running) {
+        const long long startTime = micro_time();
+
+        if (nextFrame >= framePaths.size()) {
+            if (!loop)
+                break;
+            nextFrame = 0;
+        }
+
+        unsigned char *buffer = frames.acquireForWrite();
+        if (readFrame(framePaths[nextFrame++], buffer))
+            frames.publish(buffer, startTime);
+        else
+            frames.release(buffer);
+
+        const long long readTime = micro_time() - startTime;
+        if (readTime < VISION_FRAME_LENGTH_uS) {
+            const long int microSleepTime = VISION_FRAME_LENGTH_uS - readTime;
+            interval.tv_sec = microSleepTime / (1000*1000);
+            interval.tv_nsec = (microSleepTime %(1000 * 1000)) * 1000;
+            nanosleep(&interval, &remainder);
+        }
+    }
+}
+
+void FakeImageTranscriber::stop()
+{
+    running = false;
+    frames.wake();
+    Thread::stop();
+}
+
+void FakeImageTranscriber::releaseImage()
+{
+    if (image == NULL)
+        return;
+
+    frames.release(image);
+    image = NULL;
+}
@@ -0,0 +1,80 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * A camera that plays back frames saved with Sensors::saveFrame() (.NBFRM
+ * files), so man's whole vision pipeline can run on a machine without one.
+ * The frames are read on their own thread at the camera's frame rate and
+ * handed to vision through a FrameRing, the same way ALImageTranscriber
+ * does it.  The joint angles saved with each frame are set as the body
+ * angles before vision runs, so the pose matches the image.
+ */
+
+#ifndef FakeImageTranscriber_h_DEFINED
+#define FakeImageTranscriber_h_DEFINED
+
+#include <string>
+#include <vector>
+
+#include "ThreadedImageTranscriber.h"
+#include "FrameRing.h"
+#include "Kinematics.h"
+#include "synchro.h"
+
+class FakeImageTranscriber : public ThreadedImageTranscriber {
+public:
+    FakeImageTranscriber(boost::shared_ptr<Synchro> synchro,
+                         boost::shared_ptr<Sensors> s,
+                         const std::string& frameDirectory,
+                         bool loop = true);
+    virtual ~FakeImageTranscriber();
+
+private:
+    FakeImageTranscriber(const FakeImageTranscriber &other);
+    void operator= (const FakeImageTranscriber &other);
+
+public:
+    int start();
+    void run();
+    void stop();
+    void releaseImage();
+
+    int numFrames() const { return framePaths.size(); }
+
+private:
+    void findFrames(const std::string& frameDirectory);
+    bool readFrame(const std::string& path, unsigned char *buffer);
+    void capture();
+    static void* runCapture(void *_this);
+
+private:
+    std::vector<std::string> framePaths;
+    unsigned int nextFrame;
+    bool loop;
+
+    // Each buffer holds the image followed by the frame's joint angles
+    static const int FRAME_BYTES = IMAGE_BYTE_SIZE +
+        Kinematics::NUM_JOINTS * sizeof(float);
+
+    FrameRing frames;
+    unsigned char *image;
+    pthread_t captureThread;
+};
+
+#endif /* FakeImageTranscriber_h_DEFINED */
@@ -0,0 +1,189 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "FrameRing.h"
+
+FrameRing::FrameRing(int _frameBytes, int _numFrames)
+    : frameBytes(_frameBytes),
+      numFrames(_numFrames < DEFAULT_FRAMES ? DEFAULT_FRAMES : _numFrames),
+      slots(new Slot[numFrames]), sequence(0), droppedFrames(0), woken(false)
+{
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < numFrames; i++) {
+        void *data = NULL;
+        if (posix_memalign(&data, pageSize, frameBytes) != 0) {
+            std::cerr << "FrameRing: couldn't allocate frame buffers"
+                      << std::endl;
+            exit(1);
+        }
+        memset(data, 0, frameBytes);
+        slots[i].data = static_cast<unsigned char*>(data);
+        slots[i].state = FREE;
+        slots[i].sequence = 0;
+        slots[i].timestamp = 0;
+    }
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&ready, NULL);
+}
+
+FrameRing::~FrameRing()
+{
+    for (int i = 0; i < numFrames; i++) {
+        free(slots[i].data);
+    }
+    delete [] slots;
+    pthread_cond_destroy(&ready);
+    pthread_mutex_destroy(&mutex);
+}
+
+/* Hands the capture side a buffer to fill.  Takes the free buffer released
+ * longest ago, or if there isn't one, the oldest frame vision never got to.
+ * There are at least three buffers and each side only holds one at a time,
+ * so one of the two always exists.
+ */
+unsigned char* FrameRing::acquireForWrite()
+{
+    pthread_mutex_lock(&mutex);
+
+    int oldestFree = -1, oldestReady = -1;
+    for (int i = 0; i < numFrames; i++) {
+        if (slots[i].state == FREE &&
+            (oldestFree < 0 || slots[i].sequence < slots[oldestFree].sequence)) {
+            oldestFree = i;
+        } else if (slots[i].state == READY &&
+                   (oldestReady < 0 ||
+                    slots[i].sequence < slots[oldestReady].sequence)) {
+            oldestReady = i;
+        }
+    }
+
+    int which = oldestFree;
+    if (which < 0) {
+        which = oldestReady;
+        droppedFrames++;
+    }
+    slots[which].state = WRITING;
+    unsigned char *frame = slots[which].data;
+
+    pthread_mutex_unlock(&mutex);
+    return frame;
+}
+
+void FrameRing::publish(unsigned char *frame, long long timestamp)
+{
+    pthread_mutex_lock(&mutex);
+    const int which = find(frame);
+    if (which >= 0) {
+        slots[which].state = READY;
+        slots[which].sequence = ++sequence;
+        slots[which].timestamp = timestamp;
+        pthread_cond_signal(&ready);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+/* Takes the newest finished frame.  Any older ones are stale by now and go
+ * straight back to the capture side.
+ */
+unsigned char* FrameRing::acquireForRead(long long timeout)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    const long long until = now.tv_sec * 1000000LL + now.tv_usec + timeout;
+    struct timespec deadline;
+    deadline.tv_sec = until / 1000000LL;
+    deadline.tv_nsec = (until % 1000000LL) * 1000;
+
+    pthread_mutex_lock(&mutex);
+
+    int newest = -1;
+    while (!woken) {
+        for (int i = 0; i < numFrames; i++) {
+            if (slots[i].state == READY &&
+                (newest < 0 || slots[i].sequence > slots[newest].sequence)) {
+                newest = i;
+            }
+        }
+        if (newest >= 0 ||
+            pthread_cond_timedwait(&ready, &mutex, &deadline) != 0) {
+            break;
+        }
+    }
+
+    unsigned char *frame = NULL;
+    if (newest >= 0) {
+        for (int i = 0; i < numFrames; i++) {
+            if (i != newest && slots[i].state == READY) {
+                slots[i].state = FREE;
+                droppedFrames++;
+            }
+        }
+        slots[newest].state = READING;
+        frame = slots[newest].data;
+    }
+    woken = false;
+
+    pthread_mutex_unlock(&mutex);
+    return frame;
+}
+
+long long FrameRing::getTimestamp(const unsigned char *frame) const
+{
+    pthread_mutex_lock(&mutex);
+    const int which = find(frame);
+    const long long timestamp = which >= 0 ? slots[which].timestamp : 0;
+    pthread_mutex_unlock(&mutex);
+    return timestamp;
+}
+
+void FrameRing::release(const unsigned char *frame)
+{
+    pthread_mutex_lock(&mutex);
+    const int which = find(frame);
+    if (which >= 0) {
+        slots[which].state = FREE;
+        slots[which].sequence = ++sequence;
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+void FrameRing::wake()
+{
+    pthread_mutex_lock(&mutex);
+    woken = true;
+    pthread_cond_broadcast(&ready);
+    pthread_mutex_unlock(&mutex);
+}
+
+int FrameRing::find(const unsigned char *frame) const
+{
+    for (int i = 0; i < numFrames; i++) {
+        if (slots[i].data == frame) {
+            return i;
+        }
+    }
+    return -1;
+}
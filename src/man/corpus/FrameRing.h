@@ -0,0 +1,103 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * A small pool of camera frame buffers handed back and forth between the
+ * thread that grabs frames from the camera and the thread that runs vision.
+ *
+ * Every buffer is page aligned and allocated once, up front.  At any time a
+ * buffer belongs to exactly one side:
+ *
+ *   FREE     nobody, the capture side can take it
+ *   WRITING  the capture side, between acquireForWrite() and publish()
+ *   READY    holds a finished frame, waiting for vision
+ *   READING  vision, between acquireForRead() and release()
+ *
+ * The capture side never waits on vision: if every buffer is taken it reuses
+ * the oldest frame vision hasn't picked up yet.  Vision always gets the
+ * newest finished frame, so while it works on frame N the camera can be
+ * filling in N+1.  Freed buffers are reused least recently released first,
+ * so the frame vision just let go of stays intact for a while longer for
+ * anyone (the TOOL connection, frame saving) still looking at it.
+ */
+
+#ifndef FrameRing_h_DEFINED
+#define FrameRing_h_DEFINED
+
+#include <pthread.h>
+
+class FrameRing
+{
+public:
+    // One being written, one being read, one ready to go
+    static const int DEFAULT_FRAMES = 3;
+
+    FrameRing(int frameBytes, int numFrames = DEFAULT_FRAMES);
+    ~FrameRing();
+
+    // Capture side
+    unsigned char* acquireForWrite();
+    void publish(unsigned char *frame, long long timestamp);
+
+    // Vision side.  Waits up to timeout microseconds for a frame and
+    // returns NULL if none came (or wake() was called).
+    unsigned char* acquireForRead(long long timeout);
+    long long getTimestamp(const unsigned char *frame) const;
+
+    // Either side: give a buffer back without publishing it
+    void release(const unsigned char *frame);
+
+    // Unblocks a waiting reader, for shutting down
+    void wake();
+
+    int getFrameBytes() const { return frameBytes; }
+    int getDroppedFrames() const { return droppedFrames; }
+
+private:
+    FrameRing(const FrameRing &other);
+    void operator= (const FrameRing &other);
+
+    enum State {
+        FREE,
+        WRITING,
+        READY,
+        READING
+    };
+
+    struct Slot {
+        unsigned char *data;
+        State state;
+        unsigned int sequence;   // publish order for READY, release for FREE
+        long long timestamp;
+    };
+
+    int find(const unsigned char *frame) const;
+
+    const int frameBytes;
+    const int numFrames;
+    Slot *slots;
+    unsigned int sequence;
+    int droppedFrames;
+    bool woken;
+
+    mutable pthread_mutex_t mutex;
+    pthread_cond_t ready;
+};
+
+#endif /* FrameRing_h_DEFINED */
@@ -177,40 +177,65 @@ const ufvector3 Kinematics::forwardKinematics(const ChainID id,
         sincosf(AP,&sinAP,&cosAP);
         sincosf(AR,&sinAR,&cosAR);
 
-        //Other odd angles:
-        const float cosHRPlusPiFourth = std::cos(HR+M_PI_FLOAT*0.25f);
-        const float cosHRMinusPiFourth = std::cos(HR-M_PI_FLOAT*0.25f);
-        const float sinHRPlusPiFourth = std::sin(HR+M_PI_FLOAT*0.25f);
-        const float sinHRMinusPiFourth = std::sin(HR-M_PI_FLOAT*0.25f);
-        const float sqrt2 = std::sqrt(2.0f);
-
-        switch(id){
-        case LLEG_CHAIN:
-            x = -THIGH_LENGTH*(cosHYP*sinHP+cosHP*cosHRPlusPiFourth*sinHYP)-TIBIA_LENGTH*(cosKP*(cosHYP*sinHP+cosHP*cosHRPlusPiFourth*sinHYP)+(cosHP*cosHYP-cosHRPlusPiFourth*sinHP*sinHYP)*sinKP)-FOOT_HEIGHT*(cosAR*(sinAP*(cosKP*(cosHP*cosHYP-cosHRPlusPiFourth*sinHP*sinHYP)-(cosHYP*sinHP+cosHP*cosHRPlusPiFourth*sinHYP)*sinKP)+cosAP*(cosKP*(cosHYP*sinHP+cosHP*cosHRPlusPiFourth*sinHYP)+(cosHP*cosHYP-cosHRPlusPiFourth*sinHP*sinHYP)*sinKP))-sinAR*sinHYP*sinHRPlusPiFourth);
-            y = HIP_OFFSET_Y-THIGH_LENGTH*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2)))-FOOT_HEIGHT*(-sinAR*(cosHRPlusPiFourth/sqrt2+(cosHYP*sinHRPlusPiFourth)/sqrt2)+cosAR*(sinAP*(-sinKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2))+cosKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2)))+cosAP*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2)))));
-            z = -HIP_OFFSET_Z-THIGH_LENGTH*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2)))-FOOT_HEIGHT*(-sinAR*(-cosHRPlusPiFourth/sqrt2+(cosHYP*sinHRPlusPiFourth)/sqrt2)+cosAR*(sinAP*(-sinKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2))+cosKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2)))+cosAP*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2)))));
-            break;
-        case LANKLE_CHAIN:
-            x = -THIGH_LENGTH*(cosHYP*sinHP+cosHP*cosHRPlusPiFourth*sinHYP)-TIBIA_LENGTH*(cosKP*(cosHYP*sinHP+cosHP*cosHRPlusPiFourth*sinHYP)+(cosHP*cosHYP-cosHRPlusPiFourth*sinHP*sinHYP)*sinKP);
-            y = HIP_OFFSET_Y-THIGH_LENGTH*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2-sinHRPlusPiFourth/sqrt2)));
-            z = -HIP_OFFSET_Z-THIGH_LENGTH*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRPlusPiFourth)/sqrt2+sinHRPlusPiFourth/sqrt2)));
-            break;
-        case RLEG_CHAIN:
-            x = -THIGH_LENGTH*(cosHYP*sinHP+cosHP*cosHRMinusPiFourth*sinHYP)-TIBIA_LENGTH*(cosKP*(cosHYP*sinHP+cosHP*cosHRMinusPiFourth*sinHYP)+(cosHP*cosHYP-cosHRMinusPiFourth*sinHP*sinHYP)*sinKP)-FOOT_HEIGHT*(cosAR*(sinAP*(cosKP*(cosHP*cosHYP-cosHRMinusPiFourth*sinHP*sinHYP)-(cosHYP*sinHP+cosHP*cosHRMinusPiFourth*sinHYP)*sinKP)+cosAP*(cosKP*(cosHYP*sinHP+cosHP*cosHRMinusPiFourth*sinHYP)+(cosHP*cosHYP-cosHRMinusPiFourth*sinHP*sinHYP)*sinKP))-sinAR*sinHYP*sinHRMinusPiFourth);
-            y = -HIP_OFFSET_Y-THIGH_LENGTH*((sinHP*sinHYP)/sqrt2+cosHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*((sinHP*sinHYP)/sqrt2+cosHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+sinKP*((cosHP*sinHYP)/sqrt2-sinHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)))-FOOT_HEIGHT*(-sinAR*(cosHRMinusPiFourth/sqrt2-(cosHYP*sinHRMinusPiFourth)/sqrt2)+cosAR*(sinAP*(-sinKP*((sinHP*sinHYP)/sqrt2+cosHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+cosKP*((cosHP*sinHYP)/sqrt2-sinHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)))+cosAP*(cosKP*((sinHP*sinHYP)/sqrt2+cosHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+sinKP*((cosHP*sinHYP)/sqrt2-sinHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)))));
-            z = -HIP_OFFSET_Z-THIGH_LENGTH*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)))-FOOT_HEIGHT*(-sinAR*(cosHRMinusPiFourth/sqrt2+(cosHYP*sinHRMinusPiFourth)/sqrt2)+cosAR*(sinAP*(-sinKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+cosKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)))+cosAP*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)))));
-            break;
-        case RANKLE_CHAIN:
-            x = -THIGH_LENGTH*(cosHYP*sinHP+cosHP*cosHRMinusPiFourth*sinHYP)-TIBIA_LENGTH*(cosKP*(cosHYP*sinHP+cosHP*cosHRMinusPiFourth*sinHYP)+(cosHP*cosHYP-cosHRMinusPiFourth*sinHP*sinHYP)*sinKP);
-            y = -HIP_OFFSET_Y-THIGH_LENGTH*((sinHP*sinHYP)/sqrt2+cosHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*((sinHP*sinHYP)/sqrt2+cosHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+sinKP*((cosHP*sinHYP)/sqrt2-sinHP*(-(cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)));
-            z = -HIP_OFFSET_Z-THIGH_LENGTH*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))-TIBIA_LENGTH*(cosKP*(-(sinHP*sinHYP)/sqrt2+cosHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2))+sinKP*(-(cosHP*sinHYP)/sqrt2-sinHP*((cosHYP*cosHRMinusPiFourth)/sqrt2-sinHRMinusPiFourth/sqrt2)));
-            break;
-        case LARM_CHAIN:
-        case RARM_CHAIN:
-        case HEAD_CHAIN:
-            throw "Should not be possible";
+        //The hip yaw pitch axis is at Pi/4 to the body, so the hip roll
+        //only shows up as HR + Pi/4 for the left leg and HR - Pi/4 for the
+        //right
+        const float SQRT2 = std::sqrt(2.0f);
+        const bool left = (id == LLEG_CHAIN || id == LANKLE_CHAIN);
+        const float cosHRPiFourth =
+            (left ? cosHR - sinHR : cosHR + sinHR)/SQRT2;
+        const float sinHRPiFourth =
+            (left ? sinHR + cosHR : sinHR - cosHR)/SQRT2;
+
+        //Each coordinate of the end of the chain is
+        //  offset - THIGH.P - TIBIA.K1
+        //         - FOOT_HEIGHT.(cosAR.(cosAP.K1 + sinAP.K2) - sinAR.W)
+        //where P, K1 and K2 are the axis after the hip pitch and the knee
+        //pitch rotated in and out of the shin, and u, v, W depend on which
+        //leg and coordinate only through the hip yaw pitch and hip roll.
+        float u[3], v[3], W[3], offset[3];
+        const float sinHYPOverSqrt2 = sinHYP/SQRT2;
+        u[0] = cosHRPiFourth*sinHYP;
+        v[0] = -cosHYP;
+        W[0] = sinHYP*sinHRPiFourth;
+        offset[0] = 0.0f;
+        if(left){
+            u[1] = (cosHYP*cosHRPiFourth - sinHRPiFourth)/SQRT2;
+            v[1] = sinHYPOverSqrt2;
+            W[1] = (cosHRPiFourth + cosHYP*sinHRPiFourth)/SQRT2;
+            offset[1] = HIP_OFFSET_Y;
+
+            u[2] = (cosHYP*cosHRPiFourth + sinHRPiFourth)/SQRT2;
+            v[2] = sinHYPOverSqrt2;
+            W[2] = (cosHYP*sinHRPiFourth - cosHRPiFourth)/SQRT2;
+        }else{
+            u[1] = -(cosHYP*cosHRPiFourth + sinHRPiFourth)/SQRT2;
+            v[1] = -sinHYPOverSqrt2;
+            W[1] = (cosHRPiFourth - cosHYP*sinHRPiFourth)/SQRT2;
+            offset[1] = -HIP_OFFSET_Y;
+
+            u[2] = (cosHYP*cosHRPiFourth - sinHRPiFourth)/SQRT2;
+            v[2] = sinHYPOverSqrt2;
+            W[2] = (cosHRPiFourth + cosHYP*sinHRPiFourth)/SQRT2;
         }
-
+        offset[2] = -HIP_OFFSET_Z;
+
+        const bool toAnkle = (id == LANKLE_CHAIN || id == RANKLE_CHAIN);
+        float coords[3];
+        for (int i = 0; i < 3; ++i) {
+            const float P = cosHP*u[i] - sinHP*v[i];
+            const float Q = -sinHP*u[i] - cosHP*v[i];
+            const float K1 = cosKP*P + sinKP*Q;
+            coords[i] = offset[i] - THIGH_LENGTH*P - TIBIA_LENGTH*K1;
+            if(!toAnkle){
+                const float K2 = cosKP*Q - sinKP*P;
+                coords[i] -= FOOT_HEIGHT*(cosAR*(cosAP*K1 + sinAP*K2) -
+                                          sinAR*W[i]);
+            }
+        }
+        x = coords[0];
+        y = coords[1];
+        z = coords[2];
 
     }else if( id == LARM_CHAIN || id == RARM_CHAIN ){
         // Variables for arms.
@@ -495,6 +520,32 @@ Kinematics::dls(const ChainID chainID,
     return result;
 }
 
+namespace {
+    /**
+     * Fills in the rotation part of CoordFrame4D::get6DTransform,
+     * Rotz[wz].Roty[wy].Rotx[wx], as rows.
+     */
+    inline void rotation6D(const float w[3], float r[3][3])
+    {
+        float sinX, cosX, sinY, cosY, sinZ, cosZ;
+        sincosf(w[0], &sinX, &cosX);
+        sincosf(w[1], &sinY, &cosY);
+        sincosf(w[2], &sinZ, &cosZ);
+
+        r[0][0] = cosY*cosZ;
+        r[0][1] = cosZ*sinX*sinY - cosX*sinZ;
+        r[0][2] = cosX*cosZ*sinY + sinX*sinZ;
+
+        r[1][0] = cosY*sinZ;
+        r[1][1] = cosX*cosZ + sinX*sinY*sinZ;
+        r[1][2] = cosX*sinY*sinZ - cosZ*sinX;
+
+        r[2][0] = -sinY;
+        r[2][1] = cosY*sinX;
+        r[2][2] = cosX*cosY;
+    }
+}
+
 /**
  * The following method implements the analytic (exact) IK solution for the Nao
  * which Dr. Dan Lee from UPenn was so gracious to show me. The code is ported
@@ -526,123 +577,96 @@ const Kinematics::IKLegResult Kinematics::analyticLegIK(const ChainID chainID,
                                       const ufvector3 &bodyOrientation,
                                       const float givenHYPAngle)
 {
-    bool success = true;
-#ifdef DEBUG_ANA
-    cout << "anaIK inputs:"<<endl
-         <<"  footGoal: "<<footGoal<<endl
-         <<"  footOrientation: "<<footOrientation<<endl
-         <<"  bodyGoal: "<<bodyGoal<<endl
-         <<"  bodyOrientation: "<<bodyOrientation<<endl
-         <<"  HYP Angle: " <<givenHYPAngle<<endl;
-#endif
-    //fo - translate from f to o
-    const ufmatrix4 fo_Transform = CoordFrame4D::get6DTransform(footGoal(0),
-                                                footGoal(1),footGoal(2),
-                                                footOrientation(0),
-                                                footOrientation(1),
-                                                footOrientation(2));
-    //co - translate from c to o
-    const ufmatrix4 co_Transform = CoordFrame4D::get6DTransform(bodyGoal(0),
-                                                bodyGoal(1),bodyGoal(2),
-                                                bodyOrientation(0),
-                                                bodyOrientation(1),
-                                                bodyOrientation(2));
-#ifdef DEBUG_ANA
-    cout << "fo_Transform: "<<endl<< "  "<<fo_Transform<<endl;
-    cout << "co_Transform: "<<endl<< "  "<<co_Transform<<endl;
-#endif
-    //fc - translate from f to o to c
-    const ufmatrix4 fc_Transform =
-        prod(CoordFrame4D::invertHomogenous(co_Transform),fo_Transform);
+    const LegIKGoal goal = {
+        { footGoal(0), footGoal(1), footGoal(2) },
+        { footOrientation(0), footOrientation(1), footOrientation(2) },
+        { bodyGoal(0), bodyGoal(1), bodyGoal(2) },
+        { bodyOrientation(0), bodyOrientation(1), bodyOrientation(2) },
+        givenHYPAngle
+    };
+    return analyticLegIK(chainID, goal);
+}
 
-    //cf - translate from c to o to f
-    const ufmatrix4 cf_Transform =
-        prod(CoordFrame4D::invertHomogenous(fo_Transform),co_Transform);
+/**
+ * The ublas version of this built the fo and co transforms and multiplied
+ * them out on every call. Here the products are expanded by hand:
+ * with Rf, f the rotation and translation of fo and Rc, c those of co,
+ *   cf = [Rf'Rc | Rf'(c - f)]   and   fc = [Rc'Rf | Rc'(f - c)]
+ * and we only ever need cf and fc applied to the hip and ankle offsets
+ * and one row of Rf'Rc.
+ */
+const Kinematics::IKLegResult Kinematics::analyticLegIK(const ChainID chainID,
+                                                        const LegIKGoal &goal)
+{
+    const float SQRT2 = std::sqrt(2.0f);
 
-#ifdef DEBUG_ANA
-    cout << "cf_Transform: "<<endl<< "  "<<cf_Transform<<endl;
-    cout << "fc_Transform: "<<endl<< "  "<<fc_Transform<<endl;
-#endif
+    float rf[3][3], rc[3][3];
+    rotation6D(goal.footOrientation, rf);
+    rotation6D(goal.bodyOrientation, rc);
 
     const float leg_sign = (chainID == LLEG_CHAIN ? 1.0f : -1.0f);
 
-    //The location of the hip rotation center in the C frame
-    const ufvector4 hipOffset_c = CoordFrame4D::vector4D(0.0f,
-                                                         leg_sign*HIP_OFFSET_Y,
-                                                         -HIP_OFFSET_Z);
-    const ufvector4 ankleOffset_f =CoordFrame4D::vector4D(0.0f,
-                                                          0.0f,
-                                                          FOOT_HEIGHT);
+    //The location of the hip rotation center in the C frame is
+    //(0, leg_sign*HIP_OFFSET_Y, -HIP_OFFSET_Z), and the ankle in the F frame
+    //is (0, 0, FOOT_HEIGHT)
+    const float hipY = leg_sign*HIP_OFFSET_Y;
+
+    //c - f, in the O frame
+    float cMinusF[3];
+    for (int i = 0; i < 3; ++i)
+        cMinusF[i] = goal.bodyGoal[i] - goal.footGoal[i];
 
     //Find the location of the hip in the F frame that is shifted
-    //to the ankle from the bottom of the foot
-    const ufvector4 hipPosition_fprime =
-        prod(cf_Transform,hipOffset_c) - ankleOffset_f;
+    //to the ankle from the bottom of the foot: Rf'(Rc.hip + c - f) - ankle
+    float hipPosition_o[3];
+    for (int i = 0; i < 3; ++i)
+        hipPosition_o[i] = rc[i][1]*hipY - rc[i][2]*HIP_OFFSET_Z + cMinusF[i];
 
-#ifdef DEBUG_ANA
-    cout<< "Hip position in fprime: "<< hipPosition_fprime<<endl;
-#endif
+    float hipPosition_fprime[3];
+    for (int j = 0; j < 3; ++j)
+        hipPosition_fprime[j] = rf[0][j]*hipPosition_o[0] +
+            rf[1][j]*hipPosition_o[1] + rf[2][j]*hipPosition_o[2];
+    hipPosition_fprime[2] -= FOOT_HEIGHT;
 
     //squared dist from ankle to hip
-    const float legLength = norm_2(hipPosition_fprime);
-    const float legLengthSq = std::pow(legLength,2);
-    if(legLength > THIGH_LENGTH+TIBIA_LENGTH)
-        success = false;
-#ifdef DEBUG_ANA
-    cout<< "LegLength: "<< legLength << ", sqrd = "<<legLengthSq<<endl;
-#endif
+    const float legLengthSq = hipPosition_fprime[0]*hipPosition_fprime[0] +
+        hipPosition_fprime[1]*hipPosition_fprime[1] +
+        hipPosition_fprime[2]*hipPosition_fprime[2];
+    const float legLength = std::sqrt(legLengthSq);
+    const bool success = legLength <= THIGH_LENGTH+TIBIA_LENGTH;
 
     //Using the law of cosines to find knee pitch in TTL triangle
     const float kneeCosine =
-        (legLengthSq -TIBIA_LENGTH*TIBIA_LENGTH - THIGH_LENGTH*THIGH_LENGTH)/
-                  (2.0f*TIBIA_LENGTH*THIGH_LENGTH);
-#ifdef DEBUG_ANA
-    cout<< "KneeCosine: "<<kneeCosine
-        << " unclipped cos"<< std::acos(kneeCosine)<<endl;
-#endif
+        std::min(std::max((legLengthSq -TIBIA_LENGTH*TIBIA_LENGTH -
+                           THIGH_LENGTH*THIGH_LENGTH)/
+                          (2.0f*TIBIA_LENGTH*THIGH_LENGTH), -1.0f), 1.0f);
+    const float KP = std::acos(kneeCosine);
+    const float sinKP = std::sqrt(1.0f - kneeCosine*kneeCosine);
 
-    const float KP = std::acos(std::min(std::max(kneeCosine,-1.0f),
-                                               1.0f));
-#ifdef DEBUG_ANA
-    cout<< "Calculated KP: "<<KP<<endl;
-#endif
     //Now, we can find the ankle roll using only the position of hip in f:
-    const float AR = std::atan2(hipPosition_fprime(CoordFrame4D::Y_AXIS),
-                                hipPosition_fprime(CoordFrame4D::Z_AXIS));
-
-#ifdef DEBUG_ANA
-    cout<< "Calculated AR: "<<AR<<endl;
-#endif
+    const float AR = std::atan2(hipPosition_fprime[1], hipPosition_fprime[2]);
 
     //To find AP, we first use the law of sines to find angle opposite
     //the THIGH in the TTL tri.
     //Also, note, even though the TTL triangle is not in the plane XZ plane of
     //the F frame, the following still works, since scaling the triangle into
     //that frame creates a similar triangle with the same angles
-    const float pitch0 = std::asin(THIGH_LENGTH*std::sin(KP)/legLength);
-    const float AP =
-        std::asin(-hipPosition_fprime(CoordFrame4D::X_AXIS)/legLength) - pitch0;
-
-#ifdef DEBUG_ANA
-    cout<< "Calculated AP: "<<AP<<endl;
-#endif
-
-    float tempHYP = givenHYPAngle;
-    //If the HYP was not passed in, we need to find it:
-    if(givenHYPAngle == HYP_NOT_SET){
-        //find the rotation-only transform from C to F back to Hip
-        const ufmatrix3 cf_Rot  = subrange(cf_Transform,0,3,0,3);
-        const ufmatrix3 temp =
-            prod(CoordFrame3D::rotation3D(CoordFrame3D::Y_AXIS,
-                                          AP+KP),
-                 CoordFrame3D::rotation3D(CoordFrame3D::X_AXIS,
-                                          AR));
-        const ufmatrix3 cfh_Transform =
-            prod(temp,
-                 cf_Rot);
-
-        // next, grab the hipYawPitch angle from the cfh_Transform matrix.
-        // What? that's right!
+    const float pitch0 = std::asin(THIGH_LENGTH*sinKP/legLength);
+    const float AP = std::asin(-hipPosition_fprime[0]/legLength) - pitch0;
+
+    float HYP = goal.HYPAngle;
+    //If the HYP was not passed in, we need to find it from the rotation-only
+    //transform from C to F. The ublas version premultiplied that by
+    //rotation3D(Y_AXIS, AP+KP).rotation3D(X_AXIS, AR), but rotation3D only
+    //handles Z_AXIS and returns the identity for both, so we use the
+    //rotation alone to get the same angles. We only need its Y row.
+    if(HYP == HYP_NOT_SET){
+        float cfRotY[3];
+        for (int j = 0; j < 3; ++j)
+            cfRotY[j] = rf[0][1]*rc[0][j] + rf[1][1]*rc[1][j] +
+                rf[2][1]*rc[2][j];
+
+        // next, grab the hipYawPitch angle from the rotation.
         // Here's how it works. The rHip rotation describes C->after_hip
         // transform. If we assume that the HYP was the only joint one could use
         // in the hip, then to modify rHip to be a C->C transform (i.e. I),
@@ -652,60 +676,61 @@ const Kinematics::IKLegResult Kinematics::analyticLegIK(const ChainID chainID,
         // If you find RHYP = Rotx[-3Pi/4].Rotx[HYP].Rotx[3Pi/4] (for left),
         // then you can evaluate (symbolicaly) RHYP^-1 with a transpose,
         // and see that to solve for HYP, you can apply the formulas below
-        // neat stuff...
-        if(chainID == LLEG_CHAIN){
-            tempHYP =
-                std::atan2(std::sqrt(2.0f)*cfh_Transform(CoordFrame3D::Y_AXIS,
-                                                         CoordFrame3D::X_AXIS),
-                           cfh_Transform(CoordFrame3D::Y_AXIS,
-                                         CoordFrame3D::Y_AXIS) +
-                           cfh_Transform(CoordFrame3D::Y_AXIS,
-                                         CoordFrame3D::Z_AXIS));
-        }else{
-            tempHYP =
-                std::atan2(-std::sqrt(2.0f)*cfh_Transform(CoordFrame3D::Y_AXIS,
-                                                         CoordFrame3D::X_AXIS),
-                           cfh_Transform(CoordFrame3D::Y_AXIS,
-                                         CoordFrame3D::Y_AXIS) -
-                           cfh_Transform(CoordFrame3D::Y_AXIS,
-                                         CoordFrame3D::Z_AXIS));
-        }
+        if(chainID == LLEG_CHAIN)
+            HYP = std::atan2(SQRT2*cfRotY[0], cfRotY[1] + cfRotY[2]);
+        else
+            HYP = std::atan2(-SQRT2*cfRotY[0], cfRotY[1] - cfRotY[2]);
     }
-    const float HYP = tempHYP;
-#ifdef DEBUG_ANA
-    cout<< "Calculated HYP: "<<HYP<<endl;
-#endif
 
     //Now we are left only to find the HipRoll and HipPitch
 
-    //Find the location of the ankle in a C frame shifted to hip
-    const ufvector4 anklePosition_cprime = prod(fc_Transform,
-                                                ankleOffset_f) - hipOffset_c;
+    //Find the location of the ankle in a C frame shifted to hip:
+    //Rc'(Rf.ankle + f - c) - hip
+    float anklePosition_o[3];
+    for (int i = 0; i < 3; ++i)
+        anklePosition_o[i] = rf[i][2]*FOOT_HEIGHT - cMinusF[i];
+
+    float anklePosition_cprime[3];
+    for (int j = 0; j < 3; ++j)
+        anklePosition_cprime[j] = rc[0][j]*anklePosition_o[0] +
+            rc[1][j]*anklePosition_o[1] + rc[2][j]*anklePosition_o[2];
+    anklePosition_cprime[1] -= hipY;
+    anklePosition_cprime[2] += HIP_OFFSET_Z;
 
     //Now, we have already found HYP, so we will shift the cprime
     //frame to the d frame. The d frame is positioned at the hip,
-    //and parrallel to the cprime EXCEPT for the HYP rotation, which is added:
-    const ufvector4 anklePosition_d = prod(( chainID == LLEG_CHAIN ?
-                                             rotationHYPLeftInv(HYP) :
-                                             rotationHYPRightInv(HYP)),
-                                           anklePosition_cprime);
-
+    //and parrallel to the cprime EXCEPT for the HYP rotation, which is added.
+    //This is rotationHYPLeftInv/RightInv multiplied out.
+    float sinHYP, cosHYP;
+    sincosf(HYP, &sinHYP, &cosHYP);
+    const float sinHYPOverSqrt2 = sinHYP/SQRT2;
+    const float halfCosHYP = 0.5f*cosHYP;
+    const float cy = anklePosition_cprime[1];
+    const float cz = anklePosition_cprime[2];
+
+    float anklePosition_d[3];
+    anklePosition_d[0] = cosHYP*anklePosition_cprime[0];
+    if(chainID == LLEG_CHAIN){
+        anklePosition_d[0] -= sinHYPOverSqrt2*(cy + cz);
+        anklePosition_d[1] = sinHYPOverSqrt2*anklePosition_cprime[0] +
+            (0.5f + halfCosHYP)*cy + (halfCosHYP - 0.5f)*cz;
+    }else{
+        anklePosition_d[0] += sinHYPOverSqrt2*(cy - cz);
+        anklePosition_d[1] = -sinHYPOverSqrt2*anklePosition_cprime[0] +
+            (0.5f + halfCosHYP)*cy + (0.5f - halfCosHYP)*cz;
+    }
+    const float sameSideZ = (chainID == LLEG_CHAIN ?
+                             halfCosHYP - 0.5f : 0.5f - halfCosHYP);
+    anklePosition_d[2] = sinHYPOverSqrt2*anklePosition_cprime[0] +
+        sameSideZ*cy + (0.5f + halfCosHYP)*cz;
 
     //Finding the hip Roll easy in the d frame:
-    const float HR = std::atan2(anklePosition_d(CoordFrame4D::Y_AXIS),
-                                -anklePosition_d(CoordFrame4D::Z_AXIS));
-#ifdef DEBUG_ANA
-    cout<< "Calculated HR: "<<HR<<endl;
-#endif
+    const float HR = std::atan2(anklePosition_d[1], -anklePosition_d[2]);
 
     //Again, using the law of sines, we can find the angle accross from
     //TIBIA_LENGTH in the triangle TTL:
-    const float pitch1 = std::asin(TIBIA_LENGTH*std::sin(KP)/legLength);
-    const float HP = std::asin(-anklePosition_d(CoordFrame4D::X_AXIS)
-                               /legLength) - pitch1;
-#ifdef DEBUG_ANA
-    cout<< "Calculated HP: "<<HP<<endl;
-#endif
+    const float pitch1 = std::asin(TIBIA_LENGTH*sinKP/legLength);
+    const float HP = std::asin(-anklePosition_d[0]/legLength) - pitch1;
 
     //Setup the return value:
     IKLegResult result;
@@ -717,9 +742,24 @@ const Kinematics::IKLegResult Kinematics::analyticLegIK(const ChainID chainID,
     result.angles[4] = AP;
     result.angles[5] = AR;
     result.outcome = (success ? SUCCESS : STUCK);
+
+#ifdef DEBUG_ANA
+    cout << "anaIK with leg " << chainID << ": {";
+    for(int i = 0; i < 6; i++){cout<<result.angles[i]<<",";}
+    cout << "}" << (success ? "" : " STUCK") << endl;
+#endif
     return result;
 }
 
+void Kinematics::analyticLegIK(const ChainID chainID,
+                               const LegIKGoal goals[],
+                               IKLegResult results[],
+                               const unsigned int numGoals)
+{
+    for (unsigned int i = 0; i < numGoals; ++i)
+        results[i] = analyticLegIK(chainID, goals[i]);
+}
+
 ufmatrix4 Kinematics::rotationHYPLeftInv(const float HYP){
     float sinHYP, cosHYP;
     sincosf(HYP,&sinHYP,&cosHYP);
@@ -32,6 +32,18 @@ namespace Kinematics{
         float angles[6];
     };
 
+    /**
+     * Where analyticLegIK should put a foot and the body, as x, y, z and
+     * rotations about x, y, z, and the HYP to use, or HYP_NOT_SET to find it.
+     */
+    struct LegIKGoal {
+        float footGoal[3];
+        float footOrientation[3];
+        float bodyGoal[3];
+        float bodyOrientation[3];
+        float HYPAngle;
+    };
+
     const IKLegResult simpleLegIK(const ChainID chainID,
                                   const NBMath::ufvector3 & legGoal,
                                   float startAngles []);
@@ -88,6 +100,18 @@ namespace Kinematics{
                                     const NBMath::ufvector3 &bodyOrientation,
                                     const float givenHYPAngle = HYP_NOT_SET);
 
+    const IKLegResult analyticLegIK(const ChainID chainID,
+                                    const LegIKGoal &goal);
+
+    /**
+     * Solves numGoals goals for one leg at once, for gait optimization and
+     * offline simulation.  results[i] is the solution to goals[i].
+     */
+    void analyticLegIK(const ChainID chainID,
+                       const LegIKGoal goals[],
+                       IKLegResult results[],
+                       const unsigned int numGoals);
+
 
     NBMath::ufmatrix4 rotationHYPRightInv(const float HYP);
     NBMath::ufmatrix4 rotationHYPLeftInv(const float HYP);
@@ -31,6 +31,7 @@ NaoEnactor::NaoEnactor(boost::shared_ptr<Sensors> s,
     : MotionEnactor(), broker(_pbroker), sensors(s),
       transcriber(t),
       motionValues(Kinematics::NUM_JOINTS,0.0f),  // commands sent to joints
+      motionHardness(Kinematics::NUM_JOINTS,0.0f),
       lastMotionHardness(Kinematics::NUM_JOINTS,0.0f)
 
 {
@@ -73,7 +74,7 @@ void NaoEnactor::sendJoints()
     joint_command[4][0] = dcmProxy->getTime(20);
 
     // Get the angles we want to go to this frame from the switchboard
-    motionValues = switchboard->getNextJoints();
+    switchboard->getNextJoints(&motionValues[0]);
 
     for (unsigned int i = 0; i < Kinematics::NUM_JOINTS; i++)
         {
@@ -94,7 +95,7 @@ void NaoEnactor::sendJoints()
 
 
 void NaoEnactor::sendHardness(){
-    motionHardness = switchboard->getNextStiffness();
+    switchboard->getNextStiffness(&motionHardness[0]);
 
     bool diffStiff = false;
     static float hardness = 0.0f;
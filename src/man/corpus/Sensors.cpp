@@ -171,6 +171,24 @@ const vector<float> Sensors::getMotionBodyAngles() const
     return vec;
 }
 
+void Sensors::getBodyAngles(float angles[]) const
+{
+    pthread_mutex_lock (&angles_mutex);
+
+    std::copy(bodyAngles.begin(), bodyAngles.end(), angles);
+
+    pthread_mutex_unlock (&angles_mutex);
+}
+
+void Sensors::getMotionBodyAngles(float angles[]) const
+{
+    pthread_mutex_lock (&motion_angles_mutex);
+
+    std::copy(motionBodyAngles.begin(), motionBodyAngles.end(), angles);
+
+    pthread_mutex_unlock (&motion_angles_mutex);
+}
+
 const vector<float> Sensors::getBodyTemperatures() const
 {
     pthread_mutex_lock (&temperatures_mutex);
@@ -460,6 +478,15 @@ void Sensors::setMotionBodyAngles (const vector<float>& v)
     pthread_mutex_unlock (&motion_angles_mutex);
 }
 
+void Sensors::setMotionBodyAngles (const float angles[])
+{
+    pthread_mutex_lock (&motion_angles_mutex);
+
+    std::copy(angles, angles + NUM_ACTUATORS, motionBodyAngles.begin());
+
+    pthread_mutex_unlock (&motion_angles_mutex);
+}
+
 void Sensors::setBodyAngleErrors (const vector<float>& v)
 {
     pthread_mutex_lock (&errors_mutex);
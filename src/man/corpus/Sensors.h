@@ -112,6 +112,10 @@ class Sensors {
     const float getBatteryCharge() const;
     const float getBatteryCurrent() const;
     const std::vector<float> getAllSensors() const;
+    // Copying into the caller's NUM_ACTUATORS floats, for the motion frame,
+    // which must not allocate
+    void getBodyAngles(float angles[]) const;
+    void getMotionBodyAngles(float angles[]) const;
 
     // Locking data storage methods
     //   Each of these methods first locks the associated mutex, stores
@@ -119,6 +123,7 @@ class Sensors {
     void setBodyAngles(const std::vector<float>& v);
     void setVisionBodyAngles(const std::vector<float>& v);
     void setMotionBodyAngles(const std::vector<float>& v);
+    void setMotionBodyAngles(const float angles[]);
     void setBodyAngleErrors(const std::vector<float>& v);
     void setBodyTemperatures(const std::vector<float>& v);
     void setLeftFootFSR(const float frontLeft, const float frontRight,
@@ -8,7 +8,8 @@
  * Typically, this will be done by starting a high-priority thread which recurs
  * close to the timestep (20 ms) as possible.
  * Each enactor must call getNextJoints on the switchboard, and relay that
- * information correctly.
+ * information correctly.  getNextStiffness gives the stiffnesses of the
+ * frame the last getNextJoints took, so it comes second.
  */
 
 #ifndef _ThreadedMotionEnactor_h_DEFINED
@@ -57,7 +57,7 @@ void WBEnactor::sendCommands(){
 //     cout << "About to attempt to set some joints..."<<endl;
 
     if(switchboard != NULL)
-        motionValues = switchboard->getNextJoints();
+        switchboard->getNextJoints(&motionValues[0]);
     else
         cout << "warning, switchboard is null in WB enactor" <<endl;
 //     cout << "Threadlock ??" <<endl;
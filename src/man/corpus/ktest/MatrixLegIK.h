@@ -0,0 +1,27 @@
+#ifndef MatrixLegIK_h
+#define MatrixLegIK_h
+
+#include "InverseKinematics.h"
+
+/**
+ * The leg IK and FK as they were before the closed forms in
+ * InverseKinematics.cpp, built out of ublas transforms.  Kept here as the
+ * reference the regression test and benchmark compare against.
+ */
+namespace MatrixKinematics {
+    using namespace Kinematics;
+
+    const IKLegResult analyticLegIK(const ChainID chainID,
+                                    const NBMath::ufvector3 &footGoal,
+                                    const NBMath::ufvector3 &footOrientation,
+                                    const NBMath::ufvector3 &bodyGoal,
+                                    const NBMath::ufvector3 &bodyOrientation,
+                                    const float givenHYPAngle = HYP_NOT_SET);
+
+    const NBMath::ufvector3 forwardKinematics(const ChainID id,
+                                              const float angles[]);
+
+    NBMath::ufmatrix4 rotationHYPRightInv(const float HYP);
+    NBMath::ufmatrix4 rotationHYPLeftInv(const float HYP);
+};
+#endif
@@ -0,0 +1,117 @@
+/**
+ * Times the closed form leg IK and FK in InverseKinematics.cpp against the
+ * ublas versions they replaced, kept in MatrixLegIK.cpp.
+ */
+#include <cstdlib>
+#include <iostream>
+
+#include "Common.h"
+#include "InverseKinematics.h"
+#include "MatrixLegIK.h"
+
+using namespace NBMath;
+using namespace std;
+using namespace Kinematics;
+
+static const int NUM_GOALS = 1000;
+static const int ROUNDS = 200;
+
+static float random(const float low, const float high)
+{
+    return low + (high - low) * static_cast<float>(rand()) /
+        static_cast<float>(RAND_MAX);
+}
+
+static ufvector3 toVector(const float v[3])
+{
+    return CoordFrame3D::vector3D(v[0], v[1], v[2]);
+}
+
+// Keeps the compiler from dropping the work being timed
+static float sink = 0.0f;
+
+static void report(const char *name, const long long start)
+{
+    const long long elapsed = micro_time() - start;
+    const float calls = static_cast<float>(NUM_GOALS) * ROUNDS;
+    cout << name << ": " << calls * 1000000.0f / elapsed << " calls/s, "
+         << elapsed * 1000.0f / calls << " ns/call" << endl;
+}
+
+int main()
+{
+    srand(2010);
+    const ChainID chain = LLEG_CHAIN;
+
+    LegIKGoal goals[NUM_GOALS];
+    float angles[NUM_GOALS][LEG_JOINTS];
+    for (int i = 0; i < NUM_GOALS; ++i) {
+        LegIKGoal& g = goals[i];
+        for (int j = 0; j < 3; ++j) {
+            g.footGoal[j] = random(-50.0f, 50.0f);
+            g.footOrientation[j] = random(-0.2f, 0.2f);
+            g.bodyGoal[j] = random(-50.0f, 50.0f);
+            g.bodyOrientation[j] = random(-0.2f, 0.2f);
+        }
+        g.bodyGoal[2] += 280.0f;
+        g.HYPAngle = (i % 2 ? HYP_NOT_SET : random(-0.6f, 0.2f));
+
+        for (unsigned int j = 0; j < LEG_JOINTS; ++j)
+            angles[i][j] = random(-1.0f, 1.0f);
+    }
+
+    long long start = micro_time();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < NUM_GOALS; ++i) {
+            const LegIKGoal& g = goals[i];
+            sink += MatrixKinematics::analyticLegIK(chain,
+                                            toVector(g.footGoal),
+                                            toVector(g.footOrientation),
+                                            toVector(g.bodyGoal),
+                                            toVector(g.bodyOrientation),
+                                            g.HYPAngle).angles[2];
+        }
+    report("ublas IK       ", start);
+
+    start = micro_time();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < NUM_GOALS; ++i) {
+            const LegIKGoal& g = goals[i];
+            sink += analyticLegIK(chain,
+                                  toVector(g.footGoal),
+                                  toVector(g.footOrientation),
+                                  toVector(g.bodyGoal),
+                                  toVector(g.bodyOrientation),
+                                  g.HYPAngle).angles[2];
+        }
+    report("closed IK      ", start);
+
+    start = micro_time();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < NUM_GOALS; ++i)
+            sink += analyticLegIK(chain, goals[i]).angles[2];
+    report("closed IK goal ", start);
+
+    IKLegResult results[NUM_GOALS];
+    start = micro_time();
+    for (int r = 0; r < ROUNDS; ++r) {
+        analyticLegIK(chain, goals, results, NUM_GOALS);
+        sink += results[r].angles[2];
+    }
+    report("closed IK batch", start);
+
+    start = micro_time();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < NUM_GOALS; ++i)
+            sink += MatrixKinematics::forwardKinematics(chain, angles[i])(2);
+    report("old FK         ", start);
+
+    start = micro_time();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < NUM_GOALS; ++i)
+            sink += forwardKinematics(chain, angles[i])(2);
+    report("closed FK      ", start);
+
+    cout << "(" << sink << ")" << endl;
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * Checks the closed form leg IK and FK in InverseKinematics.cpp against the
+ * ublas versions they replaced, kept in MatrixLegIK.cpp, over random goals
+ * and angles for both legs.
+ */
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "InverseKinematics.h"
+#include "MatrixLegIK.h"
+
+using namespace NBMath;
+using namespace std;
+using namespace Kinematics;
+
+static const int NUM_TRIALS = 100000;
+static const float ANGLE_TOLERANCE = 0.001f; // rad
+static const float POSITION_TOLERANCE = 0.01f; // mm
+
+// Too big for the stack between them
+static LegIKGoal goals[NUM_TRIALS];
+static IKLegResult batch[NUM_TRIALS];
+
+static float random(const float low, const float high)
+{
+    return low + (high - low) * static_cast<float>(rand()) /
+        static_cast<float>(RAND_MAX);
+}
+
+static bool near(const float a, const float b, const float tolerance)
+{
+    if (isnan(a) || isnan(b))
+        return isnan(a) && isnan(b);
+    return std::fabs(a - b) <= tolerance;
+}
+
+// Body roughly over the foot, sometimes out of reach, and sometimes with
+// a HYP to use
+static LegIKGoal randomGoal(const ChainID chain)
+{
+    const float side = (chain == LLEG_CHAIN ? 1.0f : -1.0f);
+    const float reach = (rand() % 10 == 0 ? 120.0f : 60.0f);
+
+    LegIKGoal goal;
+    goal.footGoal[0] = random(-500.0f, 500.0f);
+    goal.footGoal[1] = random(-500.0f, 500.0f);
+    goal.footGoal[2] = random(-20.0f, 20.0f);
+    goal.footOrientation[0] = random(-0.2f, 0.2f);
+    goal.footOrientation[1] = random(-0.2f, 0.2f);
+    goal.footOrientation[2] = random(-M_PI_FLOAT, M_PI_FLOAT);
+
+    goal.bodyGoal[0] = goal.footGoal[0] + random(-reach, reach);
+    goal.bodyGoal[1] = goal.footGoal[1] - side * HIP_OFFSET_Y +
+        random(-reach, reach);
+    goal.bodyGoal[2] = goal.footGoal[2] + random(220.0f, 300.0f);
+    goal.bodyOrientation[0] = random(-0.2f, 0.2f);
+    goal.bodyOrientation[1] = random(-0.2f, 0.2f);
+    goal.bodyOrientation[2] = goal.footOrientation[2] + random(-0.5f, 0.5f);
+
+    goal.HYPAngle = (rand() % 2 ? HYP_NOT_SET : random(-0.6f, 0.2f));
+    return goal;
+}
+
+static ufvector3 toVector(const float v[3])
+{
+    return CoordFrame3D::vector3D(v[0], v[1], v[2]);
+}
+
+static int checkIK(const ChainID chain)
+{
+    for (int i = 0; i < NUM_TRIALS; ++i)
+        goals[i] = randomGoal(chain);
+    analyticLegIK(chain, goals, batch, NUM_TRIALS);
+
+    int failures = 0, stuck = 0;
+    for (int i = 0; i < NUM_TRIALS; ++i) {
+        const LegIKGoal& g = goals[i];
+        const IKLegResult expected =
+            MatrixKinematics::analyticLegIK(chain,
+                                            toVector(g.footGoal),
+                                            toVector(g.footOrientation),
+                                            toVector(g.bodyGoal),
+                                            toVector(g.bodyOrientation),
+                                            g.HYPAngle);
+        const IKLegResult single = analyticLegIK(chain, g);
+
+        bool ok = expected.outcome == batch[i].outcome;
+        for (unsigned int j = 0; j < LEG_JOINTS; ++j)
+            ok = ok && near(expected.angles[j], batch[i].angles[j],
+                            ANGLE_TOLERANCE) &&
+                batch[i].angles[j] == single.angles[j];
+        if (expected.outcome == STUCK)
+            ++stuck;
+        if (!ok) {
+            if (failures < 5) {
+                cout << "  IK mismatch, expected";
+                for (unsigned int j = 0; j < LEG_JOINTS; ++j)
+                    cout << " " << expected.angles[j];
+                cout << " got";
+                for (unsigned int j = 0; j < LEG_JOINTS; ++j)
+                    cout << " " << batch[i].angles[j];
+                cout << endl;
+            }
+            ++failures;
+        }
+    }
+    cout << "IK for chain " << chain << ": " << failures << " of "
+         << NUM_TRIALS << " differ (" << stuck << " out of reach)" << endl;
+    return failures;
+}
+
+static int checkFK(const ChainID chain)
+{
+    int failures = 0;
+    for (int i = 0; i < NUM_TRIALS; ++i) {
+        float angles[LEG_JOINTS];
+        for (unsigned int j = 0; j < LEG_JOINTS; ++j)
+            angles[j] = random(-M_PI_FLOAT, M_PI_FLOAT);
+
+        const ufvector3 expected =
+            MatrixKinematics::forwardKinematics(chain, angles);
+        const ufvector3 actual = forwardKinematics(chain, angles);
+        bool ok = true;
+        for (int j = 0; j < 3; ++j)
+            ok = ok && near(expected(j), actual(j), POSITION_TOLERANCE);
+        if (!ok) {
+            if (failures < 5)
+                cout << "  FK mismatch, expected " << expected
+                     << " got " << actual << endl;
+            ++failures;
+        }
+    }
+    cout << "FK for chain " << chain << ": " << failures << " of "
+         << NUM_TRIALS << " differ" << endl;
+    return failures;
+}
+
+int main()
+{
+    srand(2010);
+
+    int failures = 0;
+    failures += checkIK(LLEG_CHAIN);
+    failures += checkIK(RLEG_CHAIN);
+
+    failures += checkFK(LLEG_CHAIN);
+    failures += checkFK(RLEG_CHAIN);
+    failures += checkFK(LANKLE_CHAIN);
+    failures += checkFK(RANKLE_CHAIN);
+
+    cout << (failures == 0 ? "PASSED" : "FAILED") << endl;
+    return failures == 0 ? 0 : 1;
+}
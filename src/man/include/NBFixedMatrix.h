@@ -0,0 +1,387 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Small fixed size float matrices and vectors for the EKFs.
+ *
+ * The sizes are template parameters, so every loop below has a trip count
+ * the compiler knows and unrolls, the storage is a plain array on the stack
+ * and there are no expression templates, proxies or size checks in between.
+ * The names and semantics of the functions are the uBLAS ones the filters
+ * were written against (prod, trans, inner_prod, outer_prod, element access
+ * with operator()), so filter code reads the same with either.
+ *
+ * Everything is zero initialized.  The (rows, cols) and (size) constructors
+ * only exist so code written for uBLAS keeps compiling; the sizes must match
+ * the template's.
+ */
+
+#ifndef NBFixedMatrix_h_DEFINED
+#define NBFixedMatrix_h_DEFINED
+
+#include <ostream>
+
+namespace NBMath {
+
+template <unsigned int N>
+class FixedVector
+{
+public:
+    FixedVector() { fill(0.0f); }
+    explicit FixedVector(unsigned int, float init = 0.0f) { fill(init); }
+
+    float& operator()(unsigned int i) { return v[i]; }
+    float operator()(unsigned int i) const { return v[i]; }
+
+    unsigned int size() const { return N; }
+
+    void fill(float f) {
+        for (unsigned int i = 0; i < N; ++i)
+            v[i] = f;
+    }
+
+    FixedVector& operator+=(const FixedVector& o) {
+        for (unsigned int i = 0; i < N; ++i)
+            v[i] += o.v[i];
+        return *this;
+    }
+
+    FixedVector& operator-=(const FixedVector& o) {
+        for (unsigned int i = 0; i < N; ++i)
+            v[i] -= o.v[i];
+        return *this;
+    }
+
+    FixedVector& operator*=(float s) {
+        for (unsigned int i = 0; i < N; ++i)
+            v[i] *= s;
+        return *this;
+    }
+
+    FixedVector& operator/=(float s) {
+        for (unsigned int i = 0; i < N; ++i)
+            v[i] /= s;
+        return *this;
+    }
+
+private:
+    float v[N];
+};
+
+template <unsigned int R, unsigned int C>
+class FixedMatrix
+{
+public:
+    FixedMatrix() { fill(0.0f); }
+    FixedMatrix(unsigned int, unsigned int, float init = 0.0f) { fill(init); }
+
+    float& operator()(unsigned int i, unsigned int j) { return m[i][j]; }
+    float operator()(unsigned int i, unsigned int j) const { return m[i][j]; }
+
+    unsigned int size1() const { return R; }
+    unsigned int size2() const { return C; }
+
+    void fill(float f) {
+        for (unsigned int i = 0; i < R; ++i)
+            for (unsigned int j = 0; j < C; ++j)
+                m[i][j] = f;
+    }
+
+    static FixedMatrix identity() {
+        FixedMatrix I;
+        for (unsigned int i = 0; i < R && i < C; ++i)
+            I.m[i][i] = 1.0f;
+        return I;
+    }
+
+    FixedMatrix& operator+=(const FixedMatrix& o) {
+        for (unsigned int i = 0; i < R; ++i)
+            for (unsigned int j = 0; j < C; ++j)
+                m[i][j] += o.m[i][j];
+        return *this;
+    }
+
+    FixedMatrix& operator-=(const FixedMatrix& o) {
+        for (unsigned int i = 0; i < R; ++i)
+            for (unsigned int j = 0; j < C; ++j)
+                m[i][j] -= o.m[i][j];
+        return *this;
+    }
+
+    FixedMatrix& operator*=(float s) {
+        for (unsigned int i = 0; i < R; ++i)
+            for (unsigned int j = 0; j < C; ++j)
+                m[i][j] *= s;
+        return *this;
+    }
+
+    FixedMatrix& operator/=(float s) {
+        for (unsigned int i = 0; i < R; ++i)
+            for (unsigned int j = 0; j < C; ++j)
+                m[i][j] /= s;
+        return *this;
+    }
+
+private:
+    float m[R][C];
+};
+
+// Vector arithmetic
+
+template <unsigned int N>
+inline FixedVector<N> operator+(FixedVector<N> a, const FixedVector<N>& b)
+{
+    return a += b;
+}
+
+template <unsigned int N>
+inline FixedVector<N> operator-(FixedVector<N> a, const FixedVector<N>& b)
+{
+    return a -= b;
+}
+
+template <unsigned int N>
+inline FixedVector<N> operator*(FixedVector<N> a, float s) { return a *= s; }
+
+template <unsigned int N>
+inline FixedVector<N> operator*(float s, FixedVector<N> a) { return a *= s; }
+
+template <unsigned int N>
+inline FixedVector<N> operator/(FixedVector<N> a, float s) { return a /= s; }
+
+// Matrix arithmetic
+
+template <unsigned int R, unsigned int C>
+inline FixedMatrix<R, C> operator+(FixedMatrix<R, C> a,
+                                   const FixedMatrix<R, C>& b)
+{
+    return a += b;
+}
+
+template <unsigned int R, unsigned int C>
+inline FixedMatrix<R, C> operator-(FixedMatrix<R, C> a,
+                                   const FixedMatrix<R, C>& b)
+{
+    return a -= b;
+}
+
+template <unsigned int R, unsigned int C>
+inline FixedMatrix<R, C> operator*(FixedMatrix<R, C> a, float s)
+{
+    return a *= s;
+}
+
+template <unsigned int R, unsigned int C>
+inline FixedMatrix<R, C> operator*(float s, FixedMatrix<R, C> a)
+{
+    return a *= s;
+}
+
+template <unsigned int R, unsigned int C>
+inline FixedMatrix<R, C> operator/(FixedMatrix<R, C> a, float s)
+{
+    return a /= s;
+}
+
+// Products, summed in index order like uBLAS does
+
+template <unsigned int R, unsigned int K, unsigned int C>
+inline FixedMatrix<R, C> prod(const FixedMatrix<R, K>& a,
+                              const FixedMatrix<K, C>& b)
+{
+    FixedMatrix<R, C> p;
+    for (unsigned int i = 0; i < R; ++i) {
+        for (unsigned int j = 0; j < C; ++j) {
+            float s = 0.0f;
+            for (unsigned int k = 0; k < K; ++k)
+                s += a(i, k) * b(k, j);
+            p(i, j) = s;
+        }
+    }
+    return p;
+}
+
+template <unsigned int R, unsigned int C>
+inline FixedVector<R> prod(const FixedMatrix<R, C>& a, const FixedVector<C>& x)
+{
+    FixedVector<R> p;
+    for (unsigned int i = 0; i < R; ++i) {
+        float s = 0.0f;
+        for (unsigned int k = 0; k < C; ++k)
+            s += a(i, k) * x(k);
+        p(i) = s;
+    }
+    return p;
+}
+
+template <unsigned int R, unsigned int C>
+inline FixedMatrix<C, R> trans(const FixedMatrix<R, C>& a)
+{
+    FixedMatrix<C, R> t;
+    for (unsigned int i = 0; i < R; ++i)
+        for (unsigned int j = 0; j < C; ++j)
+            t(j, i) = a(i, j);
+    return t;
+}
+
+// uBLAS vectors have no orientation, neither do these
+template <unsigned int N>
+inline const FixedVector<N>& trans(const FixedVector<N>& x) { return x; }
+
+template <unsigned int N>
+inline float inner_prod(const FixedVector<N>& a, const FixedVector<N>& b)
+{
+    float s = 0.0f;
+    for (unsigned int i = 0; i < N; ++i)
+        s += a(i) * b(i);
+    return s;
+}
+
+template <unsigned int N>
+inline FixedMatrix<N, N> outer_prod(const FixedVector<N>& a,
+                                    const FixedVector<N>& b)
+{
+    FixedMatrix<N, N> p;
+    for (unsigned int i = 0; i < N; ++i)
+        for (unsigned int j = 0; j < N; ++j)
+            p(i, j) = a(i) * b(j);
+    return p;
+}
+
+/**
+ * Sets the lower triangle of a square matrix to its upper triangle.
+ */
+template <unsigned int N>
+inline void symmetrize(FixedMatrix<N, N>& a)
+{
+    for (unsigned int i = 1; i < N; ++i)
+        for (unsigned int j = 0; j < i; ++j)
+            a(i, j) = a(j, i);
+}
+
+/**
+ * Invert a two by two matrix, the same way NBMath::invert2by2 does.
+ */
+inline FixedMatrix<2, 2> invert2by2(const FixedMatrix<2, 2>& m)
+{
+    const float det = 1.0f / (m(0,0) * m(1,1) - m(0,1) * m(1,0));
+    FixedMatrix<2, 2> inv;
+    inv(0,0) = det * m(1,1);
+    inv(0,1) = det * -m(0,1);
+    inv(1,0) = det * -m(1,0);
+    inv(1,1) = det * m(0,0);
+    return inv;
+}
+
+/**
+ * Invert a square matrix by LU decomposition with partial pivoting, the
+ * same way NBMath::solve(A, identity) does, and throws the same thing it
+ * does when A is singular.
+ */
+template <unsigned int N>
+inline FixedMatrix<N, N> invert(FixedMatrix<N, N> a)
+{
+    unsigned int perm[N];
+    for (unsigned int i = 0; i < N; ++i)
+        perm[i] = i;
+
+    // Doolittle LU in place, L below the diagonal with an implied unit
+    // diagonal, U on and above it
+    for (unsigned int k = 0; k < N; ++k) {
+        unsigned int pivot = k;
+        for (unsigned int i = k + 1; i < N; ++i)
+            if (a(i, k) * a(i, k) > a(pivot, k) * a(pivot, k))
+                pivot = i;
+        if (a(pivot, k) == 0.0f)
+            throw "the system had no solution";
+        if (pivot != k) {
+            for (unsigned int j = 0; j < N; ++j) {
+                const float t = a(k, j);
+                a(k, j) = a(pivot, j);
+                a(pivot, j) = t;
+            }
+            const unsigned int t = perm[k];
+            perm[k] = perm[pivot];
+            perm[pivot] = t;
+        }
+        const float r = 1.0f / a(k, k);
+        for (unsigned int i = k + 1; i < N; ++i) {
+            a(i, k) *= r;
+            for (unsigned int j = k + 1; j < N; ++j)
+                a(i, j) -= a(i, k) * a(k, j);
+        }
+    }
+
+    // Solve L U x = P e_c for every column c
+    FixedMatrix<N, N> inv;
+    for (unsigned int c = 0; c < N; ++c) {
+        float x[N];
+        for (unsigned int i = 0; i < N; ++i) {
+            float s = (perm[i] == c) ? 1.0f : 0.0f;
+            for (unsigned int j = 0; j < i; ++j)
+                s -= a(i, j) * x[j];
+            x[i] = s;
+        }
+        for (unsigned int i = N; i-- > 0; ) {
+            float s = x[i];
+            for (unsigned int j = i + 1; j < N; ++j)
+                s -= a(i, j) * x[j];
+            x[i] = s / a(i, i);
+        }
+        for (unsigned int i = 0; i < N; ++i)
+            inv(i, c) = x[i];
+    }
+    return inv;
+}
+
+/**
+ * Two by two matrices are inverted in closed form.
+ */
+inline FixedMatrix<2, 2> invert(const FixedMatrix<2, 2>& m)
+{
+    return invert2by2(m);
+}
+
+// Printed the way uBLAS prints, for the filters' debug output
+
+template <unsigned int N>
+std::ostream& operator<<(std::ostream& o, const FixedVector<N>& x)
+{
+    o << "[" << N << "](";
+    for (unsigned int i = 0; i < N; ++i)
+        o << (i ? "," : "") << x(i);
+    return o << ")";
+}
+
+template <unsigned int R, unsigned int C>
+std::ostream& operator<<(std::ostream& o, const FixedMatrix<R, C>& a)
+{
+    o << "[" << R << "," << C << "](";
+    for (unsigned int i = 0; i < R; ++i) {
+        o << (i ? ",(" : "(");
+        for (unsigned int j = 0; j < C; ++j)
+            o << (j ? "," : "") << a(i, j);
+        o << ")";
+    }
+    return o << ")";
+}
+
+}
+
+#endif /* NBFixedMatrix_h_DEFINED */
@@ -0,0 +1,94 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Philox4x32-10, the counter based random number generator of Salmon et
+ * al., "Parallel Random Numbers: As Easy as 1, 2, 3" (SC11).
+ *
+ * There is no state to advance: the same key and counter always give the
+ * same four 32 bit words, and different counters give independent ones.
+ * That lets every thread draw its own numbers without locks, and makes the
+ * numbers depend only on what they are for (which particle, which frame)
+ * instead of on the order threads happened to ask for them.  rand() gives
+ * neither: it takes libc's lock on every call and its sequence depends on
+ * who called it first.
+ *
+ * Checked against the Random123 known answers by noggin/offline/mclTest.
+ */
+
+#ifndef Philox_h_DEFINED
+#define Philox_h_DEFINED
+
+#include <stdint.h>
+
+class Philox
+{
+public:
+    explicit Philox(uint32_t seed0 = 0, uint32_t seed1 = 0) {
+        key[0] = seed0;
+        key[1] = seed1;
+    }
+
+    /**
+     * Fills out with the four words for the counter (c0, c1, c2, c3).
+     */
+    void operator()(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3,
+                    uint32_t out[4]) const {
+        uint32_t k0 = key[0], k1 = key[1];
+        out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+        for (int r = 0; r < ROUNDS; ++r) {
+            if (r > 0) {
+                k0 += W0;
+                k1 += W1;
+            }
+            const uint64_t p0 = static_cast<uint64_t>(M0) * out[0];
+            const uint64_t p1 = static_cast<uint64_t>(M1) * out[2];
+            const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32);
+            const uint32_t lo0 = static_cast<uint32_t>(p0);
+            const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32);
+            const uint32_t lo1 = static_cast<uint32_t>(p1);
+            out[0] = hi1 ^ out[1] ^ k0;
+            out[1] = lo1;
+            out[2] = hi0 ^ out[3] ^ k1;
+            out[3] = lo0;
+        }
+    }
+
+    /**
+     * A word turned into a float uniform on (0, 1], never 0 so it is safe
+     * to take the log of.
+     */
+    static float uniform(uint32_t x) {
+        return (static_cast<float>(x >> 8) + 1.0f) * (1.0f / 16777216.0f);
+    }
+
+    uint32_t getKey0() const { return key[0]; }
+    uint32_t getKey1() const { return key[1]; }
+
+private:
+    static const int ROUNDS = 10;
+    static const uint32_t M0 = 0xD2511F53u;
+    static const uint32_t M1 = 0xCD9E8D57u;
+    static const uint32_t W0 = 0x9E3779B9u;
+    static const uint32_t W1 = 0xBB67AE85u;
+
+    uint32_t key[2];
+};
+
+#endif /* Philox_h_DEFINED */
@@ -0,0 +1,99 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * One writer, one reader, no locks and no waiting on either side.
+ *
+ * There are three copies of the value.  The writer fills in its own copy
+ * and publishes it by swapping it with the middle one, and the reader
+ * takes the middle one by swapping it with its own.  Each swap is one
+ * compare and swap on the word that says which copy is in the middle and
+ * whether it is newer than the reader's, so neither side ever waits for
+ * the other, even if the other is preempted half way through.  Unlike a
+ * SeqLock that makes it safe for a reader that runs at a higher priority
+ * than the writer on the same core, which could spin forever on a SeqLock.
+ *
+ * The reader sees the newest value published before its last update(), and
+ * keeps it until the next update() that finds a newer one.
+ *
+ * T must be a POD, the buffers start out zeroed with memset.
+ */
+
+#ifndef TripleBuffer_h_DEFINED
+#define TripleBuffer_h_DEFINED
+
+#include <cstring>
+
+template <class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : writing(0), middle(1), reading(2) {
+        memset(buffers, 0, sizeof(buffers));
+    }
+
+    /*
+     * Writer side, only one thread may write.
+     */
+    T& writeBuffer() { return buffers[writing]; }
+
+    // Makes the write buffer the newest value and gives the writer another
+    void publish() {
+        unsigned int old;
+        do {
+            old = middle;
+        } while (!__sync_bool_compare_and_swap(&middle, old, writing | FRESH));
+        writing = old & INDEX;
+    }
+
+    /*
+     * Reader side, only one thread may read.
+     */
+
+    // Takes the newest value, if there is one newer than the last taken.
+    // Returns whether there was.
+    bool update() {
+        if (!(middle & FRESH))
+            return false;
+
+        unsigned int old;
+        do {
+            old = middle;
+        } while (!__sync_bool_compare_and_swap(&middle, old, reading));
+        reading = old & INDEX;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[reading]; }
+
+private:
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+
+    static const unsigned int INDEX = 3;
+    static const unsigned int FRESH = 4;
+
+    T buffers[3];
+    unsigned int writing;
+    // The middle buffer's index, and FRESH if the reader hasn't taken it
+    volatile unsigned int middle;
+    unsigned int reading;
+};
+
+#endif /* TripleBuffer_h_DEFINED */
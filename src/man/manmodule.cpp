@@ -19,6 +19,7 @@
 #ifndef _WIN32
 #include <signal.h>
 #endif
+#include <cstdlib>
 
 #include "altypes.h"
 #include "alxplatform.h"
@@ -51,6 +52,7 @@ typedef TTMan ALMan;
 
 #include "ALTranscriber.h"
 #include "ALImageTranscriber.h"
+#include "FakeImageTranscriber.h"
 
 #include "NaoLights.h"
 
@@ -68,7 +70,7 @@ static shared_ptr<ALMan> man;
 static shared_ptr<Sensors> sensors;
 static shared_ptr<Synchro> synchro;
 static shared_ptr<ALTranscriber> transcriber;
-static shared_ptr<ALImageTranscriber> imageTranscriber;
+static shared_ptr<ThreadedImageTranscriber> imageTranscriber;
 static shared_ptr<EnactorT> enactor;
 static shared_ptr<Lights> lights;
 
@@ -85,9 +87,17 @@ void ALCreateMan( ALPtr<ALBroker> broker){
     synchro = shared_ptr<Synchro>(new Synchro());
     sensors = shared_ptr<Sensors>(new Sensors);
     transcriber = shared_ptr<ALTranscriber>(new ALTranscriber(broker,sensors));
-    imageTranscriber =
-        shared_ptr<ALImageTranscriber>
-        (new ALImageTranscriber(synchro, sensors, broker));
+    // Set NBITES_FAKE_FRAMES to a folder of .NBFRM files to run vision on
+    // them instead of the camera
+    const char *fakeFrames = getenv("NBITES_FAKE_FRAMES");
+    if (fakeFrames != NULL)
+        imageTranscriber =
+            shared_ptr<ThreadedImageTranscriber>
+            (new FakeImageTranscriber(synchro, sensors, fakeFrames));
+    else
+        imageTranscriber =
+            shared_ptr<ThreadedImageTranscriber>
+            (new ALImageTranscriber(synchro, sensors, broker));
 
 #ifdef USE_DCM
     enactor = shared_ptr<EnactorT>(new EnactorT(sensors,
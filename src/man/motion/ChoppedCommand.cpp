@@ -112,7 +112,7 @@ vector<float> ChoppedCommand::getFinalJoints(const JointCommand *command,
 
 }
 
-const vector<float>
+const vector<float>&
 ChoppedCommand::getStiffness( ChainID chainID ) const
 {
     switch (chainID) {
@@ -22,11 +22,11 @@ class ChoppedCommand
 
     ChoppedCommand ( const JointCommand *command, int chops );
 
-    virtual std::vector<float> getNextJoints(int id) {
-        return std::vector<float>(0);
-    }
+    // Fills in the chain_lengths[id] joints of the chain for the next frame.
+    // The empty command has none to give.
+    virtual void getNextJoints(int id, float joints[]) { }
 
-    const std::vector<float> getStiffness( Kinematics::ChainID chaindID) const;
+    const std::vector<float>& getStiffness( Kinematics::ChainID chaindID) const;
     bool isDone() const { return finished; }
 
  protected:
@@ -115,12 +115,11 @@ void HeadProvider::setMode(){
 
 
     //update the chain angles
-    float newHeads[Kinematics::HEAD_JOINTS] = {lastYawDest,lastPitchDest};
-    vector<float> newChainAngles  =
-        vector<float>(newHeads,newHeads + Kinematics::HEAD_JOINTS);
-    setNextChainJoints(HEAD_CHAIN,newChainAngles);
+    const float newHeads[Kinematics::HEAD_JOINTS] = {lastYawDest,lastPitchDest};
+    setNextChainJoints(HEAD_CHAIN,newHeads);
 
-    vector<float> head_gains(HEAD_JOINTS, headSetStiffness);
+    const float head_gains[Kinematics::HEAD_JOINTS] = {headSetStiffness,
+                                                       headSetStiffness};
     //Return the stiffnesses for each joint
     setNextChainStiffnesses(HEAD_CHAIN,head_gains);
 }
@@ -129,18 +128,20 @@ void HeadProvider::scriptedMode(){
     if ( currCommand->isDone() )
         setNextHeadCommand();
 
+    float heads[HEAD_JOINTS];
     if (!currCommand->isDone() ) {
-        setNextChainJoints( HEAD_CHAIN,
-							currCommand->getNextJoints(HEAD_CHAIN) );
+        currCommand->getNextJoints(HEAD_CHAIN, heads);
+        setNextChainJoints( HEAD_CHAIN, heads );
 		setNextChainStiffnesses( Kinematics::HEAD_CHAIN,
 								 currCommand->getStiffness(
 									 Kinematics::HEAD_CHAIN) );
 
     }
     else {
-        setNextChainJoints( HEAD_CHAIN, getCurrentHeads() );
-		setNextChainStiffnesses( Kinematics::HEAD_CHAIN,
-								 vector<float>(HEAD_JOINTS, 0.0f) );
+        static const float noStiffness[HEAD_JOINTS] = {0.0f, 0.0f};
+        getCurrentHeads(heads);
+        setNextChainJoints( HEAD_CHAIN, heads );
+		setNextChainStiffnesses( Kinematics::HEAD_CHAIN, noStiffness );
     }
 
 
@@ -197,15 +198,13 @@ void HeadProvider::setNextHeadCommand() {
 
 }
 
-vector<float> HeadProvider::getCurrentHeads() {
-    vector<float> currentHeads(HEAD_JOINTS);
-    const vector<float> currentJoints = sensors->getMotionBodyAngles();
+void HeadProvider::getCurrentHeads(float heads[]) {
+    float currentJoints[NUM_ACTUATORS];
+    sensors->getMotionBodyAngles(currentJoints);
 
     for (unsigned int i=0; i<HEAD_JOINTS ; i++) {
-        currentHeads[i] = currentJoints[i];
+        heads[i] = currentJoints[i];
     }
-
-    return currentHeads;
 }
 
 void HeadProvider::setActive(){
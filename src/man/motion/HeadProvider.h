@@ -81,7 +81,7 @@ private:
 
     pthread_mutex_t head_provider_mutex;
 
-    std::vector<float> getCurrentHeads();
+    void getCurrentHeads(float heads[]);
     void setNextHeadCommand();
 };
 
@@ -90,7 +90,7 @@ vector<float>* LinearChoppedCommand::getDiffChain(int id) {
 	}
 }
 
-vector<float> LinearChoppedCommand::getNextJoints(int id) {
+void LinearChoppedCommand::getNextJoints(int id, float joints[]) {
 
 	if (numChopped.at(id) <= numChops) {
 		// Increment the current chain
@@ -99,14 +99,11 @@ vector<float> LinearChoppedCommand::getNextJoints(int id) {
 		// Since we changed the command's current status, we
 		// need to check to see if it's finished yet.
 		checkDone();
-
-		// Return a copy of the current chain at this id
-		return *getCurrentChain(id);
-
-	} else {
-		// Don't increment anymore and just return the current chain
-		return *getCurrentChain(id);
 	}
+	// Otherwise don't increment anymore and just give the current chain
+
+	const vector<float> *currentChain = getCurrentChain(id);
+	copy(currentChain->begin(), currentChain->end(), joints);
 }
 vector<float>* LinearChoppedCommand::getCurrentChain(int id) {
 	switch (id) {
@@ -20,7 +20,7 @@ public:
 
 	virtual ~LinearChoppedCommand(void) {  };
 
-	virtual std::vector<float> getNextJoints(int id);
+	virtual void getNextJoints(int id, float joints[]);
 
 private:
 	// Current Joint Chains
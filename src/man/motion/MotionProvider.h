@@ -29,6 +29,7 @@
 #ifndef _MotionProvider_h_DEFINED
 #define _MotionProvider_h_DEFINED
 
+#include <cstring>
 #include <vector>
 #include <string>
 #include "MotionCommand.h"
@@ -51,10 +52,12 @@ public:
     MotionProvider(ProviderType _provider_type,
 				   boost::shared_ptr<Profiler> p)
         : profiler(p),_active(false), _stopping(false),
-          nextJoints(Kinematics::NUM_CHAINS,std::vector<float>()),
-          nextStiffnesses(Kinematics::NUM_CHAINS,std::vector<float>()),
           provider_type(_provider_type)
           {
+              for (unsigned int i = 0; i < Kinematics::NUM_JOINTS; i++) {
+                  nextJoints[i] = 0.0f;
+                  nextStiffnesses[i] = 0.0f;
+              }
               switch(provider_type){
               case SCRIPTED_PROVIDER:
                   provider_name = "ScriptedProvider";
@@ -86,21 +89,12 @@ public:
     const bool isActive() const { return _active; }
     const bool isStopping() const {return _stopping;}
     virtual void calculateNextJointsAndStiffnesses() = 0;
-    std::vector<float> getChainJoints(const Kinematics::ChainID id) {
-        if(nextJoints[id].size() != Kinematics::chain_lengths[id]){
-            std::cout << "Getting joints in " << *this <<" and the length of the "
-                 <<id<<"th stiffness vector is "<<nextJoints[id].size()
-                      <<" not " <<Kinematics::chain_lengths[id]<<std::endl;
-        }
-        return nextJoints[id];
+    // Each returns chain_lengths[id] values, good until the next frame
+    const float* getChainJoints(const Kinematics::ChainID id) const {
+        return &nextJoints[Kinematics::chain_first_joint[id]];
     }
-    std::vector<float> getChainStiffnesses(const Kinematics::ChainID id){
-        if(nextStiffnesses[id].size() != Kinematics::chain_lengths[id]){
-            std::cout << "Getting stiffness in " << *this <<" and the length of the "
-                 <<id<<"th stiffness vector is "<<nextStiffnesses[id].size()
-                      <<" not " <<Kinematics::chain_lengths[id]<<std::endl;
-        }
-        return nextStiffnesses[id];
+    const float* getChainStiffnesses(const Kinematics::ChainID id) const {
+        return &nextStiffnesses[Kinematics::chain_first_joint[id]];
     }
     const std::string getName() const {return provider_name;}
     const ProviderType getType() const {return provider_type;}
@@ -118,13 +112,28 @@ public:
 
 protected:
     void setNextChainJoints(const Kinematics::ChainID id,
-                            const std::vector <float> &chainJoints) {
-        nextJoints[id] = chainJoints;
+                            const float chainJoints[]) {
+        memcpy(&nextJoints[Kinematics::chain_first_joint[id]], chainJoints,
+               Kinematics::chain_lengths[id] * sizeof(float));
     }
 
     void setNextChainStiffnesses(const Kinematics::ChainID id,
+                                 const float chainStiffnesses[]) {
+        memcpy(&nextStiffnesses[Kinematics::chain_first_joint[id]],
+               chainStiffnesses, Kinematics::chain_lengths[id] * sizeof(float));
+    }
+
+    // For the providers working from commands, which hold vectors
+    void setNextChainJoints(const Kinematics::ChainID id,
                             const std::vector <float> &chainJoints) {
-        nextStiffnesses[id] = chainJoints;
+        if (checkChainLength(id, chainJoints, "joints"))
+            setNextChainJoints(id, &chainJoints[0]);
+    }
+
+    void setNextChainStiffnesses(const Kinematics::ChainID id,
+                                 const std::vector <float> &chainStiffnesses) {
+        if (checkChainLength(id, chainStiffnesses, "stiffnesses"))
+            setNextChainStiffnesses(id, &chainStiffnesses[0]);
     }
 
     //Method that must be implemented, and called at the end of each frame
@@ -136,6 +145,20 @@ protected:
     void active() { _active = true; }
     void inactive() { _active = false; _stopping = false; }
 
+private:
+    bool checkChainLength(const Kinematics::ChainID id,
+                          const std::vector <float> &values,
+                          const char *what) const {
+        if(values.size() != Kinematics::chain_lengths[id]){
+            std::cout << "Setting " << what << " in " << *this
+                      << " and the length of the " << id << "th vector is "
+                      << values.size() << " not "
+                      << Kinematics::chain_lengths[id] << std::endl;
+            return false;
+        }
+        return true;
+    }
+
 protected:
 	boost::shared_ptr<Profiler> profiler;
 
@@ -143,8 +166,9 @@ private:
 
     bool _active;
     bool _stopping;
-    std::vector < std::vector <float> > nextJoints;
-    std::vector < std::vector <float> > nextStiffnesses;
+    // In joint order, a chain at a time
+    float nextJoints[Kinematics::NUM_JOINTS];
+    float nextStiffnesses[Kinematics::NUM_JOINTS];
 
     const ProviderType provider_type;
     std::string provider_name;
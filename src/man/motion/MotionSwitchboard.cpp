@@ -1,4 +1,6 @@
 
+#include <algorithm>
+#include <cstdio>
 #include <vector>
 using namespace std;
 
@@ -7,6 +9,7 @@ using namespace boost;
 
 #include "MotionSwitchboard.h"
 #include "NBMatrixMath.h"
+#include "Common.h"
 using namespace Kinematics;
 using namespace NBMath;
 //#define DEBUG_SWITCHBOARD
@@ -33,21 +36,27 @@ MotionSwitchboard::MotionSwitchboard(shared_ptr<Sensors> s,
 	  nextProvider(&nullBodyProvider),
       curHeadProvider(&nullHeadProvider),
       nextHeadProvider(&nullHeadProvider),
-      sensorAngles(s->getBodyAngles()),
-      nextJoints(sensorAngles),
-      nextStiffnesses(vector<float>(NUM_JOINTS,0.0f)),
-      lastJoints(sensorAngles),
 	  running(false),
-      newJoints(false),
       readyToSend(false),
+      framesSignaled(0),
+      framesRun(0),
       noWalkTransitionCommand(true)
+#ifdef LOG_MOTION_LATENCY
+    , frameSignaledAt(0),
+      firstSignaledAt(0),
+      latencies(LATENCY_LOG_FRAMES),
+      numLatencies(0)
+#endif
 {
+    sensors->getBodyAngles(sensorAngles);
+    memcpy(nextJoints, sensorAngles, sizeof(nextJoints));
+    memcpy(lastJoints, sensorAngles, sizeof(lastJoints));
+    for (unsigned int i = 0; i < NUM_JOINTS; i++)
+        nextStiffnesses[i] = 0.0f;
+    publishFrame();
 
-    //Allow safe access to the next joints
-    pthread_mutex_init(&next_joints_mutex, NULL);
     pthread_mutex_init(&next_provider_mutex, NULL);
     pthread_mutex_init(&calc_new_joints_mutex, NULL);
-    pthread_mutex_init(&stiffness_mutex, NULL);
     pthread_cond_init(&calc_new_joints_cond,NULL);
 
 #ifdef DEBUG_JOINTS_OUTPUT
@@ -68,10 +77,8 @@ MotionSwitchboard::MotionSwitchboard(shared_ptr<Sensors> s,
 }
 
 MotionSwitchboard::~MotionSwitchboard() {
-    pthread_mutex_destroy(&next_joints_mutex);
     pthread_mutex_destroy(&next_provider_mutex);
     pthread_mutex_destroy(&calc_new_joints_mutex);
-    pthread_mutex_destroy(&stiffness_mutex);
     pthread_cond_destroy(&calc_new_joints_cond);
 
 #ifdef DEBUG_JOINTS_OUTPUT
@@ -105,10 +112,10 @@ void MotionSwitchboard::stop() {
 /**
  * The switchboard run method is continuously looping. At each iteration
  * it grabs the appropriate joints from the designated provider, and
- * then copies them into place so an enactor can send them to the low level.
- * This threaed then 'hangs' until the enactor signals it has read the current
- * values. (This signaling is actually done in the getNextJoints method in
- * this class)
+ * then publishes them so an enactor can send them to the low level.
+ * This threaed then 'hangs' until the enactor signals it has posted the
+ * new sensor values. (This signaling is actually done in the
+ * signalNextFrame method in this class)
  *
  * Potential problems: If the processing for the next joints
  * takes too long, the enactor will send old joints.
@@ -116,13 +123,13 @@ void MotionSwitchboard::stop() {
 void MotionSwitchboard::run() {
     static int fcount = 0;
 
+    profiler->registerThread("motion");
+
     //IMPORTANT Before anything else happens we need to put the correct
     //angles into sensors->motionBodyAngles:
     sensors->setMotionBodyAngles(sensors->getBodyAngles());
 
-    pthread_mutex_lock(&calc_new_joints_mutex);
-    pthread_cond_wait(&calc_new_joints_cond, &calc_new_joints_mutex);
-    pthread_mutex_unlock(&calc_new_joints_mutex);
+    waitForNextFrame();
 
     while(running) {
 		PROF_ENTER(profiler, P_SWITCHBOARD);
@@ -132,8 +139,13 @@ void MotionSwitchboard::run() {
         processJoints();
         processStiffness();
         bool active  = postProcess();
+        publishFrame();
 		PROF_EXIT(profiler, P_SWITCHBOARD);
 
+#ifdef LOG_MOTION_LATENCY
+        logLatency();
+#endif
+
         if(active)
         {
             readyToSend = true;
@@ -142,14 +154,38 @@ void MotionSwitchboard::run() {
 #endif
         }
 
-        pthread_mutex_lock(&calc_new_joints_mutex);
-        pthread_cond_wait(&calc_new_joints_cond, &calc_new_joints_mutex);
-        pthread_mutex_unlock(&calc_new_joints_mutex);
+        waitForNextFrame();
         fcount++;
     }
+#ifdef LOG_MOTION_LATENCY
+    writeLatencyLog();
+#endif
     cout << "Switchboard run has exited" <<endl;
 }
 
+/**
+ * Sleeps until an enactor signals the next frame, or goes straight on if one
+ * did while the last frame was running.  Several signals in that time are
+ * only one frame, since we want the newest sensors and the DCM slots for the
+ * others have gone by.
+ */
+void MotionSwitchboard::waitForNextFrame()
+{
+    pthread_mutex_lock(&calc_new_joints_mutex);
+    while (running && framesSignaled == framesRun)
+        pthread_cond_wait(&calc_new_joints_cond, &calc_new_joints_mutex);
+#ifdef LOG_MOTION_LATENCY
+    thisFrame.signaled = frameSignaledAt;
+    thisFrame.missed = framesSignaled - framesRun - 1;
+#endif
+    framesRun = framesSignaled;
+    pthread_mutex_unlock(&calc_new_joints_mutex);
+
+#ifdef LOG_MOTION_LATENCY
+    thisFrame.woken = static_cast<int>(micro_time() - thisFrame.signaled);
+#endif
+}
+
 void MotionSwitchboard::preProcess()
 {
     pthread_mutex_lock(&next_provider_mutex);
@@ -173,52 +209,37 @@ void MotionSwitchboard::processJoints()
  * too much too it:
  */
 void MotionSwitchboard::processStiffness(){
-    try{
-        if(curHeadProvider->isActive()){
-            const vector <float > headStiffnesses =
-                curHeadProvider->getChainStiffnesses(HEAD_CHAIN);
-
-            pthread_mutex_lock(&stiffness_mutex);
+    if(curHeadProvider->isActive()){
+        const float *headStiffnesses =
+            curHeadProvider->getChainStiffnesses(HEAD_CHAIN);
 
-            for(unsigned int i = 0; i < HEAD_JOINTS; i ++){
-                nextStiffnesses[HEAD_YAW + i] = headStiffnesses.at(i);
-            }
-
-            pthread_mutex_unlock(&stiffness_mutex);
+        for(unsigned int i = 0; i < HEAD_JOINTS; i ++){
+            nextStiffnesses[HEAD_YAW + i] = headStiffnesses[i];
         }
+    }
 
-        if(curProvider->isActive()){
-            const vector <float > llegStiffnesses =
-                curProvider->getChainStiffnesses(LLEG_CHAIN);
-
-            const vector <float > rlegStiffnesses =
-                curProvider->getChainStiffnesses(RLEG_CHAIN);
-
-            const vector <float > rarmStiffnesses =
-                curProvider->getChainStiffnesses(RARM_CHAIN);
-
-            const vector <float > larmStiffnesses =
-                curProvider->getChainStiffnesses(LARM_CHAIN);
+    if(curProvider->isActive()){
+        const float *llegStiffnesses =
+            curProvider->getChainStiffnesses(LLEG_CHAIN);
 
-            pthread_mutex_lock(&stiffness_mutex);
+        const float *rlegStiffnesses =
+            curProvider->getChainStiffnesses(RLEG_CHAIN);
 
-            for(unsigned int i = 0; i < LEG_JOINTS; i ++){
-                nextStiffnesses[L_HIP_YAW_PITCH + i] = llegStiffnesses.at(i);
-                nextStiffnesses[R_HIP_YAW_PITCH + i] = rlegStiffnesses.at(i);
-            }
+        const float *rarmStiffnesses =
+            curProvider->getChainStiffnesses(RARM_CHAIN);
 
-            for(unsigned int i = 0; i < ARM_JOINTS; i ++){
-                nextStiffnesses[L_SHOULDER_PITCH + i] = larmStiffnesses.at(i);
-                nextStiffnesses[R_SHOULDER_PITCH + i] = rarmStiffnesses.at(i);
-            }
+        const float *larmStiffnesses =
+            curProvider->getChainStiffnesses(LARM_CHAIN);
 
-            pthread_mutex_unlock(&stiffness_mutex);
+        for(unsigned int i = 0; i < LEG_JOINTS; i ++){
+            nextStiffnesses[L_HIP_YAW_PITCH + i] = llegStiffnesses[i];
+            nextStiffnesses[R_HIP_YAW_PITCH + i] = rlegStiffnesses[i];
         }
-    }
 
-    catch(std::out_of_range & e){
-        cout << "Out of range exception caught in processStiffness"<< e.what()<<endl;
-        exit(0);
+        for(unsigned int i = 0; i < ARM_JOINTS; i ++){
+            nextStiffnesses[L_SHOULDER_PITCH + i] = larmStiffnesses[i];
+            nextStiffnesses[R_SHOULDER_PITCH + i] = rarmStiffnesses[i];
+        }
     }
 }
 
@@ -226,8 +247,6 @@ void MotionSwitchboard::processStiffness(){
 bool MotionSwitchboard::postProcess(){
     pthread_mutex_lock(&next_provider_mutex);
 
-    newJoints = true;
-
     //Make sure that if the current provider just became inactive,
     //and we have the next provider ready, then we want to swap to ensure
     //that we never have an inactive provider when an active one is potentially
@@ -268,14 +287,16 @@ void MotionSwitchboard::processHeadJoints()
 		curHeadProvider->calculateNextJointsAndStiffnesses();
 
 		// get headJoints from headProvider
-		vector <float > headJoints = curHeadProvider->getChainJoints(HEAD_CHAIN);
+		float headJoints[HEAD_JOINTS];
+		memcpy(headJoints, curHeadProvider->getChainJoints(HEAD_CHAIN),
+		       sizeof(headJoints));
 
         clipHeadJoints(headJoints);
 
         for(unsigned int i = FIRST_HEAD_JOINT;
             i < FIRST_HEAD_JOINT + HEAD_JOINTS; i++)
         {
-            nextJoints[i] = headJoints.at(i);
+            nextJoints[i] = headJoints[i];
         }
 
 #ifdef DEBUG_SWITCHBOARD
@@ -305,29 +326,25 @@ void MotionSwitchboard::processBodyJoints()
     {
 		//Request new joints
 		curProvider->calculateNextJointsAndStiffnesses();
-		const vector <float > llegJoints = curProvider->getChainJoints(LLEG_CHAIN);
-		const vector <float > rlegJoints = curProvider->getChainJoints(RLEG_CHAIN);
-		const vector <float > rarmJoints = curProvider->getChainJoints(RARM_CHAIN);
-
-		const vector <float > larmJoints = curProvider->getChainJoints(LARM_CHAIN);
+		const float *llegJoints = curProvider->getChainJoints(LLEG_CHAIN);
+		const float *rlegJoints = curProvider->getChainJoints(RLEG_CHAIN);
+		const float *rarmJoints = curProvider->getChainJoints(RARM_CHAIN);
 
-		//Copy the new values into place, and wait to be signaled.
-		pthread_mutex_lock(&next_joints_mutex);
+		const float *larmJoints = curProvider->getChainJoints(LARM_CHAIN);
 
+		//Copy the new values into place, to be published with the rest
         for(unsigned int i = 0; i < LEG_JOINTS; i ++)
         {
-            nextJoints[R_HIP_YAW_PITCH + i] = rlegJoints.at(i);
-            nextJoints[L_HIP_YAW_PITCH + i] = llegJoints.at(i);
+            nextJoints[R_HIP_YAW_PITCH + i] = rlegJoints[i];
+            nextJoints[L_HIP_YAW_PITCH + i] = llegJoints[i];
         }
 
         for(unsigned int i = 0; i < ARM_JOINTS; i ++)
         {
-            nextJoints[L_SHOULDER_PITCH + i] = larmJoints.at(i);
-            nextJoints[R_SHOULDER_PITCH + i] = rarmJoints.at(i);
+            nextJoints[L_SHOULDER_PITCH + i] = larmJoints[i];
+            nextJoints[R_SHOULDER_PITCH + i] = rarmJoints[i];
         }
 
-        pthread_mutex_unlock(&next_joints_mutex);
-
 #ifdef DEBUG_SWITCHBOARD
         switchedToInactive = false;
 #endif
@@ -397,7 +414,7 @@ void MotionSwitchboard::preProcessBody()
 	}
 }
 
-void MotionSwitchboard::clipHeadJoints(vector<float>& joints)
+void MotionSwitchboard::clipHeadJoints(float joints[])
 {
     float yaw = fabs(joints[HEAD_YAW]);
     float pitch = joints[HEAD_PITCH];
@@ -484,7 +501,9 @@ void MotionSwitchboard::safetyCheckJoints()
  */
 void MotionSwitchboard::swapBodyProvider(){
     std::vector<BodyJointCommand *> gaitSwitches;
+#ifdef DEBUG_SWITCHBOARD
     std::string old_provider = curProvider->getName();
+#endif
 
     switch(nextProvider->getType())
     {
@@ -530,36 +549,94 @@ void MotionSwitchboard::swapHeadProvider(){
     }
 }
 
-const vector <float> MotionSwitchboard::getNextJoints() const {
-    pthread_mutex_lock(&next_joints_mutex);
+/**
+ * Hands the frame just finished to the enactor.  Only the switchboard
+ * thread writes it, and the enactor's reads never hold it up.
+ */
+void MotionSwitchboard::publishFrame(){
+    MotionFrame& frame = publishedFrame.writeBuffer();
+    memcpy(frame.joints, nextJoints, sizeof(nextJoints));
+    memcpy(frame.stiffnesses, nextStiffnesses, sizeof(nextStiffnesses));
+    publishedFrame.publish();
+}
+
+void MotionSwitchboard::getNextJoints(float joints[]) const {
+    const bool newJoints = publishedFrame.update();
 #ifndef WEBOTS_BACKEND
     if(!newJoints && readyToSend){
         cout << "An enactor is grabbing old joints from switchboard."
              <<" Must have missed a frame!" <<endl;
     }
 #endif
-    const vector <float> vec(nextJoints);
-    newJoints = false;
-
-    pthread_mutex_unlock(&next_joints_mutex);
-
-    return vec;
+    memcpy(joints, publishedFrame.readBuffer().joints, sizeof(nextJoints));
 }
 
-const vector<float>  MotionSwitchboard::getNextStiffness() const{
-    pthread_mutex_lock(&stiffness_mutex);
-    vector<float> result(nextStiffnesses);
-    pthread_mutex_unlock(&stiffness_mutex);
-    return result;
+void MotionSwitchboard::getNextStiffness(float stiffnesses[]) const{
+    memcpy(stiffnesses, publishedFrame.readBuffer().stiffnesses,
+           sizeof(nextStiffnesses));
 }
 
 void MotionSwitchboard::signalNextFrame(){
+#ifdef LOG_MOTION_LATENCY
+    const long long now = micro_time();
+#endif
     pthread_mutex_lock(&calc_new_joints_mutex);
+#ifdef LOG_MOTION_LATENCY
+    frameSignaledAt = now;
+#endif
+    ++framesSignaled;
     pthread_cond_signal(&calc_new_joints_cond);
     pthread_mutex_unlock(&calc_new_joints_mutex);
 
 }
 
+#ifdef LOG_MOTION_LATENCY
+void MotionSwitchboard::logLatency(){
+    if (numLatencies == 0)
+        firstSignaledAt = thisFrame.signaled;
+
+    thisFrame.published = static_cast<int>(micro_time() - thisFrame.signaled);
+    latencies[numLatencies % LATENCY_LOG_FRAMES] = thisFrame;
+    latencies[numLatencies % LATENCY_LOG_FRAMES].signaled -= firstSignaledAt;
+    ++numLatencies;
+}
+
+/**
+ * Writes out the newest frames' times, oldest first, and sums them up on
+ * cout: the worst latency, the frames published a frame length or more
+ * after their signal, too late for their DCM slot, and the signals that
+ * came while a frame was still running, whose slots got old joints.
+ */
+void MotionSwitchboard::writeLatencyLog(){
+    const unsigned int logged = std::min(numLatencies, LATENCY_LOG_FRAMES);
+    const unsigned int first = numLatencies - logged;
+
+    FILE *log = fopen("/tmp/motion_latency.xls", "w");
+    if (log)
+        fprintf(log, "signaled\twoken\tpublished\tmissed\n");
+
+    int worst = 0;
+    unsigned int late = 0, missed = 0;
+    for (unsigned int i = first; i < numLatencies; ++i) {
+        const FrameLatency& frame = latencies[i % LATENCY_LOG_FRAMES];
+        if (log)
+            fprintf(log, "%lld\t%d\t%d\t%u\n", frame.signaled, frame.woken,
+                    frame.published, frame.missed);
+
+        worst = std::max(worst, frame.published);
+        if (frame.published >= MOTION_FRAME_LENGTH_uS)
+            ++late;
+        missed += frame.missed;
+    }
+    if (log)
+        fclose(log);
+
+    cout << "Motion latency: " << logged << " frames, worst "
+         << worst << " us, " << late << " late, "
+         << missed << " signals missed" << endl;
+}
+#endif
+
 
 /**
  * Checks to ensure that the current MotionBodyAngles are close enough to
@@ -571,8 +648,9 @@ int MotionSwitchboard::realityCheckJoints(){
     static const float head_joint_override_thresh = 0.3f;//need diff for head
 
     int changed = 0;
-    sensorAngles = sensors->getBodyAngles();
-    vector<float> motionAngles = sensors->getMotionBodyAngles();
+    float motionAngles[NUM_JOINTS];
+    sensors->getBodyAngles(sensorAngles);
+    sensors->getMotionBodyAngles(motionAngles);
 
     //HEAD ANGLES - handled separately to avoid trouble in HeadProvider
     for(unsigned int i = 0; i < HEAD_JOINTS; i++){
@@ -682,7 +760,6 @@ void MotionSwitchboard::closeDebugLogs(){
 void MotionSwitchboard::updateDebugLogs(){
     static float time = 0.0f;
 
-    pthread_mutex_lock(&next_joints_mutex);
     //print joints:
     fprintf(joints_log, "%f\t",time);
     for(unsigned int i = 0; i < NUM_JOINTS; i++)
@@ -700,15 +777,12 @@ void MotionSwitchboard::updateDebugLogs(){
         index += chain_lengths[chain];
     }
     fprintf(effector_log,"\n");
-    pthread_mutex_unlock(&next_joints_mutex);
 
     //Log the stiffnesses as well
-    pthread_mutex_lock(&stiffness_mutex);
     fprintf(stiffness_log, "%f\t",time);
     for(unsigned int i = 0; i < NUM_JOINTS; i++)
         fprintf(stiffness_log, "%f\t",nextStiffnesses[i]);
     fprintf(stiffness_log, "\n");
-    pthread_mutex_unlock(&stiffness_mutex);
 
 
     time += 0.05f;
@@ -26,6 +26,11 @@
  *
  * The appropriate MotionEnactor will then take the nextJoints and pass them
  * down to the robot/simulator correctly.
+ *
+ * Each frame's joints and stiffnesses are published through a TripleBuffer,
+ * so the enactor, which runs in the DCM's callbacks, takes the newest frame
+ * without ever waiting on the switchboard thread.  Only one enactor may
+ * read them.
  */
 
 #ifndef _MotionSwitchboard_h_DEFINED
@@ -37,6 +42,8 @@
 
 #include "motionconfig.h" // for cmake set debugging flags like MOTION_DEBUG
 
+#include "TripleBuffer.h"
+
 #include "MCL.h"
 #include "Kinematics.h"
 #include "WalkProvider.h"
@@ -60,6 +67,11 @@
 #  define DEBUG_JOINTS_OUTPUT
 #endif
 
+// Define to time every motion frame, from the enactor signalling it to the
+// switchboard publishing its joints.  The times go to /tmp/motion_latency.xls
+// when the switchboard stops.
+//#define LOG_MOTION_LATENCY
+
 
 class MotionSwitchboard {
 public:
@@ -71,8 +83,10 @@ public:
     void stop();
     void run();
 
-	const std::vector <float> getNextJoints() const;
-	const std::vector<float> getNextStiffness() const;
+    // Each copies NUM_JOINTS values into the enactor's array.  The
+    // stiffnesses are those of the frame the last getNextJoints() took.
+    void getNextJoints(float joints[]) const;
+    void getNextStiffness(float stiffnesses[]) const;
     void signalNextFrame();
 	void sendMotionCommand(const BodyJointCommand* command);
 	void sendMotionCommand(const HeadJointCommand* command);
@@ -102,6 +116,7 @@ public:
     }
 
 private:
+    void waitForNextFrame();
     void preProcess();
     void processJoints();
     void processStiffness();
@@ -110,11 +125,12 @@ private:
     void preProcessBody();
     void processHeadJoints();
     void processBodyJoints();
-    void clipHeadJoints(vector<float>& joints);
+    void clipHeadJoints(float joints[]);
     void safetyCheckJoints();
     void swapBodyProvider();
     void swapHeadProvider();
     int realityCheckJoints();
+    void publishFrame();
 
 #ifdef DEBUG_JOINTS_OUTPUT
     void initDebugLogs();
@@ -122,6 +138,11 @@ private:
     void updateDebugLogs();
 #endif
 
+#ifdef LOG_MOTION_LATENCY
+    void logLatency();
+    void writeLatencyLog();
+#endif
+
 private:
     boost::shared_ptr<Sensors> sensors;
 	boost::shared_ptr<Profiler> profiler;
@@ -137,15 +158,23 @@ private:
 	MotionProvider * curHeadProvider;
 	MotionProvider * nextHeadProvider;
 
-    std::vector <float> sensorAngles;
-    std::vector <float> nextJoints;
-    std::vector <float> nextStiffnesses;
-    std::vector <float> lastJoints;
+    // The switchboard thread's own, worked on during the frame
+    float sensorAngles[Kinematics::NUM_JOINTS];
+    float nextJoints[Kinematics::NUM_JOINTS];
+    float nextStiffnesses[Kinematics::NUM_JOINTS];
+    float lastJoints[Kinematics::NUM_JOINTS];
+
+    // What the enactors see, a copy of the above made at the end of a frame
+    struct MotionFrame {
+        float joints[Kinematics::NUM_JOINTS];
+        float stiffnesses[Kinematics::NUM_JOINTS];
+    };
+    // Read from the enactor's const getters
+    mutable TripleBuffer<MotionFrame> publishedFrame;
 
     bool running;
-	mutable bool newJoints; //Way to track if we ever use the same joints twice
 
-    bool readyToSend;
+    volatile bool readyToSend;
 
     static const float sitDownAngles[Kinematics::NUM_BODY_JOINTS];
 
@@ -153,8 +182,11 @@ private:
     pthread_cond_t  calc_new_joints_cond;
     mutable pthread_mutex_t calc_new_joints_mutex;
     mutable pthread_mutex_t next_provider_mutex;
-    mutable pthread_mutex_t next_joints_mutex;
-    mutable pthread_mutex_t stiffness_mutex;
+
+    // Frames the enactor has asked for and frames we have run, under
+    // calc_new_joints_mutex
+    unsigned int framesSignaled;
+    unsigned int framesRun;
 
     bool noWalkTransitionCommand;
 
@@ -164,6 +196,26 @@ private:
     FILE* effector_log;
 #endif
 
+#ifdef LOG_MOTION_LATENCY
+    // Microseconds, the signal time since the first frame's, the rest since
+    // the signal
+    struct FrameLatency {
+        long long signaled;
+        int woken;
+        int published;
+        // Signals that came while the frame before was still running
+        unsigned int missed;
+    };
+    static const unsigned int LATENCY_LOG_FRAMES = 1 << 16;
+
+    long long frameSignaledAt;  // under calc_new_joints_mutex
+    long long firstSignaledAt;
+    FrameLatency thisFrame;
+    // The newest LATENCY_LOG_FRAMES frames
+    std::vector<FrameLatency> latencies;
+    unsigned int numLatencies;
+#endif
+
 };
 
 #endif
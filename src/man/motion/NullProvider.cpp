@@ -52,29 +52,20 @@ void NullProvider::calculateNextJointsAndStiffnesses(){
     readNewStiffness();
 
     //transcode the appropriate stiffness and joint values
-    vector<float> curMotionAngles = sensors->getBodyAngles();
+    float curMotionAngles[NUM_ACTUATORS];
+    sensors->getBodyAngles(curMotionAngles);
 
     for(unsigned int chain = 0; chain < Kinematics::NUM_CHAINS; chain++){
         if( !chainMask[chain] )
             continue;
 
-        //Iterate through the 22 long list of stiff/joints and
-        //copy them into chain specific vectors to be sent to
-        //the motion provider super class, on a per chain basis
-        vector<float> chainJoints(Kinematics::chain_lengths[chain]);
-        vector<float> chainStiffness(Kinematics::chain_lengths[chain]);
-
-        unsigned int startI = Kinematics::chain_first_joint[chain];
-        unsigned int endI = Kinematics::chain_last_joint[chain];
-        for(unsigned int joint = startI, chain_joint = 0;
-            joint <= endI;
-            joint++,chain_joint++){
-            chainJoints[chain_joint] = curMotionAngles[joint];
-            chainStiffness[chain_joint] = nextStiffness[joint];
-        }
-        setNextChainJoints(static_cast<Kinematics::ChainID>(chain),chainJoints);
+        //The 22 long lists of stiff/joints are in chain order, so each
+        //chain's are the run starting at its first joint
+        const unsigned int startI = Kinematics::chain_first_joint[chain];
+        setNextChainJoints(static_cast<Kinematics::ChainID>(chain),
+                           &curMotionAngles[startI]);
         setNextChainStiffnesses(static_cast<Kinematics::ChainID>(chain),
-                                chainStiffness);
+                                &nextStiffness[startI]);
 
     }
     setActive();
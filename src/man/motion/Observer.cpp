@@ -19,9 +19,6 @@
 // <http://www.gnu.org/licenses/>.
 
 #include "Observer.h"
-using std::list;
-
-using namespace NBMath;
 
 // generated by octave
 const float Observer::weights[NUM_AVAIL_PREVIEW_FRAMES] =
@@ -69,30 +66,10 @@ const float Observer::c_values[3] =
 const float Observer::Gi = -59.557f;
 
 Observer::Observer()
-    : WalkController(), stateVector(ufvector3(3)),
-      A(ufmatrix3(3,3)), b(ufvector3(3)), c(ufrowVector3(1,3)),
-      L(ufvector3(3)),trackingError(0.0f)
+    : WalkController(), trackingError(0.0f)
 {
-    // instantiate the ublas matrices with their respective values
-    // TODO: there might be a better way to do this.
-    for (int i=0; i < 3; i++)
-        stateVector(i) = 0.0f;
-
-    for (int i=0; i < 3; i++)
-        A(0, i) = A_values[i];
-    for (int i=0; i < 3; i++)
-        A(1, i) = A_values[3+i];
-    for (int i=0; i < 3; i++)
-        A(2, i) = A_values[6+i];
-
-    for (int i=0; i < 3; i++)
-        b(i) = b_values[i];
-
     for (int i=0; i < 3; i++)
-        c(0,i) = c_values[i];
-
-    for (int i=0; i < 3; i++)
-        L(i) = L_values[i];
+        stateVector[i] = 0.0f;
 
 #ifdef DEBUG_CONTROLLER_GAINS
     FILE * gains_log;
@@ -113,26 +90,27 @@ Observer::Observer()
  * Tick calculates the next state vector for the robot, given the zmp_ref
  *
  */
-const float Observer::tick(const list<float> *zmp_ref,
+const float Observer::tick(const ZmpRefBuffer *zmp_ref,
                            const float cur_zmp_ref,
                            const float sensor_zmp) {
-    float preview_control = 0.0f;
-    unsigned int counter = 0;
+    const float preview_control = zmp_ref->dot(weights, NUM_PREVIEW_FRAMES);
 
-    for (list<float>::const_iterator i = zmp_ref->begin();
-         counter < NUM_PREVIEW_FRAMES; ++counter, ++i) {
-        preview_control += weights[counter]* (*i);
-    }
+    const float x0 = stateVector[0], x1 = stateVector[1], x2 = stateVector[2];
+    const float zmp = c_values[0]*x0 + c_values[1]*x1 + c_values[2]*x2;
 
-    trackingError += prod(c,stateVector)(0) - cur_zmp_ref;
+    trackingError += zmp - cur_zmp_ref;
 
     const float control = -Gi * trackingError - preview_control;
     const float psensor = sensor_zmp;
+    const float sensorError = psensor - zmp;
 
-    ufvector3 temp(prod(A, stateVector)
-                   - L*(psensor - prod(c,stateVector)(0)) * 1.0f
-                   + b*control);
-    stateVector.assign(temp);
+    // x = A x - L (psensor - c x) + b u, unrolled
+    stateVector[0] = A_values[0]*x0 + A_values[1]*x1 + A_values[2]*x2
+        - L_values[0]*sensorError + b_values[0]*control;
+    stateVector[1] = A_values[3]*x0 + A_values[4]*x1 + A_values[5]*x2
+        - L_values[1]*sensorError + b_values[1]*control;
+    stateVector[2] = A_values[6]*x0 + A_values[7]*x1 + A_values[8]*x2
+        - L_values[2]*sensorError + b_values[2]*control;
 
     return getPosition();
 }
@@ -142,8 +120,8 @@ const float Observer::tick(const list<float> *zmp_ref,
  * We also assume we are starting off without any tracking error.
  */
 void Observer::initState(float x, float v, float p){
-    stateVector(0) = x;
-    stateVector(1) = v;
-    stateVector(2) = p;
+    stateVector[0] = x;
+    stateVector[1] = v;
+    stateVector[2] = p;
     trackingError = 0.0f;
 }
@@ -24,7 +24,7 @@
  * previewable ZMP_REF positions.
  * Important: This controller models only one dimension at once, so you need
  * two instances one for the x and one for the y direction.
- * The weights and the time invariant system matrix A (see constructor, etc)
+ * The weights and the time invariant system matrix A (see the .cpp)
  * are pre-calculated in Octave (see observer.m and setupobserver.m). The
  * theory is described in Czarnetzki and Kajita and Katayama.
  *
@@ -37,12 +37,6 @@
 #ifndef _Observer_h_DEFINED
 #define _Observer_h_DEFINED
 
-#include <boost/numeric/ublas/matrix.hpp>
-#include <boost/numeric/ublas/vector.hpp>
-
-#include <list>
-
-#include "NBMatrixMath.h"
 #include "WalkController.h"
 #include "motionconfig.h"
 
@@ -54,15 +48,15 @@ class Observer : public WalkController {
 public:
     Observer();
     virtual ~Observer(){};
-    virtual const float tick(const std::list<float> *zmp_ref,
+    virtual const float tick(const ZmpRefBuffer *zmp_ref,
                              const float cur_zmp_ref,
                              const float sensor_zmp);
-    virtual const float getPosition() const { return stateVector(0); }
-    virtual const float getZMP() const {return stateVector(2);}
+    virtual const float getPosition() const { return stateVector[0]; }
+    virtual const float getZMP() const {return stateVector[2];}
 
     virtual void initState(float x, float v, float p);
 private:
-    NBMath::ufvector3 stateVector;
+    float stateVector[3];
 
 public: //Constants
     static const unsigned int NUM_PREVIEW_FRAMES = 70;
@@ -75,11 +69,6 @@ private:
     static const float L_values[3];
     static const float Gi;
 
-    NBMath::ufmatrix3 A;
-    NBMath::ufvector3 b;
-    NBMath::ufrowVector3 c;
-    NBMath::ufvector3 L;
-
     float trackingError;
 };
 
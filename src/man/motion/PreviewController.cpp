@@ -19,9 +19,6 @@
 // <http://www.gnu.org/licenses/>.
 
 #include "PreviewController.h"
-using std::list;
-
-using namespace NBMath;
 
 // generated by scilab.
 const float PreviewController::weights[NUM_PREVIEW_FRAMES] =
@@ -41,25 +38,9 @@ const float PreviewController::c_values[3] =
 { 0.0f, 0.0f, 1.0f };
 
 PreviewController::PreviewController()
-    : WalkController(), stateVector(ufvector3(3)),
-      A_c(ufmatrix3(3,3)), b(ufvector3(3)), c(ufrowVector3(1,3)) {
-    // instantiate the ublas matrices with their respective values
-    // TODO: there might be a better way to do this.
-    for (int i=0; i < 3; i++)
-        stateVector(i) = 0.0f;
-
-    for (int i=0; i < 3; i++)
-        A_c(0, i) = A_c_values[i];
-    for (int i=0; i < 3; i++)
-        A_c(1, i) = A_c_values[3+i];
+    : WalkController() {
     for (int i=0; i < 3; i++)
-        A_c(2, i) = A_c_values[6+i];
-
-    for (int i=0; i < 3; i++)
-        b(i) = b_values[i];
-
-    for (int i=0; i < 3; i++)
-        c(0,i) = c_values[i];
+        stateVector[i] = 0.0f;
 
 #ifdef DEBUG_CONTROLLER_GAINS
     FILE * gains_log;
@@ -80,16 +61,20 @@ PreviewController::PreviewController()
  * Tick calculates the next state vector for the robot, given the zmp_ref
  *
  */
-const float PreviewController::tick(const list<float> *zmp_ref,
+const float PreviewController::tick(const ZmpRefBuffer *zmp_ref,
                                     const float cur_zmp_ref,
                                     const float sensor_zmp) {
-    float control = 0.0f; // This is 'u' in mathematical notation
-    unsigned int counter = 0;
-    for (list<float>::const_iterator i = zmp_ref->begin();
-         counter < NUM_PREVIEW_FRAMES; counter++, i++) {
-        control += weights[counter]* (*i);
-    }
-    stateVector.assign(prod(A_c, stateVector) + b*control);
+    // This is 'u' in mathematical notation
+    const float control = zmp_ref->dot(weights, NUM_PREVIEW_FRAMES);
+
+    // x = A_c x + b u, unrolled
+    const float x0 = stateVector[0], x1 = stateVector[1], x2 = stateVector[2];
+    stateVector[0] = A_c_values[0]*x0 + A_c_values[1]*x1 + A_c_values[2]*x2
+        + b_values[0]*control;
+    stateVector[1] = A_c_values[3]*x0 + A_c_values[4]*x1 + A_c_values[5]*x2
+        + b_values[1]*control;
+    stateVector[2] = A_c_values[6]*x0 + A_c_values[7]*x1 + A_c_values[8]*x2
+        + b_values[2]*control;
     return getPosition();
 }
 
@@ -97,8 +82,8 @@ const float PreviewController::tick(const list<float> *zmp_ref,
  * Initialize the position of the robot (vel and accel assumed to be 0)
  */
 void PreviewController::initState(float x, float v, float p){
-    stateVector(0) = x;
-    stateVector(1) = v;
-    stateVector(2) = p;
+    stateVector[0] = x;
+    stateVector[1] = v;
+    stateVector[2] = p;
 
 }
@@ -24,7 +24,7 @@
  * previewable ZMP_REF positions.
  * Important: This controller models only one dimension at once, so you need
  * two instances one for the x and one for the y direction.
- * The weights and the time invariant system matrix A_c (see constructor, etc)
+ * The weights and the time invariant system matrix A_c (see the .cpp)
  * are pre-calculated in Scilab (see preview-control.sci). The theory
  * is described in Czarnetzki and Kajita and Katayama.
  *
@@ -36,12 +36,6 @@
 #ifndef _PreviewController_h_DEFINED
 #define _PreviewController_h_DEFINED
 
-#include <boost/numeric/ublas/matrix.hpp>
-#include <boost/numeric/ublas/vector.hpp>
-
-#include <list>
-
-#include "NBMatrixMath.h"
 #include "WalkController.h"
 #include "motionconfig.h"
 
@@ -53,15 +47,15 @@ class PreviewController : public WalkController {
 public:
     PreviewController();
     virtual ~PreviewController(){};
-    virtual const float tick(const std::list<float> *zmp_ref,
+    virtual const float tick(const ZmpRefBuffer *zmp_ref,
                              const float cur_zmp_ref,
                              const float sensor_zmp);
-    virtual const float getPosition() const { return stateVector(0); }
-    virtual const float getZMP() const {return stateVector(2);}
+    virtual const float getPosition() const { return stateVector[0]; }
+    virtual const float getZMP() const {return stateVector[2];}
 
     virtual void initState(float x, float v, float p);
 private:
-    NBMath::ufvector3 stateVector;
+    float stateVector[3];
 
 public: //Constants
     static const unsigned int NUM_PREVIEW_FRAMES = 60;
@@ -70,11 +64,6 @@ private:
     static const float A_c_values[9];
     static const float b_values[3];
     static const float c_values[3];
-
-    NBMath::ufmatrix3 A_c;
-    NBMath::ufvector3 b;
-    NBMath::ufrowVector3 c;
-
 };
 
 #endif
@@ -100,16 +100,20 @@ void ScriptedProvider::calculateNextJointsAndStiffnesses() {
 
 	// Go through the chains and enqueue the next
 	// joints from the ChoppedCommand.
-	shared_ptr<vector <vector <float> > > currentChains(getCurrentChains());
+	float currentJoints[NUM_ACTUATORS];
+	sensors->getBodyAngles(currentJoints);
+
+	// Big enough for the longest chain
+	float chainJoints[Kinematics::LEG_JOINTS];
 
 	for (unsigned int id=0; id< Kinematics::NUM_CHAINS; ++id ) {
 		Kinematics::ChainID cid = static_cast<Kinematics::ChainID>(id);
 		if ( currCommand->isDone() ){
 			setNextChainJoints( cid,
-								currentChains->at(cid) );
+								&currentJoints[chain_first_joint[cid]] );
 		}else{
-			setNextChainJoints( cid,
-								currCommand->getNextJoints(cid) );
+			currCommand->getNextJoints(cid, chainJoints);
+			setNextChainJoints( cid, chainJoints );
 		}
 		// Curr command will allways provide the current stiffnesses
 		// even if it is finished providing new joint angles.
@@ -161,31 +165,3 @@ void ScriptedProvider::setNextBodyCommand() {
 	}
 }
 
-// Get the chain's current positions. Gives a shared pointer to
-// a vector containing a vector for each chain. Makes accessing
-// each chain very simple.
-shared_ptr<vector<vector<float> > > ScriptedProvider::getCurrentChains() {
-    shared_ptr<vector<vector<float> > >currentChains(
-		new vector<vector<float> >(Kinematics::NUM_CHAINS) );
-
-    vector<float> currentJoints = sensors->getBodyAngles();
-
-    unsigned int lastChainJoint,joint,chain;
-	lastChainJoint= 0;
-	joint = 0;
-	chain = 0;
-
-	vector<vector<float> >::iterator i = currentChains->begin();
-
-	while (i != currentChains->end() ) {
-        lastChainJoint += chain_lengths[chain];
-
-        for ( ; joint < lastChainJoint ; joint++) {
-            i->push_back(currentJoints.at(joint));
-        }
-
-		++i;
-		++chain;
-    }
-    return currentChains;
-}
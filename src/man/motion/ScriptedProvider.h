@@ -62,8 +62,6 @@ private:
 
 	pthread_mutex_t scripted_mutex;
 
-	boost::shared_ptr<std::vector <std::vector <float> > > getCurrentChains();
-
 	void setNextBodyCommand();
     void setActive();
 	bool isDone();
@@ -110,30 +110,27 @@ vector<float>* SmoothChoppedCommand::getDiffChain(int id) {
 	}
 }
 
-vector<float> SmoothChoppedCommand::getNextJoints(int id) {
+void SmoothChoppedCommand::getNextJoints(int id, float joints[]) {
 	if ( !isChainFinished(id) ) {
 		numChopped.at(id)++;
 		checkDone();
 	}
 
-	return getNextChainFromCycloid(id);
+	getNextChainFromCycloid(id, joints);
 }
 
-vector<float> SmoothChoppedCommand::getNextChainFromCycloid(int id) {
+void SmoothChoppedCommand::getNextChainFromCycloid(int id, float joints[]) {
 	float t = getCycloidStep(id);
-	vector<float> nextChain;
 	vector<float>* diffChain = getDiffChain(id);
 	vector<float>* startChain = getStartChain(id);
 	vector<float>::iterator diffAngle = diffChain->begin();
 	vector<float>::iterator startAngle = startChain->begin();
 
 	while ( diffAngle != diffChain->end() ) {
-		nextChain.push_back(*startAngle + getCycloidAngle(*diffAngle,t) );
+		*joints++ = *startAngle + getCycloidAngle(*diffAngle,t);
 		diffAngle++;
 		startAngle++;
 	}
-
-	return nextChain;
 }
 
 float SmoothChoppedCommand::getCycloidAngle(float d_theta, float t) {
@@ -20,7 +20,7 @@ public:
 
 	virtual ~SmoothChoppedCommand(void) {  };
 
-	virtual std::vector<float> getNextJoints(int id);
+	virtual void getNextJoints(int id, float joints[]);
 
 private:
 	std::vector<float> startHead;
@@ -46,7 +46,7 @@ private:
 	void subtractChainStartFromFinalAngles(int chain);
 
 	bool isChainFinished(int id);
-	std::vector<float> getNextChainFromCycloid(int id);
+	void getNextChainFromCycloid(int id, float joints[]);
 	float getCycloidStep(int id);
 	float getCycloidAngle(float d_theta, float t);
 
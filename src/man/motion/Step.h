@@ -1,10 +1,13 @@
 #ifndef Step_h_DEFINED
 #define Step_h_DEFINED
 
+#include <list>
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <iostream>
 #include "Gait.h"
+#include "StepPool.h"
 
 
 typedef boost::tuple<const float,const float, const float>  distVector;
@@ -91,6 +94,27 @@ private:
     const WalkVector lateralClipVelocities(const WalkVector & source);
 };
 
+// Steps made while walking should come from these, so that they come out of
+// the StepPool rather than the heap
+inline boost::shared_ptr<Step> makeStep(const WalkVector &target,
+                                        const AbstractGait & gait,
+                                        const Foot foot,
+                                        const WalkVector &last = ZERO_WALKVECTOR,
+                                        const StepType type = REGULAR_STEP) {
+    return boost::allocate_shared<Step>(StepAllocator<Step>(),
+                                        target, gait, foot, last, type);
+}
+
+inline boost::shared_ptr<Step> makeStep(const float x, const float y,
+                                        const float theta,
+                                        const Step& other) {
+    return boost::allocate_shared<Step>(StepAllocator<Step>(),
+                                        x, y, theta, other);
+}
+
+typedef std::list<boost::shared_ptr<Step>,
+                  StepAllocator<boost::shared_ptr<Step> > > StepList;
+
 static const boost::shared_ptr<Step> EMPTY_STEP =
   boost::shared_ptr<Step>(new Step(ZERO_WALKVECTOR,
                                      DEFAULT_GAIT,
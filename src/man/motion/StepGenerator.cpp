@@ -44,7 +44,7 @@ StepGenerator::StepGenerator(shared_ptr<Sensors> s, const MetaGait * _gait)
     com_i(CoordFrame3D::vector3D(0.0f,0.0f)),
     com_f(CoordFrame3D::vector3D(0.0f,0.0f)),
     est_zmp_i(CoordFrame3D::vector3D(0.0f,0.0f)),
-    zmp_ref_x(list<float>()),zmp_ref_y(list<float>()),
+    zmp_ref_x(),zmp_ref_y(),
 	futureSteps(),
     currentZMPDSteps(),
     si_Transform(CoordFrame3D::identity3D()),
@@ -61,6 +61,7 @@ StepGenerator::StepGenerator(shared_ptr<Sensors> s, const MetaGait * _gait)
     //controller_y(new PreviewController())
     controller_x(new Observer()),
     controller_y(new Observer()),
+    controllerState(),
     zmp_filter(),
     acc_filter(),
     accInWorldFrame(CoordFrame4D::vector4D(0.0f,0.0f,0.0f))
@@ -141,15 +142,14 @@ zmp_xy_tuple StepGenerator::generate_zmp_ref() {
         }
 #ifdef DEBUG_ZMP
 		cout << "generate_zmp_ref()\n";
-		list<float>::iterator it;
 		cout << "zmp_ref_x: " << zmp_ref_x.size();
-		for (it=zmp_ref_x.begin(); it!=zmp_ref_x.end(); ++it)
-			cout << " " << *it;
+		for (unsigned int i = 0; i < zmp_ref_x.size(); ++i)
+			cout << " " << zmp_ref_x[i];
 		cout << "\n";
 
 		cout << " zmp_ref_y: " << zmp_ref_y.size();
-		for (it=zmp_ref_y.begin(); it!=zmp_ref_y.end(); ++it)
-			cout << " " << *it;
+		for (unsigned int i = 0; i < zmp_ref_y.size(); ++i)
+			cout << " " << zmp_ref_y[i];
 		cout << "\n";
 #endif
     }
@@ -271,6 +271,12 @@ void StepGenerator::tick_controller(){
                                            est_zmp_i(1));
     com_i = CoordFrame3D::vector3D(com_x,com_y);
 
+    controllerState.zmpRefX = cur_zmp_ref_x;
+    controllerState.zmpRefY = cur_zmp_ref_y;
+    controllerState.zmpX = controller_x->getZMP();
+    controllerState.zmpY = controller_y->getZMP();
+    controllerState.comX = com_x;
+    controllerState.comY = com_y;
 }
 
 /** Central method for moving the walking legs. It handles important stuff like:
@@ -333,10 +339,10 @@ WalkLegsTuple StepGenerator::tick_legs(){
 
     //Since we'd like to ignore the state information of the WalkinLeg as much
     //as possible, we send in the source of the swinging leg to both, regardless
-    LegJointStiffTuple left  = leftLeg.tick(leftStep_f,swingingStepSource_f,
-                                       swingingStep_f,fc_Transform);
-    LegJointStiffTuple right = rightLeg.tick(rightStep_f,swingingStepSource_f,
-                                        swingingStep_f,fc_Transform);
+    const LegJointStiffness left  = leftLeg.tick(leftStep_f,swingingStepSource_f,
+                                                 swingingStep_f,fc_Transform);
+    const LegJointStiffness right = rightLeg.tick(rightStep_f,swingingStepSource_f,
+                                                  swingingStep_f,fc_Transform);
 
     if(supportStep_f->foot == LEFT_FOOT){
         updateOdometry(leftLeg.getOdoUpdate());
@@ -421,14 +427,14 @@ void StepGenerator::swapSupportLegs(){
         //in the F coordinate frames, we express Steps representing
         // the three footholds from above
         supportStep_f =
-            shared_ptr<Step>(new Step(supp_pos_f(0),supp_pos_f(1),
-                                      0.0f,*supportStep_s));
+            makeStep(supp_pos_f(0),supp_pos_f(1),
+                     0.0f,*supportStep_s);
         swingingStep_f =
-            shared_ptr<Step>(new Step(swing_pos_f(0),swing_pos_f(1),
-                                      swing_dest_angle,*swingingStep_s));
+            makeStep(swing_pos_f(0),swing_pos_f(1),
+                     swing_dest_angle,*swingingStep_s);
         swingingStepSource_f  =
-            shared_ptr<Step>(new Step(swing_src_f(0),swing_src_f(1),
-                                      swing_src_angle,*lastStep_s));
+            makeStep(swing_src_f(0),swing_src_f(1),
+                     swing_src_angle,*lastStep_s);
 
 }
 
@@ -785,13 +791,13 @@ void StepGenerator::resetSteps(const bool startLeft){
     //Support step is END Type, but the first swing step, generated
     //in generateStep, is REGULAR type.
     shared_ptr<Step> firstSupportStep =
-      shared_ptr<Step>(new Step(ZERO_WALKVECTOR,
-                                  *gait,
-                                  firstSupportFoot,ZERO_WALKVECTOR,END_STEP));
+        makeStep(ZERO_WALKVECTOR,
+                 *gait,
+                 firstSupportFoot,ZERO_WALKVECTOR,END_STEP);
     shared_ptr<Step> dummyStep =
-        shared_ptr<Step>(new Step(ZERO_WALKVECTOR,
-                                  *gait,
-                                  dummyFoot));
+        makeStep(ZERO_WALKVECTOR,
+                 *gait,
+                 dummyFoot);
     //need to indicate what the current support foot is:
     currentZMPDSteps.push_back(dummyStep);//right gets popped right away
     fillZMP(firstSupportStep);
@@ -875,12 +881,12 @@ void StepGenerator::generateStep( float _x,
 
     const WalkVector new_walk = {_x,_y,_theta};
 
-    shared_ptr<Step> step(new Step(new_walk,
-                                   *gait,
-                                   (nextStepIsLeft ?
-                                    LEFT_FOOT : RIGHT_FOOT),
-				   lastQueuedStep->walkVector,
-                                   type));
+    shared_ptr<Step> step = makeStep(new_walk,
+                                     *gait,
+                                     (nextStepIsLeft ?
+                                      LEFT_FOOT : RIGHT_FOOT),
+                                     lastQueuedStep->walkVector,
+                                     type);
 
 #ifdef DEBUG_STEPGENERATOR
     cout << "Generated a new step: "<<*step<<endl;
@@ -1061,7 +1067,7 @@ void StepGenerator::resetOdometry(const float initX, const float initY){
  *  rather than the C frame, which is what we are actually returning.
  */
 
-void StepGenerator::updateOdometry(const vector<float> &deltaOdo){
+void StepGenerator::updateOdometry(const float deltaOdo[3]){
     const ufmatrix3 odoUpdate = prod(CoordFrame3D::translation3D(deltaOdo[0],
                                                                  deltaOdo[1]),
                                      CoordFrame3D::rotation3D(CoordFrame3D::Z_AXIS,
@@ -82,6 +82,7 @@
 
 #include "Structs.h"
 #include "WalkController.h"
+#include "ZmpRefBuffer.h"
 #include "WalkingConstants.h"
 #include "WalkingLeg.h"
 #include "WalkingArm.h"
@@ -101,12 +102,20 @@
 // ZMP Preview Queue Debugging
 #define DEBUG_ZMP_REF
 
-typedef boost::tuple<const std::list<float>*,
-                     const std::list<float>*> zmp_xy_tuple;
-typedef boost::tuple<LegJointStiffTuple,
-                      LegJointStiffTuple> WalkLegsTuple;
-typedef boost::tuple<ArmJointStiffTuple,
-                     ArmJointStiffTuple> WalkArmsTuple;
+typedef boost::tuple<const ZmpRefBuffer*,
+                     const ZmpRefBuffer*> zmp_xy_tuple;
+typedef boost::tuple<LegJointStiffness,
+                     LegJointStiffness> WalkLegsTuple;
+typedef boost::tuple<ArmJointStiffness,
+                     ArmJointStiffness> WalkArmsTuple;
+
+// The ZMP the controller was given and the one it tracked, and the CoM it
+// put out, in the I frame, for logging and the offline tools
+struct WalkControllerState {
+    float zmpRefX, zmpRefY;
+    float zmpX, zmpY;
+    float comX, comY;
+};
 
 static unsigned int MIN_NUM_ENQUEUED_STEPS = 3; //At any given time, we need at least 3
                                      //steps stored in future, current lists
@@ -137,6 +146,17 @@ public:
         return supportFoot;
     }
 
+    // As of the last tick_controller()
+    const WalkControllerState& getControllerState() const {
+        return controllerState;
+    }
+
+    // foot's hip roll and pitch from its hip hack, as of the last
+    // tick_legs()
+    const float* getHipHacks(const SupportFoot foot) const {
+        return (foot == LEFT_SUPPORT ? leftLeg : rightLeg).getHipHacks();
+    }
+
 private: // Helper methods
     zmp_xy_tuple generate_zmp_ref();
     void generate_steps();
@@ -168,7 +188,7 @@ private: // Helper methods
 					   NBMath::ufvector3 &last_zmp);
 	std::list<float> mergeZMPQueues(std::list<float> &currentQ, std::list<float> &newQ);
     void resetOdometry(const float initX, const float initY);
-    void updateOdometry(const std::vector<float> &deltaOdo);
+    void updateOdometry(const float deltaOdo[3]);
     void debugLogging();
     void updateDebugMatrix();
 private:
@@ -188,12 +208,12 @@ private:
     NBMath::ufvector3 com_i,last_com_c,com_f,est_zmp_i;
     //boost::numeric::ublas::vector<float> com_f;
     // need to store future zmp_ref values (points in xy)
-    std::list<float> zmp_ref_x, zmp_ref_y;
-    std::list<boost::shared_ptr<Step> > futureSteps; //stores steps not yet zmpd
+    ZmpRefBuffer zmp_ref_x, zmp_ref_y;
+    StepList futureSteps; //stores steps not yet zmpd
     //Stores currently relevant steps that are zmpd but not yet completed.
     //A step is consider completed (obsolete/irrelevant) as soon as the foot
     //enters into double support (perisistant)
-    std::list<boost::shared_ptr<Step> > currentZMPDSteps;
+    StepList currentZMPDSteps;
     boost::shared_ptr<Step> lastQueuedStep;
 
     //Reference Frames for ZMPing steps
@@ -231,6 +251,7 @@ private:
     SupportFoot supportFoot;
 
     WalkController *controller_x, *controller_y;
+    WalkControllerState controllerState;
 
     ZmpEKF zmp_filter;
 	ZmpAccExp acc_filter;
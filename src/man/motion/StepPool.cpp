@@ -0,0 +1,87 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include <pthread.h>
+
+#include "StepPool.h"
+
+namespace {
+    union Block {
+        Block *next;
+        char bytes[StepPool::BLOCK_SIZE];
+        double align;
+    };
+
+    Block blocks[StepPool::NUM_BLOCKS];
+
+    // Freed blocks, and the blocks that have never been handed out
+    Block *freeBlocks = 0;
+    unsigned int unusedBlocks = StepPool::NUM_BLOCKS;
+    unsigned int usedBlocks = 0;
+
+    pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    bool inPool(const void *p) {
+        return p >= static_cast<const void*>(blocks) &&
+            p < static_cast<const void*>(blocks + StepPool::NUM_BLOCKS);
+    }
+}
+
+void* StepPool::allocate(std::size_t bytes) {
+    Block *block = 0;
+
+    if (bytes <= BLOCK_SIZE) {
+        pthread_mutex_lock(&pool_mutex);
+        if (freeBlocks) {
+            block = freeBlocks;
+            freeBlocks = block->next;
+        } else if (unusedBlocks > 0) {
+            block = &blocks[NUM_BLOCKS - unusedBlocks];
+            --unusedBlocks;
+        }
+        if (block)
+            ++usedBlocks;
+        pthread_mutex_unlock(&pool_mutex);
+    }
+
+    if (!block)
+        return ::operator new(bytes);
+    return block;
+}
+
+void StepPool::deallocate(void *p) {
+    if (!inPool(p)) {
+        ::operator delete(p);
+        return;
+    }
+
+    Block *block = static_cast<Block*>(p);
+    pthread_mutex_lock(&pool_mutex);
+    block->next = freeBlocks;
+    freeBlocks = block;
+    --usedBlocks;
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+unsigned int StepPool::blocksInUse() {
+    pthread_mutex_lock(&pool_mutex);
+    const unsigned int used = usedBlocks;
+    pthread_mutex_unlock(&pool_mutex);
+    return used;
+}
@@ -0,0 +1,97 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * A pool of fixed size blocks for Steps and the lists that queue them.
+ *
+ * The StepGenerator makes and drops a few Steps every time the support foot
+ * changes, inside the motion frame.  makeStep() (in Step.h) puts a Step and
+ * its shared_ptr count together in one block of the pool, and the nodes of a
+ * StepList come from it too, so walking never has to go to malloc.  A
+ * request too big for a block, or one made while the pool is empty, falls
+ * back to the heap, and those blocks go back to the heap when they are
+ * freed.
+ *
+ * There is one pool for all the walk engines, locked, since the last
+ * reference to a Step may be dropped on another thread than the motion one.
+ */
+
+#ifndef _StepPool_h_DEFINED
+#define _StepPool_h_DEFINED
+
+#include <cstddef>
+#include <new>
+
+namespace StepPool {
+    // Enough for a Step and its count, which is the biggest user
+    static const unsigned int BLOCK_SIZE = 256;
+    // The walk holds a dozen or so Steps at once
+    static const unsigned int NUM_BLOCKS = 128;
+
+    void* allocate(std::size_t bytes);
+    void deallocate(void *p);
+
+    // Blocks of the pool in use, for the tests
+    unsigned int blocksInUse();
+}
+
+/**
+ * A standard allocator over the StepPool, for allocate_shared and lists.
+ */
+template <class T>
+class StepAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <class U> struct rebind { typedef StepAllocator<U> other; };
+
+    StepAllocator() { }
+    template <class U> StepAllocator(const StepAllocator<U>&) { }
+
+    pointer address(reference x) const { return &x; }
+    const_pointer address(const_reference x) const { return &x; }
+
+    pointer allocate(size_type n, const void* = 0) {
+        return static_cast<pointer>(StepPool::allocate(n * sizeof(T)));
+    }
+    void deallocate(pointer p, size_type) { StepPool::deallocate(p); }
+
+    size_type max_size() const { return static_cast<size_type>(-1) / sizeof(T); }
+
+    void construct(pointer p, const T& value) { new(p) T(value); }
+    void destroy(pointer p) { p->~T(); }
+};
+
+template <class T, class U>
+inline bool operator==(const StepAllocator<T>&, const StepAllocator<U>&) {
+    return true;
+}
+
+template <class T, class U>
+inline bool operator!=(const StepAllocator<T>&, const StepAllocator<U>&) {
+    return false;
+}
+
+#endif
@@ -25,15 +25,14 @@
 #ifndef _WalkController_h_DEFINED
 #define _WalkController_h_DEFINED
 
-#include <list>
-
 #include "Sensors.h"
+#include "ZmpRefBuffer.h"
 
 class WalkController {
 public:
     //WalkController(Sensors *s) : sensors(s) { }
     virtual ~WalkController(){};
-    virtual const float tick(const std::list<float> *zmp_ref,
+    virtual const float tick(const ZmpRefBuffer *zmp_ref,
                              const float cur_zmp_ref,
                              const float sensor_zmp) = 0;
     virtual const float getPosition() const = 0;
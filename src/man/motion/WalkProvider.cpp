@@ -117,30 +117,23 @@ void WalkProvider::calculateNextJointsAndStiffnesses() {
     //Finally, ask the step generator for the arm angles
     WalkArmsTuple arms_result = stepGenerator.tick_arms();
 
-    //Get the joints and stiffnesses for each Leg
-    vector<float> lleg_joints = legs_result.get<LEFT_FOOT>().get<JOINT_INDEX>();
-    vector<float> rleg_joints = legs_result.get<RIGHT_FOOT>().get<JOINT_INDEX>();
-    vector<float> lleg_gains = legs_result.get<LEFT_FOOT>().get<STIFF_INDEX>();
-    vector<float> rleg_gains = legs_result.get<RIGHT_FOOT>().get<STIFF_INDEX>();
-
-    //grab the stiffnesses for the arms
-    vector<float> larm_joints = arms_result.get<LEFT_FOOT>().get<JOINT_INDEX>();
-    vector<float> rarm_joints = arms_result.get<RIGHT_FOOT>().get<JOINT_INDEX>();
-    vector<float> larm_gains = arms_result.get<LEFT_FOOT>().get<STIFF_INDEX>();
-    vector<float> rarm_gains = arms_result.get<RIGHT_FOOT>().get<STIFF_INDEX>();
-
+    //Get the joints and stiffnesses for each limb
+    const LegJointStiffness& lleg = legs_result.get<LEFT_FOOT>();
+    const LegJointStiffness& rleg = legs_result.get<RIGHT_FOOT>();
+    const ArmJointStiffness& larm = arms_result.get<LEFT_FOOT>();
+    const ArmJointStiffness& rarm = arms_result.get<RIGHT_FOOT>();
 
     //Return the joints for the legs
-    setNextChainJoints(LARM_CHAIN,larm_joints);
-    setNextChainJoints(LLEG_CHAIN,lleg_joints);
-    setNextChainJoints(RLEG_CHAIN,rleg_joints);
-    setNextChainJoints(RARM_CHAIN,rarm_joints);
+    setNextChainJoints(LARM_CHAIN,larm.joints);
+    setNextChainJoints(LLEG_CHAIN,lleg.joints);
+    setNextChainJoints(RLEG_CHAIN,rleg.joints);
+    setNextChainJoints(RARM_CHAIN,rarm.joints);
 
     //Return the stiffnesses for each joint
-    setNextChainStiffnesses(LARM_CHAIN,larm_gains);
-    setNextChainStiffnesses(LLEG_CHAIN,lleg_gains);
-    setNextChainStiffnesses(RLEG_CHAIN,rleg_gains);
-    setNextChainStiffnesses(RARM_CHAIN,rarm_gains);
+    setNextChainStiffnesses(LARM_CHAIN,larm.stiffnesses);
+    setNextChainStiffnesses(LLEG_CHAIN,lleg.stiffnesses);
+    setNextChainStiffnesses(RLEG_CHAIN,rleg.stiffnesses);
+    setNextChainStiffnesses(RARM_CHAIN,rarm.stiffnesses);
 
     setActive();
     pthread_mutex_unlock(&walk_provider_mutex);
@@ -203,6 +196,8 @@ std::vector<BodyJointCommand *> WalkProvider::getGaitTransitionCommand(){
     vector<BodyJointCommand *> commands;
 
     if(time <= MOTION_FRAME_LENGTH_S){
+        delete gaitJoints;
+        pthread_mutex_unlock(&walk_provider_mutex);
         return commands;
     }
 
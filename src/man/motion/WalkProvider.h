@@ -83,6 +83,14 @@ public:
         return stepGenerator.getSupportFoot();
     }
 
+    const WalkControllerState& getControllerState() const {
+        return stepGenerator.getControllerState();
+    }
+
+    const float* getHipHacks(const SupportFoot foot) const {
+        return stepGenerator.getHipHacks(foot);
+    }
+
 private:
     virtual void setActive();
 
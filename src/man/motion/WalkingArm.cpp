@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "WalkingArm.h"
 
 
@@ -19,19 +21,20 @@ WalkingArm::~WalkingArm(){}
 
 
 
-ArmJointStiffTuple WalkingArm::tick(shared_ptr<Step> supportStep){
+ArmJointStiffness WalkingArm::tick(const shared_ptr<Step>& supportStep){
     singleSupportFrames = supportStep->singleSupportFrames;
     doubleSupportFrames = supportStep->doubleSupportFrames;
 
-    vector<float> armJoints = (chainID == LARM_CHAIN ?
-                               vector<float>(LARM_WALK_ANGLES,
-                                             &LARM_WALK_ANGLES[ARM_JOINTS]):
-                               vector<float>(RARM_WALK_ANGLES,
-                                             &RARM_WALK_ANGLES[ARM_JOINTS]));
+    ArmJointStiffness result;
+    memcpy(result.joints,
+           (chainID == LARM_CHAIN ? LARM_WALK_ANGLES : RARM_WALK_ANGLES),
+           ARM_JOINTS*sizeof(float));
 
-    armJoints[0] += getShoulderPitchAddition(supportStep);
-    vector<float> armStiffnesses(ARM_JOINTS,gait->stiffness[WP::ARM]);
-	armStiffnesses[0] = gait->stiffness[WP::ARM_PITCH];
+    result.joints[0] += getShoulderPitchAddition(supportStep);
+    for(unsigned int i = 0; i < ARM_JOINTS; i++){
+        result.stiffnesses[i] = gait->stiffness[WP::ARM];
+    }
+    result.stiffnesses[0] = gait->stiffness[WP::ARM_PITCH];
 
     frameCounter++;
     for(unsigned int  i = 0; shouldSwitchStates() && i < 2; i++){
@@ -39,14 +42,15 @@ ArmJointStiffTuple WalkingArm::tick(shared_ptr<Step> supportStep){
         lastStepType = supportStep->type;
     };
 
-    return ArmJointStiffTuple(armJoints,armStiffnesses);
+    return result;
 }
 
 /*
  * Currently, the arms only move in the forward direction by modulating the
  * shoulderPitch
  */
-const float WalkingArm::getShoulderPitchAddition(shared_ptr<Step> supportStep){
+const float
+WalkingArm::getShoulderPitchAddition(const shared_ptr<Step>& supportStep){
     float direction = 1.0f; //forward = negative
     float percentComplete = 0.0f;
     switch(state){
@@ -10,15 +10,18 @@
 #include <boost/tuple/tuple.hpp>
 
 
-typedef boost::tuple<std::vector<float>,
-                     std::vector<float> > ArmJointStiffTuple;
+// An arm's joint angles and stiffnesses for one motion frame
+struct ArmJointStiffness {
+    float joints[Kinematics::ARM_JOINTS];
+    float stiffnesses[Kinematics::ARM_JOINTS];
+};
 
 class WalkingArm{
 public:
     WalkingArm(const MetaGait * _gait,Kinematics::ChainID id);
     ~WalkingArm();
 
-    ArmJointStiffTuple tick(boost::shared_ptr<Step> );
+    ArmJointStiffness tick(const boost::shared_ptr<Step>& supportStep);
 
     void startLeft();
     void startRight();
@@ -29,7 +32,8 @@ private:
     SupportMode nextState();
     void setState(SupportMode newState);
 
-    const float getShoulderPitchAddition(boost::shared_ptr<Step> supportStep);
+    const float getShoulderPitchAddition(
+        const boost::shared_ptr<Step>& supportStep);
 
 private:
     SupportMode state;
@@ -37,10 +37,11 @@ WalkingLeg::WalkingLeg(boost::shared_ptr<Sensors> s,
      frameCounter(0),
      cur_dest(EMPTY_STEP),swing_src(EMPTY_STEP),swing_dest(EMPTY_STEP),
      support_step(EMPTY_STEP),
+     dist_to_cover_x(0.0f), dist_to_cover_y(0.0f), hipHackStage(0),
      chainID(id), gait(_gait),
      goal(CoordFrame3D::vector3D(0.0f,0.0f,0.0f)),
      last_goal(CoordFrame3D::vector3D(0.0f,0.0f,0.0f)),
-     lastRotation(0.0f),odoUpdate(3,0.0f),
+     lastRotation(0.0f),
      leg_sign(id == LLEG_CHAIN ? 1 : -1),
      leg_name(id == LLEG_CHAIN ? "left" : "right"),
      sensorAngles(_sensorAngles), sensorAngleX(0.0f), sensorAngleY(0.0f)
@@ -66,6 +67,8 @@ WalkingLeg::WalkingLeg(boost::shared_ptr<Sensors> s,
             "angleX\tangleY\tstate\n");
 #endif
     for ( unsigned int i = 0 ; i< LEG_JOINTS; i++) lastJoints[i]=0.0f;
+    lastHipHacks[0] = lastHipHacks[1] = 0.0f;
+    for ( unsigned int i = 0 ; i< 3; i++) odoUpdate[i]=0.0f;
 }
 
 
@@ -78,19 +81,19 @@ WalkingLeg::~WalkingLeg(){
 #endif
 }
 
-void WalkingLeg::setSteps(boost::shared_ptr<Step> _swing_src,
-                          boost::shared_ptr<Step> _swing_dest,
-                          boost::shared_ptr<Step> _support_step){
+void WalkingLeg::setSteps(const boost::shared_ptr<Step>& _swing_src,
+                          const boost::shared_ptr<Step>& _swing_dest,
+                          const boost::shared_ptr<Step>& _support_step){
     swing_src = _swing_src;
     swing_dest = _swing_dest;
     support_step = _support_step;
     assignStateTimes(support_step);
 }
 
-LegJointStiffTuple WalkingLeg::tick(boost::shared_ptr<Step> step,
-                                boost::shared_ptr<Step> _swing_src,
-                                boost::shared_ptr<Step> _swing_dest,
-                                ufmatrix3 fc_Transform){
+LegJointStiffness WalkingLeg::tick(const boost::shared_ptr<Step>& step,
+                                   const boost::shared_ptr<Step>& _swing_src,
+                                   const boost::shared_ptr<Step>& _swing_dest,
+                                   const ufmatrix3& fc_Transform){
 #ifdef DEBUG_WALKINGLEG
     cout << "WalkingLeg::tick() "<<leg_name <<" leg, state is "<<state<<endl;
 #endif
@@ -102,22 +105,22 @@ LegJointStiffTuple WalkingLeg::tick(boost::shared_ptr<Step> step,
     //ufvector3 dest_c = prod(fc_Transform,dest_f);
     //float dest_x = dest_c(0);
     //float dest_y = dest_c(1);
-    LegJointStiffTuple result;
+    LegJointStiffness result;
     switch(state){
     case SUPPORTING:
-        result  = supporting(fc_Transform);
+        supporting(fc_Transform, result);
         break;
     case SWINGING:
-        result  =  swinging(fc_Transform);
+        swinging(fc_Transform, result);
         break;
     case DOUBLE_SUPPORT:
         //In dbl sup, we have already got the final target after swinging in
         //mind, so we actually want to keep the target as the "source"
         cur_dest = swing_src;
-        result  = supporting(fc_Transform);
+        supporting(fc_Transform, result);
         break;
     case PERSISTENT_DOUBLE_SUPPORT:
-        result  = supporting(fc_Transform);
+        supporting(fc_Transform, result);
         break;
     default:
         cout << "Invalid SupportMode"<<endl;
@@ -141,7 +144,8 @@ LegJointStiffTuple WalkingLeg::tick(boost::shared_ptr<Step> step,
 }
 //#define SENSOR_SCALE 0.75f
 #define SENSOR_SCALE 0.0f
-LegJointStiffTuple WalkingLeg::swinging(ufmatrix3 fc_Transform){
+void WalkingLeg::swinging(const ufmatrix3& fc_Transform,
+                          LegJointStiffness& result){
     ufvector3 dest_f = CoordFrame3D::vector3D(cur_dest->x,cur_dest->y);
     ufvector3 src_f = CoordFrame3D::vector3D(swing_src->x,swing_src->y);
 
@@ -152,9 +156,6 @@ LegJointStiffTuple WalkingLeg::swinging(ufmatrix3 fc_Transform){
     //float dest_x = dest_c(0);
     //float dest_y = dest_c(1);
 
-    static float dist_to_cover_x = 0;
-    static float dist_to_cover_y = 0;
-
      if(firstFrame()){
          dist_to_cover_x = cur_dest->x - swing_src->x;
          dist_to_cover_y = cur_dest->y - swing_src->y;
@@ -190,13 +191,12 @@ LegJointStiffTuple WalkingLeg::swinging(ufmatrix3 fc_Transform){
     goal(2) = -gait->stance[WP::BODY_HEIGHT] + heightOffGround;
 
 
-    vector<float> joint_result = finalizeJoints(goal);
-
-    vector<float> stiff_result = getStiffnesses();
-    return LegJointStiffTuple(joint_result,stiff_result);
+    finalizeJoints(goal, result.joints);
+    getStiffnesses(result.stiffnesses);
 }
 
-LegJointStiffTuple WalkingLeg::supporting(ufmatrix3 fc_Transform){//float dest_x, float dest_y) {
+void WalkingLeg::supporting(const ufmatrix3& fc_Transform,
+                            LegJointStiffness& result){
     /**
        this method calculates the angles for this leg when it is on the ground
        (i.e. the leg on the ground in single support, or either leg in double
@@ -213,13 +213,13 @@ LegJointStiffTuple WalkingLeg::supporting(ufmatrix3 fc_Transform){//float dest_x
     goal(1) = dest_y;  //targetY
     goal(2) = -gait->stance[WP::BODY_HEIGHT];         //targetZ
 
-    vector<float> joint_result = finalizeJoints(goal);
-    vector<float> stiff_result = getStiffnesses();
-    return LegJointStiffTuple(joint_result,stiff_result);
+    finalizeJoints(goal, result.joints);
+    getStiffnesses(result.stiffnesses);
 }
 
 
-const vector<float> WalkingLeg::finalizeJoints(const ufvector3& footGoal){
+void WalkingLeg::finalizeJoints(const ufvector3& footGoal,
+                                float joints[LEG_JOINTS]){
     const float startStopSensorScale = getEndStepSensorScale();
 
 
@@ -276,7 +276,7 @@ const vector<float> WalkingLeg::finalizeJoints(const ufvector3& footGoal){
     applyHipHacks(result.angles);
 
     memcpy(lastJoints, result.angles, LEG_JOINTS*sizeof(float));
-    return vector<float>(result.angles, &result.angles[LEG_JOINTS]);
+    memcpy(joints, result.angles, LEG_JOINTS*sizeof(float));
 
 }
 
@@ -377,6 +377,8 @@ void WalkingLeg::applyHipHacks(float angles[]){
     boost::tuple <const float, const float > hipHacks  = getHipHack(footAngleZ);
     angles[1] += hipHacks.get<1>(); //HipRoll
     angles[2] += hipHacks.get<0>(); //HipPitch
+    lastHipHacks[0] = hipHacks.get<1>();
+    lastHipHacks[1] = hipHacks.get<0>();
 }
 
 /**
@@ -397,7 +399,7 @@ WalkingLeg::getHipHack(const float footAngleZ){
         hack_chain = getOtherLegChainID();
     }else{
         // This step is double support, returning 0 hip hack
-        return 0.0f;
+        return boost::tuple<const float, const float>(0.0f, 0.0f);
     }
     const float support_sign = (state !=SWINGING? 1.0f : -1.0f);
     const float absFootAngle = std::abs(footAngleZ);
@@ -410,26 +412,25 @@ WalkingLeg::getHipHack(const float footAngleZ){
 
     // the swinging leg will follow a trapezoid in 3-d. The trapezoid has
     // three stages: going up, a level stretch, going back down to the ground
-    static int stage;
-    if (firstFrame()) stage = 0;
+    if (firstFrame()) hipHackStage = 0;
 
     float hr_offset = 0.0f;
 
-    if (stage == 0) { // we are rising
+    if (hipHackStage == 0) { // we are rising
         // we want to raise the foot up for the first third of the step duration
         hr_offset = MAX_HIP_ANGLE_OFFSET*
             static_cast<float>(frameCounter) /
             (static_cast<float>(singleSupportFrames)/3.0f);
         if (frameCounter >= (static_cast<float>(singleSupportFrames)
 							 / 3.0f) )
-            stage++;
+            hipHackStage++;
 
     }
-    else if (stage == 1) { // keep it level
+    else if (hipHackStage == 1) { // keep it level
         hr_offset  = MAX_HIP_ANGLE_OFFSET;
 
         if (frameCounter >= 2.* static_cast<float>(singleSupportFrames)/3)
-            stage++;
+            hipHackStage++;
     }
     else {// stage 2, set the foot back down on the ground
         hr_offset = max(0.0f,
@@ -460,7 +461,7 @@ WalkingLeg::getHipHack(const float footAngleZ){
  * in the gait cycle. Currently, the stiffnesses are static throughout the gait
  * cycle
  */
-const vector<float> WalkingLeg::getStiffnesses(){
+void WalkingLeg::getStiffnesses(float stiffnesses[LEG_JOINTS]){
 
     //get shorter names for all the constants
     const float maxS = gait->stiffness[WP::HIP];
@@ -468,12 +469,10 @@ const vector<float> WalkingLeg::getStiffnesses(){
     const float ankleRollS = gait->stiffness[WP::AR];
     const float kneeS = gait->stiffness[WP::KP];
 
-    float stiffnesses[LEG_JOINTS] = {maxS, maxS, maxS,
-                                     kneeS,anklePitchS,ankleRollS};
-    vector<float> stiff_result = vector<float>(stiffnesses,
-                                               &stiffnesses[LEG_JOINTS]);
-    return stiff_result;
-
+    stiffnesses[0] = stiffnesses[1] = stiffnesses[2] = maxS;
+    stiffnesses[3] = kneeS;
+    stiffnesses[4] = anklePitchS;
+    stiffnesses[5] = ankleRollS;
 }
 
 
@@ -531,13 +530,6 @@ WalkingLeg::getAnglesFromGoal(const ChainID chainID,
 }
 
 
-/**
- * Assuming this is the support foot, then we can return how far we have moved
- */
-vector<float> WalkingLeg::getOdoUpdate(){
-    return odoUpdate;
-}
-
 void WalkingLeg::startLeft(){
     if(chainID == LLEG_CHAIN){
         //we will start walking first by swinging left leg (this leg), so
@@ -605,7 +597,7 @@ void WalkingLeg::setState(SupportMode newState){
         lastRotation = -lastRotation;
 }
 
-void WalkingLeg::assignStateTimes(boost::shared_ptr<Step> step){
+void WalkingLeg::assignStateTimes(const boost::shared_ptr<Step>& step){
     doubleSupportFrames = step->doubleSupportFrames;
     singleSupportFrames = step->singleSupportFrames;
     cycleFrames = step->stepDurationFrames;
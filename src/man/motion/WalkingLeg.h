@@ -71,13 +71,11 @@
 #  define DEBUG_WALKING_SENSOR_LOGGING
 #endif
 
-typedef boost::tuple<std::vector<float>,
-                     std::vector<float> > LegJointStiffTuple;
-
-
-enum JointStiffIndex {
-    JOINT_INDEX,
-    STIFF_INDEX
+// A leg's joint angles and stiffnesses for one motion frame. They are
+// fixed arrays so that passing them up to the switchboard never allocates.
+struct LegJointStiffness {
+    float joints[Kinematics::LEG_JOINTS];
+    float stiffnesses[Kinematics::LEG_JOINTS];
 };
 
 class WalkingLeg  {
@@ -88,14 +86,14 @@ public:
                    Kinematics::ChainID id);
     ~WalkingLeg();
 
-    LegJointStiffTuple tick(boost::shared_ptr<Step> step,
-                             boost::shared_ptr<Step> swing_src,
-                             boost::shared_ptr<Step> _suppoting,
-                             NBMath::ufmatrix3 fc_Transform);
+    LegJointStiffness tick(const boost::shared_ptr<Step>& step,
+                           const boost::shared_ptr<Step>& swing_src,
+                           const boost::shared_ptr<Step>& _suppoting,
+                           const NBMath::ufmatrix3& fc_Transform);
 
-    void setSteps(boost::shared_ptr<Step> _swing_src,
-                  boost::shared_ptr<Step> _swing_dest,
-                  boost::shared_ptr<Step> _suppoting);
+    void setSteps(const boost::shared_ptr<Step>& _swing_src,
+                  const boost::shared_ptr<Step>& _swing_dest,
+                  const boost::shared_ptr<Step>& _suppoting);
 
     //Hopefully these never need to get called (architecturally).
     //Instead, use methods like startLeft, right etc
@@ -120,9 +118,15 @@ public:
             state == PERSISTENT_DOUBLE_SUPPORT || state == SUPPORTING;
     };
 
-    std::vector<float> getOdoUpdate();
+    // How far we moved this frame (x, y, theta), assuming this is the
+    // support foot
+    const float* getOdoUpdate() const { return odoUpdate; }
     void computeOdoUpdate();
 
+    // The hip roll and pitch the hip hack added this frame, to make up for
+    // the supporting hip giving under the robot's weight
+    const float* getHipHacks() const { return lastHipHacks; }
+
     static std::vector<float>
     getAnglesFromGoal(const Kinematics::ChainID chainID,
                       const NBMath::ufvector3 & goal,
@@ -130,11 +134,14 @@ public:
 
 private:
     //Execution methods, get called depending on which state the leg is in
-    LegJointStiffTuple supporting(NBMath::ufmatrix3 fc_Transform);
-    LegJointStiffTuple swinging(NBMath::ufmatrix3 fc_Transform);
+    void supporting(const NBMath::ufmatrix3& fc_Transform,
+                    LegJointStiffness& result);
+    void swinging(const NBMath::ufmatrix3& fc_Transform,
+                  LegJointStiffness& result);
 
     //Consolidated goal handleing
-    const std::vector<float> finalizeJoints(const NBMath::ufvector3& legGoal );
+    void finalizeJoints(const NBMath::ufvector3& legGoal,
+                        float joints[Kinematics::LEG_JOINTS]);
 
     //FSA methods
     void setState(SupportMode newState);
@@ -142,7 +149,7 @@ private:
     SupportMode nextState();
     bool shouldSwitchStates();
     bool firstFrame() const {return frameCounter == 0;}
-    void assignStateTimes(boost::shared_ptr<Step> step);
+    void assignStateTimes(const boost::shared_ptr<Step>& step);
     const boost::tuple<const float, const float> getSensorFeedback();
     void debugProcessing();
 //hack
@@ -155,7 +162,7 @@ private:
     const float getFootRotation_c();
     const float getHipYawPitch();
     void applyHipHacks(float angles[]);
-    const std::vector<float> getStiffnesses();
+    void getStiffnesses(float stiffnesses[Kinematics::LEG_JOINTS]);
     const boost::tuple<const float,const float>getHipHack(const float HYPAngle);
     const float cycloidy(float theta);
     const float cycloidx(float theta);
@@ -174,6 +181,12 @@ private:
 
     //destination attributes
     boost::shared_ptr<Step> cur_dest, swing_src, swing_dest,support_step;
+    //how far the swinging foot goes this step, set on its first frame
+    float dist_to_cover_x, dist_to_cover_y;
+    //which part of the hip hack trapezoid the supporting leg is in
+    int hipHackStage;
+    //hip roll and pitch added by the last applyHipHacks()
+    float lastHipHacks[2];
 
     //Leg Attributes
     Kinematics::ChainID chainID; //keep track of which leg this is
@@ -182,7 +195,7 @@ private:
     NBMath::ufvector3 goal;
     NBMath::ufvector3 last_goal;
     float lastRotation;
-    std::vector<float> odoUpdate;
+    float odoUpdate[3];
     int leg_sign; //-1 for right leg, 1 for left leg
     std::string leg_name;
 
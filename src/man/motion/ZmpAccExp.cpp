@@ -1,8 +1,10 @@
 #include "ZmpAccExp.h"
 #include "ExponentialFilter.h"
 
+// The file scope alpha, since in here plain alpha is the base's own,
+// still unset, member
 ZmpAccExp::ZmpAccExp()
-	: ExponentialFilter<AccelMeasurement, num_dimensions> (alpha)
+	: ExponentialFilter<AccelMeasurement, num_dimensions> (::alpha)
 {
 }
 
@@ -5,7 +5,6 @@
 #include "Kinematics.h"
 using namespace Kinematics;
 
-using namespace boost::numeric;
 
 const float ZmpEKF::beta = 0.1f;
 const float ZmpEKF::gamma = 0.5f;
@@ -41,16 +40,13 @@ void ZmpEKF::update(const ZmpTimeUpdate tUp,
                     const ZmpMeasurement zMeasure) {
     timeUpdate(tUp);
 
-    std::vector<ZmpMeasurement> z(1,zMeasure);
-    correctionStep(z);
+    singleCorrectionStep(zMeasure);
     //noCorrectionStep();
 }
 
 EKF<ZmpMeasurement,ZmpTimeUpdate, ZMP_NUM_DIMENSIONS, ZMP_NUM_MEASUREMENTS>::StateVector
 ZmpEKF::associateTimeUpdate(ZmpTimeUpdate u_k)
 {
-    static ZmpTimeUpdate lastUpdate = {0.0f, 0.0f};
-
     StateVector delta(ZMP_NUM_DIMENSIONS);
     delta(0) = u_k.cur_zmp_x - xhat_k(0);
     delta(1) = u_k.cur_zmp_y - xhat_k(1);
@@ -76,14 +72,12 @@ const float getVariance(const float divergence){
 }
 
 
-void ZmpEKF::incorporateMeasurement(ZmpMeasurement z,
+void ZmpEKF::incorporateMeasurement(const ZmpMeasurement& z,
                                     StateMeasurementMatrix &H_k,
                                     MeasurementMatrix &R_k,
                                     MeasurementVector &V_k)
 {
     static const float com_height  = 310; //TODO: Move this
-    static MeasurementVector last_measurement(
-        ublas::scalar_vector<float>(measurementSize, 0.0f));
 
     MeasurementVector z_x(measurementSize);
     z_x(0) = z.comX + com_height/GRAVITY_mss * z.accX;
@@ -97,10 +91,6 @@ void ZmpEKF::incorporateMeasurement(ZmpMeasurement z,
     V_k = z_x - xhat_k; // divergence
 
 
-    //MeasurementVector deltaS = z_x - last_measurement;
-
     R_k(0,0) = getVariance(V_k(0));//variance;
     R_k(1,1) = getVariance(V_k(1));//variance;
-
-    last_measurement = z_x;
 }
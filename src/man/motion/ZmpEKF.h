@@ -45,7 +45,7 @@ public:
 private:
     // Core functions
     virtual StateVector associateTimeUpdate(ZmpTimeUpdate u_k);
-    virtual void incorporateMeasurement(ZmpMeasurement z,
+    virtual void incorporateMeasurement(const ZmpMeasurement& z,
                                         StateMeasurementMatrix &H_k,
                                         MeasurementMatrix &R_k,
                                         MeasurementVector &V_k);
@@ -0,0 +1,141 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * The queue of previewed ZMP reference values for one axis, which the
+ * StepGenerator fills a step at a time and the walk controllers read the
+ * front of every motion frame.
+ *
+ * It is a ring over an array allocated up front, so pushing and popping
+ * don't allocate.  Every value is stored twice, at its slot and one
+ * capacity further on, which makes any run of values starting at the front
+ * contiguous in memory however the ring has wrapped.  The controllers'
+ * preview sum is then one straight dot product, done four floats at a time
+ * with SSE2 or NEON.  Everything else, including the Geode, runs the scalar
+ * loop.  Define NO_SIMD_PREVIEW to force the scalar loop.
+ *
+ * The StepGenerator holds the preview period plus a few steps of values,
+ * which DEFAULT_CAPACITY covers for steps of up to three seconds.  A gait
+ * with longer steps grows the ring once, when the step is ZMPed, and it
+ * then stays that size.
+ */
+
+#ifndef _ZmpRefBuffer_h_DEFINED
+#define _ZmpRefBuffer_h_DEFINED
+
+#include <vector>
+
+#ifndef NO_SIMD_PREVIEW
+#  if defined(__SSE2__)
+#    include <emmintrin.h>
+#    define PREVIEW_DOT_SSE2
+#  elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#    include <arm_neon.h>
+#    define PREVIEW_DOT_NEON
+#  endif
+#endif
+
+class ZmpRefBuffer {
+public:
+    // Must be a power of two
+    static const unsigned int DEFAULT_CAPACITY = 1024;
+
+    ZmpRefBuffer()
+        : values(2 * DEFAULT_CAPACITY, 0.0f), mask(DEFAULT_CAPACITY - 1),
+          head(0), count(0) { }
+
+    unsigned int size() const { return count; }
+    bool empty() const { return count == 0; }
+    unsigned int capacity() const { return mask + 1; }
+
+    void clear() { head = 0; count = 0; }
+
+    float front() const { return values[head]; }
+
+    // The i'th value from the front
+    float operator[](unsigned int i) const { return values[head + i]; }
+
+    void pop_front() {
+        head = (head + 1) & mask;
+        --count;
+    }
+
+    void push_back(float value) {
+        if (count == capacity())
+            grow(count + 1);
+        const unsigned int i = (head + count) & mask;
+        values[i] = value;
+        values[i + capacity()] = value;
+        ++count;
+    }
+
+    /**
+     * @return The sum of weights[i] times the i'th value from the front,
+     *         over the first n values, of which there must be at least n
+     */
+    float dot(const float *weights, unsigned int n) const {
+        const float *z = &values[head];
+        unsigned int i = 0;
+        float sum = 0.0f;
+
+#if defined(PREVIEW_DOT_SSE2)
+        __m128 acc = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(weights + i),
+                                             _mm_loadu_ps(z + i)));
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(PREVIEW_DOT_NEON)
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (; i + 4 <= n; i += 4)
+            acc = vmlaq_f32(acc, vld1q_f32(weights + i), vld1q_f32(z + i));
+        float lanes[4];
+        vst1q_f32(lanes, acc);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+        for (; i < n; ++i)
+            sum += weights[i] * z[i];
+        return sum;
+    }
+
+private:
+    void grow(unsigned int needed) {
+        unsigned int newCapacity = capacity();
+        while (newCapacity < needed)
+            newCapacity *= 2;
+
+        std::vector<float> grown(2 * newCapacity, 0.0f);
+        for (unsigned int i = 0; i < count; ++i) {
+            grown[i] = (*this)[i];
+            grown[i + newCapacity] = grown[i];
+        }
+        values.swap(grown);
+        mask = newCapacity - 1;
+        head = 0;
+    }
+
+    std::vector<float> values;
+    unsigned int mask;
+    unsigned int head;
+    unsigned int count;
+};
+
+#endif
@@ -0,0 +1,613 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <pthread.h>
+#include <boost/shared_ptr.hpp>
+
+#include "WalkSimulator.h"
+#include "WalkProvider.h"
+#include "COMKinematics.h"
+#include "InverseKinematics.h"
+#include "BasicWorldConstants.h"
+#include "Common.h"
+
+using namespace std;
+using namespace Kinematics;
+using namespace NBMath;
+using boost::shared_ptr;
+
+namespace {
+    // Where the FSRs are under the left foot, from the point under the
+    // ankle, in mm.  The right foot's are mirrored.  They bound each
+    // foot's part of the support polygon.
+    const float FSR_FRONT_X = 70.25f;
+    const float FSR_REAR_X = -30.25f;
+    const float FSR_OUTER_Y = 29.9f;
+    const float FSR_INNER_Y = -23.1f;
+
+    // Both feet are down when their soles are this close in height, mm
+    const float DOUBLE_SUPPORT_HEIGHT = 2.0f;
+
+    const float GRAVITY_mmss = -GRAVITY_mss * 1000.0f;
+
+    // As in GaitLearnStates.scoreGaitPerformance and noggin's Stability
+    const float STABILITY_WEIGHT = 50.0f;
+    const float LINEARITY_WEIGHT = 250.0f;
+    const float MINIMUM_REQUIRED_DISTANCE = 100.0f; // cm
+    const float DISTANCE_PENALTY = -400.0f;
+    const unsigned int POSITION_UPDATE_FRAMES = 15;
+    // How long standingZMPDeviation() stands on each foot
+    const unsigned int STAND_SWAP_FRAMES = 5;
+
+    long long fakeTime() { return 0; }
+
+    struct Point {
+        float x, y;
+        bool operator<(const Point& other) const {
+            return x < other.x || (x == other.x && y < other.y);
+        }
+    };
+
+    float cross(const Point& o, const Point& a, const Point& b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    /**
+     * The least distance from p to the line through any edge of the convex
+     * hull of points, which is how far p is inside the hull, or negative
+     * if it is outside.  points is sorted in place.
+     */
+    float hullMargin(Point points[], const int n, const Point& p) {
+        sort(points, points + n);
+
+        // Andrew's monotone chain, counter-clockwise
+        Point hull[2 * 8];
+        int k = 0;
+        for (int i = 0; i < n; ++i) {
+            while (k >= 2 && cross(hull[k-2], hull[k-1], points[i]) <= 0)
+                --k;
+            hull[k++] = points[i];
+        }
+        for (int i = n - 2, lower = k + 1; i >= 0; --i) {
+            while (k >= lower && cross(hull[k-2], hull[k-1], points[i]) <= 0)
+                --k;
+            hull[k++] = points[i];
+        }
+
+        float margin = 1e9f;
+        for (int i = 0; i + 1 < k; ++i) {
+            const float length = hypotf(hull[i+1].x - hull[i].x,
+                                        hull[i+1].y - hull[i].y);
+            if (length > 0.0f)
+                margin = min(margin, cross(hull[i], hull[i+1], p) / length);
+        }
+        return margin;
+    }
+
+    /**
+     * The robot under the walk, see WalkSimulator.h.
+     */
+    class SimulatedRobot {
+    public:
+        SimulatedRobot(shared_ptr<Sensors> s)
+            : sensors(s), frames(0), lastSupport(LEFT_SUPPORT),
+              odoX(0.0f), odoY(0.0f), odoH(0.0f),
+              angleX(0.0f), angleY(0.0f) {
+            for (int i = 0; i < 3; ++i) {
+                com[i] = lastCom[i] = secondLastCom[i] = 0.0f;
+                feet[0][i] = feet[1][i] = 0.0f;
+            }
+        }
+
+        /**
+         * Puts the robot at joints, having moved by odometry (as the walk
+         * gives it, in cm) and standing on support, and fills in frame.
+         */
+        void update(const float joints[NUM_JOINTS],
+                    const MotionModel& odometry,
+                    const SupportFoot support,
+                    WalkSimFrame& frame);
+
+    private:
+        void toWorld(const float v[3], float w[3]) const;
+        void toWorld(const float v[3], float w[3],
+                     const float leanX, const float leanY) const;
+        void lean(const float joints[NUM_JOINTS], const float feet_c[2][3],
+                  const int foot, float& leanX, float& leanY) const;
+        void toTorso(const float w[3], float v[3]) const;
+        void setSensors(const float joints[NUM_JOINTS],
+                        const float acc[3], const float zmp[2],
+                        const SupportFoot support, const bool doubleSupport);
+        void footCorners(const int foot, Point corners[4]) const;
+
+        shared_ptr<Sensors> sensors;
+        unsigned int frames;
+        SupportFoot lastSupport;
+        float odoX, odoY, odoH;
+        float angleX, angleY;
+        // World positions of the CoM, the last two frames', and the points
+        // under each ankle, indexed by SupportFoot
+        float com[3], lastCom[3], secondLastCom[3];
+        float feet[2][3];
+    };
+
+    // Rotz[odoH].Roty[angleY].Rotx[angleX], torso to world
+    void SimulatedRobot::toWorld(const float v[3], float w[3]) const {
+        toWorld(v, w, angleX, angleY);
+    }
+
+    // The same, leaning by leanX and leanY instead
+    void SimulatedRobot::toWorld(const float v[3], float w[3],
+                                 const float leanX, const float leanY) const {
+        float sinX, cosX, sinY, cosY, sinH, cosH;
+        sincosf(leanX, &sinX, &cosX);
+        sincosf(leanY, &sinY, &cosY);
+        sincosf(odoH, &sinH, &cosH);
+
+        const float y1 = cosX * v[1] - sinX * v[2];
+        const float z1 = sinX * v[1] + cosX * v[2];
+        const float x2 = cosY * v[0] + sinY * z1;
+        w[2] = -sinY * v[0] + cosY * z1;
+        w[0] = cosH * x2 - sinH * y1;
+        w[1] = sinH * x2 + cosH * y1;
+    }
+
+    void SimulatedRobot::toTorso(const float w[3], float v[3]) const {
+        float sinX, cosX, sinY, cosY, sinH, cosH;
+        sincosf(angleX, &sinX, &cosX);
+        sincosf(angleY, &sinY, &cosY);
+        sincosf(odoH, &sinH, &cosH);
+
+        const float x1 = cosH * w[0] + sinH * w[1];
+        const float y1 = -sinH * w[0] + cosH * w[1];
+        v[0] = cosY * x1 - sinY * w[2];
+        const float z2 = sinY * x1 + cosY * w[2];
+        v[1] = cosX * y1 + sinX * z2;
+        v[2] = -sinX * y1 + cosX * z2;
+    }
+
+    void SimulatedRobot::footCorners(const int foot, Point corners[4]) const {
+        const float side = (foot == LEFT_SUPPORT ? 1.0f : -1.0f);
+        const float xs[2] = { FSR_REAR_X, FSR_FRONT_X };
+        const float ys[2] = { side * FSR_INNER_Y, side * FSR_OUTER_Y };
+
+        float sinH, cosH;
+        sincosf(odoH, &sinH, &cosH);
+        for (int i = 0; i < 4; ++i) {
+            const float x = xs[i / 2], y = ys[i % 2];
+            corners[i].x = feet[foot][0] + cosH * x - sinH * y;
+            corners[i].y = feet[foot][1] + sinH * x + cosH * y;
+        }
+    }
+
+    // How the torso leans when foot is flat on the ground: its sole's up,
+    // from feet_c, the soles in the torso frame, is the world's up
+    void SimulatedRobot::lean(const float joints[NUM_JOINTS],
+                              const float feet_c[2][3], const int foot,
+                              float& leanX, float& leanY) const {
+        const ChainID ankles[2] = { LANKLE_CHAIN, RANKLE_CHAIN };
+        const ChainID legs[2] = { LLEG_CHAIN, RLEG_CHAIN };
+        const ufvector3 ankle =
+            forwardKinematics(ankles[foot],
+                              &joints[chain_first_joint[legs[foot]]]);
+        const float up[3] = { ankle(0) - feet_c[foot][0],
+                              ankle(1) - feet_c[foot][1],
+                              ankle(2) - feet_c[foot][2] };
+        leanX = atan2f(up[1], up[2]);
+        leanY = atan2f(-up[0], hypotf(up[1], up[2]));
+    }
+
+    void SimulatedRobot::update(const float joints[NUM_JOINTS],
+                                const MotionModel& odometry,
+                                const SupportFoot support,
+                                WalkSimFrame& frame) {
+        float sinH, cosH;
+        sincosf(odoH, &sinH, &cosH);
+        odoX += (odometry.deltaF * cosH - odometry.deltaL * sinH) * CM_TO_MM;
+        odoY += (odometry.deltaF * sinH + odometry.deltaL * cosH) * CM_TO_MM;
+        odoH += odometry.deltaR;
+
+        // The feet in the torso frame, and the lean on the support foot
+        const ChainID legs[2] = { LLEG_CHAIN, RLEG_CHAIN };
+        float feet_c[2][3];
+        for (int foot = 0; foot < 2; ++foot) {
+            const ufvector3 sole =
+                forwardKinematics(legs[foot],
+                                  &joints[chain_first_joint[legs[foot]]]);
+            for (int i = 0; i < 3; ++i)
+                feet_c[foot][i] = sole(i);
+        }
+        float lastAngleX = angleX, lastAngleY = angleY;
+        lean(joints, feet_c, support, angleX, angleY);
+
+        const ufvector4 com_c =
+            getCOMc(vector<float>(joints, joints + NUM_JOINTS));
+        float comFromFoot_c[3], comFromFoot[3];
+        for (int i = 0; i < 3; ++i)
+            comFromFoot_c[i] = com_c(i) - feet_c[support][i];
+        toWorld(comFromFoot_c, comFromFoot);
+
+        // Start with the CoM over the origin
+        if (frames == 0) {
+            feet[support][0] = -comFromFoot[0];
+            feet[support][1] = -comFromFoot[1];
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            secondLastCom[i] = (frames > 0 ? lastCom[i] : 0.0f);
+            lastCom[i] = com[i];
+        }
+
+        // The support foot stays where it was put down.  Measuring from it
+        // instead of the last one moves the CoM and the lean, by the new
+        // foot's height and by how far the soles are from parallel, without
+        // the robot moving, so the last two frames are moved with them.
+        if (frames > 0 && support != lastSupport) {
+            feet[support][2] = 0.0f;
+
+            float lastLeanX, lastLeanY;
+            lean(joints, feet_c, lastSupport, lastLeanX, lastLeanY);
+            float fromLast_c[3], fromLast[3];
+            for (int i = 0; i < 3; ++i)
+                fromLast_c[i] = com_c(i) - feet_c[lastSupport][i];
+            toWorld(fromLast_c, fromLast, lastLeanX, lastLeanY);
+            for (int i = 0; i < 3; ++i) {
+                const float moved = feet[support][i] + comFromFoot[i] -
+                    (feet[lastSupport][i] + fromLast[i]);
+                lastCom[i] += moved;
+                secondLastCom[i] += moved;
+            }
+            lastAngleX += angleX - lastLeanX;
+            lastAngleY += angleY - lastLeanY;
+        }
+        lastSupport = support;
+
+        const int other = (support == LEFT_SUPPORT ? RIGHT_SUPPORT :
+                           LEFT_SUPPORT);
+        float otherFromFoot_c[3], otherFromFoot[3];
+        for (int i = 0; i < 3; ++i)
+            otherFromFoot_c[i] = feet_c[other][i] - feet_c[support][i];
+        toWorld(otherFromFoot_c, otherFromFoot);
+
+        for (int i = 0; i < 3; ++i) {
+            com[i] = feet[support][i] + comFromFoot[i];
+            feet[other][i] = feet[support][i] + otherFromFoot[i];
+        }
+        const bool doubleSupport = fabsf(feet[other][2] - feet[support][2]) <
+            DOUBLE_SUPPORT_HEIGHT;
+
+        // The ZMP of the cart-table model, once there are three frames to
+        // find the CoM's acceleration from
+        float acc[3] = { 0.0f, 0.0f, 0.0f };
+        if (frames >= 2) {
+            const float dt2 = MOTION_FRAME_LENGTH_S * MOTION_FRAME_LENGTH_S;
+            for (int i = 0; i < 3; ++i)
+                acc[i] = (com[i] - 2.0f * lastCom[i] + secondLastCom[i]) / dt2;
+        }
+        const float zmpScale = com[2] / (acc[2] + GRAVITY_mmss);
+        const float zmp[2] = { com[0] - zmpScale * acc[0],
+                               com[1] - zmpScale * acc[1] };
+
+        Point polygon[8];
+        footCorners(support, polygon);
+        int corners = 4;
+        if (doubleSupport) {
+            footCorners(other, polygon + 4);
+            corners = 8;
+        }
+        const Point zmpPoint = { zmp[0], zmp[1] };
+
+        frame.comX = com[0];
+        frame.comY = com[1];
+        frame.comZ = com[2];
+        frame.zmpX = zmp[0];
+        frame.zmpY = zmp[1];
+        frame.zmpMargin = hullMargin(polygon, corners, zmpPoint);
+        frame.odoX = odoX;
+        frame.odoY = odoY;
+        frame.odoH = odoH;
+        frame.support = support;
+        frame.doubleSupport = doubleSupport;
+        memcpy(frame.joints, joints, sizeof(frame.joints));
+
+        // The inertial unit reads the lean's rate of change as its gyros
+        const float dt = MOTION_FRAME_LENGTH_S;
+        const float gyrX = (frames > 0 ? (angleX - lastAngleX) / dt : 0.0f);
+        const float gyrY = (frames > 0 ? (angleY - lastAngleY) / dt : 0.0f);
+
+        // and the CoM's acceleration less gravity, in m/s^2, in the torso
+        // frame, as its accelerometers
+        const float accWorld[3] = { acc[0] * 0.001f, acc[1] * 0.001f,
+                                    acc[2] * 0.001f + GRAVITY_mss };
+        float accTorso[3];
+        toTorso(accWorld, accTorso);
+        const Inertial inertial(accTorso[0], accTorso[1], accTorso[2],
+                                gyrX, gyrY, angleX, angleY);
+        sensors->setInertial(inertial);
+        sensors->setUnfilteredInertial(inertial);
+
+        // The FSRs share the robot's weight, in kg, between the feet on the
+        // ground, and between the front and back, left and right of each,
+        // by where the ZMP is
+        const float weight = TOTAL_MASS * 0.001f *
+            (acc[2] + GRAVITY_mmss) / GRAVITY_mmss;
+        float onFoot[2] = { 0.0f, 0.0f };
+        onFoot[support] = weight;
+        if (doubleSupport) {
+            const float dx = feet[other][0] - feet[support][0];
+            const float dy = feet[other][1] - feet[support][1];
+            const float lengthSq = dx * dx + dy * dy;
+            const float toOther = (lengthSq > 0.0f ?
+                                   ((zmp[0] - feet[support][0]) * dx +
+                                    (zmp[1] - feet[support][1]) * dy) /
+                                   lengthSq : 0.5f);
+            onFoot[other] = weight * clip(toOther, 0.0f, 1.0f);
+            onFoot[support] = weight - onFoot[other];
+        }
+
+        FSR fsrs[2] = { FSR(0.0f, 0.0f, 0.0f, 0.0f),
+                        FSR(0.0f, 0.0f, 0.0f, 0.0f) };
+        for (int foot = 0; foot < 2; ++foot) {
+            const float side = (foot == LEFT_SUPPORT ? 1.0f : -1.0f);
+            const float x = zmp[0] - feet[foot][0];
+            const float y = zmp[1] - feet[foot][1];
+            const float forward = cosH * x + sinH * y;
+            const float left = (-sinH * x + cosH * y) * side;
+            const float front = clip((forward - FSR_REAR_X) /
+                                     (FSR_FRONT_X - FSR_REAR_X), 0.0f, 1.0f);
+            // Toward the foot's left side
+            float toLeft = clip((left - FSR_INNER_Y) /
+                                (FSR_OUTER_Y - FSR_INNER_Y), 0.0f, 1.0f);
+            if (foot == RIGHT_SUPPORT)
+                toLeft = 1.0f - toLeft;
+
+            fsrs[foot] = FSR(onFoot[foot] * front * toLeft,
+                             onFoot[foot] * front * (1.0f - toLeft),
+                             onFoot[foot] * (1.0f - front) * toLeft,
+                             onFoot[foot] * (1.0f - front) * (1.0f - toLeft));
+        }
+        sensors->setFSR(fsrs[LEFT_SUPPORT], fsrs[RIGHT_SUPPORT]);
+        sensors->setSupportFoot(support);
+
+        // and the joints get where they were sent, in time for the next
+        // frame
+        sensors->setMotionBodyAngles(joints);
+        ++frames;
+    }
+
+    float variance(const vector<float>& values) {
+        if (values.empty())
+            return 0.0f;
+        float mean = 0.0f;
+        for (unsigned int i = 0; i < values.size(); ++i)
+            mean += values[i];
+        mean /= static_cast<float>(values.size());
+
+        float sumSquares = 0.0f;
+        for (unsigned int i = 0; i < values.size(); ++i)
+            sumSquares += (values[i] - mean) * (values[i] - mean);
+        return sumSquares / static_cast<float>(values.size());
+    }
+
+    float correlation(const vector<float>& xs, const vector<float>& ys) {
+        const float n = static_cast<float>(xs.size());
+        if (xs.size() < 2)
+            return 0.0f;
+        float meanX = 0.0f, meanY = 0.0f;
+        for (unsigned int i = 0; i < xs.size(); ++i) {
+            meanX += xs[i];
+            meanY += ys[i];
+        }
+        meanX /= n;
+        meanY /= n;
+
+        float sxy = 0.0f, sxx = 0.0f, syy = 0.0f;
+        for (unsigned int i = 0; i < xs.size(); ++i) {
+            sxy += (xs[i] - meanX) * (ys[i] - meanY);
+            sxx += (xs[i] - meanX) * (xs[i] - meanX);
+            syy += (ys[i] - meanY) * (ys[i] - meanY);
+        }
+        if (sxx <= 0.0f || syy <= 0.0f)
+            return 0.0f;
+        return sxy / sqrtf(sxx * syy);
+    }
+
+    void stanceJoints(const Gait& gait, float joints[NUM_JOINTS]) {
+        for (unsigned int i = 0; i < NUM_JOINTS; ++i)
+            joints[i] = 0.0f;
+        vector<float> *stance = StepGenerator::getDefaultStance(gait);
+        copy(stance->begin(), stance->end(), joints + HEAD_JOINTS);
+        delete stance;
+    }
+}
+
+float standingZMPDeviation(const Gait& gait, unsigned int frames)
+{
+    shared_ptr<Sensors> sensors(new Sensors());
+    SimulatedRobot robot(sensors);
+
+    float joints[NUM_JOINTS];
+    stanceJoints(gait, joints);
+
+    // Changing feet every few frames, as a walk does
+    float worst = 0.0f;
+    for (unsigned int f = 0; f < frames; ++f) {
+        const SupportFoot support = ((f / STAND_SWAP_FRAMES) % 2 == 0 ?
+                                     LEFT_SUPPORT : RIGHT_SUPPORT);
+        WalkSimFrame frame;
+        robot.update(joints, MotionModel(), support, frame);
+        worst = max(worst, hypotf(frame.zmpX - frame.comX,
+                                  frame.zmpY - frame.comY));
+    }
+    return worst;
+}
+
+WalkSimResult simulateWalk(const Gait& gait,
+                           const vector<WalkSimSegment>& plan,
+                           vector<WalkSimFrame> *trace)
+{
+    shared_ptr<Sensors> sensors(new Sensors());
+    shared_ptr<Profiler> profiler(new Profiler(&fakeTime));
+    WalkProvider walk(sensors, profiler);
+    SimulatedRobot robot(sensors);
+
+    // Stand in the gait's stance, so the walk starts straight from it
+    float joints[NUM_JOINTS];
+    stanceJoints(gait, joints);
+
+    walk.setCommand(shared_ptr<Gait>(new Gait(gait)));
+    vector<BodyJointCommand*> transition = walk.getGaitTransitionCommand();
+    for (unsigned int i = 0; i < transition.size(); ++i)
+        delete transition[i];
+
+    WalkSimFrame frame = WalkSimFrame();
+    float startX = 0.0f, startY = 0.0f;
+
+    WalkSimResult result;
+    result.frames = 0;
+    result.fell = false;
+    result.worstZMPMargin = 0.0f;
+
+    vector<float> accX, accY, pathX, pathY;
+    unsigned int outside = 0;
+
+    const ChainID walkChains[4] = { LARM_CHAIN, LLEG_CHAIN,
+                                    RLEG_CHAIN, RARM_CHAIN };
+    for (unsigned int s = 0; s < plan.size() && !result.fell; ++s) {
+        walk.setCommand(new WalkCommand(plan[s].x, plan[s].y, plan[s].theta));
+
+        const unsigned int frames = static_cast<unsigned int>(
+            plan[s].seconds / MOTION_FRAME_LENGTH_S + 0.5f);
+        for (unsigned int f = 0; f < frames; ++f) {
+            // Once the walk has stopped, the robot stands where it is, as
+            // it would under the switchboard
+            MotionModel odometry;
+            if (walk.isActive())
+                walk.calculateNextJointsAndStiffnesses();
+
+            // The robot has stood in the stance until now.  It stands on
+            // the foot the walk starts on, which the walk only knows once
+            // it has run a frame, so the first step doesn't move the
+            // support to the other foot.
+            if (result.frames == 0) {
+                robot.update(joints, MotionModel(), walk.getSupportFoot(),
+                             frame);
+                startX = frame.comX;
+                startY = frame.comY;
+                result.worstZMPMargin = frame.zmpMargin;
+            }
+
+            if (walk.isActive()) {
+                for (int c = 0; c < 4; ++c)
+                    memcpy(&joints[chain_first_joint[walkChains[c]]],
+                           walk.getChainJoints(walkChains[c]),
+                           chain_lengths[walkChains[c]] * sizeof(float));
+                odometry = walk.getOdometryUpdate();
+
+                // The support hip gives under the robot's weight by as much
+                // as the walk's hip hack makes up for
+                const SupportFoot support = walk.getSupportFoot();
+                const float *hipHacks = walk.getHipHacks(support);
+                const bool left = (support == LEFT_SUPPORT);
+
+                joints[left ? L_HIP_ROLL : R_HIP_ROLL] -= hipHacks[0];
+                joints[left ? L_HIP_PITCH : R_HIP_PITCH] -= hipHacks[1];
+            }
+
+            robot.update(joints, odometry, walk.getSupportFoot(), frame);
+            frame.controller = walk.getControllerState();
+            if (trace)
+                trace->push_back(frame);
+            ++result.frames;
+
+            const Inertial inertial = sensors->getInertial();
+            accX.push_back(inertial.accX);
+            accY.push_back(inertial.accY);
+            if (result.frames % POSITION_UPDATE_FRAMES == 0) {
+                pathX.push_back(frame.comX);
+                pathY.push_back(frame.comY);
+            }
+
+            result.worstZMPMargin = min(result.worstZMPMargin,
+                                        frame.zmpMargin);
+            outside = (frame.zmpMargin < 0.0f ? outside + 1 : 0);
+            if (outside > FALL_FRAMES) {
+                result.fell = true;
+                break;
+            }
+        }
+    }
+
+    result.framesStood = result.frames;
+    result.distance = hypotf(frame.comX - startX, frame.comY - startY);
+    result.odometryDistance = hypotf(frame.odoX, frame.odoY);
+    result.accVarianceX = variance(accX);
+    result.accVarianceY = variance(accY);
+    result.pathLinearity = fabsf(correlation(pathX, pathY));
+
+    const float distance = result.distance * MM_TO_CM;
+    result.score = static_cast<float>(result.framesStood) +
+        (distance < MINIMUM_REQUIRED_DISTANCE ? DISTANCE_PENALTY : distance) +
+        result.pathLinearity * LINEARITY_WEIGHT -
+        STABILITY_WEIGHT * (result.accVarianceX + result.accVarianceY);
+    return result;
+}
+
+namespace {
+    struct GaitJobs {
+        const vector<Gait> *gaits;
+        const vector<WalkSimSegment> *plan;
+        vector<WalkSimResult> *results;
+        volatile unsigned int next;
+    };
+
+    void* runGaitJobs(void *arg) {
+        GaitJobs *jobs = static_cast<GaitJobs*>(arg);
+        for (;;) {
+            const unsigned int i = __sync_fetch_and_add(&jobs->next, 1);
+            if (i >= jobs->gaits->size())
+                break;
+            (*jobs->results)[i] = simulateWalk((*jobs->gaits)[i],
+                                               *jobs->plan);
+        }
+        return 0;
+    }
+}
+
+void evaluateGaits(const vector<Gait>& gaits,
+                   const vector<WalkSimSegment>& plan,
+                   unsigned int numThreads,
+                   vector<WalkSimResult>& results)
+{
+    results.resize(gaits.size());
+    GaitJobs jobs = { &gaits, &plan, &results, 0 };
+
+    numThreads = max(1u, min(numThreads,
+                             static_cast<unsigned int>(gaits.size())));
+    vector<pthread_t> threads(numThreads - 1);
+    for (unsigned int i = 0; i < threads.size(); ++i)
+        pthread_create(&threads[i], NULL, runGaitJobs, &jobs);
+
+    runGaitJobs(&jobs);
+    for (unsigned int i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+}
@@ -0,0 +1,138 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * A headless stand-in for the robot under the walk engine, so gaits can be
+ * judged offline as fast as the CPU allows instead of in real time in
+ * Webots.
+ *
+ * Each frame runs a WalkProvider as the switchboard would, and the joints
+ * it asks for are fed back into its Sensors as though the robot had
+ * reached them.  The robot is taken to be rigid, but for its support hip
+ * giving under its weight by as much as the walk's hip hack makes up for,
+ * and to stand flat on its support foot.  That means the joints alone
+ * give where the CoM is, which way the torso leans and where each foot
+ * is, all from the existing forward kinematics.  The walk's own odometry
+ * gives the heading.  From that the simulated robot has:
+ *  - an inertial unit that reads the CoM's acceleration and the torso's
+ *    lean,
+ *  - FSRs that split the robot's weight by where the ZMP is,
+ *  - a ZMP from the cart-table model, checked against the support
+ *    polygon.  The robot falls if the ZMP stays outside it for more than
+ *    FALL_FRAMES frames in a row.
+ * Sensors are always a frame behind the joints, as on the robot.
+ *
+ * None of this is physics.  There is no other compliance, slipping or
+ * tipping, and the feet are taken to point along the heading.  A gait
+ * that does well here still has to be tried on the robot, but one that
+ * walks its ZMP off its feet here won't do any better there.
+ *
+ * Every simulation builds its own walk engine, so simulations can run on
+ * as many threads as there are cores.  See evaluateGaits().
+ */
+
+#ifndef _WalkSimulator_h_DEFINED
+#define _WalkSimulator_h_DEFINED
+
+#include <vector>
+
+#include "Gait.h"
+#include "Kinematics.h"
+#include "StepGenerator.h"
+
+// Frames the ZMP may spend outside the support polygon before the robot
+// has fallen, as in noggin's Stability.FALL_FRAMES_THRESHOLD
+static const unsigned int FALL_FRAMES = 15;
+
+/**
+ * Walk at a speed for a while, as a WalkCommand would: mm/s, mm/s, rad/s.
+ */
+struct WalkSimSegment {
+    float x, y, theta;
+    float seconds;
+};
+
+/**
+ * Everything recorded about one frame.  World positions are in mm, with
+ * the robot's CoM starting over the origin, facing along x.
+ */
+struct WalkSimFrame {
+    float joints[Kinematics::NUM_JOINTS];
+    // The preview controller's reference ZMP, ZMP and CoM, in the walk's
+    // I frame
+    WalkControllerState controller;
+    float comX, comY, comZ;
+    // ZMP of the CoM's motion, in the world
+    float zmpX, zmpY;
+    // Signed distance from the ZMP in to the edge of the support polygon
+    float zmpMargin;
+    // The walk's odometry, summed, in mm and rad
+    float odoX, odoY, odoH;
+    SupportFoot support;
+    bool doubleSupport;
+};
+
+struct WalkSimResult {
+    unsigned int frames;
+    // Frames until the robot fell, or all of them
+    unsigned int framesStood;
+    bool fell;
+    // Straight line distance the CoM went, mm
+    float distance;
+    // By the walk's own odometry, mm
+    float odometryDistance;
+    // The least zmpMargin of any frame, negative if the ZMP left the feet.
+    // A kink in the joints shows up here even if it only lasts a frame.
+    float worstZMPMargin;
+    // Variances of the simulated accelerometer, (m/s^2)^2
+    float accVarianceX, accVarianceY;
+    // Absolute correlation of the CoM's x and y, as noggin's Stability
+    // reports path linearity
+    float pathLinearity;
+    // GaitLearnStates' heuristic, higher is better
+    float score;
+};
+
+/**
+ * Starts the robot standing in gait's stance and walks it through plan,
+ * appending every frame to trace when it is given.  Stops early if the
+ * robot falls.
+ */
+WalkSimResult simulateWalk(const Gait& gait,
+                           const std::vector<WalkSimSegment>& plan,
+                           std::vector<WalkSimFrame> *trace = 0);
+
+/**
+ * Holds the robot still in gait's stance for frames frames, standing on
+ * each foot in turn, and returns how far the ZMP ever got from under the
+ * CoM, in mm.  A robot that isn't moving has its ZMP right under its CoM,
+ * so anything but zero is the simulation's own error.
+ */
+float standingZMPDeviation(const Gait& gait, unsigned int frames);
+
+/**
+ * Simulates each of gaits through plan on numThreads threads, and puts
+ * the results in results, in the same order.
+ */
+void evaluateGaits(const std::vector<Gait>& gaits,
+                   const std::vector<WalkSimSegment>& plan,
+                   unsigned int numThreads,
+                   std::vector<WalkSimResult>& results);
+
+#endif
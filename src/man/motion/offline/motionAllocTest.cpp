@@ -0,0 +1,209 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Checks that a motion frame doesn't touch the heap.  The switchboard has
+ * to finish every frame in time for the DCM, and an allocation can wait on
+ * the allocator's lock or page in memory, so once a motion is under way
+ * none of its frames may allocate.
+ *
+ * Replaces operator new with one that counts, starts each provider on a
+ * motion, lets it settle, and then counts the allocations over a few
+ * hundred frames: walking, moving the head to a set point and along a
+ * scripted command, and running a scripted body command.  Last it runs a
+ * switchboard on its own thread, as Motion does, with this thread as the
+ * enactor.  Starting a command may allocate, when it is chopped or its
+ * first step is planned, and those frames aren't counted.  Also checks
+ * that the walk's Steps fit in the StepPool.
+ *
+ * Usage: motionAllocTest [--frames n]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <boost/shared_ptr.hpp>
+
+#include "MotionSwitchboard.h"
+#include "UnfreezeCommand.h"
+
+using namespace std;
+using boost::shared_ptr;
+
+static volatile bool counting = false;
+static volatile long allocations = 0;
+
+// Kept out of line, and paired with countedFree(), so the compiler never
+// sees operator new's malloc() handed to a free() it inlined from delete
+static void* countedAlloc(size_t size) __attribute__((noinline));
+static void countedFree(void *p) __attribute__((noinline));
+
+static void* countedAlloc(size_t size)
+{
+    if (counting)
+        __sync_fetch_and_add(&allocations, 1);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+    return countedAlloc(size);
+}
+
+static void countedFree(void *p)
+{
+    free(p);
+}
+
+void operator delete(void *p) throw() { countedFree(p); }
+void operator delete[](void *p) throw() { countedFree(p); }
+
+static long long fakeTime() { return 0; }
+
+// Runs frames frames of the provider and gives how many allocations they made
+static long countFrames(MotionProvider& provider, int frames)
+{
+    allocations = 0;
+    counting = true;
+    for (int i = 0; i < frames; ++i)
+        provider.calculateNextJointsAndStiffnesses();
+    counting = false;
+    return allocations;
+}
+
+static bool check(const char *what, long allocated, int frames)
+{
+    printf("%-16s %6ld allocations in %d frames\n", what, allocated, frames);
+    return allocated == 0;
+}
+
+static void* runSwitchboard(void *switchboard)
+{
+    static_cast<MotionSwitchboard*>(switchboard)->run();
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 500;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        } else {
+            fprintf(stderr, "Usage: %s [--frames n]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1) {
+        fprintf(stderr, "--frames must be positive\n");
+        return 1;
+    }
+
+    shared_ptr<Sensors> sensors(new Sensors());
+    shared_ptr<Profiler> profiler(new Profiler(&fakeTime));
+    const float seconds = frames * MOTION_FRAME_LENGTH_S;
+    bool ok = true;
+
+    // The walk, a few steps in
+    WalkProvider walk(sensors, profiler);
+    walk.setCommand(shared_ptr<Gait>(new Gait(DEFAULT_GAIT)));
+    walk.setCommand(new WalkCommand(100.0f, 20.0f, 0.1f));
+    for (int i = 0; i < 200; ++i)
+        walk.calculateNextJointsAndStiffnesses();
+    ok &= check("walk", countFrames(walk, frames), frames);
+
+    // If the walk used up the pool, Steps would be coming from the heap
+    printf("%-16s %6u of %u step pool blocks in use\n", "",
+           StepPool::blocksInUse(), StepPool::NUM_BLOCKS);
+    ok &= StepPool::blocksInUse() < StepPool::NUM_BLOCKS;
+
+    // The head, slowly enough that it doesn't get there
+    HeadProvider head(sensors, profiler);
+    const SetHeadCommand setHead(1.0f, 0.3f, 0.5f / frames, 0.5f / frames);
+    head.setCommand(&setHead);
+    head.calculateNextJointsAndStiffnesses();
+    ok &= check("head set", countFrames(head, frames), frames);
+
+    head.setCommand(new HeadJointCommand(
+                        2.0f * seconds,
+                        new vector<float>(Kinematics::HEAD_JOINTS, 0.5f),
+                        new vector<float>(Kinematics::HEAD_JOINTS, 0.8f),
+                        Kinematics::INTERPOLATION_SMOOTH));
+    head.calculateNextJointsAndStiffnesses();
+    ok &= check("head scripted", countFrames(head, frames), frames);
+
+    // A body command, and holding still once it's done
+    ScriptedProvider scripted(sensors, profiler);
+    scripted.setCommand(new BodyJointCommand(
+                            seconds,
+                            new vector<float>(Kinematics::NUM_BODY_JOINTS,
+                                              0.2f),
+                            new vector<float>(Kinematics::NUM_JOINTS, 0.8f),
+                            Kinematics::INTERPOLATION_LINEAR));
+    scripted.calculateNextJointsAndStiffnesses();
+    ok &= check("body scripted", countFrames(scripted, frames), frames);
+
+    // The whole frame, switchboard and enactor
+    MotionSwitchboard switchboard(sensors, profiler);
+    switchboard.sendMotionCommand(shared_ptr<UnfreezeCommand>(
+                                      new UnfreezeCommand()));
+    switchboard.sendMotionCommand(new WalkCommand(100.0f, 20.0f, 0.1f));
+    switchboard.sendMotionCommand(&setHead);
+    switchboard.start();
+    pthread_t thread;
+    pthread_create(&thread, NULL, runSwitchboard, &switchboard);
+
+    // Through the gait transition and onto the walk before counting
+    float joints[Kinematics::NUM_JOINTS];
+    float stiffnesses[Kinematics::NUM_JOINTS];
+    int walkFrames = 0;
+    while (walkFrames < 200 + frames) {
+        if (switchboard.isWalkActive())
+            ++walkFrames;
+        if (walkFrames == 200) {
+            allocations = 0;
+            counting = true;
+        }
+        switchboard.getNextJoints(joints);
+        switchboard.getNextStiffness(stiffnesses);
+        sensors->setMotionBodyAngles(joints);
+        switchboard.signalNextFrame();
+        usleep(1000);
+    }
+    counting = false;
+    ok &= check("switchboard", allocations, frames);
+
+    switchboard.stop();
+    pthread_join(thread, NULL);
+
+    printf(ok ? "PASSED\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
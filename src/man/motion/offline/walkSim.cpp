@@ -0,0 +1,302 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Judges candidate gaits headlessly, as GaitLearnStates does in Webots,
+ * but on every core and as fast as they go, so a gait search is a batch
+ * job.  See WalkSimulator.h for what is simulated.
+ *
+ * Candidates come from a file, one gait a line, in the order and units of
+ * noggin's gaitToArray: stance, step, zmp, hack, sensor, stiffness, odo and
+ * arm configs, in cm and degrees.  Lines starting with # are skipped.
+ * Without a file, the default gait and random candidates around it are
+ * judged.  Each is walked at a speed for some seconds, and one line of
+ * results is printed for each, then how many were judged a second.  The
+ * first candidate's frames can be written out to a tab separated file.
+ * Every candidate is first held standing still, and nothing is judged if
+ * that moves its ZMP (see standingZMPDeviation()).
+ *
+ * Usage: walkSim [--gaits file] [--random n] [--threads n] [--seconds s]
+ *                [--speed x y theta] [--trace file]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "WalkSimulator.h"
+#include "GaitConstants.h"
+
+using namespace std;
+
+// Where each config starts in a candidate's line
+static const unsigned int STANCE_START = 0;
+static const unsigned int STEP_START = STANCE_START + WP::LEN_STANCE_CONFIG;
+static const unsigned int ZMP_START = STEP_START + WP::LEN_STEP_CONFIG;
+static const unsigned int HACK_START = ZMP_START + WP::LEN_ZMP_CONFIG;
+static const unsigned int SENSOR_START = HACK_START + WP::LEN_HACK_CONFIG;
+static const unsigned int STIFF_START = SENSOR_START + WP::LEN_SENSOR_CONFIG;
+static const unsigned int ODO_START = STIFF_START + WP::LEN_STIFF_CONFIG;
+static const unsigned int ARM_START = ODO_START + WP::LEN_ODO_CONFIG;
+static const unsigned int GAIT_LENGTH = ARM_START + WP::LEN_ARM_CONFIG;
+
+// How far random candidates stray from the default gait
+static const float RANDOM_SPREAD = 0.1f;
+
+// A robot standing still has to keep its ZMP this close to under its CoM,
+// mm, or the simulation itself is moving it
+static const unsigned int STAND_CHECK_FRAMES = 100;
+static const float STAND_TOLERANCE = 0.01f;
+
+static double seconds()
+{
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void convert(float target[], const float source[],
+                    const float conversion[], unsigned int length)
+{
+    for (unsigned int i = 0; i < length; ++i)
+        target[i] = source[i] * conversion[i];
+}
+
+// A gait from a line of values in gaitToArray's units
+static Gait gaitFromArray(const float values[GAIT_LENGTH])
+{
+    float converted[GAIT_LENGTH];
+    convert(converted + STANCE_START, values + STANCE_START,
+            WP::STANCE_CONVERSION, WP::LEN_STANCE_CONFIG);
+    convert(converted + STEP_START, values + STEP_START,
+            WP::STEP_CONVERSION, WP::LEN_STEP_CONFIG);
+    convert(converted + ZMP_START, values + ZMP_START,
+            WP::ZMP_CONVERSION, WP::LEN_ZMP_CONFIG);
+    convert(converted + HACK_START, values + HACK_START,
+            WP::HACK_CONVERSION, WP::LEN_HACK_CONFIG);
+    convert(converted + SENSOR_START, values + SENSOR_START,
+            WP::SENSOR_CONVERSION, WP::LEN_SENSOR_CONFIG);
+    convert(converted + STIFF_START, values + STIFF_START,
+            WP::STIFF_CONVERSION, WP::LEN_STIFF_CONFIG);
+    convert(converted + ODO_START, values + ODO_START,
+            WP::ODO_CONVERSION, WP::LEN_ODO_CONFIG);
+    convert(converted + ARM_START, values + ARM_START,
+            WP::ARM_CONVERSION, WP::LEN_ARM_CONFIG);
+
+    return Gait(converted + STANCE_START, converted + STEP_START,
+                converted + ZMP_START, converted + HACK_START,
+                converted + SENSOR_START, converted + STIFF_START,
+                converted + ODO_START, converted + ARM_START);
+}
+
+static bool readGaits(const char *path, vector<Gait>& gaits)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+
+    char line[4096];
+    unsigned int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        ++lineNumber;
+        char *p = line;
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        if (*p == '#' || *p == '\n' || *p == '\0')
+            continue;
+
+        float values[GAIT_LENGTH];
+        unsigned int n = 0;
+        for (char *end; n < GAIT_LENGTH; ++n, p = end) {
+            values[n] = strtof(p, &end);
+            if (end == p)
+                break;
+            while (*end == ',' || *end == ' ' || *end == '\t')
+                ++end;
+        }
+        if (n != GAIT_LENGTH) {
+            fprintf(stderr, "%s:%u: %u values, wanted %u\n",
+                    path, lineNumber, n, GAIT_LENGTH);
+            ok = false;
+        } else {
+            gaits.push_back(gaitFromArray(values));
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+// Scales each of the default gait's values by up to RANDOM_SPREAD either way
+static void perturb(float values[], const float defaults[],
+                    unsigned int length, unsigned int *seed)
+{
+    for (unsigned int i = 0; i < length; ++i) {
+        const float r = static_cast<float>(rand_r(seed)) / RAND_MAX;
+        values[i] = defaults[i] * (1.0f + RANDOM_SPREAD * (2.0f * r - 1.0f));
+    }
+}
+
+static Gait randomGait(unsigned int *seed)
+{
+    Gait gait(DEFAULT_GAIT);
+    perturb(gait.stance, WP::STANCE_DEFAULT, WP::LEN_STANCE_CONFIG, seed);
+    perturb(gait.step, WP::STEP_DEFAULT, WP::LEN_STEP_CONFIG, seed);
+    perturb(gait.zmp, WP::ZMP_DEFAULT, WP::LEN_ZMP_CONFIG, seed);
+    perturb(gait.hack, WP::HACK_DEFAULT, WP::LEN_HACK_CONFIG, seed);
+    perturb(gait.stiffness, WP::STIFF_DEFAULT, WP::LEN_STIFF_CONFIG, seed);
+    return gait;
+}
+
+static bool writeTrace(const char *path, const vector<WalkSimFrame>& trace)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+
+    fprintf(file, "frame\tsupport\tdouble\tcom_x\tcom_y\tcom_z\t"
+            "zmp_x\tzmp_y\tmargin\todo_x\todo_y\todo_h\t"
+            "pre_ref_x\tpre_ref_y\tpre_zmp_x\tpre_zmp_y\t"
+            "pre_com_x\tpre_com_y");
+    for (unsigned int j = 0; j < Kinematics::NUM_JOINTS; ++j)
+        fprintf(file, "\t%s", Kinematics::JOINT_STRINGS[j].c_str());
+    fprintf(file, "\n");
+
+    for (unsigned int i = 0; i < trace.size(); ++i) {
+        const WalkSimFrame& f = trace[i];
+        fprintf(file, "%u\t%d\t%d\t%g\t%g\t%g\t%g\t%g\t%g\t%g\t%g\t%g\t"
+                "%g\t%g\t%g\t%g\t%g\t%g",
+                i, f.support, f.doubleSupport, f.comX, f.comY, f.comZ,
+                f.zmpX, f.zmpY, f.zmpMargin, f.odoX, f.odoY, f.odoH,
+                f.controller.zmpRefX, f.controller.zmpRefY,
+                f.controller.zmpX, f.controller.zmpY,
+                f.controller.comX, f.controller.comY);
+        for (unsigned int j = 0; j < Kinematics::NUM_JOINTS; ++j)
+            fprintf(file, "\t%g", f.joints[j]);
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    return true;
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [--gaits file] [--random n] [--threads n] "
+            "[--seconds s] [--speed x y theta] [--trace file]\n", name);
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    const char *gaitsPath = 0, *tracePath = 0;
+    int numRandom = 15;
+    int numThreads = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    WalkSimSegment walk = { 100.0f, 0.0f, 0.0f, 20.0f };
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--gaits") == 0 && hasValue) {
+            gaitsPath = argv[++i];
+        } else if (strcmp(argv[i], "--random") == 0 && hasValue) {
+            numRandom = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            numThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            walk.seconds = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 3 < argc) {
+            walk.x = static_cast<float>(atof(argv[++i]));
+            walk.y = static_cast<float>(atof(argv[++i]));
+            walk.theta = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (numRandom < 0 || numThreads < 1 || walk.seconds <= 0.0f)
+        return usage(argv[0]);
+
+    vector<Gait> gaits;
+    if (gaitsPath) {
+        if (!readGaits(gaitsPath, gaits))
+            return 1;
+    } else {
+        gaits.push_back(DEFAULT_GAIT);
+        unsigned int seed = 1;
+        for (int i = 0; i < numRandom; ++i)
+            gaits.push_back(randomGait(&seed));
+    }
+    if (gaits.empty()) {
+        fprintf(stderr, "No gaits to judge\n");
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < gaits.size(); ++i) {
+        const float deviation = standingZMPDeviation(gaits[i],
+                                                     STAND_CHECK_FRAMES);
+        if (deviation > STAND_TOLERANCE) {
+            fprintf(stderr, "gait %u: the ZMP is %.3f mm from under the CoM "
+                    "of a robot standing still\n", i, deviation);
+            return 1;
+        }
+    }
+
+    // Stand a moment, then walk
+    vector<WalkSimSegment> plan;
+    const WalkSimSegment stand = { 0.0f, 0.0f, 0.0f, 1.0f };
+    plan.push_back(stand);
+    plan.push_back(walk);
+
+    const double start = seconds();
+    vector<WalkSimResult> results;
+    evaluateGaits(gaits, plan, numThreads, results);
+    const double elapsed = seconds() - start;
+
+    unsigned long frames = 0;
+    printf("gait\tscore\tstood\tfell\tdist_mm\todo_mm\tmargin_mm\t"
+           "acc_var_x\tacc_var_y\tlinearity\n");
+    for (unsigned int i = 0; i < results.size(); ++i) {
+        const WalkSimResult& r = results[i];
+        printf("%u\t%.1f\t%u\t%d\t%.1f\t%.1f\t%.1f\t%.4f\t%.4f\t%.3f\n",
+               i, r.score, r.framesStood, r.fell, r.distance,
+               r.odometryDistance, r.worstZMPMargin,
+               r.accVarianceX, r.accVarianceY, r.pathLinearity);
+        frames += r.frames;
+    }
+    fprintf(stderr, "%u gaits on %d threads in %.2f s: "
+            "%.1f gaits/s, %.0f frames/s, %.0fx real time\n",
+            static_cast<unsigned int>(gaits.size()), numThreads, elapsed,
+            gaits.size() / elapsed, frames / elapsed,
+            frames * MOTION_FRAME_LENGTH_S / elapsed);
+
+    if (tracePath) {
+        vector<WalkSimFrame> trace;
+        simulateWalk(gaits[0], plan, &trace);
+        if (!writeTrace(tracePath, trace))
+            return 1;
+    }
+    return 0;
+}
@@ -1,6 +1,5 @@
 #include "BallEKF.h"
 #include "FieldConstants.h"
-using namespace boost::numeric;
 using namespace boost;
 using namespace NBMath;
 using namespace std;
@@ -211,7 +210,7 @@ EKF<RangeBearingMeasurement, MotionModel, BALL_EKF_DIMENSION,
  *
  * @return the measurement invariance
  */
-void BallEKF::incorporateMeasurement(RangeBearingMeasurement z,
+void BallEKF::incorporateMeasurement(const RangeBearingMeasurement& z,
                                      StateMeasurementMatrix &H_k,
                                      MeasurementMatrix &R_k,
                                      MeasurementVector &V_k)
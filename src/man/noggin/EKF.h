@@ -7,13 +7,11 @@
 #ifndef EKF_h_DEFINED
 #define EKF_h_DEFINED
 //#define DEBUG_JACOBIAN_JUNK
-// Boost libraries
-#include <boost/numeric/ublas/matrix.hpp>
-#include <boost/numeric/ublas/vector.hpp>
+#include <vector>
+#include <iostream>
 
-#include "NBMatrixMath.h"
+#include "NBFixedMatrix.h"
 #include "NBMath.h"
-#include <boost/numeric/ublas/io.hpp> // for cout
 
 // Default uncertainty growth parameters
 #define DEFAULT_BETA 3.0f
@@ -46,41 +44,25 @@ template <class Measurement, class UpdateModel,
 class EKF
 {
 public:
-    // Our template dimensions allow us to use bounded arrays for storage
-    // We define our own types for simpler use throughout the class
+    // Our template dimensions let every matrix be a fixed size array whose
+    // arithmetic the compiler unrolls, see NBFixedMatrix.h
 
     // A vector with the number of state dimensions
-    typedef boost::numeric::ublas::vector<float, boost::numeric::ublas::
-                                          bounded_array<float,dimension> >
-        StateVector;
+    typedef NBMath::FixedVector<dimension> StateVector;
     // A vector with the length of the measurement dimensions
-    typedef boost::numeric::ublas::vector<float, boost::numeric::ublas::
-                                          bounded_array<float,mSize> >
-        MeasurementVector;
+    typedef NBMath::FixedVector<mSize> MeasurementVector;
 
     // A square matrix with state dimension number of rows and cols
-    typedef boost::numeric::ublas::matrix<float,
-                                          boost::numeric::ublas::row_major,
-                                          boost::numeric::ublas::
-                                          bounded_array<float, dimension*
-                                                        dimension> >
-    StateMatrix;
+    typedef NBMath::FixedMatrix<dimension, dimension> StateMatrix;
 
     // A square matrix with measurement dimension number of rows and cols
-    typedef boost::numeric::ublas::matrix<float,
-                                          boost::numeric::ublas::row_major,
-                                          boost::numeric::ublas::
-                                          bounded_array<float, mSize*
-                                                        mSize> >
-    MeasurementMatrix;
+    typedef NBMath::FixedMatrix<mSize, mSize> MeasurementMatrix;
 
     // A matrix that is of size measurement * states
-    typedef boost::numeric::ublas::matrix<float,
-                                          boost::numeric::ublas::row_major,
-                                          boost::numeric::ublas::
-                                          bounded_array<float, mSize*
-                                                        dimension> >
-    StateMeasurementMatrix;
+    typedef NBMath::FixedMatrix<mSize, dimension> StateMeasurementMatrix;
+
+    // A matrix that is of size states * measurement
+    typedef NBMath::FixedMatrix<dimension, mSize> MeasurementStateMatrix;
 
 protected:
     StateVector xhat_k; // Estimate Vector
@@ -89,7 +71,6 @@ protected:
     StateMatrix A_k; // Update measurement Jacobian
     StateMatrix P_k; // Uncertainty Matrix
     StateMatrix P_k_bar; // A priori uncertainty Matrix
-    const boost::numeric::ublas::identity_matrix<float> dimensionIdentity;
     const unsigned int numStates; // number of states in the kalman filter
     const unsigned int measurementSize; // dimension of the observation (z_k)
 
@@ -102,9 +83,9 @@ public:
         : xhat_k(dimension), xhat_k_bar(dimension),
           Q_k(dimension,dimension), A_k(dimension,dimension),
           P_k(dimension,dimension), P_k_bar(dimension,dimension),
-          dimensionIdentity(dimension), numStates(dimension),
+          numStates(dimension),
           measurementSize(mSize), betas(dimension), gammas(dimension),
-          frameCounter(0), K_k(numStates, measurementSize, 0.0f),
+          frameCounter(0), K_k(dimension, mSize, 0.0f),
 		  H_k(measurementSize, numStates, 0.0f),
 		  R_k(measurementSize, measurementSize, 0.0f),
 		  v_k(measurementSize){
@@ -159,9 +140,9 @@ public:
             Q_k(i,i) = betas(i) + gammas(i) * deltas(i) * deltas(i);
         }
 
-        // Update error covariance matrix
-        const StateMatrix newP = prod(P_k, trans(A_k));
-        P_k_bar = prod(A_k, newP) + Q_k;
+        // Update error covariance matrix, keeping it exactly symmetric
+        P_k_bar = prod(A_k, prod(P_k, trans(A_k))) + Q_k;
+        NBMath::symmetrize(P_k_bar);
 
 #ifdef DEBUG_JACOBIAN_JUNK
         bool outputInfos = false;
@@ -188,7 +169,7 @@ public:
 #endif
     }
 
-    virtual void correctionStep(std::vector<Measurement> z_k) {
+    virtual void correctionStep(const std::vector<Measurement>& z_k) {
 
         // Incorporate all correction observations
         for(unsigned int i = 0; i < z_k.size(); ++i) {
@@ -203,31 +184,36 @@ public:
 		updateState();
     }
 
-	virtual void correctionStep(Measurement z_k){
+    // The same for filters with a single measurement a frame, without
+    // building a vector to hold it
+    void singleCorrectionStep(const Measurement& z_k) {
+        correctionStep(z_k);
+        beforeCorrectionFinish();
+        updateState();
+    }
+
+	virtual void correctionStep(const Measurement& z_k){
 		incorporateMeasurement(z_k, H_k, R_k, v_k);
 
 		if (R_k(0,0) == DONT_PROCESS_KEY) {
 			return;
 		}
 		// Calculate the Kalman gain matrix
-		const StateMeasurementMatrix pTimesHTrans = prod(P_k_bar, trans(H_k));
-
-		if(measurementSize == 2){
-			K_k = prod(pTimesHTrans,
-					   NBMath::invert2by2(prod(H_k, pTimesHTrans) + R_k));
-		}else{
-			const MeasurementMatrix inv =
-				NBMath::solve(prod(H_k, pTimesHTrans) + R_k,
-							  boost::numeric::ublas::identity_matrix<float>(
-								  measurementSize));
-			K_k = prod(pTimesHTrans, inv);
-		}
+		const MeasurementStateMatrix pTimesHTrans = prod(P_k_bar, trans(H_k));
+		const MeasurementMatrix S_k = prod(H_k, pTimesHTrans) + R_k;
+
+		K_k = prod(pTimesHTrans, NBMath::invert(S_k));
 
 		// Use the Kalman gain matrix to determine the next estimate
 		xhat_k_bar = xhat_k_bar + prod(K_k, v_k);
 
-		// Update associate uncertainty
-		P_k_bar = prod(dimensionIdentity - prod(K_k,H_k), P_k_bar);
+		// Update associate uncertainty in Joseph form,
+		// (I - KH) P (I - KH)' + K R K', which stays symmetric and positive
+		// definite under rounding where (I - KH) P drifts
+		const StateMatrix IKH = StateMatrix::identity() - prod(K_k, H_k);
+		P_k_bar = prod(prod(IKH, P_k_bar), trans(IKH)) +
+			prod(prod(K_k, R_k), trans(K_k));
+		NBMath::symmetrize(P_k_bar);
 	}
 
     virtual void noCorrectionStep(void) {
@@ -250,7 +236,7 @@ public:
 protected:
     // Pure virtual methods to be specified by implementing class
     virtual StateVector associateTimeUpdate(UpdateModel u_k) = 0;
-    virtual void incorporateMeasurement(Measurement z,
+    virtual void incorporateMeasurement(const Measurement& z,
                                         StateMeasurementMatrix &H_k,
                                         MeasurementMatrix &R_k,
                                         MeasurementVector &V_k) = 0;
@@ -273,7 +259,8 @@ protected:
     }
 
 	// Necessary computational matrices for correction step
-	StateMeasurementMatrix K_k, H_k;
+	MeasurementStateMatrix K_k;
+	StateMeasurementMatrix H_k;
 	MeasurementMatrix R_k;
 	MeasurementVector v_k;
 };
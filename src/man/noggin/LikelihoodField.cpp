@@ -0,0 +1,459 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include "LikelihoodField.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ConcreteCorner.h"
+#include "ConcreteLine.h"
+#include "FieldConstants.h"
+
+using namespace std;
+
+static const char LIKELIHOOD_FIELD_MAGIC[4] = { 'N', 'B', 'L', 'F' };
+static const uint32_t LIKELIHOOD_FIELD_VERSION = 1;
+static const int MAX_TABLE_LANDMARKS = ConcreteCorner::NUM_CORNERS;
+
+/**
+ * Start of the image.  Everything in it is written by this class on this
+ * machine, so it is in the machine's own byte order.
+ */
+struct LikelihoodField::Header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t bytes;             // Of the whole image
+    int32_t cols, rows;         // Grid nodes
+    int32_t numTables;
+    float originX, originY;     // Field position of node (0, 0)
+    float cellSize;
+};
+
+/**
+ * One landmark group.  Its grid holds (dx, dy) for every node, row by row.
+ */
+struct LikelihoodField::Table
+{
+    char name[24];
+    int32_t isLine;
+    int32_t numLandmarks;
+    float landmarks[MAX_TABLE_LANDMARKS][4]; // x, y or x1, y1, x2, y2
+    uint32_t offset;            // Of the grid from the start of the image
+};
+
+LikelihoodField::LikelihoodField(const char *cacheFile)
+    : image(0), mappedBytes(0)
+{
+    for (int i = 0; i < LIKELIHOOD_FIELD_HEADINGS; ++i) {
+        const float a = 2.0f * M_PI_FLOAT * i / LIKELIHOOD_FIELD_HEADINGS;
+        cosTable[i] = cosf(a);
+        sinTable[i] = sinf(a);
+    }
+
+    if (cacheFile != 0 && load(cacheFile)) {
+        return;
+    }
+    generate();
+    if (cacheFile != 0 && !save(cacheFile)) {
+        cerr << "LikelihoodField: could not write " << cacheFile << endl;
+    }
+}
+
+LikelihoodField::~LikelihoodField()
+{
+    if (mappedBytes != 0) {
+        munmap(const_cast<char*>(image), mappedBytes);
+    } else {
+        free(const_cast<char*>(image));
+    }
+}
+
+// Directory
+
+/**
+ * Fills in the header and the table directory for the current field, with
+ * the grids' offsets but not the grids.
+ */
+void LikelihoodField::makeDirectory(Header& h, vector<Table>& tables) const
+{
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, LIKELIHOOD_FIELD_MAGIC, sizeof(h.magic));
+    h.version = LIKELIHOOD_FIELD_VERSION;
+    h.cellSize = LIKELIHOOD_FIELD_CELL;
+    h.originX = -LIKELIHOOD_FIELD_MARGIN;
+    h.originY = -LIKELIHOOD_FIELD_MARGIN;
+    h.cols = static_cast<int32_t>(ceilf((FIELD_WIDTH +
+                                         2.0f * LIKELIHOOD_FIELD_MARGIN) /
+                                        LIKELIHOOD_FIELD_CELL)) + 1;
+    h.rows = static_cast<int32_t>(ceilf((FIELD_HEIGHT +
+                                         2.0f * LIKELIHOOD_FIELD_MARGIN) /
+                                        LIKELIHOOD_FIELD_CELL)) + 1;
+
+    const struct {
+        const char *name;
+        const vector<const ConcreteCorner*>& corners;
+    } groups[] = {
+        { "corners", ConcreteCorner::concreteCorners() },
+        { "l corners", ConcreteCorner::lCorners() },
+        { "t corners", ConcreteCorner::tCorners() },
+        { "center circle", ConcreteCorner::ccCorners() },
+        { "blue goal corners", ConcreteCorner::blueGoalCorners() },
+        { "yellow goal corners", ConcreteCorner::yellowGoalCorners() }
+    };
+    const int numGroups = sizeof(groups) / sizeof(groups[0]);
+
+    tables.assign(numGroups + 1, Table());
+    for (unsigned int i = 0; i < tables.size(); ++i) {
+        memset(&tables[i], 0, sizeof(Table));
+    }
+
+    Table& lines = tables[0];
+    strncpy(lines.name, "lines", sizeof(lines.name) - 1);
+    lines.isLine = 1;
+    const vector<const ConcreteLine*>& concrete = ConcreteLine::concreteLines();
+    for (unsigned int i = 0; i < concrete.size() &&
+             lines.numLandmarks < MAX_TABLE_LANDMARKS; ++i) {
+        float *l = lines.landmarks[lines.numLandmarks++];
+        l[0] = concrete[i]->getFieldX1();
+        l[1] = concrete[i]->getFieldY1();
+        l[2] = concrete[i]->getFieldX2();
+        l[3] = concrete[i]->getFieldY2();
+    }
+
+    for (int g = 0; g < numGroups; ++g) {
+        Table& t = tables[g + 1];
+        strncpy(t.name, groups[g].name, sizeof(t.name) - 1);
+        const vector<const ConcreteCorner*>& corners = groups[g].corners;
+        for (unsigned int i = 0; i < corners.size() &&
+                 t.numLandmarks < MAX_TABLE_LANDMARKS; ++i) {
+            float *p = t.landmarks[t.numLandmarks++];
+            p[0] = corners[i]->getFieldX();
+            p[1] = corners[i]->getFieldY();
+        }
+    }
+
+    // Grids after the directory, each on a 16 byte boundary
+    const uint32_t gridBytes = h.cols * h.rows * 2 * sizeof(float);
+    uint32_t offset = sizeof(Header) + tables.size() * sizeof(Table);
+    offset = (offset + 15) & ~15u;
+    for (unsigned int i = 0; i < tables.size(); ++i) {
+        tables[i].offset = offset;
+        offset += (gridBytes + 15) & ~15u;
+    }
+    h.numTables = tables.size();
+    h.bytes = offset;
+}
+
+/**
+ * Finds the vector from every node to the nearest landmark of t.  For a
+ * line that is the nearest point of the segment.
+ */
+void LikelihoodField::fillTable(const Table& t, float *grid) const
+{
+    const Header& g = header();
+    for (int r = 0; r < g.rows; ++r) {
+        const float py = g.originY + r * g.cellSize;
+        for (int c = 0; c < g.cols; ++c) {
+            const float px = g.originX + c * g.cellSize;
+
+            float best = -1.0f, bestX = 0.0f, bestY = 0.0f;
+            for (int i = 0; i < t.numLandmarks; ++i) {
+                const float *l = t.landmarks[i];
+                float nx = l[0], ny = l[1];
+                if (t.isLine) {
+                    const float lx = l[2] - l[0];
+                    const float ly = l[3] - l[1];
+                    const float len2 = lx * lx + ly * ly;
+                    float u = len2 > 0.0f ?
+                        ((px - l[0]) * lx + (py - l[1]) * ly) / len2 : 0.0f;
+                    u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+                    nx = l[0] + u * lx;
+                    ny = l[1] + u * ly;
+                }
+                const float d2 = (nx - px) * (nx - px) + (ny - py) * (ny - py);
+                if (best < 0.0f || d2 < best) {
+                    best = d2;
+                    bestX = nx;
+                    bestY = ny;
+                }
+            }
+
+            float *node = grid + 2 * (r * g.cols + c);
+            node[0] = bestX - px;
+            node[1] = bestY - py;
+        }
+    }
+}
+
+void LikelihoodField::generate()
+{
+    Header h;
+    vector<Table> tables;
+    makeDirectory(h, tables);
+
+    char *buffer;
+    if (posix_memalign(reinterpret_cast<void**>(&buffer), 16, h.bytes) != 0) {
+        cerr << "LikelihoodField: could not allocate " << h.bytes
+             << " bytes" << endl;
+        return;
+    }
+    memset(buffer, 0, h.bytes);
+    memcpy(buffer, &h, sizeof(h));
+    memcpy(buffer + sizeof(h), &tables[0], tables.size() * sizeof(Table));
+    image = buffer;
+    mappedBytes = 0;
+
+    for (unsigned int i = 0; i < tables.size(); ++i) {
+        fillTable(tables[i], reinterpret_cast<float*>(buffer +
+                                                      tables[i].offset));
+    }
+}
+
+/**
+ * Maps in the tables from path if its header and directory are the ones
+ * the current field constants give.
+ */
+bool LikelihoodField::load(const char *path)
+{
+    Header h;
+    vector<Table> tables;
+    makeDirectory(h, tables);
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != static_cast<off_t>(h.bytes)) {
+        close(fd);
+        return false;
+    }
+    void *map = mmap(0, h.bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const char *mapped = static_cast<const char*>(map);
+    if (memcmp(mapped, &h, sizeof(h)) != 0 ||
+        memcmp(mapped + sizeof(h), &tables[0],
+               tables.size() * sizeof(Table)) != 0) {
+        munmap(map, h.bytes);
+        return false;
+    }
+    image = mapped;
+    mappedBytes = h.bytes;
+    return true;
+}
+
+bool LikelihoodField::save(const char *path) const
+{
+    if (image == 0) {
+        return false;
+    }
+    string temp = string(path) + ".XXXXXX";
+    vector<char> name(temp.begin(), temp.end());
+    name.push_back('\0');
+    const int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+        return false;
+    }
+    // mkstemp() makes it private, the cache is as readable as fopen() made it
+    fchmod(fd, 0644);
+    FILE *f = fdopen(fd, "wb");
+    if (f == 0) {
+        close(fd);
+        unlink(&name[0]);
+        return false;
+    }
+    const bool wrote = fwrite(image, header().bytes, 1, f) == 1;
+    if (fclose(f) != 0 || !wrote || rename(&name[0], path) != 0) {
+        unlink(&name[0]);
+        return false;
+    }
+    return true;
+}
+
+// Lookups
+
+const LikelihoodField::Header& LikelihoodField::header() const
+{
+    return *reinterpret_cast<const Header*>(image);
+}
+
+const LikelihoodField::Table& LikelihoodField::table(int i) const
+{
+    return reinterpret_cast<const Table*>(image + sizeof(Header))[i];
+}
+
+const float* LikelihoodField::offsets(int i) const
+{
+    return reinterpret_cast<const float*>(image + table(i).offset);
+}
+
+int LikelihoodField::getNumTables() const
+{
+    return image != 0 ? header().numTables : 0;
+}
+
+const char* LikelihoodField::getTableName(int i) const
+{
+    return table(i).name;
+}
+
+int LikelihoodField::findTable(const vector<PointLandmark>& possible) const
+{
+    for (int i = 0; i < getNumTables(); ++i) {
+        const Table& t = table(i);
+        if (t.isLine || t.numLandmarks != static_cast<int>(possible.size())) {
+            continue;
+        }
+        unsigned int j = 0;
+        for ( ; j < possible.size(); ++j) {
+            int k = 0;
+            while (k < t.numLandmarks &&
+                   (t.landmarks[k][0] != possible[j].x ||
+                    t.landmarks[k][1] != possible[j].y)) {
+                ++k;
+            }
+            if (k == t.numLandmarks) {
+                break;
+            }
+        }
+        if (j == possible.size()) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int LikelihoodField::findTable(const vector<LineLandmark>& possible) const
+{
+    for (int i = 0; i < getNumTables(); ++i) {
+        const Table& t = table(i);
+        if (!t.isLine || t.numLandmarks != static_cast<int>(possible.size())) {
+            continue;
+        }
+        unsigned int j = 0;
+        for ( ; j < possible.size(); ++j) {
+            const LineLandmark& l = possible[j];
+            int k = 0;
+            for ( ; k < t.numLandmarks; ++k) {
+                const float *m = t.landmarks[k];
+                if ((m[0] == l.x1 && m[1] == l.y1 &&
+                     m[2] == l.x2 && m[3] == l.y2) ||
+                    (m[0] == l.x2 && m[1] == l.y2 &&
+                     m[2] == l.x1 && m[3] == l.y1)) {
+                    break;
+                }
+            }
+            if (k == t.numLandmarks) {
+                break;
+            }
+        }
+        if (j == possible.size()) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Bilinear interpolation of the table's vectors at (x, y).  Points off the
+ * grid read the nearest point of its edge and add the step back out.
+ */
+static inline void interpolate(const float *grid, int cols, int rows,
+                               float originX, float originY, float invCell,
+                               float cellSize, float x, float y,
+                               float& dx, float& dy)
+{
+    const float gx = (x - originX) * invCell;
+    const float gy = (y - originY) * invCell;
+    const float maxX = cols - 1.001f;
+    const float maxY = rows - 1.001f;
+    const float cx = gx < 0.0f ? 0.0f : (gx > maxX ? maxX : gx);
+    const float cy = gy < 0.0f ? 0.0f : (gy > maxY ? maxY : gy);
+    const int ix = static_cast<int>(cx);
+    const int iy = static_cast<int>(cy);
+    const float fx = cx - ix;
+    const float fy = cy - iy;
+
+    const float *n00 = grid + 2 * (iy * cols + ix);
+    const float *n01 = n00 + 2 * cols;
+    const float w00 = (1.0f - fx) * (1.0f - fy);
+    const float w10 = fx * (1.0f - fy);
+    const float w01 = (1.0f - fx) * fy;
+    const float w11 = fx * fy;
+    dx = (w00 * n00[0] + w10 * n00[2] + w01 * n01[0] + w11 * n01[2] +
+          (cx - gx) * cellSize);
+    dy = (w00 * n00[1] + w10 * n00[3] + w01 * n01[1] + w11 * n01[3] +
+          (cy - gy) * cellSize);
+}
+
+void LikelihoodField::nearest(int t, float x, float y,
+                              float& dx, float& dy) const
+{
+    const Header& g = header();
+    interpolate(offsets(t), g.cols, g.rows, g.originX, g.originY,
+                1.0f / g.cellSize, g.cellSize, x, y, dx, dy);
+}
+
+void LikelihoodField::weigh(int t, const float* x, const float* y,
+                            const float* h, float* w, int begin, int end,
+                            const MCLKernels::Measurement& z) const
+{
+    const Header& g = header();
+    const float *grid = offsets(t);
+    const float invCell = 1.0f / g.cellSize;
+    const float headingScale = LIKELIHOOD_FIELD_HEADINGS / (2.0f * M_PI_FLOAT);
+    const int headingMask = LIKELIHOOD_FIELD_HEADINGS - 1;
+    const float headingBias = 4.0f * LIKELIHOOD_FIELD_HEADINGS + 0.5f;
+    // Across the line of sight an error of e cm is a bearing error of e/d
+    const float invVarAcross = z.invVarA / (z.dist * z.dist > 1.0f ?
+                                            z.dist * z.dist : 1.0f);
+
+    for (int i = begin; i < end; ++i) {
+        // Shifted up a few turns so the cast rounds; any turns left below
+        // zero are still masked into the table, only off by one bucket
+        const int k = static_cast<int>((h[i] + z.bearing) * headingScale +
+                                       headingBias) & headingMask;
+        const float ux = cosTable[k];
+        const float uy = sinTable[k];
+
+        float ex, ey;
+        interpolate(grid, g.cols, g.rows, g.originX, g.originY, invCell,
+                    g.cellSize, x[i] + z.dist * ux, y[i] + z.dist * uy,
+                    ex, ey);
+
+        const float along = ex * ux + ey * uy;
+        const float across = ey * ux - ex * uy;
+        const float s = MCLKernels::fastExp(-(along * along) * z.invVarD -
+                                            (across * across) * invVarAcross);
+        w[i] *= s < z.minSimilarity ? z.minSimilarity : s;
+    }
+}
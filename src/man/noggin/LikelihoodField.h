@@ -0,0 +1,128 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Precomputed likelihood fields for MCL's measurement model.
+ *
+ * For each of a fixed set of landmark groups (every line, the L, T and
+ * center circle corners, every corner, the corners of each goal box) a
+ * grid over the field holds, at every node, the vector from the node to
+ * the nearest landmark of the group.  The groups and their positions come
+ * from ConcreteLine and ConcreteCorner, so from FieldConstants.h.
+ *
+ * A particle weighs an observation by projecting the observed distance and
+ * bearing out onto the field, reading the vector to the nearest landmark
+ * there by bilinear interpolation, and splitting it into the part along
+ * the line of sight (a distance error) and across it (a bearing error
+ * times the distance).  Within the area one landmark is nearest to, the
+ * interpolated vector is exact, so this agrees with MCLKernels' range and
+ * bearing model to first order in the errors.  The line of sight comes
+ * from a table of headings, so no particle needs hypot or atan2.
+ *
+ * The tables are a single image that can be written to a file and mapped
+ * back in on the next start.  The image starts with the grid geometry and
+ * the landmarks of every group, and is only used if those match what the
+ * current field constants generate; otherwise it is regenerated.
+ */
+
+#ifndef LikelihoodField_h_DEFINED
+#define LikelihoodField_h_DEFINED
+
+#include <vector>
+#include <stdint.h>
+
+#include "NogginStructs.h"
+#include "MCLKernels.h"
+
+// Grid spacing and how far the grid reaches past the green on each side
+static const float LIKELIHOOD_FIELD_CELL = 10.0f; // cm
+static const float LIKELIHOOD_FIELD_MARGIN = 100.0f; // cm
+// Heading table size, a power of two
+static const int LIKELIHOOD_FIELD_HEADINGS = 2048;
+
+class LikelihoodField
+{
+public:
+    /**
+     * @param cacheFile If given, the tables are mapped in from this file
+     *                  when it holds tables for the current field, and
+     *                  otherwise generated and written to it.  If 0 they
+     *                  are always generated.
+     */
+    LikelihoodField(const char *cacheFile = 0);
+    ~LikelihoodField();
+
+    /**
+     * @return The table whose landmarks are exactly these possibilities,
+     *         in any order, or -1 if there is none.
+     */
+    int findTable(const std::vector<PointLandmark>& possible) const;
+    int findTable(const std::vector<LineLandmark>& possible) const;
+
+    /**
+     * Weighs particles [begin, end) against an observation of one of the
+     * landmarks of the given table.
+     */
+    void weigh(int table, const float* x, const float* y, const float* h,
+               float* w, int begin, int end,
+               const MCLKernels::Measurement& z) const;
+
+    /**
+     * The vector from (x, y) to the nearest landmark of the table, as the
+     * particles see it.
+     */
+    void nearest(int table, float x, float y, float& dx, float& dy) const;
+
+    int getNumTables() const;
+    const char* getTableName(int table) const;
+
+    // True if the tables came from the cache file
+    bool isMapped() const { return mappedBytes != 0; }
+
+    /**
+     * Writes the tables to a file load() can map.  The file is written
+     * under a temporary name and renamed over path, so nothing mapping path
+     * ever sees it half written.  Returns false if the file could not be
+     * written.
+     */
+    bool save(const char *path) const;
+
+private:
+    struct Header;
+    struct Table;
+
+    void generate();
+    bool load(const char *path);
+    void makeDirectory(Header& header, std::vector<Table>& tables) const;
+    void fillTable(const Table& t, float *offsets) const;
+
+    const Header& header() const;
+    const Table& table(int i) const;
+    const float* offsets(int i) const;
+
+    const char *image; // Header, the tables, then every table's grid
+    size_t mappedBytes; // Length of the mapping, 0 if image is malloc'd
+    float cosTable[LIKELIHOOD_FIELD_HEADINGS];
+    float sinTable[LIKELIHOOD_FIELD_HEADINGS];
+
+    LikelihoodField(const LikelihoodField&);
+    LikelihoodField& operator=(const LikelihoodField&);
+};
+
+#endif // LikelihoodField_h_DEFINED
@@ -1,9 +1,9 @@
+#include <algorithm>
+
 #include "LocEKF.h"
-#include <boost/numeric/ublas/io.hpp> // for cout
 #include "FieldConstants.h"
 //#define DEBUG_LOC_EKF_INPUTS
 //#define DEBUG_STANDARD_ERROR
-using namespace boost::numeric;
 using namespace boost;
 using namespace std;
 using namespace NBMath;
@@ -61,7 +61,7 @@ LocEKF::LocEKF(float initX, float initY, float initH,
     : EKF<Observation, MotionModel, LOC_EKF_DIMENSION,
           LOC_MEASUREMENT_DIMENSION>(BETA_LOC,GAMMA_LOC), LocSystem(),
 	  lastOdo(0,0,0),
-	  lastObservations(0), useAmbiguous(true),
+	  lastObservations(0), useAmbiguous(true), fusedUpdate(false),
 	  R_pred_k(measurementSize, measurementSize, 0.0f)
 {
     // ones on the diagonal
@@ -208,7 +208,7 @@ void LocEKF::resetLocTo(float x, float y, float h)
  * @param u The odometry since the last frame
  * @param Z The observations from the current frame
  */
-void LocEKF::updateLocalization(MotionModel u, vector<Observation> Z)
+void LocEKF::updateLocalization(MotionModel u, const vector<Observation>& Z)
 {
 #ifdef DEBUG_LOC_EKF_INPUTS
 	printBeforeUpdateInfo();
@@ -234,31 +234,110 @@ void LocEKF::odometryUpdate(MotionModel u)
 /**
  * Apply a whole set of observations from one time frame.
  */
-void LocEKF::applyObservations(vector<Observation> Z)
+void LocEKF::applyObservations(const vector<Observation>& Z)
 {
 	lastObservations = Z;
 
+    if (fusedUpdate) {
+        fusedCorrectionStep(Z);
+        return;
+    }
+
+    vector<Observation> unambiguous;
     if (! useAmbiguous) {
         // Remove ambiguous observations
-        vector<Observation>::iterator iter = Z.begin();
-        while( iter != Z.end() ) {
-            if (iter->getNumPossibilities() > 1 ) {
-                iter = Z.erase( iter );
-            } else {
-                ++iter;
+        for (unsigned int i = 0; i < Z.size(); ++i) {
+            if (Z[i].getNumPossibilities() <= 1) {
+                unambiguous.push_back(Z[i]);
             }
         }
     }
+    const vector<Observation>& used = useAmbiguous ? Z : unambiguous;
 
     // Correct step based on the observed stuff
-    if (Z.size() > 0) {
-        correctionStep(Z);
+    if (used.size() > 0) {
+        correctionStep(used);
     } else {
         noCorrectionStep();
     }
     //limitPosteriorUncert();
 }
 
+/**
+ * Fold all of a frame's observations into the estimate at once.
+ *
+ * Every observation is matched to a landmark and linearized about the a
+ * priori estimate before any of them moves it, so neither the matching nor
+ * the result depends on the order vision reports them in, as it does when
+ * correctionStep() applies them one after another.  The observations are
+ * then one stacked measurement with a block diagonal R.  Since the blocks
+ * are independent, the stacked Kalman update is the same as updating with
+ * one block at a time about the fixed linearization point, which only ever
+ * inverts a 2x2 S and needs no stacked matrices, so that is how it is done.
+ * Each block's covariance update is in Joseph form, like correctionStep()'s,
+ * since with up to MAX_FUSED_OBSERVATIONS of them in a row the rounding of
+ * P - K S K' can pile up and leave P indefinite.
+ */
+void LocEKF::fusedCorrectionStep(const vector<Observation>& Z)
+{
+    FusedMeasurement fused[MAX_FUSED_OBSERVATIONS];
+    bool corrected = false;
+
+    // More observations than fit are fused in batches, each linearized
+    // about the estimate the last one left
+    for (unsigned int first = 0; first < Z.size();
+         first += MAX_FUSED_OBSERVATIONS) {
+        const unsigned int last = std::min<unsigned int>(
+            Z.size(), first + MAX_FUSED_OBSERVATIONS);
+
+        // Match and linearize every observation
+        unsigned int numFused = 0;
+        for (unsigned int i = first; i < last; ++i) {
+            if (! useAmbiguous && Z[i].getNumPossibilities() > 1) {
+                continue;
+            }
+            FusedMeasurement& m = fused[numFused];
+            incorporateMeasurement(Z[i], m.H, m.R, m.v);
+            m.polar = isPolarMeasurement(Z[i]);
+            if (m.R(0,0) != DONT_PROCESS_KEY) {
+                ++numFused;
+            }
+        }
+
+        // Then update with them, correcting each innovation for how far
+        // the blocks before it have moved the estimate
+        const StateVector x0 = xhat_k_bar;
+        for (unsigned int i = 0; i < numFused; ++i) {
+            const FusedMeasurement& m = fused[i];
+            const MeasurementStateMatrix pTimesHTrans =
+                prod(P_k_bar, trans(m.H));
+            const MeasurementMatrix S_k = prod(m.H, pTimesHTrans) + m.R;
+            K_k = prod(pTimesHTrans, NBMath::invert(S_k));
+
+            // Only a bearing wraps, a cartesian block is two lengths
+            MeasurementVector v = m.v - prod(m.H, xhat_k_bar - x0);
+            if (m.polar) {
+                v(1) = NBMath::subPIAngle(v(1));
+            }
+            xhat_k_bar = xhat_k_bar + prod(K_k, v);
+
+            const StateMatrix IKH = StateMatrix::identity() - prod(K_k, m.H);
+            P_k_bar = prod(prod(IKH, P_k_bar), trans(IKH)) +
+                prod(prod(K_k, m.R), trans(K_k));
+            NBMath::symmetrize(P_k_bar);
+        }
+        if (numFused > 0) {
+            corrected = true;
+        }
+    }
+
+    if (corrected) {
+        updateState();
+    } else {
+        noCorrectionStep();
+    }
+}
+
 
 /**
  * Apply an individual observation to the EKF.
@@ -281,7 +360,7 @@ bool LocEKF::applyObservation(Observation Z)
 }
 
 #ifdef USE_MM_LOC_EKF
-bool LocEKF::updateProabbility(const Observation& Z)
+bool LocEKF::updateProbability(const Observation& Z)
 {
 
 	if (R_k(0,0) == DONT_PROCESS_KEY)
@@ -305,7 +384,6 @@ bool LocEKF::updateProabbility(const Observation& Z)
 
 	v_k(0) = abs(v_k(0));
 	v_k(1) = abs(v_k(1));
-	v_k(2) = abs(v_k(2));
 
 	// We need the measurement innovation or invariance, aka v_k
 	const double exponent = -0.5 * inner_prod(trans(v_k),
@@ -395,7 +473,7 @@ LocEKF::associateTimeUpdate(MotionModel u)
  *
  * @return the measurement invariance
  */
-void LocEKF::incorporateMeasurement(Observation z,
+void LocEKF::incorporateMeasurement(const Observation& z,
                                     StateMeasurementMatrix &H_k,
                                     MeasurementMatrix &R_k,
                                     MeasurementVector &V_k)
@@ -412,16 +490,14 @@ void LocEKF::incorporateMeasurement(Observation z,
 		return;
 	}
 
-	if ( z.isLine() ){
+	if (isPolarMeasurement(z)) {
 		incorporatePolarMeasurement( obsIndex, z, H_k, R_k, V_k);
-	} else if (z.getVisDistance() < USE_CARTESIAN_DIST) {
-		incorporateCartesianMeasurement( obsIndex, z, H_k, R_k, V_k);
     } else {
-		incorporatePolarMeasurement( obsIndex, z, H_k, R_k, V_k);
+		incorporateCartesianMeasurement( obsIndex, z, H_k, R_k, V_k);
     }
 
     // Calculate the standard error of the measurement
-    const StateMeasurementMatrix newP = prod(P_k, trans(H_k));
+    const MeasurementStateMatrix newP = prod(P_k, trans(H_k));
     MeasurementMatrix se = prod(H_k, newP) + R_k;
     se(0,0) = sqrt(se(0,0));
     se(1,1) = sqrt(se(1,1));
@@ -438,8 +514,17 @@ void LocEKF::incorporateMeasurement(Observation z,
 
 }
 
+/**
+ * Lines, and points further than USE_CARTESIAN_DIST, are measured as range
+ * and bearing.  Close points are measured as x and y relative to the robot.
+ */
+bool LocEKF::isPolarMeasurement(const Observation& z) const
+{
+	return z.isLine() || z.getVisDistance() >= USE_CARTESIAN_DIST;
+}
+
 void LocEKF::incorporateCartesianMeasurement(int obsIndex,
-											 Observation z,
+											 const Observation& z,
 											 StateMeasurementMatrix &H_k,
 											 MeasurementMatrix &R_k,
 											 MeasurementVector &V_k)
@@ -523,7 +608,7 @@ void LocEKF::incorporateCartesianMeasurement(int obsIndex,
 }
 
 void LocEKF::incorporatePolarMeasurement(int obsIndex,
-										   Observation z,
+										   const Observation& z,
 										   StateMeasurementMatrix &H_k,
 										   MeasurementMatrix &R_k,
 										   MeasurementVector &V_k)
@@ -700,31 +785,6 @@ int LocEKF::findBestLandmark(const Observation& z)
  * Uses the Mahalanobis distance to find the most likely line choice
  */
 int LocEKF::findMostLikelyLine(const Observation &z)
-{
-
-	vector<LineLandmark> possibleLines = z.getLinePossibilities();
-	int minIndex = -1;
-	float minDivergence = 800000.0f;
-	for (unsigned int i = 0; i < possibleLines.size(); ++i) {
-		float distance = getMahalanobisDistance(z, possibleLines[i]);
-
-		if (distance < minDivergence) {
-			minDivergence = distance;
-			minIndex = i;
-		}
-	}
-	return minIndex;
-}
-
-/**
- * Find the Mahalanobis distance from the observed line
- * to the potential concrete line. Uses Cartesian coordinates.
- *
- * @param The observed line
- * @param The ConcreteLine to compare against
- * @return The Mahalanobis distance between the lines
- */
-float LocEKF::getMahalanobisDistance(const Observation& z, const LineLandmark& l)
 {
 	// Robot's current estimated position
 	const float x_r = xhat_k_bar(0);
@@ -736,13 +796,7 @@ float LocEKF::getMahalanobisDistance(const Observation& z, const LineLandmark& l
 	z_x(0) = x_r + z.getVisDistance() * cos(z.getVisBearing() + h_r);
 	z_x(1) = y_r + z.getVisDistance() * sin(z.getVisBearing() + h_r);
 
-	const pair<float, float> line_xy =
-		findClosestLinePointCartesian(l, x_r, y_r, h_r);
-
-	MeasurementVector u(2);
-	u(0) = line_xy.first;
-	u(1) = line_xy.second;
-
+	// The covariance only depends on the observation, not the line
 	const float dist_sd_2 = pow(z.getDistanceSD(), 2);
 
 	const float bsd = z.getVisBearing();
@@ -753,8 +807,7 @@ float LocEKF::getMahalanobisDistance(const Observation& z, const LineLandmark& l
 	const float sinb_2 = sinb * sinb;
 	const float cosb_2 = cosb * cosb;
 
-	MeasurementMatrix s_inverse =
-		boost::numeric::ublas::scalar_matrix<float>(2,2,0.0f);
+	MeasurementMatrix s_inverse(2, 2, 0.0f);
 	s_inverse(0,0) = ((0.0001f + dist_sd_2*sinb_2)/
 			  (1.e-8f + (dist_sd_2*cosb_2)/10000.f +
 			   (dist_sd_2*sinb_2)/10000.f));
@@ -768,6 +821,42 @@ float LocEKF::getMahalanobisDistance(const Observation& z, const LineLandmark& l
 			  (1.e-8f + (dist_sd_2*cosb_2)/10000.f +
 			   (dist_sd_2*sinb_2)/10000.f));
 
+	const vector<LineLandmark>& possibleLines = z.getLinePossibilities();
+	int minIndex = -1;
+	float minDivergence = 800000.0f;
+	for (unsigned int i = 0; i < possibleLines.size(); ++i) {
+		float distance = getMahalanobisDistance(z_x, s_inverse,
+												possibleLines[i]);
+
+		if (distance < minDivergence) {
+			minDivergence = distance;
+			minIndex = i;
+		}
+	}
+	return minIndex;
+}
+
+/**
+ * Find the Mahalanobis distance from the observed line
+ * to the potential concrete line. Uses Cartesian coordinates.
+ *
+ * @param z_x The observed line's x,y in the field frame of reference
+ * @param s_inverse The inverse covariance of the observation
+ * @param The ConcreteLine to compare against
+ * @return The Mahalanobis distance between the lines
+ */
+float LocEKF::getMahalanobisDistance(const MeasurementVector& z_x,
+									 const MeasurementMatrix& s_inverse,
+									 const LineLandmark& l)
+{
+	const pair<float, float> line_xy =
+		findClosestLinePointCartesian(l, xhat_k_bar(0), xhat_k_bar(1),
+									  xhat_k_bar(2));
+
+	MeasurementVector u(2);
+	u(0) = line_xy.first;
+	u(1) = line_xy.second;
+
 	return sqrt(inner_prod(trans(z_x-u),prod(s_inverse,z_x-u)));
 }
 
@@ -780,7 +869,7 @@ float LocEKF::getMahalanobisDistance(const Observation& z, const LineLandmark& l
  */
 int LocEKF::findNearestNeighbor(const Observation& z)
 {
-	vector<PointLandmark> possiblePoints = z.getPointPossibilities();
+	const vector<PointLandmark>& possiblePoints = z.getPointPossibilities();
 	float minDivergence = 250.0f;
 	int minIndex = -1;
 	for (unsigned int i = 0; i < possiblePoints.size(); ++i) {
@@ -37,9 +37,10 @@ public:
     virtual ~LocEKF() {}
 
     // Update functions
-    virtual void updateLocalization(MotionModel u, std::vector<Observation> Z);
+    virtual void updateLocalization(MotionModel u,
+                                    const std::vector<Observation>& Z);
 	void odometryUpdate(MotionModel u);
-	void applyObservations(vector<Observation> Z);
+	void applyObservations(const vector<Observation>& Z);
 	bool applyObservation(Observation Z);
 	void endFrame();
 
@@ -52,7 +53,7 @@ public:
     virtual void reset();
     virtual void redGoalieReset();
     virtual void blueGoalieReset();
-	virtual inline void resetLocTo(float x, float y, float h);
+	virtual void resetLocTo(float x, float y, float h);
 
     // Getters
     /**
@@ -156,20 +157,30 @@ public:
      */
     void setUseAmbiguous(bool _use) { useAmbiguous = _use; }
 
+    /**
+     * @param _fused True to fold a frame's observations into the estimate in
+     *               one update, false to apply them one after another (the
+     *               default until ekfBench has the fused update faster in
+     *               both observation orders)
+     */
+    void setFusedUpdate(bool _fused) { fusedUpdate = _fused; }
+
 private:
     // Core Functions
     virtual StateVector associateTimeUpdate(MotionModel u_k);
-    virtual void incorporateMeasurement(Observation z,
+    virtual void incorporateMeasurement(const Observation& z,
                                         StateMeasurementMatrix &H_k,
                                         MeasurementMatrix &R_k,
                                         MeasurementVector &V_k);
+	void fusedCorrectionStep(const vector<Observation>& Z);
+	bool isPolarMeasurement(const Observation& z) const;
 	void incorporateCartesianMeasurement(int obsIndex,
-										   Observation z,
+										   const Observation& z,
 										   StateMeasurementMatrix &H_k,
 										   MeasurementMatrix &R_k,
 										   MeasurementVector &V_k);
 	void incorporatePolarMeasurement(int obsIndex,
-									   Observation z,
+									   const Observation& z,
 									   StateMeasurementMatrix &H_k,
 									   MeasurementMatrix &R_k,
 									   MeasurementVector &V_k);
@@ -177,7 +188,9 @@ private:
 
     int findBestLandmark(const Observation& z);
 	int findMostLikelyLine(const Observation& z);
-	float getMahalanobisDistance(const Observation& z, const LineLandmark& ll);
+	float getMahalanobisDistance(const MeasurementVector& z_x,
+								 const MeasurementMatrix& s_inverse,
+								 const LineLandmark& ll);
 	int findNearestNeighbor(const Observation& z);
     float getDivergence(const Observation& z, const PointLandmark& pt);
 
@@ -198,8 +211,20 @@ private:
     MotionModel lastOdo;
 	vector<Observation> lastObservations;
     bool useAmbiguous;
+    bool fusedUpdate;
 	MeasurementMatrix R_pred_k;
 
+    // An observation of a fused update, linearized about the a priori
+    // estimate
+    struct FusedMeasurement
+    {
+        StateMeasurementMatrix H;
+        MeasurementMatrix R;
+        MeasurementVector v;
+        bool polar;     // range and bearing, else x and y relative to us
+    };
+    const static unsigned int MAX_FUSED_OBSERVATIONS = 32;
+
     // Parameters
     const static float USE_CARTESIAN_DIST;
     const static float BETA_LOC;
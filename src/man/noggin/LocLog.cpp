@@ -0,0 +1,455 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include <list>
+#include <sys/time.h>
+
+#include "LocLog.h"
+#include "LocSystem.h"
+#include "MMLocEKF.h"
+#include "BallEKF.h"
+
+using namespace std;
+
+// The writer writes once this much is queued, or once a second
+static const size_t LOC_LOG_WRITE_BYTES = 64 * 1024;
+static const int LOC_LOG_WRITE_SECONDS = 1;
+// Frames are dropped while this much is waiting to be written
+static const size_t LOC_LOG_MAX_PENDING_BYTES = 4 * 1024 * 1024;
+// Larger records are taken to be a corrupt length
+static const uint32_t LOC_LOG_MAX_RECORD_BYTES = 16 * 1024 * 1024;
+
+// The format is little endian and these copy the bytes as they are
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "LocLog reads and writes little endian logs only"
+#endif
+
+template <class T>
+static void put(vector<char>& out, const T& value)
+{
+    const char *bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void putPose(vector<char>& out, const PoseEst& pose)
+{
+    put(out, pose.x);
+    put(out, pose.y);
+    put(out, pose.h);
+}
+
+/**
+ * Reads values off a record, failing every read once one runs past its end.
+ */
+class RecordReader
+{
+public:
+    RecordReader(const vector<char>& record)
+        : at(record.empty() ? 0 : &record[0]),
+          end(at + record.size()), ok(true) {}
+
+    template <class T>
+    T get() {
+        T value = T();
+        if (ok && static_cast<size_t>(end - at) >= sizeof(T)) {
+            memcpy(&value, at, sizeof(T));
+            at += sizeof(T);
+        } else {
+            ok = false;
+        }
+        return value;
+    }
+
+    PoseEst getPose() {
+        const float x = get<float>();
+        const float y = get<float>();
+        const float h = get<float>();
+        return PoseEst(x, y, h);
+    }
+
+    bool isOk() const { return ok; }
+
+private:
+    const char *at;
+    const char *end;
+    bool ok;
+};
+
+LocLogFrame::LocLogFrame()
+    : frame(0), hasTruth(false)
+{
+    memset(&ballEstimate, 0, sizeof(ballEstimate));
+}
+
+void LocLogFrame::setEstimates(const LocSystem& loc, const BallEKF& ballEKF)
+{
+    estimates.clear();
+
+    LocLogEstimate e;
+    e.pose = loc.getCurrentEstimate();
+    e.uncert = loc.getCurrentUncertainty();
+    estimates.push_back(e);
+
+    const MMLocEKF *mmLoc = dynamic_cast<const MMLocEKF*>(&loc);
+    if (mmLoc) {
+        const list<const LocEKF*> models = mmLoc->getModels();
+        for (list<const LocEKF*>::const_iterator model = models.begin();
+             model != models.end(); ++model) {
+            if (!(*model)->isActive())
+                continue;
+            e.pose = (*model)->getCurrentEstimate();
+            e.uncert = (*model)->getCurrentUncertainty();
+            estimates.push_back(e);
+        }
+    }
+
+    ballEstimate.x = ballEKF.getXEst();
+    ballEstimate.y = ballEKF.getYEst();
+    ballEstimate.xUncert = ballEKF.getXUncert();
+    ballEstimate.yUncert = ballEKF.getYUncert();
+    ballEstimate.velX = ballEKF.getXVelocityEst();
+    ballEstimate.velY = ballEKF.getYVelocityEst();
+    ballEstimate.velXUncert = ballEKF.getXVelocityUncert();
+    ballEstimate.velYUncert = ballEKF.getYVelocityUncert();
+}
+
+LocLogWriter::LocLogWriter(const char *path, int teamColor, int playerNumber)
+    : file(fopen(path, "wb")), stopping(false), frames(0), dropped(0)
+{
+    if (!file)
+        return;
+
+    fwrite(LOC_LOG_MAGIC, 1, sizeof(LOC_LOG_MAGIC), file);
+    fwrite(&LOC_LOG_MAJOR_VERSION, sizeof(uint16_t), 1, file);
+    fwrite(&LOC_LOG_MINOR_VERSION, sizeof(uint16_t), 1, file);
+
+    record.clear();
+    put(record, uint32_t(0));
+    put(record, uint8_t(LOC_LOG_HEADER));
+    put(record, int32_t(teamColor));
+    put(record, int32_t(playerNumber));
+    queue(record);
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+    if (pthread_create(&thread, NULL, runWriter, this) != 0) {
+        pthread_mutex_destroy(&mutex);
+        pthread_cond_destroy(&cond);
+        fclose(file);
+        file = 0;
+    }
+}
+
+LocLogWriter::~LocLogWriter()
+{
+    if (!file)
+        return;
+
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, NULL);
+
+    pthread_mutex_destroy(&mutex);
+    pthread_cond_destroy(&cond);
+    fclose(file);
+}
+
+void LocLogWriter::write(const LocLogFrame& frame)
+{
+    if (!file)
+        return;
+
+    // Build the record here, where it is only copying, and leave the
+    // writing to the writer thread
+    record.clear();
+    put(record, uint32_t(0));
+    put(record, uint8_t(LOC_LOG_FRAME));
+    put(record, uint32_t(frames++));
+
+    uint8_t flags = 0;
+    if (frame.hasTruth)
+        flags |= LOC_LOG_HAS_TRUTH;
+    if (!frame.particles.empty())
+        flags |= LOC_LOG_HAS_PARTICLES;
+    put(record, flags);
+
+    put(record, frame.odometry.deltaF);
+    put(record, frame.odometry.deltaL);
+    put(record, frame.odometry.deltaR);
+
+    put(record, frame.ball.distance);
+    put(record, frame.ball.bearing);
+    put(record, frame.ball.distanceSD);
+    put(record, frame.ball.bearingSD);
+
+    put(record, uint16_t(frame.observations.size()));
+    for (unsigned int i = 0; i < frame.observations.size(); ++i) {
+        const Observation& z = frame.observations[i];
+        put(record, int32_t(z.getID()));
+        put(record, z.getVisDistance());
+        put(record, z.getVisBearing());
+        put(record, z.getDistanceSD());
+        put(record, z.getBearingSD());
+        put(record, uint8_t(z.isLine()));
+        if (z.isLine()) {
+            const vector<LineLandmark>& ps = z.getLinePossibilities();
+            put(record, uint16_t(ps.size()));
+            for (unsigned int j = 0; j < ps.size(); ++j) {
+                put(record, ps[j].x1);
+                put(record, ps[j].y1);
+                put(record, ps[j].x2);
+                put(record, ps[j].y2);
+            }
+        } else {
+            const vector<PointLandmark>& ps = z.getPointPossibilities();
+            put(record, uint16_t(ps.size()));
+            for (unsigned int j = 0; j < ps.size(); ++j) {
+                put(record, ps[j].x);
+                put(record, ps[j].y);
+            }
+        }
+    }
+
+    put(record, uint16_t(frame.estimates.size()));
+    for (unsigned int i = 0; i < frame.estimates.size(); ++i) {
+        putPose(record, frame.estimates[i].pose);
+        putPose(record, frame.estimates[i].uncert);
+    }
+    put(record, frame.ballEstimate);
+
+    if (frame.hasTruth) {
+        putPose(record, frame.truePose);
+        put(record, frame.trueBall.x);
+        put(record, frame.trueBall.y);
+        put(record, frame.trueBall.velX);
+        put(record, frame.trueBall.velY);
+    }
+
+    if (!frame.particles.empty()) {
+        put(record, uint32_t(frame.particles.size()));
+        const char *bytes =
+            reinterpret_cast<const char*>(&frame.particles[0]);
+        record.insert(record.end(), bytes,
+                      bytes + frame.particles.size() * sizeof(LocLogParticle));
+    }
+
+    pthread_mutex_lock(&mutex);
+    if (pending.size() + record.size() > LOC_LOG_MAX_PENDING_BYTES) {
+        ++dropped;
+    } else {
+        queue(record);
+        if (pending.size() >= LOC_LOG_WRITE_BYTES)
+            pthread_cond_signal(&cond);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * Fills in the record's length and appends it to the pending records.
+ */
+void LocLogWriter::queue(const vector<char>& r)
+{
+    const uint32_t length = r.size() - sizeof(uint32_t);
+    const size_t start = pending.size();
+    pending.insert(pending.end(), r.begin(), r.end());
+    memcpy(&pending[start], &length, sizeof(length));
+}
+
+void* LocLogWriter::runWriter(void *writer)
+{
+    reinterpret_cast<LocLogWriter*>(writer)->writeRecords();
+    return NULL;
+}
+
+void LocLogWriter::writeRecords()
+{
+    pthread_mutex_lock(&mutex);
+    while (true) {
+        if (!stopping && pending.size() < LOC_LOG_WRITE_BYTES) {
+            timeval now;
+            gettimeofday(&now, NULL);
+            timespec until;
+            until.tv_sec = now.tv_sec + LOC_LOG_WRITE_SECONDS;
+            until.tv_nsec = now.tv_usec * 1000;
+            pthread_cond_timedwait(&cond, &mutex, &until);
+        }
+
+        if (pending.empty()) {
+            if (stopping)
+                break;
+            continue;
+        }
+
+        // Swapping keeps both buffers' memory, so nothing is allocated once
+        // they have grown to the size of a write
+        writing.swap(pending);
+        pthread_mutex_unlock(&mutex);
+
+        fwrite(&writing[0], 1, writing.size(), file);
+        fflush(file);
+        writing.clear();
+
+        pthread_mutex_lock(&mutex);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+LocLogReader::LocLogReader(const char *path)
+    : file(fopen(path, "rb")), teamColor(0), playerNumber(0), minorVersion(0)
+{
+    if (!file)
+        return;
+
+    char magic[sizeof(LOC_LOG_MAGIC)];
+    uint16_t major = 0, minor = 0;
+    uint8_t type = 0;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, LOC_LOG_MAGIC, sizeof(magic)) != 0 ||
+        fread(&major, sizeof(major), 1, file) != 1 ||
+        fread(&minor, sizeof(minor), 1, file) != 1 ||
+        major != LOC_LOG_MAJOR_VERSION ||
+        !readRecord(type) || type != LOC_LOG_HEADER) {
+        fclose(file);
+        file = 0;
+        return;
+    }
+
+    RecordReader header(record);
+    teamColor = header.get<int32_t>();
+    playerNumber = header.get<int32_t>();
+    minorVersion = minor;
+}
+
+LocLogReader::~LocLogReader()
+{
+    if (file)
+        fclose(file);
+}
+
+bool LocLogReader::isLocLog(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    char magic[sizeof(LOC_LOG_MAGIC)];
+    const bool isLog = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+        memcmp(magic, LOC_LOG_MAGIC, sizeof(magic)) == 0;
+    fclose(f);
+    return isLog;
+}
+
+/**
+ * Reads the next record's body into record.
+ */
+bool LocLogReader::readRecord(uint8_t& type)
+{
+    uint32_t length;
+    if (fread(&length, sizeof(length), 1, file) != 1 ||
+        length < 1 || length > LOC_LOG_MAX_RECORD_BYTES ||
+        fread(&type, 1, 1, file) != 1)
+        return false;
+
+    record.resize(length - 1);
+    return record.empty() ||
+        fread(&record[0], 1, record.size(), file) == record.size();
+}
+
+bool LocLogReader::readFrame(LocLogFrame& frame)
+{
+    if (!file)
+        return false;
+
+    uint8_t type;
+    do {
+        if (!readRecord(type))
+            return false;
+    } while (type != LOC_LOG_FRAME);
+
+    RecordReader r(record);
+    frame.frame = r.get<uint32_t>();
+    const uint8_t flags = r.get<uint8_t>();
+
+    frame.odometry.deltaF = r.get<float>();
+    frame.odometry.deltaL = r.get<float>();
+    frame.odometry.deltaR = r.get<float>();
+
+    frame.ball.distance = r.get<float>();
+    frame.ball.bearing = r.get<float>();
+    frame.ball.distanceSD = r.get<float>();
+    frame.ball.bearingSD = r.get<float>();
+
+    frame.observations.clear();
+    const int numObservations = r.get<uint16_t>();
+    for (int i = 0; i < numObservations && r.isOk(); ++i) {
+        const int id = r.get<int32_t>();
+        const float dist = r.get<float>();
+        const float bearing = r.get<float>();
+        const float distSD = r.get<float>();
+        const float bearingSD = r.get<float>();
+        const bool isLine = r.get<uint8_t>() != 0;
+
+        Observation z(id, dist, bearing, distSD, bearingSD, isLine);
+        const int numPossible = r.get<uint16_t>();
+        for (int j = 0; j < numPossible && r.isOk(); ++j) {
+            if (isLine) {
+                const float x1 = r.get<float>();
+                const float y1 = r.get<float>();
+                const float x2 = r.get<float>();
+                const float y2 = r.get<float>();
+                z.addLinePossibility(LineLandmark(x1, y1, x2, y2));
+            } else {
+                const float x = r.get<float>();
+                const float y = r.get<float>();
+                z.addPointPossibility(PointLandmark(x, y));
+            }
+        }
+        frame.observations.push_back(z);
+    }
+
+    frame.estimates.resize(r.get<uint16_t>());
+    for (unsigned int i = 0; i < frame.estimates.size(); ++i) {
+        frame.estimates[i].pose = r.getPose();
+        frame.estimates[i].uncert = r.getPose();
+    }
+    frame.ballEstimate = r.get<LocLogBall>();
+
+    frame.hasTruth = (flags & LOC_LOG_HAS_TRUTH) != 0;
+    if (frame.hasTruth) {
+        frame.truePose = r.getPose();
+        frame.trueBall.x = r.get<float>();
+        frame.trueBall.y = r.get<float>();
+        frame.trueBall.velX = r.get<float>();
+        frame.trueBall.velY = r.get<float>();
+    }
+
+    frame.particles.clear();
+    if (flags & LOC_LOG_HAS_PARTICLES) {
+        const uint32_t numParticles = r.get<uint32_t>();
+        if (r.isOk() && numParticles <= record.size() / sizeof(LocLogParticle))
+            frame.particles.resize(numParticles);
+        for (unsigned int i = 0; i < frame.particles.size(); ++i)
+            frame.particles[i] = r.get<LocLogParticle>();
+    }
+
+    return r.isOk();
+}
@@ -0,0 +1,209 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Binary localization logs, written on the robot (.loc) and by the offline
+ * tools (.ekf, .mcl), and read by convertRobotLog and the TOOL's
+ * WorldController.
+ *
+ * A log is the four bytes "NBLL", a 16 bit major and minor version, and
+ * then a stream of records.  Each record is a 32 bit length, counting the
+ * type byte and the body, a type byte, and the body.  Everything is little
+ * endian and floats are IEEE 754 singles.  Readers skip records of types
+ * they don't know, and ignore bytes past the end of a body they do know, so
+ * new records and new fields at the end of a frame only need a minor
+ * version; anything else needs a new major version.
+ *
+ * The first record is a header:
+ *   int32 team color, int32 player number
+ *
+ * Every frame after it is a frame record:
+ *   uint32 frame number
+ *   uint8  flags (LOC_LOG_HAS_TRUTH, LOC_LOG_HAS_PARTICLES)
+ *   float  odometry forward, lateral, rotation
+ *   float  ball distance, bearing, distance SD, bearing SD
+ *   uint16 observations, each
+ *            int32 id, float distance, bearing, distance SD, bearing SD,
+ *            uint8 is a line, uint16 possibilities, each
+ *              float x, y (points) or x1, y1, x2, y2 (lines)
+ *   uint16 estimates, each
+ *            float x, y, h, x uncert, y uncert, h uncert
+ *          the filter's, then one for each active MMLocEKF model
+ *   float  ball x, y, x uncert, y uncert, x velocity, y velocity,
+ *          x velocity uncert, y velocity uncert
+ *   with LOC_LOG_HAS_TRUTH
+ *     float true x, y, h, ball x, ball y, ball x velocity, ball y velocity
+ *   with LOC_LOG_HAS_PARTICLES
+ *     uint32 particles, each float x, y, h, weight
+ *
+ * LocLogWriter builds the records on the caller's thread, which is a few
+ * copies, and leaves writing them out to a thread of its own.
+ */
+
+#ifndef LocLog_h_DEFINED
+#define LocLog_h_DEFINED
+
+#include <cstdio>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "EKFStructs.h"
+#include "NogginStructs.h"
+#include "Observation.h"
+
+class LocSystem;
+class BallEKF;
+
+static const char LOC_LOG_MAGIC[4] = { 'N', 'B', 'L', 'L' };
+static const uint16_t LOC_LOG_MAJOR_VERSION = 1;
+static const uint16_t LOC_LOG_MINOR_VERSION = 0;
+
+enum LocLogRecordType {
+    LOC_LOG_HEADER = 1,
+    LOC_LOG_FRAME = 2
+};
+
+enum LocLogFrameFlags {
+    LOC_LOG_HAS_TRUTH = 1,
+    LOC_LOG_HAS_PARTICLES = 2
+};
+
+struct LocLogEstimate
+{
+    PoseEst pose;
+    PoseEst uncert;
+};
+
+struct LocLogBall
+{
+    float x, y;
+    float xUncert, yUncert;
+    float velX, velY;
+    float velXUncert, velYUncert;
+};
+
+struct LocLogParticle
+{
+    float x, y, h;
+    float weight;
+};
+
+/**
+ * Everything logged about one frame.
+ */
+struct LocLogFrame
+{
+    LocLogFrame();
+
+    // Fills in estimates and ballEstimate
+    void setEstimates(const LocSystem& loc, const BallEKF& ballEKF);
+
+    unsigned int frame;
+    MotionModel odometry;
+    RangeBearingMeasurement ball;
+    std::vector<Observation> observations;
+    std::vector<LocLogEstimate> estimates;
+    LocLogBall ballEstimate;
+
+    // Only known to the offline tools
+    bool hasTruth;
+    PoseEst truePose;
+    BallPose trueBall;
+    std::vector<LocLogParticle> particles;
+};
+
+class LocLogWriter
+{
+public:
+    LocLogWriter(const char *path, int teamColor, int playerNumber);
+    ~LocLogWriter();
+
+    // False if the file could not be opened
+    bool isOpen() const { return file != 0; }
+
+    /**
+     * Queues a frame for writing.  The frame is numbered as the next frame
+     * of the log, whatever its frame field says.  If the writing thread has
+     * fallen too far behind, the frame is dropped.
+     */
+    void write(const LocLogFrame& frame);
+
+    unsigned int getDroppedFrames() const { return dropped; }
+
+private:
+    static void* runWriter(void *writer);
+    void writeRecords();
+    void queue(const std::vector<char>& record);
+
+    FILE *file;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool stopping;
+
+    // Records waiting to be written, the ones being written, and the one
+    // being built
+    std::vector<char> pending;
+    std::vector<char> writing;
+    std::vector<char> record;
+
+    unsigned int frames;
+    unsigned int dropped;
+
+    LocLogWriter(const LocLogWriter&);
+    LocLogWriter& operator=(const LocLogWriter&);
+};
+
+class LocLogReader
+{
+public:
+    LocLogReader(const char *path);
+    ~LocLogReader();
+
+    // False if the file could not be opened or is not a log this can read
+    bool isOpen() const { return file != 0; }
+
+    int getTeamColor() const { return teamColor; }
+    int getPlayerNumber() const { return playerNumber; }
+    int getMinorVersion() const { return minorVersion; }
+
+    /**
+     * Reads the next frame of the log.  Returns false at the end of the
+     * log, or at a frame cut short, as the last one is if the robot went
+     * down while logging.
+     */
+    bool readFrame(LocLogFrame& frame);
+
+    // True if the file starts like a binary localization log
+    static bool isLocLog(const char *path);
+
+private:
+    bool readRecord(uint8_t& type);
+
+    FILE *file;
+    int teamColor, playerNumber;
+    int minorVersion;
+    std::vector<char> record;
+
+    LocLogReader(const LocLogReader&);
+    LocLogReader& operator=(const LocLogReader&);
+};
+
+#endif // LocLog_h_DEFINED
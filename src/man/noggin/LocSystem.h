@@ -18,7 +18,7 @@ public:
     virtual ~LocSystem() {};
     // Core Functions
     virtual void updateLocalization(MotionModel u_t,
-                                    std::vector<Observation> z_t) = 0;
+                                    const std::vector<Observation>& z_t) = 0;
     virtual void reset() = 0;
 
     virtual void blueGoalieReset() = 0;
@@ -7,42 +7,145 @@
  */
 
 #include "MCL.h"
+#include "MCLKernels.h"
 #include "NBMath.h"
-#include <time.h> // for srand(time(NULL))
-#include <cstdlib> // for MAX_RAND
+#include "synchro.h"
+#include <time.h> // for seeding from the clock
+#include <cstdlib> // for posix_memalign
+#include <cfloat>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
 using namespace std;
+using boost::shared_ptr;
 #define MAX_CHANGE_X 5.0f
 #define MAX_CHANGE_Y 5.0f
 #define MAX_CHANGE_H M_PI_FLOAT / 16.0f
 #define MAX_CHANGE_F 5.0f
 #define MAX_CHANGE_L 5.0f
 #define MAX_CHANGE_R M_PI_FLOAT / 16.0f
-#define UNIFORM_1_NEG_1 (2.0f*(static_cast<float>(rand()) / (static_cast<float>(RAND_MAX)+1)) - 1.0f)
 
 /**
- * Initializes the sampel sets so that the first update works appropriately
+ * Runs its share of every parallel MCL step.  Sleeps on the MCL's job
+ * condition between steps.
  */
-MCL::MCL(int _M) : useBest(false), lastOdo(0,0,0), frameCounter(0), M(_M)
+class MCLWorker : public Thread
 {
-    // Initialize particles to be randomly spread about the field...
-    srand(time(NULL));
-    for (int m = 0; m < M; ++m) {
-        //Particle p_m;
-        // X bounded by width of the field
-        // Y bounded by height of the field
-        // H between +-pi
-        PoseEst x_m(static_cast<float>(rand() % static_cast<int>(FIELD_WIDTH)),
-                    static_cast<float>(rand() % static_cast<int>(FIELD_HEIGHT)),
-                    UNIFORM_1_NEG_1 * (M_PI_FLOAT / 2.0f));
-        Particle p_m(x_m, 1.0f);
-        X_t.push_back(p_m);
+public:
+    MCLWorker(shared_ptr<Synchro> _synchro, string _name, MCL *_mcl,
+              int _chunk)
+        : Thread(_synchro, _name), mcl(_mcl), chunk(_chunk), lastJob(0) {}
+
+    void run();
+    void stop();
+
+private:
+    MCL *mcl;
+    const int chunk;
+    unsigned int lastJob;
+};
+
+void MCLWorker::run()
+{
+    Thread::running = true;
+    Thread::trigger->on();
+
+    while (true) {
+        pthread_mutex_lock(&mcl->jobMutex);
+        while (mcl->jobNumber == lastJob && Thread::running)
+            pthread_cond_wait(&mcl->jobCond, &mcl->jobMutex);
+        if (!Thread::running) {
+            pthread_mutex_unlock(&mcl->jobMutex);
+            break;
+        }
+        lastJob = mcl->jobNumber;
+        const MCL::Job job = mcl->job;
+        pthread_mutex_unlock(&mcl->jobMutex);
+
+        mcl->runChunk(job, chunk);
+
+        pthread_mutex_lock(&mcl->jobMutex);
+        if (--mcl->jobsPending == 0)
+            pthread_cond_signal(&mcl->doneCond);
+        pthread_mutex_unlock(&mcl->jobMutex);
     }
 
+    Thread::trigger->off();
+}
+
+void MCLWorker::stop()
+{
+    pthread_mutex_lock(&mcl->jobMutex);
+    Thread::stop();
+    pthread_cond_broadcast(&mcl->jobCond);
+    pthread_mutex_unlock(&mcl->jobMutex);
+}
+
+/**
+ * Initializes the sampel sets so that the first update works appropriately.
+ * All of the particle memory is allocated here, the updates never allocate.
+ */
+MCL::MCL(int _M, int threads, uint32_t seed)
+    : X_t(&sets[0]), X_bar_t(&sets[1]), storage(0), parents(0),
+      kldSampling(false), minParticles(KLD_MIN_PARTICLES),
+      kldBinsX(static_cast<int>(ceilf(FIELD_WIDTH / KLD_BIN_XY))),
+      kldBinsY(static_cast<int>(ceilf(FIELD_HEIGHT / KLD_BIN_XY))),
+      kldBinsH(static_cast<int>(ceilf(2.0f * M_PI_FLOAT / KLD_BIN_H))),
+      kldBins(0), kldOccupied(0), useLikelihoodField(false),
+      useBest(false), lastOdo(0,0,0), numLastObservations(0),
+      rng(seed != 0 ? seed : static_cast<uint32_t>(time(NULL))), epoch(0),
+      numThreads(threads < 1 ? 1 : threads),
+      jobNumber(0), jobsPending(0), job(JOB_PREDICT),
+      jobOdometry(0), jobObservations(0),
+      frameCounter(0), M(_M)
+{
+    // Everything the destructor touches is set up before anything can fail
+    for (int s = 0; s < 2; ++s) {
+        sets[s].x = sets[s].y = sets[s].h = sets[s].w = 0;
+        sets[s].size = 0;
+    }
+    pthread_mutex_init(&jobMutex, NULL);
+    pthread_cond_init(&jobCond, NULL);
+    pthread_cond_init(&doneCond, NULL);
+
+    // Round each array up to a multiple of four floats so every one of
+    // them starts on a 16 byte boundary
+    const int stride = (M + 3) & ~3;
+    if (posix_memalign(reinterpret_cast<void**>(&storage), 16,
+                       8 * stride * sizeof(float)) != 0) {
+        storage = 0;
+        cout << "MCL: could not allocate " << M << " particles" << endl;
+        return;
+    }
+    parents = new int[M];
+    kldBins = new unsigned char[kldBinsX * kldBinsY * kldBinsH]();
+    kldOccupied = new int[M];
+
+    for (int s = 0; s < 2; ++s) {
+        float *base = storage + 4 * s * stride;
+        sets[s].x = base;
+        sets[s].y = base + stride;
+        sets[s].h = base + 2 * stride;
+        sets[s].w = base + 3 * stride;
+    }
+
+    startWorkers();
+
+    // Initialize particles to be randomly spread about the field...
+    spreadParticles();
     updateEstimates();
 }
 
 MCL::~MCL()
 {
+    stopWorkers();
+    pthread_cond_destroy(&doneCond);
+    pthread_cond_destroy(&jobCond);
+    pthread_mutex_destroy(&jobMutex);
+    delete [] kldOccupied;
+    delete [] kldBins;
+    delete [] parents;
+    free(storage);
 }
 
 /**
@@ -51,19 +154,46 @@ MCL::~MCL()
 void MCL::reset()
 {
     frameCounter = 0;
+    ++epoch;
+    spreadParticles();
+    updateEstimates();
+}
+
+/**
+ * Reset the filter to a blue goalie starting configuration
+ */
+void MCL::blueGoalieReset()
+{
+    resetLocTo(FIELD_WHITE_LEFT_SIDELINE_X + GOALBOX_DEPTH / 2.0f,
+               CENTER_FIELD_Y, 0.0f);
+}
+
+/**
+ * Reset the filter to a red goalie starting configuration
+ */
+void MCL::redGoalieReset()
+{
+    resetLocTo(FIELD_WHITE_RIGHT_SIDELINE_X - GOALBOX_DEPTH / 2.0f,
+               CENTER_FIELD_Y, M_PI_FLOAT);
+}
 
+/**
+ * Put every particle at the given pose.
+ *
+ * @param x,y,h the position to set the filter to.
+ */
+void MCL::resetLocTo(float x, float y, float h)
+{
+    frameCounter = 0;
+    ++epoch;
+    h = NBMath::subPIAngle(h);
     for (int m = 0; m < M; ++m) {
-        //Particle p_m;
-        // X bounded by width of the field
-        // Y bounded by height of the field
-        // H between +-pi
-        PoseEst x_m(static_cast<float>(rand() % static_cast<int>(FIELD_WIDTH)),
-                    static_cast<float>(rand() % static_cast<int>(FIELD_HEIGHT)),
-                    UNIFORM_1_NEG_1 * (M_PI_FLOAT / 2.0f));
-        Particle p_m(x_m, 1.0f);
-        X_t.push_back(p_m);
+        X_t->x[m] = x;
+        X_t->y[m] = y;
+        X_t->h[m] = h;
+        X_t->w[m] = 1.0f;
     }
-
+    X_t->size = M;
     updateEstimates();
 }
 
@@ -73,37 +203,42 @@ void MCL::reset()
  *
  * @param u_t The motion (odometery) change since the last update.
  * @param z_t The set of landmark observations in the current frame.
- * @param resample Should we resample during this update
- * @return The set of particles representing the estimate of the current frame.
  */
-void MCL::updateLocalization(MotionModel u_t, vector<Observation> z_t)
+void MCL::updateLocalization(MotionModel u_t, const vector<Observation>& z_t)
 {
     frameCounter++;
-    // Set the current particles to be of time minus one.
-    vector<Particle> X_t_1 = X_t;
-    // Clar the current set
-    X_t.clear();
-    vector<Particle> X_bar_t; // A priori estimates
-    float totalWeights = 0.; // Must sum all weights for future use
+    ++epoch;
+    lastOdo = u_t;
+    // Keep a copy for getLastObservations().  Assigning the vector would
+    // destroy the extra observations when there are fewer than last frame
+    // and construct new ones, possibility lists and all, when there are
+    // more.  Copying into kept slots only allocates until every slot has
+    // held as many observations and possibilities as it ever will.
+    if (z_t.size() > lastObservations.size()) {
+        lastObservations.insert(lastObservations.end(),
+                                z_t.begin() + lastObservations.size(),
+                                z_t.end());
+    }
+    std::copy(z_t.begin(), z_t.end(), lastObservations.begin());
+    numLastObservations = z_t.size();
 
-    // Run through the particles
-    for (int m = 0; m < M; ++m) {
-        Particle x_t_m;
-
-        // Update motion model for the particle
-        x_t_m.pose = updateMotionModel(X_t_1[m].pose, u_t);
-        // Update measurement model
-        x_t_m.weight = updateMeasurementModel(z_t, x_t_m.pose);
-        totalWeights += x_t_m.weight;
-        // Add the particle to the current frame set
-        X_bar_t.push_back(x_t_m);
+    // Move the particles into the a priori set and weight them there
+    jobOdometry = &u_t;
+    jobObservations = &z_t;
+    X_bar_t->size = X_t->size;
+    runJob(JOB_PREDICT);
+
+    // Summed here, in order, so the total doesn't depend on the threads
+    float totalWeights = 0.; // Must sum all weights for future use
+    for (int m = 0; m < X_bar_t->size; ++m) {
+        totalWeights += X_bar_t->w[m];
     }
 
-    // Resample the particles
+    // Resample the particles back into X_t
     if (frameCounter % 1 == 0) {
-        resample(&X_bar_t, totalWeights);
+        resample(totalWeights);
     } else {
-        noResample(&X_bar_t);
+        noResample();
     }
 
     // Update pose and uncertainty estimates
@@ -112,129 +247,233 @@ void MCL::updateLocalization(MotionModel u_t, vector<Observation> z_t)
 }
 
 /**
- * Update a particle's pose based on the last motion model.
- * We sample the pose with noise proportional to the odometery update.
+ * Update the pose of particles [begin, end) based on the last motion model,
+ * writing the results into the a priori set.  We sample the pose with noise
+ * proportional to the odometery update.
  *
- * @param x_t_1 The robot pose from the pervious position distribution
  * @param u_t The odometry update from the last frame
- *
- * @return A new robot pose sampled on the odometry update
  */
-PoseEst MCL::updateMotionModel(PoseEst x_t, MotionModel u_t)
+void MCL::updateMotionModel(const MotionModel& u_t, int begin, int end)
 {
-    lastOdo = u_t;
-    u_t.deltaF -= sampleNormalDistribution(fabs(u_t.deltaF));
-    u_t.deltaL -= sampleNormalDistribution(fabs(u_t.deltaL));
-    u_t.deltaR -= sampleNormalDistribution(fabs(u_t.deltaR));
-
-    // u_t.deltaF -= sampleTriangularDistribution(fabs(u_t.deltaF));
-    // u_t.deltaL -= sampleTriangularDistribution(fabs(u_t.deltaL));
-    // u_t.deltaR -= sampleTriangularDistribution(fabs(u_t.deltaR));
-
-    x_t += u_t;
-
-    x_t.h = NBMath::subPIAngle(x_t.h);
-
-    return x_t;
+    const float sdF = fabs(u_t.deltaF);
+    const float sdL = fabs(u_t.deltaL);
+    const float sdR = fabs(u_t.deltaR);
+
+    for (int m = begin; m < end; ++m) {
+        float noise[4];
+        sampleNormals(m, RANDOM_MOTION, noise);
+        const float deltaF = u_t.deltaF - noise[0] * sdF;
+        const float deltaL = u_t.deltaL - noise[1] * sdL;
+        const float deltaR = u_t.deltaR - noise[2] * sdR;
+
+        // Translate the relative change into the global coordinate system
+        // the same way PoseEst += MotionModel does
+        float sinh, cosh;
+        sincosf(X_t->h[m], &sinh, &cosh);
+        X_bar_t->x[m] = X_t->x[m] + deltaF * cosh - deltaL * sinh;
+        X_bar_t->y[m] = X_t->y[m] + deltaF * sinh + deltaL * cosh;
+        X_bar_t->h[m] = NBMath::subPIAngle(X_t->h[m] + deltaR);
+    }
 }
 
 /**
- * Method determines the weight of a particle based on the current landmark
- * observations.
+ * Method determines the weight of a priori particles [begin, end) based on
+ * the current landmark observations.  Works one observation at a time over
+ * the whole range, see MCLKernels.h and LikelihoodField.h for the per
+ * particle math.
  *
  * @param z_t The landmark observations for the current frame.
- * @param x_t The a priori estimate of the robot pose.
- * @param m The particle ID
- * @return The particle weight
  */
-float MCL::updateMeasurementModel(vector<Observation> z_t, PoseEst x_t)
+void MCL::updateMeasurementModel(const vector<Observation>& z_t,
+                                 int begin, int end)
 {
-    // Give the particle a weight of 1 to begin with
-    float w = 1;
+    const int size = end - begin;
+    float *x = X_bar_t->x + begin;
+    float *y = X_bar_t->y + begin;
+    float *h = X_bar_t->h + begin;
+    float *w = X_bar_t->w + begin;
+
+    // Give the particles a weight of 1 to begin with
+    for (int m = 0; m < size; ++m) {
+        w[m] = 1.0f;
+    }
 
-    //cout << "New Particle" << endl;
     // Determine the likelihood of each observation
     for (unsigned int i = 0; i < z_t.size(); ++i) {
-
-        // Determine the most likely match
-        float p = 0; // Combined probability of observation
-        float pMax = -1; // Maximum combined probability
-
-        // Get local copies of our possible landmarks
-        vector<LineLandmark> possibleLines = z_t[i].getLinePossibilities();
-        vector<PointLandmark> possiblePoints = z_t[i].getPointPossibilities();
-
-        // Loop through all possible landmarks
-        // If the observation is distinct, there will only be one possibility
-        for (unsigned int j = 0; j < z_t[i].getNumPossibilities(); ++j) {
-            if (z_t[i].isLine()) {
-                p = determineLineWeight(z_t[i], x_t, possibleLines[j]);
-            } else {
-                p = determinePointWeight(z_t[i], x_t, possiblePoints[j]);
+        const Observation& z = z_t[i];
+
+        MCLKernels::Measurement meas;
+        meas.dist = z.getVisDistance();
+        meas.bearing = z.getVisBearing();
+        meas.invVarD = 1.0f / (z.getDistanceSD() * z.getDistanceSD());
+        meas.invVarA = 1.0f / (z.getBearingSD() * z.getBearingSD());
+        meas.minSimilarity = MIN_SIMILARITY;
+
+        // If the observation is distinct, there will only be one
+        // possibility
+        if (z.isLine()) {
+            const vector<LineLandmark>& possibleLines =
+                z.getLinePossibilities();
+            const int table = useLikelihoodField ?
+                likelihoodField->findTable(possibleLines) : -1;
+            if (table >= 0) {
+                likelihoodField->weigh(table, x, y, h, w, 0, size, meas);
+                continue;
             }
-
-            //cout << "p is: " << p << " ";
-            if( p > pMax) {
-                pMax = p;
+            MCLKernels::LineSegment segments[ConcreteLine::NUM_LINES];
+            int numPossible = 0;
+            for (unsigned int j = 0; j < possibleLines.size() &&
+                     numPossible < ConcreteLine::NUM_LINES; ++j) {
+                MCLKernels::makeSegment(possibleLines[j],
+                                        segments[numPossible++]);
+            }
+            MCLKernels::lineWeights(x, y, h, w, size, meas,
+                                    segments, numPossible);
+        } else {
+            const vector<PointLandmark>& possiblePoints =
+                z.getPointPossibilities();
+            const int table = useLikelihoodField ?
+                likelihoodField->findTable(possiblePoints) : -1;
+            if (table >= 0) {
+                likelihoodField->weigh(table, x, y, h, w, 0, size, meas);
+                continue;
             }
+            MCLKernels::pointWeights(x, y, h, w, size, meas,
+                                     possiblePoints.empty() ? 0 :
+                                     &possiblePoints[0],
+                                     possiblePoints.size());
         }
-        //cout << "pMax is: " << pMax << endl;
-        w *= pMax;
     }
-
-    return w; // The combined weight of all observations
 }
 
 /**
- * Method to resample the particles based on a straight proportion of their
- * weights. Adds copies of the paritcle jittered proportional to the weight
- * of the particle
+ * Method to resample the particles in proportion to their weights and
+ * jitter the copies proportional to their weight.  Reads X_bar_t and writes
+ * X_t.  Keeps M particles, or with KLD-sampling as many as the spread of
+ * the jittered set calls for.
  *
- * @param X_bar_t the set of particles before being resampled
  * @param totalWeights the totalWeights of the particle set X_bar_t
  */
-void MCL::resample(std::vector<Particle> * X_bar_t, float totalWeights) {
-    for (int m = 0; m < M; ++m) {
-        // Normalize the particle weights
-        (*X_bar_t)[m].weight /= totalWeights;
-
-        int count = int(round(float(M) * (*X_bar_t)[m].weight));
-        for (int i = 0; i < count; ++i) {
-            // Random walk the particles
-            X_t.push_back(randomWalkParticle((*X_bar_t)[m]));
-            //X_t.push_back(X_bar_t[m]);
+void MCL::resample(float totalWeights) {
+    // Normalize the particle weights.  Enough unlikely observations
+    // underflow every weight to zero, and dividing by that would make
+    // every pose NaN for good, so then keep the set with equal weights.
+    const int size = X_bar_t->size;
+    if (totalWeights > 0.0f && totalWeights <= FLT_MAX) {
+        for (int m = 0; m < size; ++m) {
+            X_bar_t->w[m] /= totalWeights;
+        }
+    } else {
+        for (int m = 0; m < size; ++m) {
+            X_bar_t->w[m] = 1.0f / static_cast<float>(size);
         }
     }
+
+    uint32_t draw[4];
+    rng(0, epoch, RANDOM_RESAMPLE, 0, draw);
+    const float r = Philox::uniform(draw[0]);
+
+    // KLD-sampling bins the particles after they have been jittered, as
+    // Fox does after the motion update, so a converged set can spread into
+    // new bins and grow again.  Start small and draw more, with the same
+    // draw, until there are as many as the bins call for.
+    int n = kldSampling ? min(minParticles, M) : M;
+    for (;;) {
+        systematicResample(r, n);
+        X_t->size = n;
+        runJob(JOB_WALK);
+
+        if (!kldSampling || n == M) {
+            break;
+        }
+        const int bound = kldBound(countOccupiedBins(*X_t));
+        if (bound <= n) {
+            break;
+        }
+        n = min(M, max(bound, n + n / 2));
+    }
 }
 
-void MCL::lowVarianceResample(std::vector<Particle> * X_bar_t,
-                              float totalWeights) {
-    float r = ((static_cast<float>(rand()) /
-				static_cast<float>(RAND_MAX)) *
-			   (1.0f/static_cast<float>(M) ));
-    float c = (*X_bar_t)[0].weight / totalWeights;
+/**
+ * Systematic (low variance) resampling: n evenly spaced pointers, offset by
+ * one random draw, walked along the cumulative weights of X_bar_t.  O(n +
+ * size), and every particle gets within one copy of n times its weight.
+ * Fills parents[0, n).  Weights must already be normalized.
+ *
+ * @param r A uniform draw on (0, 1]
+ * @param n The number of particles to draw
+ */
+void MCL::systematicResample(float r, int n)
+{
+    const float *w = X_bar_t->w;
+    const int last = X_bar_t->size - 1;
+    const float step = 1.0f / static_cast<float>(n);
+    float c = w[0];
     int i = 0;
-    for (int m = 0; m < M; ++m) {
+    for (int m = 0; m < n; ++m) {
+        const float U = (static_cast<float>(m) + r) * step;
+        // Rounding can leave the sum a hair under 1, never run off the end
+        while (U > c && i < last) {
+            ++i;
+            c += w[i];
+        }
+        parents[m] = i;
+    }
+}
 
-        float U = r = static_cast<float>(m) * (1.0f/static_cast<float>(M));
+/**
+ * @return The number of KLD bins the particles of set fall in.  Only the
+ *         bins touched are cleared afterwards.
+ */
+int MCL::countOccupiedBins(const ParticleSet& set)
+{
+    int k = 0;
+    for (int m = 0; m < set.size; ++m) {
+        int bx = static_cast<int>(set.x[m] / KLD_BIN_XY);
+        int by = static_cast<int>(set.y[m] / KLD_BIN_XY);
+        int bh = static_cast<int>((set.h[m] + M_PI_FLOAT) / KLD_BIN_H);
+        bx = max(0, min(bx, kldBinsX - 1));
+        by = max(0, min(by, kldBinsY - 1));
+        bh = max(0, min(bh, kldBinsH - 1));
+
+        const int bin = (bh * kldBinsY + by) * kldBinsX + bx;
+        if (!kldBins[bin]) {
+            kldBins[bin] = 1;
+            kldOccupied[k++] = bin;
+        }
+    }
 
-        // Normalize the particle weights
-        (*X_bar_t)[m].weight /= totalWeights;
+    for (int j = 0; j < k; ++j) {
+        kldBins[kldOccupied[j]] = 0;
+    }
+    return k;
+}
 
-        while ( U > c) {
-            i++;
-            c += (*X_bar_t)[m].weight;
-        }
-        X_t.push_back(randomWalkParticle((*X_bar_t)[i]));
+/**
+ * The KLD-sampling bound for k occupied bins, by the Wilson-Hilferty
+ * approximation of the chi-square quantile, clamped to [minParticles, M].
+ */
+int MCL::kldBound(int k) const
+{
+    if (k < 2) {
+        return minParticles;
+    }
+    const float a = 2.0f / (9.0f * static_cast<float>(k - 1));
+    const float b = 1.0f - a + sqrtf(a) * KLD_Z;
+    const float n = static_cast<float>(k - 1) / (2.0f * KLD_EPSILON) * b*b*b;
+    if (n >= static_cast<float>(M)) {
+        return M;
     }
+    return max(minParticles, static_cast<int>(ceilf(n)));
 }
+
 /**
  * Prepare for the next update step without resampling the particles
- *
- * @param X_bar_t the set of updated particles
  */
-void MCL::noResample(std::vector<Particle> * X_bar_t) {
-    X_t = *X_bar_t;
+void MCL::noResample() {
+    ParticleSet *t = X_t;
+    X_t = X_bar_t;
+    X_bar_t = t;
 }
 
 /**
@@ -243,6 +482,12 @@ void MCL::noResample(std::vector<Particle> * X_bar_t) {
  */
 void MCL::updateEstimates()
 {
+    const float *x = X_t->x;
+    const float *y = X_t->y;
+    const float *h = X_t->h;
+    const float *w = X_t->w;
+    const int size = X_t->size;
+
     float weightSum = 0.;
     PoseEst wMeans(0.,0.,0.);
     PoseEst bSDs(0., 0., 0.);
@@ -250,17 +495,17 @@ void MCL::updateEstimates()
     float maxWeight = 0;
 
     // Calculate the weighted mean
-    for (unsigned int i = 0; i < X_t.size(); ++i) {
+    for (int i = 0; i < size; ++i) {
         // Sum the values
-        wMeans.x += X_t[i].pose.x*X_t[i].weight;
-        wMeans.y += X_t[i].pose.y*X_t[i].weight;
-        wMeans.h += X_t[i].pose.h*X_t[i].weight;
+        wMeans.x += x[i]*w[i];
+        wMeans.y += y[i]*w[i];
+        wMeans.h += h[i]*w[i];
         // Sum the weights
-        weightSum += X_t[i].weight;
+        weightSum += w[i];
 
-        if (X_t[i].weight > maxWeight) {
-            maxWeight = X_t[i].weight;
-            best = X_t[i].pose;
+        if (w[i] > maxWeight) {
+            maxWeight = w[i];
+            best = PoseEst(x[i], y[i], h[i]);
         }
     }
 
@@ -271,16 +516,10 @@ void MCL::updateEstimates()
     wMeans.h = NBMath::subPIAngle(wMeans.h);
 
     // Calculate the biased variances
-    for (unsigned int i=0; i < X_t.size(); ++i) {
-        bSDs.x += X_t[i].weight *
-            (X_t[i].pose.x - wMeans.x)*
-            (X_t[i].pose.x - wMeans.x);
-        bSDs.y += X_t[i].weight *
-            (X_t[i].pose.y - wMeans.y)*
-            (X_t[i].pose.y - wMeans.y);
-        bSDs.h += X_t[i].weight *
-            (X_t[i].pose.h - wMeans.h)*
-            (X_t[i].pose.h - wMeans.h);
+    for (int i=0; i < size; ++i) {
+        bSDs.x += w[i] * (x[i] - wMeans.x) * (x[i] - wMeans.x);
+        bSDs.y += w[i] * (y[i] - wMeans.y) * (y[i] - wMeans.y);
+        bSDs.h += w[i] * (h[i] - wMeans.h) * (h[i] - wMeans.h);
     }
 
     bSDs.x /= weightSum;
@@ -298,168 +537,189 @@ void MCL::updateEstimates()
     curUncert = bSDs;
 }
 
-//Helpers
-
 /**
- * Determine the weight to compound the particle weight by for a single
- * observation of an landmark point
- *
- * @param z    the observation to determine the weight of
- * @param x_t  the a priori estimate of the robot pose.
- * @param l    the landmark to be used as basis for the observation
- * @return     the probability of the observation
+ * @return The current particles, copied out of the arrays
  */
-float MCL::determinePointWeight(Observation z, PoseEst x_t, PointLandmark pt)
+const vector<Particle> MCL::getParticles() const
 {
-    // Expected dist and bearing
-    float d_hat;
-    float a_hat;
-    // Residuals of distance and bearing observations
-    float r_d;
-    float r_a;
-
-    // Determine expected distance to the landmark
-    d_hat = static_cast<float>(hypot(pt.x - x_t.x, pt.y - x_t.y));
-    // Expected bearing
-    a_hat = atan2(pt.y - x_t.y, pt.x - x_t.x) - x_t.h;
-
-    // Calculate residuals
-    r_d = z.getVisDistance() - d_hat;
-    r_a = z.getVisBearing() - a_hat;
-
-    return getSimilarity(r_d, r_a, z);
+    vector<Particle> particles;
+    particles.reserve(X_t->size);
+    for (int m = 0; m < X_t->size; ++m) {
+        particles.push_back(Particle(PoseEst(X_t->x[m], X_t->y[m], X_t->h[m]),
+                                     X_t->w[m]));
+    }
+    return particles;
 }
 
-/**
- * Determine the simalirty between the observed and expected of a line.
- *
- * @param z    the observation to determine the weight of
- * @param x_t  the a priori estimate of the robot pose.
- * @param l    the landmark to be used as basis for the observation
- * @return     the probability of the observation
- */
-float MCL::determineLineWeight(Observation z, PoseEst x_t, LineLandmark line)
+void MCL::setKLDSampling(bool on, int _minParticles)
 {
-    // Distance and bearing for expected point
-    float d_hat;
-    float a_hat;
-
-    // Residuals of distance and bearing observations
-    float r_d;
-    float r_a;
-
-    // Nearest point on the line
-    PointLandmark pt;
-    // Slopes
-    float m;
-
-    if (line.x2 - line.x1 != 0) { // Check if the line is vertical
-        m = (line.y2 - line.y1) / (line.x2 - line.x1);
-
-        if (m != 0) { // Line is on a slope
-            pt.x = (line.y1 - x_t.y + m*line.x1 + m*x_t.x) *
-                (m / (2*m + 1));
-            pt.y = m * (pt.x - line.x1) + line.y1;
-        } else { // Line is horizontal; ortho is vertical
-            pt.x = x_t.x;
-            pt.y = line.y1;
-        }
-    } else { // Line is vertical
-        pt.x = line.x1;
-        pt.y = x_t.y;
+    kldSampling = on;
+    minParticles = max(1, min(_minParticles, M));
+}
+
+void MCL::setLikelihoodField(bool on, const char *cacheFile)
+{
+    if (on && !likelihoodField) {
+        likelihoodField.reset(new LikelihoodField(cacheFile));
     }
+    useLikelihoodField = on && likelihoodField->getNumTables() > 0;
+}
 
-    // Check if the intersecting point is on the line
-    if( ((line.x1 < line.x2) && (pt.x < line.x1 || pt.x > line.x2)) ||
-        ((line.x1 > line.x2) && (pt.x > line.x1 || pt.x < line.x2)) ||
-        ((line.y1 < line.y2) && (pt.y < line.y1 || pt.y > line.y2)) ||
-        ((line.y1 > line.y2) && (pt.y > line.y1 || pt.y < line.y2))) {
-        // Point is outside the bound of the bounds of the line segment
-        float d_1 = static_cast<float>(hypot(line.x1 - x_t.x, line.y1 - x_t.y));
-        float d_2 = static_cast<float>(hypot(line.x2 - x_t.x, line.y2 - x_t.y));
-        if (d_1 < d_2) {
-            d_hat = d_1;
-            a_hat = atan2(line.y1 - x_t.y, line.x1 - x_t.x) - x_t.h;
-        } else {
-            d_hat = d_2;
-            a_hat = atan2(line.y2 - x_t.y, line.x2 - x_t.x) - x_t.h;
+// Threading
+
+void MCL::startWorkers()
+{
+    if (numThreads < 2) {
+        return;
+    }
+
+    synchro = shared_ptr<Synchro>(new Synchro());
+    for (int i = 1; i < numThreads; ++i) {
+        ostringstream name;
+        name << "MCLWorker" << i;
+        shared_ptr<MCLWorker> worker(new MCLWorker(synchro, name.str(),
+                                                   this, i));
+        if (worker->start() != 0) {
+            cerr << "MCL: worker " << i << " failed to start" << endl;
+            break;
         }
+        worker->getTrigger()->await_on();
+        workers.push_back(worker);
+    }
+}
 
-    } else {
+void MCL::stopWorkers()
+{
+    for (unsigned int i = 0; i < workers.size(); ++i) {
+        workers[i]->stop();
+        workers[i]->getTrigger()->await_off();
+    }
+    workers.clear();
+}
 
-        // Determine nearest expected point on the line
-        d_hat = static_cast<float>(hypot(pt.x - x_t.x, pt.y - x_t.y));
-        // Expected bearing
-        a_hat = atan2(pt.y - x_t.y, pt.x - x_t.x) - x_t.h;
+/**
+ * Runs one step on every thread and returns when all of them are done.
+ */
+void MCL::runJob(Job j)
+{
+    if (workers.empty()) {
+        runChunk(j, 0);
+        return;
     }
 
-    // Calculate residuals
-    r_d = fabs(z.getVisDistance() - d_hat);
-    r_a = fabs(z.getVisBearing() - a_hat);
+    pthread_mutex_lock(&jobMutex);
+    job = j;
+    jobsPending = workers.size();
+    ++jobNumber;
+    pthread_cond_broadcast(&jobCond);
+    pthread_mutex_unlock(&jobMutex);
+
+    runChunk(j, 0);
 
-    return getSimilarity(r_d, r_a, z);
+    pthread_mutex_lock(&jobMutex);
+    while (jobsPending > 0)
+        pthread_cond_wait(&doneCond, &jobMutex);
+    pthread_mutex_unlock(&jobMutex);
 }
 
 /**
- * Determine the similarity of an observation to a landmark location
- *
- * @param r_d     The difference between the expected and observed distance
- * @param r_a     The difference between the expected and observed bearing
- * @param sigma_d The standard deviation of the distance measurement
- * @param sigma_a The standard deviation of the bearing measurement
- * @return        The combined similarity of the landmark observation
+ * Does one thread's share of a step.  Chunks are whole multiples of the
+ * measurement kernels' vector width, so every particle goes through the
+ * same code, and gets the same weight, however the set is split.
+ */
+void MCL::runChunk(Job j, int chunk)
+{
+    const int size = (j == JOB_PREDICT) ? X_bar_t->size : X_t->size;
+    const int threads = workers.size() + 1;
+    const int step = MCLKernels::PARTICLES_PER_STEP;
+    const int perChunk = ((size + threads - 1) / threads + step - 1) /
+        step * step;
+    const int begin = chunk * perChunk;
+    const int end = (begin + perChunk < size) ? begin + perChunk : size;
+    if (begin >= end) {
+        return;
+    }
+
+    switch (j) {
+    case JOB_PREDICT:
+        updateMotionModel(*jobOdometry, begin, end);
+        updateMeasurementModel(*jobObservations, begin, end);
+        break;
+    case JOB_WALK:
+        for (int n = begin; n < end; ++n) {
+            copyParticle(*X_bar_t, parents[n], *X_t, n);
+            randomWalkParticle(*X_t, n);
+        }
+        break;
+    }
+}
+
+//Helpers
+
+/**
+ * Fill the current set with M particles spread randomly about the field.
  */
-float MCL::getSimilarity(float r_d, float r_a, Observation &z)
+void MCL::spreadParticles()
 {
-    // Similarity of observation and expectation
-    float s_d_a;
-    float sigma_d = z.getDistanceSD();
-    float sigma_a = z.getBearingSD();
-    // Calculate the similarity of the observation and expectation
-    s_d_a = exp((-(r_d*r_d) / (sigma_d*sigma_d))
-                -((r_a*r_a) / (sigma_a*sigma_a)));
-
-    if (s_d_a < MIN_SIMILARITY) {
-        s_d_a = MIN_SIMILARITY;
+    for (int m = 0; m < M; ++m) {
+        uint32_t draw[4];
+        rng(m, epoch, RANDOM_SPREAD, 0, draw);
+        // X bounded by width of the field
+        // Y bounded by height of the field
+        // H between +-pi/2
+        X_t->x[m] = Philox::uniform(draw[0]) * FIELD_WIDTH;
+        X_t->y[m] = Philox::uniform(draw[1]) * FIELD_HEIGHT;
+        X_t->h[m] = (2.0f * Philox::uniform(draw[2]) - 1.0f) *
+            (M_PI_FLOAT / 2.0f);
+        X_t->w[m] = 1.0f;
     }
-    return s_d_a;
+    X_t->size = M;
+}
+
+void MCL::copyParticle(const ParticleSet& from, int i, ParticleSet& to, int j)
+{
+    to.x[j] = from.x[i];
+    to.y[j] = from.y[i];
+    to.h[j] = from.h[i];
+    to.w[j] = from.w[i];
 }
 
 /**
  * Move a particle randomly in the x, y, and h directions proportional
  * to its weight, within a certian bounds.
  *
- * @param p The particle to be random walked
- *
- * @return The walked particle
+ * @param set The set holding the particle
+ * @param i   The particle to be random walked
  */
-Particle MCL::randomWalkParticle(Particle p)
+void MCL::randomWalkParticle(ParticleSet& set, int i)
 {
-    p.pose.x += sampleNormalDistribution(MAX_CHANGE_X * (1.0f - p.weight));
-    p.pose.y += sampleNormalDistribution(MAX_CHANGE_Y * (1.0f - p.weight));
-    p.pose.h += sampleNormalDistribution(MAX_CHANGE_H * (1.0f - p.weight));
+    float noise[4];
+    sampleNormals(i, RANDOM_WALK, noise);
 
-    p.pose.h = NBMath::subPIAngle(p.pose.h);
+    const float spread = 1.0f - set.w[i];
+    set.x[i] += noise[0] * MAX_CHANGE_X * spread;
+    set.y[i] += noise[1] * MAX_CHANGE_Y * spread;
+    set.h[i] += noise[2] * MAX_CHANGE_H * spread;
 
-    return p;
+    set.h[i] = NBMath::subPIAngle(set.h[i]);
 }
 
-float MCL::sampleNormalDistribution(float sd)
+/**
+ * Four standard normal samples for one particle, by Box-Muller on one
+ * Philox block.
+ */
+void MCL::sampleNormals(uint32_t particle, RandomPurpose purpose,
+                        float normals[4]) const
 {
-    float samp = 0;
-    for(int i = 0; i < 12; i++) {
-        samp += (2*(static_cast<float>(rand()) /
-					static_cast<float>(RAND_MAX)) * sd) - sd;
+    uint32_t draw[4];
+    rng(particle, epoch, purpose, 0, draw);
+    for (int k = 0; k < 4; k += 2) {
+        const float r = sqrtf(-2.0f * logf(Philox::uniform(draw[k])));
+        float s, c;
+        sincosf(2.0f * M_PI_FLOAT * Philox::uniform(draw[k + 1]), &s, &c);
+        normals[k] = r * c;
+        normals[k + 1] = r * s;
     }
-    return 0.5f*samp;
-}
-
-float MCL::sampleTriangularDistribution(float sd)
-{
-    return std::sqrt(6.0f)*0.5f * ((2.0f*sd*(static_cast<float>(rand()) /
-								   static_cast<float>(RAND_MAX))) - sd +
-                            (2.0f*sd*(static_cast<float>(rand()) /
-								   static_cast<float>(RAND_MAX))) - sd);
 }
 
 // Particle
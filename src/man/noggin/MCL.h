@@ -12,13 +12,17 @@
 // STL
 #include <vector>
 #include <math.h>
+#include <pthread.h>
+#include <boost/shared_ptr.hpp>
 // Local
+#include "Philox.h"
 #include "Observation.h"
 #include "FieldConstants.h"
 #include "EKFStructs.h"
 #include "NBMath.h"
 #include "NogginStructs.h"
 #include "LocSystem.h"
+#include "LikelihoodField.h"
 
 // Particle
 class Particle
@@ -40,18 +44,46 @@ public:
 // Constants
 static const float MIN_SIMILARITY = static_cast<float>(1.0e-20); // Minimum possible similarity
 
+// KLD-sampling (Fox, "Adapting the Sample Size in Particle Filters Through
+// KLD-Sampling", IJRR 2003).  Enough particles are kept that, with
+// probability 1 - delta, the KL distance between the particle estimate and
+// the posterior stays under epsilon, counting the posterior's support in
+// bins of the sizes below.
+static const float KLD_EPSILON = 0.05f;
+static const float KLD_Z = 2.326f; // Upper 1 - delta quantile, delta = 0.01
+static const float KLD_BIN_XY = 25.0f; // cm
+static const float KLD_BIN_H = M_PI_FLOAT / 18.0f; // 10 degrees
+static const int KLD_MIN_PARTICLES = 100;
+
+class Synchro;
+class MCLWorker;
+
 // The Monte Carlo Localization class
 class MCL : public LocSystem
 {
+    friend class MCLWorker;
+
 public:
     // Constructors & Destructors
-    MCL(int M=100);
+    /**
+     * @param M       Number of particles; with KLD-sampling the most the
+     *                filter will ever use
+     * @param threads Threads to update the particles on, including the
+     *                caller's; the others are started here
+     * @param seed    Seed of the random number streams, 0 picks one from
+     *                the clock.  For a given seed the filter gives the same
+     *                results with any number of threads.
+     */
+    MCL(int M=100, int threads=1, uint32_t seed=0);
     virtual ~MCL();
 
     // Core Functions
     virtual void updateLocalization(MotionModel u_t,
-                                    std::vector<Observation> z_t);
+                                    const std::vector<Observation>& z_t);
     virtual void reset();
+    virtual void blueGoalieReset();
+    virtual void redGoalieReset();
+    virtual void resetLocTo(float x, float y, float h);
 
     // Getters
     const PoseEst getCurrentEstimate() const { return curEst; }
@@ -107,11 +139,22 @@ public:
     const float getHUncertDeg() const { return curUncert.h * 2 * TO_DEG;}
 
     const MotionModel getLastOdo() const { return lastOdo; }
+    const std::vector<Observation> getLastObservations() const {
+        return std::vector<Observation>(lastObservations.begin(),
+                                        lastObservations.begin() +
+                                        numLastObservations);
+    }
+
+    /**
+     * @return A copy of the current set of particles in the filter. Builds
+     *         a new vector every call, so keep it out of the update loop.
+     */
+    const std::vector<Particle> getParticles() const;
 
     /**
-     * @return The current set of particles in the filter
+     * @return The number of particles in the current set
      */
-    const std::vector<Particle> getParticles() const { return X_t; }
+    int getNumParticles() const { return X_t->size; }
 
     // Setters
     /**
@@ -146,39 +189,138 @@ public:
 
     void setUseBest(bool _new) { useBest = _new; }
 
+    /**
+     * Switch KLD-sampling on or off.  When on, every resample picks the
+     * number of particles, between minParticles and M, from how spread out
+     * the posterior is: M when the robot is lost, a few hundred once it has
+     * converged.  When off the filter always keeps M.
+     */
+    void setKLDSampling(bool on, int minParticles = KLD_MIN_PARTICLES);
+    bool getKLDSampling() const { return kldSampling; }
+
+    /**
+     * Switch likelihood field weighting on or off.  When on, observations
+     * whose possibilities are one of LikelihoodField's landmark groups,
+     * such as a corner that could be any L corner or a line that could be
+     * any line, are weighed from the precomputed field instead of against
+     * every possibility.  Observations of anything else still use
+     * MCLKernels.  The field is built, or mapped in from cacheFile, the
+     * first time this is switched on.
+     */
+    void setLikelihoodField(bool on, const char *cacheFile = 0);
+    bool getLikelihoodField() const { return useLikelihoodField; }
+
+    uint32_t getSeed() const { return rng.getKey0(); }
+    int getNumThreads() const { return numThreads; }
+
 private:
+    /**
+     * A set of particles stored as one array per field, so the update loops
+     * walk contiguous floats instead of hopping between Particle objects.
+     * The arrays are allocated once, with room for M particles, and never
+     * resized.
+     */
+    struct ParticleSet
+    {
+        float *x;
+        float *y;
+        float *h;
+        float *w;
+        int size;
+    };
+
     // Class variables
     PoseEst curEst; // Current {x,y,h} esitamates
     PoseEst curBest; // Current {x,y,h} esitamate of the highest weighted particle
     PoseEst curUncert; // Associated {x,y,h} uncertainties (standard deviations)
-    std::vector<Particle> X_t; // Current set of particles
+    ParticleSet sets[2]; // Double buffer, each update writes the other one
+    ParticleSet *X_t; // Current set of particles
+    ParticleSet *X_bar_t; // A priori set, written during the update
+    float *storage; // Backing memory of both sets
+    int *parents; // X_bar_t index each resampled particle is copied from
+    bool kldSampling;
+    int minParticles;
+    int kldBinsX, kldBinsY, kldBinsH;
+    unsigned char *kldBins; // Occupancy of every KLD bin, cleared after use
+    int *kldOccupied; // Indices of the occupied bins
+    bool useLikelihoodField;
+    boost::shared_ptr<LikelihoodField> likelihoodField;
     bool useBest;
     MotionModel lastOdo;
+    // The last frame's observations are the first numLastObservations.
+    // Slots past that are kept, not destroyed, so copying into them reuses
+    // their possibility lists.
+    std::vector<Observation> lastObservations;
+    unsigned int numLastObservations;
+
+    /**
+     * Random numbers.  Every draw is keyed on what it is for, never on the
+     * order it was made in: counter (particle, epoch, purpose).  The epoch
+     * goes up once per update or reset.
+     */
+    enum RandomPurpose {
+        RANDOM_SPREAD,
+        RANDOM_MOTION,
+        RANDOM_WALK,
+        RANDOM_RESAMPLE
+    };
+    Philox rng;
+    uint32_t epoch;
+
+    /**
+     * Worker pool.  Each parallel step is split into one chunk per thread;
+     * the caller runs chunk 0 and waits for the workers to finish the rest.
+     */
+    enum Job {
+        JOB_PREDICT, // motion and measurement models into X_bar_t
+        JOB_WALK     // copy resampled particles into X_t and jitter them
+    };
+    const int numThreads;
+    boost::shared_ptr<Synchro> synchro;
+    std::vector<boost::shared_ptr<MCLWorker> > workers;
+    pthread_mutex_t jobMutex;
+    pthread_cond_t jobCond;
+    pthread_cond_t doneCond;
+    unsigned int jobNumber;
+    int jobsPending;
+    Job job;
+    const MotionModel *jobOdometry;
+    const std::vector<Observation> *jobObservations;
 
     // Core Functions
-    PoseEst updateMotionModel(PoseEst x_t, MotionModel u_t);
-    float updateMeasurementModel(std::vector<Observation> z_t, PoseEst x_t);
-    void resample(std::vector<Particle> * X_bar_t, float totalWeights);
-    void lowVarianceResample(std::vector<Particle> * X_bar_t,
-                             float totalWeights);
-    void noResample(std::vector<Particle> * X_bar_t);
+    void updateMotionModel(const MotionModel& u_t, int begin, int end);
+    void updateMeasurementModel(const std::vector<Observation>& z_t,
+                                int begin, int end);
+    void resample(float totalWeights);
+    void systematicResample(float r, int n);
+    int countOccupiedBins(const ParticleSet& set);
+    int kldBound(int k) const;
+    void noResample();
     void updateEstimates();
 
+    // Threading
+    void startWorkers();
+    void stopWorkers();
+    void runJob(Job j);
+    void runChunk(Job j, int chunk);
+
     // Helpers
-    float determinePointWeight(Observation z, PoseEst x_t,
-                               PointLandmark landmark);
-    float determineLineWeight(Observation z, PoseEst x_t, LineLandmark _line);
-    float getSimilarity(float r_d, float r_a, Observation &z);
-    Particle randomWalkParticle(Particle p);
-    float sampleNormalDistribution(float sd);
-    float sampleTriangularDistribution(float sd);
+    void spreadParticles();
+    void copyParticle(const ParticleSet& from, int i, ParticleSet& to, int j);
+    void randomWalkParticle(ParticleSet& set, int i);
+    void sampleNormals(uint32_t particle, RandomPurpose purpose,
+                       float normals[4]) const;
 
 public:
     // friend std::ostream& operator<< (std::ostream &o, const MCL &c) {
     //     return o << "Est: " << c.curEst << "\nUnct: " << c.curUncert;
     // }
     int frameCounter;
-    const int M; // Number of particles
+    const int M; // Number of particles, or the most with KLD-sampling
+
+private:
+    MCL(const MCL&);
+    MCL& operator=(const MCL&);
 };
 
 #endif // _MCL_H_DEFINED
@@ -0,0 +1,454 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Measurement model kernels used by MCL::updateMeasurementModel().
+ *
+ * Each kernel weighs one observation against a run of particles stored as
+ * separate x, y, h and w arrays.  For every particle it finds the most
+ * likely of the observation's possible landmarks and multiplies that
+ * similarity into the particle's weight.  The max is kept in a register
+ * while the possibilities are walked, so each weight is only loaded and
+ * stored once per observation.
+ *
+ * hypot, atan2 and exp are the expensive part, so the kernels use
+ * polynomial approximations instead of libm:
+ *   fastAtan2  absolute error below 2e-5 rad
+ *   fastExp    relative error below 1e-5 for x in [-87, 0]
+ * The scalar and vector versions run the same arithmetic, so they agree to
+ * rounding.  mclBench checks both error bounds against libm.
+ *
+ * The vector path does four particles per step with SSE2 (Atom bodies, dev
+ * boxes); everything else, including the Geode, runs the scalar loop.
+ * Define NO_SIMD_MCL to force the scalar loop.  The vector kernels expect
+ * the particle arrays to be 16 byte aligned, which MCL's are.
+ */
+
+#ifndef MCLKernels_h_DEFINED
+#define MCLKernels_h_DEFINED
+
+#include <math.h>
+#include "NogginStructs.h"
+
+#ifndef NO_SIMD_MCL
+#  if defined(__SSE2__)
+#    include <emmintrin.h>
+#    define MCL_KERNEL_SSE2
+#  endif
+#endif
+
+namespace MCLKernels {
+
+    // Number of particles handled per vector step
+    static const int PARTICLES_PER_STEP = 4;
+
+    /**
+     * One observation, with everything the kernels need precomputed.
+     */
+    struct Measurement
+    {
+        float dist;         // observed distance
+        float bearing;      // observed bearing
+        float invVarD;      // 1 / sigma_d^2
+        float invVarA;      // 1 / sigma_a^2
+        float minSimilarity;
+    };
+
+    /**
+     * A line landmark rewritten so the nearest point to a particle is an
+     * affine function of the particle's position, with no branches on the
+     * slope.  Built once per possibility per frame.
+     */
+    struct LineSegment
+    {
+        float ax, bx, cx;   // pt.x = ax*x + bx*y + cx
+        float ay, by, cy;   // pt.y = ay*x + by*y + cy
+        float x1, y1, x2, y2;
+        float xMin, xMax, yMin, yMax;
+        bool checkX, checkY;    // false along the axis the line is flat in
+    };
+
+    /**
+     * Sets up s for the line.  Uses the same nearest point formulas as
+     * the original MCL::determineLineWeight().
+     */
+    inline void makeSegment(const LineLandmark& line, LineSegment& s)
+    {
+        s.x1 = line.x1;
+        s.y1 = line.y1;
+        s.x2 = line.x2;
+        s.y2 = line.y2;
+        s.xMin = line.x1 < line.x2 ? line.x1 : line.x2;
+        s.xMax = line.x1 < line.x2 ? line.x2 : line.x1;
+        s.yMin = line.y1 < line.y2 ? line.y1 : line.y2;
+        s.yMax = line.y1 < line.y2 ? line.y2 : line.y1;
+        s.checkX = line.x1 != line.x2;
+        s.checkY = line.y1 != line.y2;
+
+        if (line.x2 - line.x1 != 0) { // Check if the line is vertical
+            const float m = (line.y2 - line.y1) / (line.x2 - line.x1);
+
+            if (m != 0) { // Line is on a slope
+                // pt.x = (y1 - y + m*x1 + m*x) * (m / (2m + 1))
+                // pt.y = m * (pt.x - x1) + y1
+                const float k = m / (2*m + 1);
+                s.ax = k * m;
+                s.bx = -k;
+                s.cx = k * (line.y1 + m * line.x1);
+                s.ay = m * s.ax;
+                s.by = m * s.bx;
+                s.cy = m * s.cx - m * line.x1 + line.y1;
+            } else { // Line is horizontal; ortho is vertical
+                s.ax = 1; s.bx = 0; s.cx = 0;
+                s.ay = 0; s.by = 0; s.cy = line.y1;
+            }
+        } else { // Line is vertical
+            s.ax = 0; s.bx = 0; s.cx = line.x1;
+            s.ay = 0; s.by = 1; s.cy = 0;
+        }
+    }
+
+    /**
+     * atan2 from a minimax polynomial for atan on [0, 1] and the usual
+     * octant folding.
+     */
+    inline float fastAtan2(float y, float x)
+    {
+        const float ax = fabsf(x);
+        const float ay = fabsf(y);
+        const float mn = ax < ay ? ax : ay;
+        float mx = ax < ay ? ay : ax;
+        if (mx < 1e-30f) {
+            mx = 1e-30f;
+        }
+        const float z = mn / mx;
+        const float z2 = z * z;
+        float a = z * (0.99997726f + z2 * (-0.33262347f + z2 *
+                       (0.19354346f + z2 * (-0.11643287f + z2 *
+                        (0.05265332f + z2 * -0.01172120f)))));
+        if (ay > ax) {
+            a = 1.57079637f - a;
+        }
+        if (x < 0) {
+            a = 3.14159274f - a;
+        }
+        return y < 0 ? -a : a;
+    }
+
+    /**
+     * exp(x) = 2^n * 2^f with n the nearest integer to x*log2(e) and f in
+     * [-0.5, 0.5], 2^f from the Cephes exp2f polynomial.  Only meant for
+     * the non positive arguments of the similarity; clamped at -87 so the
+     * exponent can't underflow.
+     */
+    inline float fastExp(float x)
+    {
+        if (x < -87.0f) {
+            x = -87.0f;
+        }
+        const float t = x * 1.44269504f;
+        const float n = floorf(t + 0.5f);
+        const float f = t - n;
+        const float p = 1.0f + f * (6.931472028550421e-1f + f *
+                        (2.402264791363012e-1f + f *
+                         (5.550332471162809e-2f + f *
+                          (9.618437357674640e-3f + f *
+                           (1.339887440266574e-3f + f *
+                            1.535336188319500e-4f)))));
+        union { int i; float f; } scale;
+        scale.i = (static_cast<int>(n) + 127) << 23;
+        return p * scale.f;
+    }
+
+    inline float similarity(float r_d, float r_a, const Measurement& z)
+    {
+        const float s = fastExp(-(r_d * r_d) * z.invVarD -
+                                (r_a * r_a) * z.invVarA);
+        return s < z.minSimilarity ? z.minSimilarity : s;
+    }
+
+    /**
+     * Weighs particles [begin, end) against a point observation.
+     */
+    inline void pointWeightsScalar(const float* x, const float* y,
+                                   const float* h, float* w,
+                                   int begin, int end, const Measurement& z,
+                                   const PointLandmark* possible,
+                                   int numPossible)
+    {
+        for (int i = begin; i < end; ++i) {
+            float pMax = -1;
+            for (int j = 0; j < numPossible; ++j) {
+                const float dx = possible[j].x - x[i];
+                const float dy = possible[j].y - y[i];
+                const float d_hat = sqrtf(dx * dx + dy * dy);
+                const float a_hat = fastAtan2(dy, dx) - h[i];
+                const float p = similarity(z.dist - d_hat,
+                                           z.bearing - a_hat, z);
+                if (p > pMax) {
+                    pMax = p;
+                }
+            }
+            w[i] *= pMax;
+        }
+    }
+
+    /**
+     * Weighs particles [begin, end) against a line observation.  The
+     * expected point is the nearest point on the line, or the nearer end
+     * point if that falls off the segment.
+     */
+    inline void lineWeightsScalar(const float* x, const float* y,
+                                  const float* h, float* w,
+                                  int begin, int end, const Measurement& z,
+                                  const LineSegment* possible,
+                                  int numPossible)
+    {
+        for (int i = begin; i < end; ++i) {
+            float pMax = -1;
+            for (int j = 0; j < numPossible; ++j) {
+                const LineSegment& s = possible[j];
+                float px = s.ax * x[i] + s.bx * y[i] + s.cx;
+                float py = s.ay * x[i] + s.by * y[i] + s.cy;
+
+                if ((s.checkX && (px < s.xMin || px > s.xMax)) ||
+                    (s.checkY && (py < s.yMin || py > s.yMax))) {
+                    const float d1 = ((s.x1 - x[i]) * (s.x1 - x[i]) +
+                                      (s.y1 - y[i]) * (s.y1 - y[i]));
+                    const float d2 = ((s.x2 - x[i]) * (s.x2 - x[i]) +
+                                      (s.y2 - y[i]) * (s.y2 - y[i]));
+                    px = d1 < d2 ? s.x1 : s.x2;
+                    py = d1 < d2 ? s.y1 : s.y2;
+                }
+
+                const float dx = px - x[i];
+                const float dy = py - y[i];
+                const float d_hat = sqrtf(dx * dx + dy * dy);
+                const float a_hat = fastAtan2(dy, dx) - h[i];
+                const float p = similarity(z.dist - d_hat,
+                                           z.bearing - a_hat, z);
+                if (p > pMax) {
+                    pMax = p;
+                }
+            }
+            w[i] *= pMax;
+        }
+    }
+
+#ifdef MCL_KERNEL_SSE2
+    // Picks a where mask is set, b elsewhere (no blendv before SSE4.1)
+    inline __m128 sse2Select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline __m128 sse2Atan2(__m128 y, __m128 x)
+    {
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 ax = _mm_andnot_ps(signBit, x);
+        const __m128 ay = _mm_andnot_ps(signBit, y);
+        const __m128 mn = _mm_min_ps(ax, ay);
+        const __m128 mx = _mm_max_ps(_mm_max_ps(ax, ay),
+                                     _mm_set1_ps(1e-30f));
+        const __m128 z = _mm_div_ps(mn, mx);
+        const __m128 z2 = _mm_mul_ps(z, z);
+
+        __m128 p = _mm_set1_ps(-0.01172120f);
+        p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(0.05265332f));
+        p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(-0.11643287f));
+        p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(0.19354346f));
+        p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(-0.33262347f));
+        p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(0.99997726f));
+        __m128 a = _mm_mul_ps(p, z);
+
+        a = sse2Select(_mm_cmpgt_ps(ay, ax),
+                       _mm_sub_ps(_mm_set1_ps(1.57079637f), a), a);
+        a = sse2Select(_mm_cmplt_ps(x, _mm_setzero_ps()),
+                       _mm_sub_ps(_mm_set1_ps(3.14159274f), a), a);
+        // Copy the sign of y
+        return _mm_or_ps(a, _mm_and_ps(y, signBit));
+    }
+
+    inline __m128 sse2Exp(__m128 x)
+    {
+        x = _mm_max_ps(x, _mm_set1_ps(-87.0f));
+        const __m128 t = _mm_mul_ps(x, _mm_set1_ps(1.44269504f));
+        // cvtps rounds to nearest under the default MXCSR
+        const __m128i n = _mm_cvtps_epi32(t);
+        const __m128 f = _mm_sub_ps(t, _mm_cvtepi32_ps(n));
+
+        __m128 p = _mm_set1_ps(1.535336188319500e-4f);
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.339887440266574e-3f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.618437357674640e-3f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.550332471162809e-2f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.402264791363012e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.931472028550421e-1f));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+        const __m128i bits = _mm_slli_epi32(
+            _mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+        return _mm_mul_ps(p, _mm_castsi128_ps(bits));
+    }
+
+    /**
+     * Similarity of four expected points (ex, ey) to the observation, seen
+     * from four particles.
+     */
+    inline __m128 sse2Similarity(__m128 px, __m128 py, __m128 ph,
+                                 __m128 ex, __m128 ey, const Measurement& z)
+    {
+        const __m128 dx = _mm_sub_ps(ex, px);
+        const __m128 dy = _mm_sub_ps(ey, py);
+        const __m128 d_hat = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+                                                    _mm_mul_ps(dy, dy)));
+        const __m128 a_hat = _mm_sub_ps(sse2Atan2(dy, dx), ph);
+        const __m128 r_d = _mm_sub_ps(_mm_set1_ps(z.dist), d_hat);
+        const __m128 r_a = _mm_sub_ps(_mm_set1_ps(z.bearing), a_hat);
+        const __m128 e = _mm_add_ps(
+            _mm_mul_ps(_mm_mul_ps(r_d, r_d), _mm_set1_ps(z.invVarD)),
+            _mm_mul_ps(_mm_mul_ps(r_a, r_a), _mm_set1_ps(z.invVarA)));
+        return _mm_max_ps(sse2Exp(_mm_sub_ps(_mm_setzero_ps(), e)),
+                          _mm_set1_ps(z.minSimilarity));
+    }
+
+    inline void pointWeightsSSE2(const float* x, const float* y,
+                                 const float* h, float* w, int n,
+                                 const Measurement& z,
+                                 const PointLandmark* possible,
+                                 int numPossible)
+    {
+        const int vectorEnd = n - n % PARTICLES_PER_STEP;
+        int i;
+        for (i = 0; i < vectorEnd; i += PARTICLES_PER_STEP) {
+            const __m128 px = _mm_load_ps(x + i);
+            const __m128 py = _mm_load_ps(y + i);
+            const __m128 ph = _mm_load_ps(h + i);
+            __m128 pMax = _mm_set1_ps(-1.0f);
+            for (int j = 0; j < numPossible; ++j) {
+                pMax = _mm_max_ps(pMax, sse2Similarity(
+                                      px, py, ph,
+                                      _mm_set1_ps(possible[j].x),
+                                      _mm_set1_ps(possible[j].y), z));
+            }
+            _mm_store_ps(w + i, _mm_mul_ps(_mm_load_ps(w + i), pMax));
+        }
+        pointWeightsScalar(x, y, h, w, i, n, z, possible, numPossible);
+    }
+
+    inline void lineWeightsSSE2(const float* x, const float* y,
+                                const float* h, float* w, int n,
+                                const Measurement& z,
+                                const LineSegment* possible,
+                                int numPossible)
+    {
+        const int vectorEnd = n - n % PARTICLES_PER_STEP;
+        int i;
+        for (i = 0; i < vectorEnd; i += PARTICLES_PER_STEP) {
+            const __m128 px = _mm_load_ps(x + i);
+            const __m128 py = _mm_load_ps(y + i);
+            const __m128 ph = _mm_load_ps(h + i);
+            __m128 pMax = _mm_set1_ps(-1.0f);
+            for (int j = 0; j < numPossible; ++j) {
+                const LineSegment& s = possible[j];
+                __m128 ex = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.ax), px),
+                               _mm_mul_ps(_mm_set1_ps(s.bx), py)),
+                    _mm_set1_ps(s.cx));
+                __m128 ey = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.ay), px),
+                               _mm_mul_ps(_mm_set1_ps(s.by), py)),
+                    _mm_set1_ps(s.cy));
+
+                // Lanes whose nearest point is off the segment
+                __m128 outside = _mm_setzero_ps();
+                if (s.checkX) {
+                    outside = _mm_or_ps(
+                        _mm_cmplt_ps(ex, _mm_set1_ps(s.xMin)),
+                        _mm_cmpgt_ps(ex, _mm_set1_ps(s.xMax)));
+                }
+                if (s.checkY) {
+                    outside = _mm_or_ps(outside, _mm_or_ps(
+                        _mm_cmplt_ps(ey, _mm_set1_ps(s.yMin)),
+                        _mm_cmpgt_ps(ey, _mm_set1_ps(s.yMax))));
+                }
+
+                if (_mm_movemask_ps(outside)) {
+                    const __m128 dx1 = _mm_sub_ps(_mm_set1_ps(s.x1), px);
+                    const __m128 dy1 = _mm_sub_ps(_mm_set1_ps(s.y1), py);
+                    const __m128 dx2 = _mm_sub_ps(_mm_set1_ps(s.x2), px);
+                    const __m128 dy2 = _mm_sub_ps(_mm_set1_ps(s.y2), py);
+                    const __m128 nearFirst = _mm_cmplt_ps(
+                        _mm_add_ps(_mm_mul_ps(dx1, dx1), _mm_mul_ps(dy1, dy1)),
+                        _mm_add_ps(_mm_mul_ps(dx2, dx2), _mm_mul_ps(dy2, dy2)));
+                    const __m128 endX = sse2Select(nearFirst,
+                                                   _mm_set1_ps(s.x1),
+                                                   _mm_set1_ps(s.x2));
+                    const __m128 endY = sse2Select(nearFirst,
+                                                   _mm_set1_ps(s.y1),
+                                                   _mm_set1_ps(s.y2));
+                    ex = sse2Select(outside, endX, ex);
+                    ey = sse2Select(outside, endY, ey);
+                }
+
+                pMax = _mm_max_ps(pMax,
+                                  sse2Similarity(px, py, ph, ex, ey, z));
+            }
+            _mm_store_ps(w + i, _mm_mul_ps(_mm_load_ps(w + i), pMax));
+        }
+        lineWeightsScalar(x, y, h, w, i, n, z, possible, numPossible);
+    }
+#endif /* MCL_KERNEL_SSE2 */
+
+    /**
+     * The kernels MCL::updateMeasurementModel() runs, chosen at build time.
+     */
+    inline void pointWeights(const float* x, const float* y, const float* h,
+                             float* w, int n, const Measurement& z,
+                             const PointLandmark* possible, int numPossible)
+    {
+#if defined(MCL_KERNEL_SSE2)
+        pointWeightsSSE2(x, y, h, w, n, z, possible, numPossible);
+#else
+        pointWeightsScalar(x, y, h, w, 0, n, z, possible, numPossible);
+#endif
+    }
+
+    inline void lineWeights(const float* x, const float* y, const float* h,
+                            float* w, int n, const Measurement& z,
+                            const LineSegment* possible, int numPossible)
+    {
+#if defined(MCL_KERNEL_SSE2)
+        lineWeightsSSE2(x, y, h, w, n, z, possible, numPossible);
+#else
+        lineWeightsScalar(x, y, h, w, 0, n, z, possible, numPossible);
+#endif
+    }
+
+    // Name of the kernel in use, for the benchmark
+    inline const char* name()
+    {
+#if defined(MCL_KERNEL_SSE2)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+}
+
+#endif /* MCLKernels_h_DEFINED */
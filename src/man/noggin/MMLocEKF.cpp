@@ -1,56 +1,51 @@
 #include "MMLocEKF.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "FieldConstants.h"
+
 // @todo implement mostLikelyModel tracking
-MMLocEKF::MMLocEKF() :
-	LocSystem(),mostLikelyModel(0), numActive(0),
-	numFree(MAX_MODELS)
+MMLocEKF::MMLocEKF(int maxActive) :
+	LocSystem(),
+	// Leave room for splitting every active model
+	maxActiveModels(max(1, min(maxActive, MAX_MODELS / 2))),
+	mostLikelyModel(0), numActive(0), numFree(MAX_MODELS)
 {
 	initModels();
 }
 
 MMLocEKF::~MMLocEKF()
 {
-	destroyModels();
 }
 
 /**
- * Create the fixed models for the filter
+ * Set up the fixed models for the filter
  */
 void MMLocEKF::initModels()
 {
 	for (int i = 0; i < MAX_MODELS; ++i){
-		models[i] = new LocEKF();
-		models[i]->deactivate();
-
-		models[i]->setProbability(0.0);
-
-		modelList.push_back(models[i]);
+		models[i].deactivate();
+		models[i].setProbability(0.0);
 	}
 	numActive = 0;
 	numFree = MAX_MODELS;
-	activateModel(models[0]);
-	models[0]->setProbability(1.0);
-}
-
-/**
- * Delete all the models on the heap.
- */
-void MMLocEKF::destroyModels()
-{
-	for (int i = 0; i < MAX_MODELS; ++i){
-		delete models[i];
-	}
+	activateModel(&models[0]);
+	models[0].setProbability(1.0);
 }
 
 /**
  * Update localization according to the given odometry and visual observations.
  */
-void MMLocEKF::updateLocalization(MotionModel u, std::vector<Observation> Z)
+void MMLocEKF::updateLocalization(MotionModel u,
+								  const std::vector<Observation>& Z)
 {
 	// Apply time update
 	timeUpdate(u);
 
-	bool hasAppliedACorrection = correctionStep(Z);
+	// correctionStep() removes the observations it has applied
+	std::vector<Observation> unapplied(Z);
+	bool hasAppliedACorrection = correctionStep(unapplied);
 
 	if (!hasAppliedACorrection)
 		applyNoCorrectionStep();
@@ -64,8 +59,8 @@ void MMLocEKF::updateLocalization(MotionModel u, std::vector<Observation> Z)
 void MMLocEKF::timeUpdate(MotionModel u)
 {
 	for (int i=0; i < MAX_MODELS; ++i)
-		if ( models[i]->isActive() ){
-			models[i]->odometryUpdate(u);
+		if ( models[i].isActive() ){
+			models[i].odometryUpdate(u);
 		}
 }
 
@@ -96,8 +91,8 @@ bool MMLocEKF::applyUnambiguousObservations(vector<Observation>& Z)
 void MMLocEKF::applyObsToActiveModels(const Observation& obs)
 {
 	for (int i=0; i < MAX_MODELS; ++i){
-		if (models[i]->isActive()){
-			models[i]->applyObservation(obs);
+		if (models[i].isActive()){
+			models[i].applyObservation(obs);
 		}
 	}
 }
@@ -105,21 +100,31 @@ void MMLocEKF::applyObsToActiveModels(const Observation& obs)
 void MMLocEKF::applyNoCorrectionStep()
 {
 	for (int i=0; i < MAX_MODELS; ++i){
-		if (models[i]->isActive()){
-			models[i]->noCorrectionStep();
+		if (models[i].isActive()){
+			models[i].noCorrectionStep();
 		}
 	}
 }
 
+/**
+ * Split every model on every ambiguous observation, one observation at a
+ * time. Only the models that were active before an observation are split on
+ * it; the models split off it already have one of its possibilities applied.
+ */
 bool MMLocEKF::applyAmbiguousObservations(const vector<Observation>& Z)
 {
 	bool applied = false;
 	if (!Z.empty())
 		applied = true;
-	for (int i=0; i < MAX_MODELS ; ++i){
-		vector<Observation>::const_iterator obs;
-		for (obs = Z.begin(); obs != Z.end() ; ++obs){
-			splitObservation(*obs, models[i]);
+
+	int which[MAX_MODELS];
+	vector<Observation>::const_iterator obs;
+	for (obs = Z.begin(); obs != Z.end() ; ++obs){
+		const int count = getActiveModels(which);
+		for (int i=0; i < count; ++i){
+			// Splitting an earlier model may have merged this one away
+			if (models[which[i]].isActive())
+				splitObservation(*obs, &models[which[i]]);
 		}
 	}
 	return applied;
@@ -128,14 +133,22 @@ bool MMLocEKF::applyAmbiguousObservations(const vector<Observation>& Z)
 void MMLocEKF::splitObservation(const Observation& obs, LocEKF * model)
 {
 	const double originalProb = model->getProbability();
-	list<LocEKF*> splitModels;
-
-	// const int numRequiredModels = obs.getNumPossibilities() * numActive;
-	// if (numRequiredModels > numFree)
-	// 	consolidateModels(MAX_ACTIVE_MODELS);
+	const int numPossibilities = static_cast<int>(obs.getNumPossibilities());
+	int splitModels[MAX_MODELS];
+	int numSplit = 0;
+
+	// Make room for a model per possibility. With many possibilities that
+	// can merge this model into another one, which then stands in for it.
+	if (numFree < numPossibilities){
+		consolidateModels(max(1, MAX_MODELS - numPossibilities));
+		if (!model->isActive())
+			return;
+	}
 
-	for (unsigned int i=0; i < obs.getNumPossibilities(); ++i){
+	for (int i=0; i < numPossibilities; ++i){
 		LocEKF * inactiveModel = getInactiveModel();
+		if (inactiveModel == 0)
+			break;
 		inactiveModel->copyEKF(*model);
 
 		Observation newObs(obs);
@@ -147,12 +160,12 @@ void MMLocEKF::splitObservation(const Observation& obs, LocEKF * model)
 		bool isOutlier = inactiveModel->applyObservation(newObs);
 		if (!isOutlier) {
 			activateModel(inactiveModel);
-			splitModels.push_back(inactiveModel);
+			splitModels[numSplit++] = static_cast<int>(inactiveModel - models);
 		}
 	}
 
-	consolidateModels(MAX_ACTIVE_MODELS);
-	normalizeProbabilities(splitModels, originalProb);
+	consolidateModels(maxActiveModels);
+	normalizeProbabilities(splitModels, numSplit, originalProb);
 	// If every possibility is an outlier and the original model was the only
 	// model to start with, than we need to keep this model active.
 	if (numActive > 1)
@@ -163,24 +176,26 @@ void MMLocEKF::splitObservation(const Observation& obs, LocEKF * model)
 void MMLocEKF::endFrame()
 {
 	for (int i=0; i < MAX_MODELS; ++i){
-		if (models[i]->isActive()){
-			models[i]->endFrame();
+		if (models[i].isActive()){
+			models[i].endFrame();
 		}
 	}
 
-	consolidateModels(MAX_ACTIVE_MODELS);
-	normalizeProbabilities(modelList, PROB_SUM);
+	consolidateModels(maxActiveModels);
+
+	int which[MAX_MODELS];
+	const int count = getActiveModels(which);
+	normalizeProbabilities(which, count, PROB_SUM);
 }
 
-void MMLocEKF::normalizeProbabilities(const list<LocEKF*>& unnormalized,
+void MMLocEKF::normalizeProbabilities(const int * which, int count,
 									  double totalProb)
 {
 	// Normalize the Probabilities so that they all sum to totalProb
     double sumAlpha=0.0;
-	list<LocEKF*>::const_iterator model = unnormalized.begin();
-    for ( ; model != unnormalized.end() ; model++) {
-        if ((*model)->isActive()) {
-            sumAlpha += (*model)->getProbability();
+	for (int i=0; i < count; ++i) {
+        if (models[which[i]].isActive()) {
+            sumAlpha += models[which[i]].getProbability();
         }
     }
 
@@ -188,63 +203,206 @@ void MMLocEKF::normalizeProbabilities(const list<LocEKF*>& unnormalized,
 
     if (sumAlpha == 0) sumAlpha = 1e-12;
 
-	model = unnormalized.begin();
-    for ( ; model != unnormalized.end() ; model++) {
-        if ((*model)->isActive()) {
-            (*model)->setProbability((*model)->getProbability()/sumAlpha);
+	for (int i=0; i < count; ++i) {
+        if (models[which[i]].isActive()) {
+            models[which[i]].setProbability(models[which[i]].getProbability() /
+											sumAlpha);
         }
     }
 
 }
 
-// @todo Tune merging and # of MAX_ACTIVE_MODELS
+// @todo Tune merging and # of maxActiveModels
 void MMLocEKF::consolidateModels(int maxAfterMerge)
 {
 	double mergeThreshold = MERGE_THRESH_INIT;
-	int numMerges = 0;
-	const int MAX_MERGES = 10;
 	const double MIN_ACCEPT_PROB = 0.0001;
 
 	for (int i=0; i < MAX_MODELS; ++i){
-		if (models[i]->isActive() &&
-			models[i]->getProbability() < MIN_ACCEPT_PROB){
-			deactivateModel(models[i]);
+		if (models[i].isActive() &&
+			models[i].getProbability() < MIN_ACCEPT_PROB){
+			deactivateModel(&models[i]);
 		}
 	}
 
-	bool shouldMergeAgain = true;
 	while (numActive > maxAfterMerge){
 		mergeThreshold += MERGE_THRESH_STEP;
 		mergeModels(mergeThreshold);
-		numMerges++;
 	}
 }
 
+/**
+ * One merge pass at the given threshold. Each active model is checked
+ * against the models within mergeRadius() of it, found in a grid with cells
+ * at least that big, in the same order mergeAllPairs() checks them in.
+ *
+ * A merge moves the surviving model, so it is moved to its new cell and its
+ * remaining candidates are gathered again from there. The radius itself is
+ * only worked out once per pass, though, and a merge can grow a model's
+ * covariance past the one it was bounded by. Such a model may miss a pair
+ * that mergeAllPairs() would merge in the same pass; consolidateModels()
+ * runs passes until there are few enough models, so the pair is just left
+ * for a later one.
+ */
 void MMLocEKF::mergeModels(double mergeThreshold)
+{
+	const float radius = mergeRadius(mergeThreshold);
+	if (radius < 0.0f){
+		mergeAllPairs(mergeThreshold);
+		return;
+	}
+
+	mergeCellSize = max(radius,
+						max(FIELD_WIDTH, FIELD_HEIGHT) / MERGE_GRID_SIZE);
+	mergeCols = min(MERGE_GRID_SIZE,
+					static_cast<int>(FIELD_WIDTH / mergeCellSize) + 1);
+	mergeRows = min(MERGE_GRID_SIZE,
+					static_cast<int>(FIELD_HEIGHT / mergeCellSize) + 1);
+
+	// Every cell neighbours every other one
+	if (mergeCols < 3 && mergeRows < 3){
+		mergeAllPairs(mergeThreshold);
+		return;
+	}
+
+	for (int c=0; c < mergeCols * mergeRows; ++c)
+		mergeCellHead[c] = -1;
+
+	for (int i=MAX_MODELS - 1; i >= 0; --i){
+		if (models[i].isActive())
+			addToMergeCell(i);
+	}
+
+	int candidates[MAX_MODELS];
+	for (int i=0; i < MAX_MODELS; ++i) {
+		if (!models[i].isActive())
+			continue;
+
+		int numCandidates = mergeCandidates(i, -1, candidates);
+		for (int k=0; k < numCandidates && models[i].isActive(); ++k){
+			LocEKF& other = models[candidates[k]];
+			if (mergeable(mergeThreshold, models[i], other)){
+				models[i].mergeEKF(other);
+				deactivateModel(&other);
+
+				// Carry on with the later candidates around where the
+				// merged model is now
+				removeFromMergeCell(i);
+				addToMergeCell(i);
+				numCandidates = mergeCandidates(i, candidates[k], candidates);
+				k = -1;
+			}
+		}
+	}
+}
+
+/**
+ * Puts model i at the head of the list of the grid cell it is in. Models off
+ * the field go in the edge cells. Clamping only brings models closer
+ * together, so no pair within the radius is lost.
+ */
+void MMLocEKF::addToMergeCell(int i)
+{
+	const int col = max(0, min(mergeCols - 1, static_cast<int>(
+								   floor(models[i].getXEst() / mergeCellSize))));
+	const int row = max(0, min(mergeRows - 1, static_cast<int>(
+								   floor(models[i].getYEst() / mergeCellSize))));
+	mergeCell[i] = row * mergeCols + col;
+	mergeCellNext[i] = mergeCellHead[mergeCell[i]];
+	mergeCellHead[mergeCell[i]] = i;
+}
+
+void MMLocEKF::removeFromMergeCell(int i)
+{
+	int * link = &mergeCellHead[mergeCell[i]];
+	while (*link != i)
+		link = &mergeCellNext[*link];
+	*link = mergeCellNext[i];
+}
+
+/**
+ * Fill candidates with the active models after index after in model i's
+ * and the neighbouring cells, in order, and return how many there are.
+ */
+int MMLocEKF::mergeCandidates(int i, int after, int * candidates) const
+{
+	int numCandidates = 0;
+	const int col = mergeCell[i] % mergeCols;
+	const int row = mergeCell[i] / mergeCols;
+	for (int r = max(0, row - 1); r <= min(mergeRows - 1, row + 1); ++r){
+		for (int c = max(0, col - 1); c <= min(mergeCols - 1, col + 1); ++c){
+			for (int j = mergeCellHead[r * mergeCols + c]; j >= 0;
+				 j = mergeCellNext[j]){
+				if (j != i && j > after && models[j].isActive())
+					candidates[numCandidates++] = j;
+			}
+		}
+	}
+	sort(candidates, candidates + numCandidates);
+	return numCandidates;
+}
+
+void MMLocEKF::mergeAllPairs(double mergeThreshold)
 {
 	for (int i=0; i < MAX_MODELS; ++i) {
 		for (int j=0; j < MAX_MODELS; ++j){
 			if (i != j && mergeable(mergeThreshold,
 									models[i], models[j])){
-				models[i]->mergeEKF(*models[j]);
-				deactivateModel(models[j]);
+				models[i].mergeEKF(models[j]);
+				deactivateModel(&models[j]);
 			}
 		}
 	}
 }
 
-bool MMLocEKF::mergeable(double mergeThreshold, LocEKF* one, LocEKF* two)
+/**
+ * The distance beyond which no two active models are mergeable() at the
+ * given threshold, or -1 if there is no useful bound.
+ *
+ * With S the probability weighted sum of two models' covariances, the
+ * metric is at least p1 * p2 * d^2 / max(S(0,0), S(1,1)), as long as
+ * mergeable() does not have to clamp its determinant. Bounding the
+ * probabilities below by the smallest one and the covariances above by the
+ * largest diagonal entry of any model, it is at least pMin * d^2 / (2 *
+ * varMax), which is below the threshold only for d < sqrt(2 * threshold *
+ * varMax / pMin).
+ */
+float MMLocEKF::mergeRadius(double mergeThreshold) const
 {
-	if (!one->isActive() || !two->isActive() || one == two)
+	double pMin = 1.0, varMin = -1.0, varMax = 0.0;
+	for (int i=0; i < MAX_MODELS; ++i){
+		if (!models[i].isActive())
+			continue;
+		const LocEKF::StateMatrix P = models[i].getStateUncertainty();
+		pMin = min(pMin, models[i].getProbability());
+		const double lo = min(P(0,0), P(1,1));
+		varMin = (varMin < 0.0) ? lo : min(varMin, lo);
+		varMax = max(varMax, static_cast<double>(max(P(0,0), P(1,1))));
+	}
+
+	// Small enough that the clamped determinant could matter
+	const double minSumVar = 2.0 * pMin * varMin;
+	if (pMin <= 0.0 || minSumVar * minSumVar < 0.0001)
+		return -1.0f;
+
+	// With a little slack for mergeable() working in floats
+	return static_cast<float>(1.01 * sqrt(2.0 * mergeThreshold *
+										  varMax / pMin));
+}
+
+bool MMLocEKF::mergeable(double mergeThreshold,
+						 const LocEKF& one, const LocEKF& two) const
+{
+	if (!one.isActive() || !two.isActive() || &one == &two)
 		return false;
 
-	const LocEKF::StateVector diff = one->getState() - two->getState();
+	const LocEKF::StateVector diff = one.getState() - two.getState();
 
-	LocEKF::StateMatrix oneUncert = one->getStateUncertainty();
-	LocEKF::StateMatrix twoUncert = two->getStateUncertainty();
+	LocEKF::StateMatrix oneUncert = one.getStateUncertainty();
+	LocEKF::StateMatrix twoUncert = two.getStateUncertainty();
 
-	LocEKF::StateMatrix uncertSum = (oneUncert * one->getProbability() +
-									 twoUncert * two->getProbability());
+	LocEKF::StateMatrix uncertSum = (oneUncert * one.getProbability() +
+									 twoUncert * two.getProbability());
 
 
 	float denom = (-uncertSum(0,1) * uncertSum(1,0) +
@@ -261,66 +419,82 @@ bool MMLocEKF::mergeable(double mergeThreshold, LocEKF* one, LocEKF* two)
 	uncertSumInv(1,0) = 0.0f;
 	uncertSumInv(1,1) = uncertSum(0,0)/denom;
 
-	double metric = abs(one->getProbability() * two->getProbability() *
-		inner_prod(trans(diff), prod(uncertSumInv, diff)));
+	double metric = fabs(one.getProbability() * two.getProbability() *
+						 inner_prod(trans(diff), prod(uncertSumInv, diff)));
 
 	return (metric < mergeThreshold);
 }
 
+/**
+ * Fill which with the indices of the active models, in order, and return
+ * how many there are.
+ */
+int MMLocEKF::getActiveModels(int * which) const
+{
+	int count = 0;
+	for (int i=0; i < MAX_MODELS; ++i)
+		if (models[i].isActive())
+			which[count++] = i;
+	return count;
+}
+
 
 /****************** Getters *****************************/
 const PoseEst MMLocEKF::getCurrentEstimate() const
 {
-	return models[getMostLikelyModel()]->getCurrentEstimate();
+	return models[getMostLikelyModel()].getCurrentEstimate();
 }
 
 const PoseEst MMLocEKF::getCurrentUncertainty() const
 {
-	return models[getMostLikelyModel()]->getCurrentUncertainty();
+	return models[getMostLikelyModel()].getCurrentUncertainty();
 }
 
 const float MMLocEKF::getXEst() const
 {
-	return models[getMostLikelyModel()]->getXEst();
+	return models[getMostLikelyModel()].getXEst();
 }
 
 const float MMLocEKF::getYEst() const
 {
-	return models[getMostLikelyModel()]->getYEst();
+	return models[getMostLikelyModel()].getYEst();
 }
 
 const float MMLocEKF::getHEst() const
 {
-	return models[getMostLikelyModel()]->getHEst();
+	return models[getMostLikelyModel()].getHEst();
 }
 
 const float MMLocEKF::getHEstDeg() const
 {
-	return models[getMostLikelyModel()]->getHEstDeg();
+	return models[getMostLikelyModel()].getHEstDeg();
 }
 
 const float MMLocEKF::getXUncert() const
 {
-	return models[getMostLikelyModel()]->getXUncert();
+	return models[getMostLikelyModel()].getXUncert();
 }
 
 const float MMLocEKF::getYUncert() const
 {
-	return models[getMostLikelyModel()]->getYUncert();
+	return models[getMostLikelyModel()].getYUncert();
 }
 
 const float MMLocEKF::getHUncert() const
 {
-	return models[getMostLikelyModel()]->getHUncert();
+	return models[getMostLikelyModel()].getHUncert();
 }
 
 const float MMLocEKF::getHUncertDeg() const
 {
-	return models[getMostLikelyModel()]->getHUncertDeg();
+	return models[getMostLikelyModel()].getHUncertDeg();
 }
 
-const list<LocEKF*> MMLocEKF::getModels() const
+const list<const LocEKF*> MMLocEKF::getModels() const
 {
+	list<const LocEKF*> modelList;
+	for (int i=0; i < MAX_MODELS; ++i)
+		modelList.push_back(&models[i]);
 	return modelList;
 }
 
@@ -332,9 +506,9 @@ const int MMLocEKF::getMostLikelyModel() const
 	int index = 0;
 
 	for (int i=0; i<MAX_MODELS; ++i){
-		if (models[i]->getProbability() > max &&
-			models[i]->isActive()){
-			max = models[i]->getProbability();
+		if (models[i].getProbability() > max &&
+			models[i].isActive()){
+			max = models[i].getProbability();
 			index = i;
 		}
 	}
@@ -342,29 +516,30 @@ const int MMLocEKF::getMostLikelyModel() const
 	return index;
 }
 
-LocEKF * MMLocEKF::getInactiveModel() const
+/**
+ * @return A free model from the pool, or 0 if every model is in use.
+ */
+LocEKF * MMLocEKF::getInactiveModel()
 {
 	for (int i=0; i < MAX_MODELS; ++i)
-		if (!models[i]->isActive())
-			return models[i];
-	cout << "SHIT RAN OUT OF MODELS";
-	exit(0);
-	return models[MAX_MODELS -1];
+		if (!models[i].isActive())
+			return &models[i];
+	return 0;
 }
 
 /************** PRIVATE HELPERS ***********/
 void MMLocEKF::setAllModelsInactive()
 {
 	for (int i=0; i < MAX_MODELS; ++i)
-		deactivateModel(models[i]);
+		deactivateModel(&models[i]);
 }
 
 void MMLocEKF::equalizeProbabilities()
 {
 	const double newProbability = 1.0/numActive;
 	for (int i=0; i < MAX_MODELS ; ++i){
-		if (models[i]->isActive())
-			models[i]->setProbability(newProbability);
+		if (models[i].isActive())
+			models[i].setProbability(newProbability);
 	}
 }
 
@@ -390,24 +565,32 @@ void MMLocEKF::activateModel(LocEKF * model)
 void MMLocEKF::blueGoalieReset()
 {
 	setAllModelsInactive();
-	activateModel(models[0]);
+	activateModel(&models[0]);
 	equalizeProbabilities();
-	models[0]->blueGoalieReset();
+	models[0].blueGoalieReset();
 }
 
 void MMLocEKF::redGoalieReset()
 {
 	setAllModelsInactive();
-	activateModel(models[0]);
+	activateModel(&models[0]);
 	equalizeProbabilities();
-	models[0]->redGoalieReset();
+	models[0].redGoalieReset();
 }
 
 void MMLocEKF::reset()
 {
 	setAllModelsInactive();
-	activateModel(models[0]);
+	activateModel(&models[0]);
 	equalizeProbabilities();
-	models[0]->reset();
+	models[0].reset();
 
 }
+
+void MMLocEKF::resetLocTo(float x, float y, float h)
+{
+	setAllModelsInactive();
+	activateModel(&models[0]);
+	equalizeProbabilities();
+	models[0].resetLocTo(x, y, h);
+}
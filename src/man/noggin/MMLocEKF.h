@@ -1,6 +1,15 @@
 /**
  * Multiple model Extend Kalman Filter class for robot self localization.
  *
+ * The models live in one fixed, contiguous pool of LocEKFs owned by the
+ * filter; a model is in use when it is active.  Splitting a model copies it
+ * into a free slot of the pool, merging one deactivates it, and nothing is
+ * allocated after construction.
+ *
+ * Merge candidates come from a grid over the field.  Two models further
+ * apart than mergeRadius() cannot pass mergeable(), so each model is only
+ * checked against the models in its own and the eight neighbouring cells,
+ * which keeps consolidating many models from being quadratic in them.
  */
 
 #ifndef MMLocEKF_h_DEFINED
@@ -15,14 +24,17 @@ class MMLocEKF : public LocSystem
 
 
 public:							// Public interface
-	MMLocEKF();
+	MMLocEKF(int maxActiveModels = DEFAULT_MAX_ACTIVE_MODELS);
 	virtual ~MMLocEKF();
 
-	virtual void updateLocalization(MotionModel u, std::vector<Observation> Z);
+	virtual void updateLocalization(MotionModel u,
+									const std::vector<Observation>& Z);
+
+	const static int MAX_MODELS = 64;
+	const static int DEFAULT_MAX_ACTIVE_MODELS = 6;
 
 private:						// Private methods
 	void initModels();
-	void destroyModels();
 
 	void timeUpdate(MotionModel u);
 	bool correctionStep(std::vector<Observation>& Z);
@@ -36,38 +48,52 @@ private:						// Private methods
 	void consolidateModels(int maxAfterMerge);
 
 	void mergeModels(double mergeThreshold);
+	void mergeAllPairs(double mergeThreshold);
+	float mergeRadius(double mergeThreshold) const;
+	void addToMergeCell(int i);
+	void removeFromMergeCell(int i);
+	int mergeCandidates(int i, int after, int * candidates) const;
 
 	void endFrame();
-	void normalizeProbabilities(const list<LocEKF*>& unnormalized,
+	void normalizeProbabilities(const int * which, int count,
 								double totalProb);
 
 	void setAllModelsInactive();
 	void equalizeProbabilities();
-	bool mergeable(double mergeThreshold, LocEKF* one, LocEKF* two);
+	bool mergeable(double mergeThreshold,
+				   const LocEKF& one, const LocEKF& two) const;
 
+	int getActiveModels(int * which) const;
 
-private:						// Private variables
 
-	const static int MAX_MODELS = 30;
+private:						// Private variables
 
-	LocEKF* models[MAX_MODELS];
-	list<LocEKF*> modelList;
+	LocEKF models[MAX_MODELS];
+	const int maxActiveModels;
 
 	int mostLikelyModel;
 	int numActive, numFree;
 
 	inline const int getMostLikelyModel() const;
-	inline LocEKF * getInactiveModel() const;
+	inline LocEKF * getInactiveModel();
 	inline void deactivateModel(LocEKF * model);
 	inline void activateModel(LocEKF * model);
 
 	MotionModel lastOdo;
 	vector<Observation> lastObservations;
 
+	// Merge candidate grid, rebuilt for every merge pass: the first model
+	// in each cell and the next model in the same cell as each model
+	const static int MERGE_GRID_SIZE = 16;
+	int mergeCellHead[MERGE_GRID_SIZE * MERGE_GRID_SIZE];
+	int mergeCellNext[MAX_MODELS];
+	int mergeCell[MAX_MODELS];
+	int mergeCols, mergeRows;
+	float mergeCellSize;
+
 	const static double PROB_SUM = 1.0;
 	const static double MERGE_THRESH_INIT = 0.01f;
 	const static double MERGE_THRESH_STEP = 0.05f;
-	const static int MAX_ACTIVE_MODELS = 6;
 	const static double OUTLIER_PROB_LIMIT = 0.005;
 
 public:
@@ -87,7 +113,9 @@ public:
         return lastOdo;
     }
 
-	const list<LocEKF*>  getModels() const;
+	const list<const LocEKF*> getModels() const;
+	const int getNumActiveModels() const { return numActive; }
+	const int getMaxActiveModels() const { return maxActiveModels; }
 
 	virtual const vector<Observation> getLastObservations() const {
 		return lastObservations;
@@ -96,6 +124,7 @@ public:
     virtual void blueGoalieReset();
     virtual void redGoalieReset();
     virtual void reset();
+	virtual void resetLocTo(float x, float y, float h);
 
 	// LocSystem virtual setters
     virtual void setXEst(float xEst){}
@@ -30,7 +30,6 @@ using namespace std;
 using namespace boost;
 
 #ifdef LOG_LOCALIZATION
-fstream outputFile;
 #include <ctime>
 #endif
 
@@ -51,6 +50,9 @@ Noggin::Noggin (shared_ptr<Profiler> p, shared_ptr<Vision> v,
       error_state(false), brain_module(NULL), brain_instance(NULL),
       motion_interface(_minterface),registeredGCReset(false), ballFramesOff(0),
       do_reload(0)
+#ifdef LOG_LOCALIZATION
+      , loggingLoc(false)
+#endif
 {
 #   ifdef DEBUG_NOGGIN_INITIALIZATION
     printf("Noggin::initializing\n");
@@ -78,7 +80,7 @@ Noggin::~Noggin ()
 {
     Py_XDECREF(brain_instance);
     Py_XDECREF(brain_module);
-#   ifdef LOG_LOC
+#   ifdef LOG_LOCALIZATION
     stopLocLog();
 #   endif
 }
@@ -264,16 +266,30 @@ void Noggin::runStep ()
 
     PROF_ENTER(profiler, P_PYTHON);
 
+    // Copy out the newest finished frame from vision.  Everything below
+    // works on this copy, so vision is free to start on the next image (on
+    // another thread, if Man is pipelined).  If no new frame is ready we
+    // just run again on the last one.
+    vision->getFrameResult(visionFrame);
+
     // Update vision information for Python
     PROF_ENTER(profiler, P_PYUPDATE);
-    PyVision_update(pyvision);
+    PyVision_update(pyvision, visionFrame);
     PROF_EXIT(profiler, P_PYUPDATE);
 
 #   ifdef RUN_LOCALIZATION
     // Update localization information
     PROF_ENTER(profiler, P_LOC);
-    updateLocalization();
+    updateLocalization(visionFrame);
     PROF_EXIT(profiler, P_LOC);
+
+#   ifdef LOG_LOCALIZATION
+    // Logged out here so that it isn't counted as localization time
+    if (loggingLoc) {
+        locLogFrame.setEstimates(*loc, *ballEKF);
+        locLog->write(locLogFrame);
+    }
+#   endif
 #   endif //RUN_LOCALIZATION
 
 
@@ -301,7 +317,7 @@ void Noggin::runStep ()
     PROF_EXIT(profiler, P_PYTHON);
 }
 
-void Noggin::updateLocalization()
+void Noggin::updateLocalization(const VisionFrameResult& frame)
 {
     // Self Localization
     MotionModel odometery = motion_interface->getOdometryUpdate();
@@ -309,65 +325,65 @@ void Noggin::updateLocalization()
     // Build the observations from vision data
     vector<Observation> observations;
     // FieldObjects
-    VisualFieldObject fo;
-    fo = *vision->bgrp;
+    const FieldObjectResult *fo;
+    fo = &frame.bgrp;
 
-    if(fo.getDistance() > 0 && fo.getDistanceCertainty() != BOTH_UNSURE) {
-        Observation seen(fo);
+    if(fo->d.distance > 0 && fo->distCertainty != BOTH_UNSURE) {
+        Observation seen(*fo);
         observations.push_back(seen);
 #       ifdef DEBUG_POST_OBSERVATIONS
-        cout << "Saw bgrp at distance " << fo.getDistance()
+        cout << "Saw bgrp at distance " << fo->d.distance
              << " and bearing " << seen.getVisBearing() << endl;
 #       endif
     }
 
-    fo = *vision->bglp;
-    if(fo.getDistance() > 0 && fo.getDistanceCertainty() != BOTH_UNSURE) {
-        Observation seen(fo);
+    fo = &frame.bglp;
+    if(fo->d.distance > 0 && fo->distCertainty != BOTH_UNSURE) {
+        Observation seen(*fo);
         observations.push_back(seen);
 #       ifdef DEBUG_POST_OBSERVATIONS
-        cout << "Saw bglp at distance " << fo.getDistance()
+        cout << "Saw bglp at distance " << fo->d.distance
              << " and bearing " << seen.getVisBearing() << endl;
 #       endif
     }
 
-    fo = *vision->ygrp;
-    if(fo.getDistance() > 0 && fo.getDistanceCertainty() != BOTH_UNSURE) {
-        Observation seen(fo);
+    fo = &frame.ygrp;
+    if(fo->d.distance > 0 && fo->distCertainty != BOTH_UNSURE) {
+        Observation seen(*fo);
         observations.push_back(seen);
 #       ifdef DEBUG_POST_OBSERVATIONS
-        cout << "Saw ygrp at distance " << fo.getDistance()
+        cout << "Saw ygrp at distance " << fo->d.distance
              << " and bearing " << seen.getVisBearing() << endl;
 #       endif
     }
 
-    fo = *vision->yglp;
-    if(fo.getDistance() > 0 && fo.getDistanceCertainty() != BOTH_UNSURE) {
-        Observation seen(fo);
+    fo = &frame.yglp;
+    if(fo->d.distance > 0 && fo->distCertainty != BOTH_UNSURE) {
+        Observation seen(*fo);
         observations.push_back(seen);
 #       ifdef DEBUG_POST_OBSERVATIONS
-        cout << "Saw yglp at distance " << fo.getDistance()
+        cout << "Saw yglp at distance " << fo->d.distance
              << " and bearing " << seen.getVisBearing() << endl;
 #       endif
     }
 
     // Corners
 #   ifdef USE_LOC_CORNERS
-    const list<VisualCorner> * corners = vision->fieldLines->getCorners();
-    list <VisualCorner>::const_iterator i;
-    for ( i = corners->begin(); i != corners->end(); ++i) {
-        if (i->getDistance() < MAX_CORNER_DISTANCE) {
+    for (int c = 0; c < frame.numCorners; ++c) {
+        const CornerResult *i = &frame.corners[c];
+        if (i->d.distance < MAX_CORNER_DISTANCE) {
             Observation seen(*i);
             observations.push_back(seen);
 #           ifdef DEBUG_CORNER_OBSERVATIONS
             cout << "Saw corner "
-                 << ConcreteCorner::cornerIDToString(i->getID())
+                 << ConcreteCorner::cornerIDToString(
+                     static_cast<cornerID>(i->id))
                  << " at distance "
                  << seen.getVisDistance() << " and bearing "
                  << seen.getVisBearing() << endl;
 #           endif
 #           ifdef DEBUG_CC_DETECTION_SAVE_FRAMES
-            if (i->getShape() == CIRCLE) {
+            if (i->shape == CIRCLE) {
 	      cout<< "saw cc" <<endl;
                 sensors->saveFrame();
             }
@@ -377,28 +393,26 @@ void Noggin::updateLocalization()
 #   endif
 
     // Field Cross
-    if (vision->cross->getDistance() > 0 &&
-        vision->cross->getDistance() < MAX_CROSS_DISTANCE) {
-        Observation seen(*vision->cross);
+    if (frame.cross.d.distance > 0 &&
+        frame.cross.d.distance < MAX_CROSS_DISTANCE) {
+        Observation seen(frame.cross);
         observations.push_back(seen);
 #       ifdef DEBUG_CROSS_OBSERVATIONS
         cout << "Saw cross "
-             << vision->cross->getID()
-             << " at distance " << vision->cross->getDistance()
-             << " and bearing " << vision->cross->getBearing() << endl;
+             << frame.cross.id
+             << " at distance " << frame.cross.d.distance
+             << " and bearing " << frame.cross.d.bearing << endl;
         //sensors->saveFrame();
 #       endif
     }
 
     // Lines
-	// const vector< shared_ptr<VisualLine> > * lines = vision->fieldLines->getLines();
-    // vector <shared_ptr<VisualLine> >::const_iterator j;
-    // for ( j = lines->begin(); j != lines->end(); ++j) {
-	// 	if ( !(*j)->getCCLine() &&
-	// 		 (*j)->getPossibleLines().size() < ConcreteLine::NUM_LINES) {
-	// 		Observation seen(**j);
-	// 		observations.push_back(seen);
-	// 	}
+    // for (int j = 0; j < frame.numLines; ++j) {
+    //     if (!frame.lines[j].ccLine &&
+    //         frame.lines[j].numPossible < ConcreteLine::NUM_LINES) {
+    //         Observation seen(frame.lines[j]);
+    //         observations.push_back(seen);
+    //     }
     // }
 
     // Process the information
@@ -407,11 +421,11 @@ void Noggin::updateLocalization()
     PROF_EXIT(profiler, P_MCL);
 
     // Ball Tracking
-    if (vision->ball->getDistance() > 0.0) {
+    if (frame.ball.d.distance > 0.0) {
         ballFramesOff = 0;
 #   ifdef DEBUG_BALL_OBSERVATIONS
-        cout << "Ball seen at distance " << vision->ball->getDistance()
-             << " and bearing " << vision->ball->getBearing() << endl;
+        cout << "Ball seen at distance " << frame.ball.d.distance
+             << " and bearing " << frame.ball.d.bearing << endl;
         //sensors->saveFrame();
 #   endif
     } else {
@@ -421,7 +435,9 @@ void Noggin::updateLocalization()
     if( ballFramesOff < TEAMMATE_FRAMES_OFF_THRESH) {
         // If it's less than the threshold then we either see a ball or report
         // no ball seen
-        RangeBearingMeasurement k(vision->ball);
+        RangeBearingMeasurement k(frame.ball.d.distance, frame.ball.d.bearing,
+                                  frame.ball.d.distanceSD,
+                                  frame.ball.d.bearingSD);
         m = k;
     } else {
         // If it's off for more then the threshold, then try and use mate data
@@ -436,8 +452,8 @@ void Noggin::updateLocalization()
             m.bearing = subPIAngle(atan2(n.ballY - loc->getYEst(),
                                          n.ballX - loc->getXEst()) -
                                    loc->getHEst());
-            m.distanceSD = vision->ball->ballDistanceToSD(m.distance);
-            m.bearingSD =  vision->ball->ballBearingToSD(m.bearing);
+            m.distanceSD = VisualBall::ballDistanceToSD(m.distance);
+            m.bearingSD =  VisualBall::ballBearingToSD(m.bearing);
 #           ifdef DEBUG_TEAMMATE_BALL_OBSERVATIONS
             cout << setprecision(4)
                  << "Using teammate ball report of (" << m.distance << ", "
@@ -451,35 +467,12 @@ void Noggin::updateLocalization()
 
     ballEKF->updateModel(m, loc->getCurrentEstimate());
 #   ifdef LOG_LOCALIZATION
+    // Keep what went into this frame for runStep() to log.  The
+    // observations are done with, so they can be handed over as they are.
     if (loggingLoc) {
-        // Print out odometry and ball readings
-        outputFile << odometery.deltaF << " " << odometery.deltaL << " "
-                   << odometery.deltaR << " " << m.distance
-                   << " " << m.bearing;
-        // Print out observation information
-        for (unsigned int x = 0; x < observations.size(); ++x) {
-            // Separate observations with a colon
-            outputFile << ":";
-            outputFile << observations[x].getID() << " "
-                       << observations[x].getVisDistance() << " "
-                       << observations[x].getVisBearing() << " "
-                       << observations[x].getDistanceSD() << " "
-                       << observations[x].getBearingSD();
-            if( observations[x].isLine() ) {
-                vector<LineLandmark> ps;
-                ps = observations[x].getLinePossibilities();
-                for (unsigned int u = 0; u < ps.size(); ++u) {
-                    outputFile << " " << ps[u];
-                }
-            } else {
-                vector<PointLandmark> ps;
-                ps = observations[x].getPointPossibilities();
-                for (unsigned int u = 0; u < ps.size(); ++u) {
-                    outputFile << " " << ps[u];
-                }
-            }
-        }
-        outputFile << endl;
+        locLogFrame.odometry = odometery;
+        locLogFrame.ball = m;
+        locLogFrame.observations.swap(observations);
     }
 #   endif
 
@@ -606,23 +599,20 @@ void Noggin::startLocLog()
     string s  = "/home/nao/naoqi/log/" + string(buf) + ".loc";
 #endif
     cout << "Started localization log at " << s << endl;
-    outputFile.open(s.c_str(), ios::out);
-    outputFile << (int)gc->color() << " " << (int)gc->player() << endl;
-    outputFile << loc->getXEst() << " " << loc->getYEst() << " "
-               << loc->getHEst() << " "
-               << loc->getXUncert() << " " << loc->getYUncert() << " "
-               << loc->getHUncert() << " "
-               << ballEKF->getXEst() << " " << ballEKF->getYEst() << " "
-               << ballEKF->getXUncert() << " " << ballEKF->getYUncert() << " "
-               << ballEKF->getXVelocityEst() << " "
-               << ballEKF->getYVelocityEst() << " "
-               << ballEKF->getXVelocityUncert() << " "
-               << ballEKF->getYVelocityUncert() << endl;
+    locLog = shared_ptr<LocLogWriter>(new LocLogWriter(s.c_str(),
+                                                       (int)gc->color(),
+                                                       (int)gc->player()));
+    if (!locLog->isOpen()) {
+        cout << "Could not open the localization log" << endl;
+        locLog.reset();
+        loggingLoc = false;
+    }
 }
 
 void Noggin::stopLocLog()
 {
-    outputFile.close();
+    // Waits for the writer to finish with what it has queued
+    locLog.reset();
     loggingLoc = false;
 }
 #endif
@@ -16,6 +16,10 @@
 
 //#define LOG_LOCALIZATION
 
+#ifdef LOG_LOCALIZATION
+#include "LocLog.h"
+#endif
+
 /**
  *
  * @brief Class to control the main thread function of all reasoning and
@@ -54,8 +58,9 @@ private:
     void getBrainInstance();
     // Initialize the localization system
     void initializeLocalization();
-    // Run the localization update; performed at every run step
-    void updateLocalization();
+    // Run the localization update on the given frame's vision results;
+    // performed at every run step
+    void updateLocalization(const VisionFrameResult& frame);
     //Process button  clicks that pertain to GameController manipulation
     void processGCButtonClicks();
 
@@ -71,6 +76,8 @@ private:
     boost::shared_ptr<ClickableButton> rightFootButton;
 
     PyVision* pyvision;
+    // Our copy of the frame vision published last
+    VisionFrameResult visionFrame;
     bool error_state;
     PyObject *module_helper;
     PyObject *brain_module;
@@ -96,6 +103,9 @@ public:
 
 private:
     bool loggingLoc;
+    boost::shared_ptr<LocLogWriter> locLog;
+    // What went into the last localization update
+    LocLogFrame locLogFrame;
 #endif // LOG_LOCALIZATION
 };
 
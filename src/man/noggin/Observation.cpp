@@ -92,6 +92,63 @@ Observation::Observation(const VisualLine &_line) :
     }
 
 }
+/**
+ * @param _object Field object from a VisionFrameResult.
+ */
+Observation::Observation(const FieldObjectResult &_object) :
+    visDist(_object.d.distance), visBearing(_object.d.bearing),
+    sigma_d(_object.d.distanceSD), sigma_b(_object.d.bearingSD),
+    id(_object.id), line_truth(false), numPossibilities(0)
+{
+    for (int i = 0; i < _object.numPossible; ++i) {
+        addPointPossibility(PointLandmark(_object.possible[i]->getFieldX(),
+                                          _object.possible[i]->getFieldY()));
+    }
+}
+
+/**
+ * @param _cross Field cross from a VisionFrameResult.
+ */
+Observation::Observation(const CrossResult &_cross) :
+    visDist(_cross.d.distance), visBearing(_cross.d.bearing),
+    sigma_d(_cross.d.distanceSD), sigma_b(_cross.d.bearingSD),
+    id(_cross.id), line_truth(false), numPossibilities(0)
+{
+    for (int i = 0; i < _cross.numPossible; ++i) {
+        addPointPossibility(PointLandmark(_cross.possible[i]->getFieldX(),
+                                          _cross.possible[i]->getFieldY()));
+    }
+}
+
+/**
+ * @param _corner Corner from a VisionFrameResult.
+ */
+Observation::Observation(const CornerResult &_corner) :
+    visDist(_corner.d.distance), visBearing(_corner.d.bearing),
+    sigma_d(_corner.d.distanceSD), sigma_b(_corner.d.bearingSD),
+    id(_corner.id), line_truth(false), numPossibilities(0)
+{
+    for (int i = 0; i < _corner.numPossible; ++i) {
+        addPointPossibility(PointLandmark(_corner.possible[i]->getFieldX(),
+                                          _corner.possible[i]->getFieldY()));
+    }
+}
+
+/**
+ * @param _line Line from a VisionFrameResult.
+ */
+Observation::Observation(const LineResult &_line) :
+    visDist(_line.distance), visBearing(_line.bearing),
+    sigma_d(_line.distanceSD), sigma_b(_line.bearingSD),
+    id(_line.id), line_truth(true), numPossibilities(0)
+{
+    for (int i = 0; i < _line.numPossible; ++i) {
+        const ConcreteLine *l = _line.possible[i];
+        addLinePossibility(LineLandmark(l->getFieldX1(), l->getFieldY1(),
+                                        l->getFieldX2(), l->getFieldY2()));
+    }
+}
+
 Observation::Observation(int _ID, float _visDist,
                          float _visBearing, float _distSD,
                          float _bearingSD, bool _line_truth) :
@@ -16,6 +16,7 @@
 #include "VisualCorner.h"
 #include "VisualFieldObject.h"
 #include "VisualCross.h"
+#include "VisionFrameResult.h"
 #include "NBMath.h"
 #include "NogginStructs.h"
 
@@ -30,6 +31,11 @@ public:
     Observation(VisualCross &_cross);
     Observation(const VisualCorner &_corner);
     Observation(const VisualLine &_line);
+    // The same, from a published VisionFrameResult
+    Observation(const FieldObjectResult &_object);
+    Observation(const CrossResult &_cross);
+    Observation(const CornerResult &_corner);
+    Observation(const LineResult &_line);
     Observation(int _ID = -1, float _visDist = 0.0, float _visBearing = 0.0,
                 float _distSD = 0.0, float _bearingSD = 0.0,
                 bool _line_truth = false);
@@ -84,14 +90,14 @@ public:
     /*
      * @return The list of possible line landmarks
      */
-    const std::vector<LineLandmark> getLinePossibilities() const {
+    const std::vector<LineLandmark>& getLinePossibilities() const {
         return linePossibilities;
     }
 
     /*
      * @return The list of possible point landmarks
      */
-    const std::vector<PointLandmark> getPointPossibilities() const {
+    const std::vector<PointLandmark>& getPointPossibilities() const {
         return pointPossibilities;
     }
 
@@ -9,32 +9,14 @@
  * NAVIGATION LINES
  * deltaForward deltaLateral deltaRotation ball-vel-x ball-vel-y numFrames
  *
- * Format of the MCL log output file (*.mcl):
- *
- * PARTICLE INFO (see fakerIO.cpp method printOutMCLLogLine())
- * x y h weight (for M particles)
- *
- * Colon signifying end of section
- *
- * DEBUG INFO (see fakerIO.cpp method printOutLogLine())
- * team_color player_number
- * x-estimate y-estimate heading-estimate
- * x-uncertinty y-uncert heading-uncert
- * ball-x ball-y
- * ball-uncert-x ball-uncert-y
- * ball-vel-x ball-vel-y
- * ball-vel-uncert-x ball-vel-uncert-y
- * odometery-lateral odometery-forward odometery-rotational
- *
- * ROBOT REAL INFO
- * x y h ball-x ball-y ball-vel-x ball-vel-y (as given by the system)
- *
- * LANDMARK INFO
- * ID dist bearing (for all landmarks observed in the frame)
- *
- * The EKF log output file (*.ekf) is the same as the MCL file without the
- * particle info.
+ * The MCL (*.mcl.faker) and EKF (*.ekf.faker) output files are binary
+ * localization logs, as described in LocLog.h.  Every frame of both has the
+ * filter's estimates, the real robot and ball positions, and the landmarks
+ * observed; the MCL log has every particle too.
  */
+#include <cstdlib>
+#include <cstring>
+
 #include "fakerIO.h"
 #include "fakerIterators.h"
 #include "NBMath.h"
@@ -50,20 +32,39 @@ int main(int argc, char** argv)
     NavPath letsGo;
     // IO Variables
     fstream inputFile;
-    fstream mclFile;
-    fstream ekfFile;
     fstream ekfDiffFile;
 
-    /* Test for the correct number of CLI arguments */
-    if(argc != 2) {
-        cerr << "usage: " << argv[0] << " input-file" << endl;
+    // MCL threads, and the seed of both the faked observation noise and
+    // the MCL.  The same seed gives the same logs with any thread count.
+    int threads = 1;
+    unsigned int seed = 1;
+    const char *navFile = 0;
+
+    /* Test for the correct CLI arguments */
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], 0, 0);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (navFile == 0) {
+            navFile = argv[i];
+        } else {
+            navFile = 0;
+            break;
+        }
+    }
+    if(navFile == 0 || seed == 0 || threads < 1) {
+        cerr << "usage: " << argv[0]
+             << " [--seed n (not 0)] [--threads n] input-file" << endl;
         return 1;
     }
+    srand(seed);
+
     try {
-        inputFile.open(argv[1], ios::in);
+        inputFile.open(navFile, ios::in);
 
     } catch (ifstream::failure e) {
-        cout << "Failed to open input file" << argv[1] << endl;
+        cout << "Failed to open input file" << navFile << endl;
         return 1;
     }
 
@@ -75,26 +76,26 @@ int main(int argc, char** argv)
     inputFile.close();
 
     // Open output files
-    string mclFileName(argv[1]);
-    string ekfFileName(argv[1]);
-    string ekfDiffFileName(argv[1]);
+    string mclFileName(navFile);
+    string ekfFileName(navFile);
+    string ekfDiffFileName(navFile);
 
     mclFileName.replace(mclFileName.end()-3, mclFileName.end(), "mcl.faker");
     ekfFileName.replace(ekfFileName.end()-3, ekfFileName.end(), "ekf.faker");
     ekfDiffFileName.replace(ekfDiffFileName.end()-3, ekfDiffFileName.end(), "ekf.diff.faker");
 
-    mclFile.open(mclFileName.c_str(), ios::out);
-    ekfFile.open(ekfFileName.c_str(), ios::out);
+    LocLogWriter mclLog(mclFileName.c_str(), TEAM_COLOR, PLAYER_NUMBER);
+    LocLogWriter ekfLog(ekfFileName.c_str(), TEAM_COLOR, PLAYER_NUMBER);
     ekfDiffFile.open(ekfDiffFileName.c_str(), ios::out);
 	printOutPoseDiffHeader(&ekfDiffFile);
 
     // Iterate through the path
     cout << "Running loc systems" << endl;
-    iterateFakerPath(&mclFile, &ekfFile, &ekfDiffFile, &letsGo);
+    iterateFakerPath(&mclLog, &ekfLog, &ekfDiffFile, &letsGo, 0.05f,
+                     threads, seed);
 
-    // Close the output files
-    mclFile.close();
-    ekfFile.close();
+    // The logs are closed as they go out of scope
+    ekfDiffFile.close();
 
     return 0;
 }
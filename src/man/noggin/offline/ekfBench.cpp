@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <sys/time.h>
+
+#include "LocEKF.h"
+#include "BallEKF.h"
+#include "AccEKF.h"
+#include "AngleEKF.h"
+#include "ZmpEKF.h"
+
+/**
+ * Times the time and correction updates of every EKF in the tree on
+ * made up but plausible inputs, and prints the updates per second each one
+ * sustains along with its final estimate.  The inputs come from a fixed
+ * generator, so the final estimates can be compared across builds to check
+ * a change to the EKF core left the filters' behavior alone.
+ *
+ * LocEKF is also run with ten landmarks in every frame, once fusing each
+ * frame's observations and once applying them one after another, each in
+ * vision's order and reversed, to time the two and show which of them the
+ * order changes.
+ *
+ * Usage: ekfBench [updates]
+ */
+
+static long micros()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+// Same sequence on every platform, unlike rand()
+static unsigned int lcgState = 1;
+static float noise(float scale)
+{
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return scale * (static_cast<float>(lcgState >> 8) / 8388608.0f - 1.0f);
+}
+
+static void report(const char *name, int updates, long took)
+{
+    printf("%-9s %9.0f updates/s  %7.3f us/update\n", name,
+           updates * 1000000.0 / took, took / (double)updates);
+}
+
+static Observation sightPost(const PoseEst& pose, int id, float x, float y)
+{
+    Observation z(id, hypotf(x - pose.x, y - pose.y) + noise(5.0f),
+                  NBMath::subPIAngle(atan2f(y - pose.y, x - pose.x) - pose.h) +
+                  noise(0.05f), 20.0f, 0.1f, false);
+    z.addPointPossibility(PointLandmark(x, y));
+    return z;
+}
+
+static void benchLoc(int updates)
+{
+    LocEKF ekf;
+    PoseEst truth(CENTER_FIELD_X, CENTER_FIELD_Y - 100.0f, 0.0f);
+    const MotionModel step(1.0f, 0.0f, 1.0f * TO_RAD);
+    std::vector<Observation> z;
+
+    long took = 0;
+    for (int i = 0; i < updates; ++i) {
+        truth += step;
+        truth.h = NBMath::subPIAngle(truth.h);
+        z.clear();
+        z.push_back(sightPost(truth, 0, LANDMARK_YELLOW_GOAL_TOP_POST_X,
+                              LANDMARK_YELLOW_GOAL_TOP_POST_Y));
+        if (i % 2) {
+            z.push_back(sightPost(truth, 1, LANDMARK_BLUE_GOAL_BOTTOM_POST_X,
+                                  LANDMARK_BLUE_GOAL_BOTTOM_POST_Y));
+        }
+
+        const long start = micros();
+        ekf.updateLocalization(step, z);
+        took += micros() - start;
+    }
+    report("LocEKF", updates, took);
+    printf("          est (%.7g, %.7g, %.7g) uncert (%.7g, %.7g, %.7g)\n",
+           ekf.getXEst(), ekf.getYEst(), ekf.getHEst(),
+           ekf.getXUncert(), ekf.getYUncert(), ekf.getHUncert());
+}
+
+// Posts, crosses and the field's corners
+static const float crowdX[] = {
+    LANDMARK_BLUE_GOAL_BOTTOM_POST_X, LANDMARK_BLUE_GOAL_TOP_POST_X,
+    LANDMARK_YELLOW_GOAL_BOTTOM_POST_X, LANDMARK_YELLOW_GOAL_TOP_POST_X,
+    LANDMARK_BLUE_GOAL_CROSS_X, LANDMARK_YELLOW_GOAL_CROSS_X,
+    FIELD_WHITE_LEFT_SIDELINE_X, FIELD_WHITE_LEFT_SIDELINE_X,
+    FIELD_WHITE_RIGHT_SIDELINE_X, FIELD_WHITE_RIGHT_SIDELINE_X };
+static const float crowdY[] = {
+    LANDMARK_BLUE_GOAL_BOTTOM_POST_Y, LANDMARK_BLUE_GOAL_TOP_POST_Y,
+    LANDMARK_YELLOW_GOAL_BOTTOM_POST_Y, LANDMARK_YELLOW_GOAL_TOP_POST_Y,
+    LANDMARK_BLUE_GOAL_CROSS_Y, LANDMARK_YELLOW_GOAL_CROSS_Y,
+    FIELD_WHITE_BOTTOM_SIDELINE_Y, FIELD_WHITE_TOP_SIDELINE_Y,
+    FIELD_WHITE_BOTTOM_SIDELINE_Y, FIELD_WHITE_TOP_SIDELINE_Y };
+static const int CROWD_SIZE = sizeof(crowdX) / sizeof(crowdX[0]);
+
+static void benchLocCrowd(int updates, bool fused, bool reversed)
+{
+    LocEKF ekf;
+    ekf.setFusedUpdate(fused);
+    PoseEst truth(CENTER_FIELD_X, CENTER_FIELD_Y - 100.0f, 0.0f);
+    const MotionModel step(1.0f, 0.0f, 1.0f * TO_RAD);
+    std::vector<Observation> z;
+
+    // Both orders see the same noise
+    lcgState = 1;
+    long took = 0;
+    for (int i = 0; i < updates; ++i) {
+        truth += step;
+        truth.h = NBMath::subPIAngle(truth.h);
+        z.clear();
+        for (int j = 0; j < CROWD_SIZE; ++j) {
+            z.push_back(sightPost(truth, j, crowdX[j], crowdY[j]));
+        }
+        if (reversed) {
+            std::reverse(z.begin(), z.end());
+        }
+
+        const long start = micros();
+        ekf.updateLocalization(step, z);
+        took += micros() - start;
+    }
+    report(fused ? "fused" : "serial", updates, took);
+    printf("          %s est (%.7g, %.7g, %.7g) uncert (%.7g, %.7g, %.7g)\n",
+           reversed ? "reversed" : "in order",
+           ekf.getXEst(), ekf.getYEst(), ekf.getHEst(),
+           ekf.getXUncert(), ekf.getYUncert(), ekf.getHUncert());
+}
+
+static void benchBall(int updates)
+{
+    BallEKF ekf;
+    const PoseEst robot(CENTER_FIELD_X, CENTER_FIELD_Y, 0.0f);
+
+    long took = 0;
+    for (int i = 0; i < updates; ++i) {
+        // Seen three frames in four, rolling slowly away
+        const float dist = (i % 4) ? 100.0f + 0.1f * (i % 1000) + noise(5.0f)
+            : 0.0f;
+        const RangeBearingMeasurement ball(dist, 0.2f + noise(0.05f),
+                                           10.0f, 0.1f);
+        const long start = micros();
+        ekf.updateModel(ball, robot);
+        took += micros() - start;
+    }
+    report("BallEKF", updates, took);
+    printf("          est (%.7g, %.7g, %.7g, %.7g) uncert (%.7g, %.7g)\n",
+           ekf.getXEst(), ekf.getYEst(), ekf.getXVelocityEst(),
+           ekf.getYVelocityEst(), ekf.getXUncert(), ekf.getYUncert());
+}
+
+static void benchAcc(int updates)
+{
+    AccEKF ekf;
+    long took = 0;
+    for (int i = 0; i < updates; ++i) {
+        const float x = noise(1.0f), y = noise(1.0f), z = 9.8f + noise(1.0f);
+        const long start = micros();
+        ekf.update(x, y, z);
+        took += micros() - start;
+    }
+    report("AccEKF", updates, took);
+    printf("          est (%.7g, %.7g, %.7g) uncert (%.7g, %.7g, %.7g)\n",
+           ekf.getX(), ekf.getY(), ekf.getZ(),
+           ekf.getXUnc(), ekf.getYUnc(), ekf.getZUnc());
+}
+
+static void benchAngle(int updates)
+{
+    AngleEKF ekf;
+    long took = 0;
+    for (int i = 0; i < updates; ++i) {
+        const float x = 0.1f + noise(0.05f), y = -0.05f + noise(0.05f);
+        const long start = micros();
+        ekf.update(x, y);
+        took += micros() - start;
+    }
+    report("AngleEKF", updates, took);
+    printf("          est (%.7g, %.7g) uncert (%.7g, %.7g)\n",
+           ekf.getAngleX(), ekf.getAngleY(),
+           ekf.getAngleXUnc(), ekf.getAngleYUnc());
+}
+
+static void benchZmp(int updates)
+{
+    ZmpEKF ekf;
+    long took = 0;
+    for (int i = 0; i < updates; ++i) {
+        const float phase = 0.01f * (i % 628);
+        const ZmpTimeUpdate u = { 10.0f * sinf(phase), 50.0f * cosf(phase) };
+        const ZmpMeasurement m = { u.cur_zmp_x + noise(2.0f),
+                                   u.cur_zmp_y + noise(2.0f),
+                                   noise(0.5f), noise(0.5f) };
+        const long start = micros();
+        ekf.update(u, m);
+        took += micros() - start;
+    }
+    report("ZmpEKF", updates, took);
+    printf("          est (%.7g, %.7g) uncert (%.7g, %.7g)\n",
+           ekf.get_zmp_x(), ekf.get_zmp_y(),
+           ekf.get_zmp_unc_x(), ekf.get_zmp_unc_y());
+}
+
+int main(int argc, char** argv)
+{
+    const int updates = argc > 1 ? atoi(argv[1]) : 100000;
+    benchLoc(updates);
+    benchBall(updates);
+    benchAcc(updates);
+    benchAngle(updates);
+    benchZmp(updates);
+    benchLocCrowd(updates, true, false);
+    benchLocCrowd(updates, true, true);
+    benchLocCrowd(updates, false, false);
+    benchLocCrowd(updates, false, true);
+    return 0;
+}
@@ -40,6 +40,9 @@ void readNavInputFile(fstream* inputFile, NavPath * letsGo)
         *inputFile >> motion.deltaF >> motion.deltaL >> motion.deltaR
                    >> ballMove.velX >> ballMove.velY
                    >> time;
+        // A trailing newline leaves nothing to read on the last pass
+        if (inputFile->fail())
+            break;
 
         motion.deltaR *= TO_RAD;
         letsGo->myMoves.push_back(NavMove(motion, ballMove, time));
@@ -286,130 +289,63 @@ void printOutObsLine(fstream* outputFile, vector<Observation> sightings,
 }
 
 /**
- * Prints the input to a log file to be read by the TOOL
+ * Writes a frame, with every particle, to a log to be read by the TOOL
  *
- * @param outputFile File to write the log line to
+ * @param log Log to write the frame to
  * @param myLoc Current localization module
  * @param sightings Vector of landmark observations
  * @param lastOdo Odometery since previous frame
  */
-void printOutMCLLogLine(fstream* outputFile, shared_ptr<MCL> myLoc,
+void printOutMCLLogLine(LocLogWriter* log, shared_ptr<MCL> myLoc,
                         const vector<Observation>& sightings,
 						const MotionModel& lastOdo,
                         const PoseEst& currentPose, const BallPose& currentBall,
-                        shared_ptr<BallEKF> ballEKF, const VisualBall& _b,
-                        int team_color, int player_number, int ball_id)
+                        shared_ptr<BallEKF> ballEKF, const VisualBall& _b)
 {
-    // Output particle infos
-    vector<Particle> particles = myLoc->getParticles();
+    LocLogFrame frame;
+    const vector<Particle> particles = myLoc->getParticles();
+    frame.particles.resize(particles.size());
     for(unsigned int j = 0; j < particles.size(); ++j) {
-        Particle p = particles[j];
-        *outputFile << p << " ";
+        frame.particles[j].x = particles[j].pose.x;
+        frame.particles[j].y = particles[j].pose.y;
+        frame.particles[j].h = particles[j].pose.h;
+        frame.particles[j].weight = particles[j].weight;
     }
-    // Divide the sections with a colon
-    *outputFile << ":";
 
-    printOutLogLine(outputFile, myLoc, sightings, lastOdo,
-                    currentPose, currentBall,
-                    ballEKF, _b,
-                    team_color, player_number, ball_id);
+    printOutLogLine(log, myLoc, sightings, lastOdo,
+                    currentPose, currentBall, ballEKF, _b, frame);
 }
 
 /**
- * Prints the input to a log file to be read by the TOOL
+ * Writes a frame to a log to be read by the TOOL
  *
- * @param outputFile File to write the log line to
+ * @param log Log to write the frame to
  * @param myLoc Current localization module
  * @param sightings Vector of landmark observations
  * @param lastOdo Odometery since previous frame
+ * @param frame Anything else to log with the frame, such as particles
  */
-void printOutLogLine(fstream* outputFile, shared_ptr<LocSystem> myLoc,
+void printOutLogLine(LocLogWriter* log, shared_ptr<LocSystem> myLoc,
                      const vector<Observation>& sightings,
 					 const MotionModel& lastOdo,
                      const PoseEst &currentPose, const BallPose& currentBall,
                      shared_ptr<BallEKF> ballEKF, const VisualBall& _b,
-                     int team_color, int player_number, int ball_id)
+                     LocLogFrame frame)
 {
-    // Output standard infos
-    *outputFile << setprecision(6) << team_color<< " " << player_number << "|"
-                << myLoc->getXEst() << " " << myLoc->getYEst() << " "
-                << myLoc->getHEst() << " "
-                << myLoc->getXUncert() << " " << myLoc->getYUncert() << " "
-                << myLoc->getHUncert() << " ";
-
-#ifdef USE_MM_LOC_EKF
-	shared_ptr<MMLocEKF> mmloc = boost::dynamic_pointer_cast<MMLocEKF>(myLoc);
-	const list<LocEKF*> models = mmloc->getModels();
-	list<LocEKF*>::const_iterator model;
-
-	*outputFile << ";";
-
-	for(model = models.begin(); model != models.end() ; ++model){
-		if (!(*model)->isActive())
-			continue;
-		*outputFile << (*model)->getXEst() << " " <<
-			(*model)->getYEst() << " " <<
-			(*model)->getHEst() << " " <<
-			(*model)->getXUncert() << " " <<
-			(*model)->getYUncert() << " " <<
-			(*model)->getHUncert()
-					<< ";";	// Split models with ;
-	}
-	// Split models section from ball and obs section
-#endif
-	*outputFile << "|";
-
-    // X Estimate
-	 *outputFile << (ballEKF->getXEst()) << " "
-		// Y Estimate
-                << (ballEKF->getYEst()) << " "
-		// X Uncert
-                << (ballEKF->getXUncert()) << " "
-		// Y Uncert
-                << (ballEKF->getYUncert()) << " "
-		// X Velocity Estimate
-                << ballEKF->getXVelocityEst() << " "
-		// Y Velocity Estimate
-                << ballEKF->getYVelocityEst() << " "
-		// X Velocity Uncert
-                << ballEKF->getXVelocityUncert() << " "
-		// Y Velocity Uncert
-                << ballEKF->getYVelocityUncert() << " "
-		// Odometery
-                << lastOdo.deltaF << " " << lastOdo.deltaL << " "
-                << lastOdo.deltaR;
-
-    // Divide the sections with a colon
-    *outputFile << ":";
-
-    // Print the actual robot position
-    *outputFile << currentPose.x << " "
-                << currentPose.y << " "
-                << currentPose.h << " "
-		// print actual ball position
-                << currentBall.x << " "
-                << currentBall.y << " "
-                << currentBall.velX << " "
-                << currentBall.velY << " ";
-
-    // Divide the sections with a colon
-    *outputFile << ":";
-
-    // Output landmark infos
-    for(unsigned int k = 0; k < sightings.size(); ++k) {
-        *outputFile << setprecision(12) << sightings[k].getID() << " "
-                    << sightings[k].getVisDistance() << " "
-                    << sightings[k].getVisBearing() << " ";
-    }
-    // Output ball as landmark
-    if (_b.getDistance() > 0.0) {
-        *outputFile << setprecision(12) << ball_id << " "
-                    << _b.getDistance() << " "
-                    << _b.getBearing() << " ";
-    }
-
-    // Close the line
-    *outputFile << endl;
+    frame.odometry = lastOdo;
+    frame.ball = RangeBearingMeasurement(_b.getDistance(), _b.getBearing(),
+                                         _b.getDistanceSD(),
+                                         _b.getBearingSD());
+    frame.observations = sightings;
+    // For an MMLocEKF this also logs every active model
+    frame.setEstimates(*myLoc, *ballEKF);
+
+    // The actual robot and ball positions, when they are known
+    frame.hasTruth = currentPose.x != NO_DATA_VALUE;
+    frame.truePose = currentPose;
+    frame.trueBall = currentBall;
+
+    log->write(frame);
 }
 
 void printOutPoseDiffHeader(std::fstream* outputFile)
@@ -491,13 +427,12 @@ void printCoreLogLine(fstream* outputFile, shared_ptr<LocSystem> myLoc,
 /**
  * Take a robot log and convert it to something we can use in the EKF log
  *
- * @param inputFile The robot log
- * @param outputFile The log to be read in by TOOL
+ * @param robotLog The robot log
+ * @param toolLog The log to be read in by TOOL
  */
-void readRobotLogFile(fstream* inputFile, fstream* outputFile)
+void readRobotLogFile(LocLogReader* robotLog, LocLogWriter* toolLog)
 {
-    vector<Observation> sightings;
-    MotionModel lastOdo(0.0f, 0.0f, 0.0f);
+    LocLogFrame robotFrame;
     // Known robot and ball data, set to unknown
     PoseEst currentPose(NO_DATA_VALUE, NO_DATA_VALUE, NO_DATA_VALUE);
     BallPose currentBall(NO_DATA_VALUE, NO_DATA_VALUE,
@@ -505,95 +440,45 @@ void readRobotLogFile(fstream* inputFile, fstream* outputFile)
 
     VisualBall * _b = new VisualBall();
 
-    int teamColor, playerNumber;
-    float initX, initY, initH,
-        initUncertX, initUncertY, initUncertH,
-        initBallX, initBallY,
-        initBallXUncert, initBallYUncert,
-        initBallVelX, initBallVelY,
-        initBallVelXUncert, initBallVelYUncert;
-
-    if(!inputFile->eof()) {
-        stringstream headerLine(stringstream::in | stringstream::out);
-        char line[1024];
-        // Read in the header line
-        inputFile->getline(line, 1024);
-        headerLine << line;
-        headerLine >> teamColor >> playerNumber;
-
-        stringstream startLine(stringstream::in | stringstream::out);
-        // Read the EKF start configuration
-        inputFile->getline(line, 1024);
-        startLine << line;
-        startLine >> initX >> initY >> initH
-                  >> initUncertX >> initUncertY >> initUncertH
-                  >> initBallX >> initBallY
-                  >> initBallXUncert >> initBallYUncert
-                  >> initBallVelX >> initBallVelY
-                  >> initBallVelXUncert >> initBallVelYUncert;
+    if (!robotLog->readFrame(robotFrame)) {
+        delete _b;
+        return;
     }
-    // Initialize localization systems
+
+    // Initialize localization systems, the ball where the robot had it
+    // after its first frame
+    const LocLogBall& initBall = robotFrame.ballEstimate;
     shared_ptr<LocSystem> locEKF  = shared_ptr<MMLocEKF>(
         new MMLocEKF());
     shared_ptr<BallEKF> ballEKF =  shared_ptr<BallEKF>(
-        new BallEKF(initBallX, initBallY, initBallVelX, initBallVelY,
-                    initBallXUncert, initBallYUncert,
-                    initBallVelXUncert, initBallVelYUncert));
-
-    printOutLogLine(outputFile,locEKF, sightings, lastOdo,
-                    currentPose, currentBall, ballEKF, *_b,
-                    teamColor, playerNumber, BALL_ID);
+        new BallEKF(initBall.x, initBall.y, initBall.velX, initBall.velY,
+                    initBall.xUncert, initBall.yUncert,
+                    initBall.velXUncert, initBall.velYUncert));
 
-    float ballDist, ballBearing;
     // Collect the frame by frame data
-
-    while(!inputFile->eof()) {
-        stringstream inputLine(stringstream::in | stringstream::out);
-        char line[1024];
-        inputFile->getline(line, 1024);
-        inputLine << line;
-        // Read in the base data
-        inputLine >> lastOdo.deltaF >> lastOdo.deltaL >> lastOdo.deltaR
-                  >> ballDist >> ballBearing;
+    do {
+        const RangeBearingMeasurement& m = robotFrame.ball;
 
         // Update Ball
-        if (ballDist > 0) {
-            _b->setDistanceWithSD(ballDist);
-            _b->setBearingWithSD(ballBearing);
+        if (m.distance > 0) {
+            _b->setDistanceWithSD(m.distance);
+            _b->setBearingWithSD(m.bearing);
         } else {
             _b->setDistanceWithSD(0.0f);
             _b->setBearingWithSD(0.0f);
         }
-        RangeBearingMeasurement m(_b);
-
-        // Read in observations
-        sightings.clear();
-
-        // Observations are separated by colons
-        while(inputLine.peek() == ':') {
-            int id;
-            char c;
-            float dist, bearing, distSD, bearingSD;
-            inputLine >> c >> id >> dist >> bearing >> distSD >> bearingSD;
-
-            Observation obs(id, dist, bearing, distSD, bearingSD,
-                             Observation::isLineID(id));
-            while(inputLine.peek() != ':' &&
-                  inputLine.peek() != EOF) {
-                PointLandmark p;
-                inputLine >> p.x >> p.y;
-                obs.addPointPossibility(p);
-            }
-            sightings.push_back(obs);
-        }
 
         // Update localization
-        locEKF->updateLocalization(lastOdo, sightings);
-        ballEKF->updateModel(m, locEKF->getCurrentEstimate());
-
-        // Write out the next observation line
-        printOutLogLine(outputFile, locEKF, sightings, lastOdo,
-                        currentPose, currentBall, ballEKF, *_b,
-                        teamColor, playerNumber, BALL_ID);
-    }
+        locEKF->updateLocalization(robotFrame.odometry,
+                                   robotFrame.observations);
+        ballEKF->updateModel(RangeBearingMeasurement(_b),
+                             locEKF->getCurrentEstimate());
+
+        // Write out the next frame
+        printOutLogLine(toolLog, locEKF, robotFrame.observations,
+                        robotFrame.odometry, currentPose, currentBall,
+                        ballEKF, *_b);
+    } while (robotLog->readFrame(robotFrame));
+
+    delete _b;
 }
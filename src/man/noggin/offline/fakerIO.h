@@ -11,29 +11,8 @@
  * NAVIGATION LINES
  * deltaForward deltaLateral deltaRotation
  *
- * Format of the log output file (*.mcl):
- *
- * PARTICLE INFO
- * x y h weight (for M particles)
- *
- * Colon signifying end of section
- *
- * DEBUG INFO
- * team_color player_number
- * x-estimate y-estimate heading-estimate deg
- * x-uncertinty y-uncert heading-uncert
- * ball-x ball-y
- * ball-uncert-x ball-uncert-y
- * ball-vel-x ball-vel-y
- * ball-vel-uncert-x ball-vel-uncert-y
- * odometery-lateral odometery-forward odometery-rotational
- *
- * ROBOT REAL INFO
- * x y h (as given by the system)
- *
- * LANDMARK INFO
- * ID dist bearing (for all landmarks observed in the frame)
- *
+ * The log output files (*.mcl, *.ekf) are binary localization logs, as
+ * described in LocLog.h.
  */
 
 #ifndef fakerIO_h_DEFINED
@@ -49,6 +28,7 @@
 #include "BallEKF.h"
 #include "LocEKF.h"
 #include "MMLocEKF.h"
+#include "LocLog.h"
 
 #define USE_MM_LOC_EKF
 //#undef USE_MM_LOC_EKF
@@ -70,15 +50,14 @@ void printOutObsLine(std::fstream* outputFile,
                      std::vector<Observation> sightings, MotionModel lastOdo,
                      PoseEst *currentPose, BallPose * currentBall,
                      VisualBall _b, int ball_id);
-void printOutMCLLogLine(std::fstream* outputFile, boost::shared_ptr<MCL> myLoc,
+void printOutMCLLogLine(LocLogWriter* log, boost::shared_ptr<MCL> myLoc,
                         const std::vector<Observation>& sightings,
 						const MotionModel& lastOdo,
                         const PoseEst& currentPose,
 						const BallPose& currentBall,
                         boost::shared_ptr<BallEKF> ballEKF,
-						const VisualBall& _b,
-                        int team_color, int player_number, int ball_id);
-void printOutLogLine(std::fstream* outputFile,
+						const VisualBall& _b);
+void printOutLogLine(LocLogWriter* log,
                      boost::shared_ptr<LocSystem> myLoc,
                      const std::vector<Observation>& sightings,
 					 const MotionModel& lastOdo,
@@ -86,7 +65,7 @@ void printOutLogLine(std::fstream* outputFile,
 					 const  BallPose& currentBall,
                      boost::shared_ptr<BallEKF> ballEKF,
 					 const VisualBall& _b,
-                     int team_color, int player_number, int ball_id);
+                     LocLogFrame frame = LocLogFrame());
 
 void printOutPoseDiffHeader(std::fstream* outputFile);
 
@@ -100,6 +79,6 @@ void printCoreLogLine(std::fstream* outputFile,
                       PoseEst *currentPose, BallPose * currentBall,
                       boost::shared_ptr<BallEKF> ballEKF);
 
-void readRobotLogFile(std::fstream* inputFile, std::fstream* outputFile);
+void readRobotLogFile(LocLogReader* robotLog, LocLogWriter* toolLog);
 
 #endif // fakerIO_h_DEFINED
@@ -57,17 +57,22 @@ void iterateNavPath(fstream * obsFile, NavPath * letsGo)
 /**
  * Method to iterate through a robot path and write the localization info.
  *
- * @param outputFile The file to have everything printed to
+ * @param mclLog The log to write the MCL frames to
+ * @param ekfLog The log to write the EKF frames to
+ * @param ekfDiffFile The file to print the EKF's errors to
  * @param letsGo The robot path from which to localize
+ * @param mclThreads Threads to run the MCL particle updates on
+ * @param mclSeed Seed of the MCL random numbers, 0 for one from the clock
  */
-void iterateFakerPath(fstream * mclFile, fstream * ekfFile,
+void iterateFakerPath(LocLogWriter * mclLog, LocLogWriter * ekfLog,
 					  fstream * ekfDiffFile, NavPath * letsGo,
-                      float noiseLevel)
+                      float noiseLevel, int mclThreads, uint32_t mclSeed)
 {
     // Method variables
     vector<Observation> Z_t;
-    // shared_ptr<MCL> mclLoc = shared_ptr<MCL>(new MCL(100));
-    // shared_ptr<BallEKF> MCLballEKF = shared_ptr<BallEKF>(new BallEKF());
+    shared_ptr<MCL> mclLoc = shared_ptr<MCL>(new MCL(100, mclThreads,
+                                                     mclSeed));
+    shared_ptr<BallEKF> MCLballEKF = shared_ptr<BallEKF>(new BallEKF());
 #ifdef USE_MM_LOC_EKF
     shared_ptr<LocSystem> ekfLoc = shared_ptr<LocSystem>(new MMLocEKF());
 #else
@@ -85,11 +90,12 @@ void iterateFakerPath(fstream * mclFile, fstream * ekfFile,
     currentBall = letsGo->ballStart;
 
     // Print out starting configuration
-    // printOutMCLLogLine(mclFile, mclLoc, Z_t, noMove, &currentPose,
-    //                  &currentBall, MCLballEKF);
-    printOutLogLine(ekfFile, ekfLoc, Z_t, noMove, currentPose,
+    printOutMCLLogLine(mclLog, mclLoc, Z_t, noMove, currentPose,
+                       currentBall, MCLballEKF,
+                       *visBall);
+    printOutLogLine(ekfLog, ekfLoc, Z_t, noMove, currentPose,
                     currentBall, EKFballEKF,
-                    *visBall, TEAM_COLOR, PLAYER_NUMBER, BALL_ID);
+                    *visBall);
 	printOutPoseDiffs(ekfDiffFile, ekfLoc, currentPose);
 
     unsigned frameCounter = 0;
@@ -112,14 +118,13 @@ void iterateFakerPath(fstream * mclFile, fstream * ekfFile,
             RangeBearingMeasurement m(visBall);
 
             // Update the MCL sytem
-            // mclLoc->updateLocalization(letsGo->myMoves[i].move, Z_t);
-            // // Update the MCL ball
-
-            // if (usePerfectLocForBall) {
-            //     MCLballEKF->updateModel(m, currentPose;
-            // } else {
-            //     MCLballEKF->updateModel(m, mclLoc->getCurrentEstimate());
-            // }
+            mclLoc->updateLocalization(letsGo->myMoves[i].move, Z_t);
+            // Update the MCL ball
+            if (usePerfectLocForBall) {
+                MCLballEKF->updateModel(m, currentPose);
+            } else {
+                MCLballEKF->updateModel(m, mclLoc->getCurrentEstimate());
+            }
 
             // Update the EKF sytem
             ekfLoc->updateLocalization(letsGo->myMoves[i].move, Z_t);
@@ -131,12 +136,13 @@ void iterateFakerPath(fstream * mclFile, fstream * ekfFile,
             }
 
             // Print the current MCL frame to file
-            // printCoreLogLine(mclFile, mclLoc, Z_t, letsGo->myMoves[i].move,
-            //                  &currentPose, &currentBall, MCLballEKF);
+            printOutMCLLogLine(mclLog, mclLoc, Z_t, letsGo->myMoves[i].move,
+                               currentPose, currentBall, MCLballEKF,
+                               *visBall);
             // Print the current EKF frame to file
-            printOutLogLine(ekfFile, ekfLoc, Z_t, letsGo->myMoves[i].move,
+            printOutLogLine(ekfLog, ekfLoc, Z_t, letsGo->myMoves[i].move,
                             currentPose, currentBall, EKFballEKF,
-                            *visBall, TEAM_COLOR, PLAYER_NUMBER, BALL_ID);
+                            *visBall);
 			printOutPoseDiffs(ekfDiffFile, ekfLoc, currentPose);
         }
     }
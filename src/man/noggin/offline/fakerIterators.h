@@ -53,9 +53,10 @@ void iterateMCLObsPath(std::fstream * locFile, std::fstream * coreFile,
                        std::vector<float> * ballBearings,
                        int ball_id);
 
-void iterateFakerPath(std::fstream * mclFile, std::fstream * ekfFile,
+void iterateFakerPath(LocLogWriter * mclLog, LocLogWriter * ekfLog,
 					  std::fstream * ekfDiffFile,
-                      NavPath * letsGo, float noiseLevel = 0.05);
+                      NavPath * letsGo, float noiseLevel = 0.05,
+                      int mclThreads = 1, uint32_t mclSeed = 0);
 void checkObjects(std::vector<Observation> &Z_t, PoseEst myPos,
 				  float noiseLevel);
 void checkCorners(std::vector<Observation> &Z_t, PoseEst myPos,
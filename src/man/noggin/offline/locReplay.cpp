@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fakerIterators.h"
+#include "MCL.h"
+#include "LocEKF.h"
+#include "MMLocEKF.h"
+
+/**
+ * Replays one localization log through MCL, LocEKF and MMLocEKF with a sweep
+ * of parameters and prints the accuracy and update latency of each run as
+ * CSV, one line per run.
+ *
+ * The log is read once.  A .nav path is run through the faker's observation
+ * model up front at every noise level and repeat, each with its own seed for
+ * rand(), so every filter sees the same frames; an .obs log is replayed as
+ * recorded.  The runs then share the frames read-only and are spread over
+ * worker threads, one filter per run, with MCL on a single thread of its own
+ * and a fixed seed, so the accuracy columns are the same from run to run
+ * whatever the number of workers.
+ *
+ * Latency is the time updateLocalization() takes per frame, as percentiles
+ * over all of a run's frames.  With more workers than cores the runs fight
+ * over them and the latencies mean little; use -j 1 for those.
+ *
+ * Usage: locReplay [-j workers] [-r repeats] [-o out.csv] log.nav|log.obs
+ */
+
+using namespace std;
+
+// Sweeps.  The noise levels only apply to .nav paths.
+static const float noiseLevels[] = { 0.0f, 0.05f, 0.1f, 0.2f, 0.3f };
+static const int particleCounts[] = { 100, 1000, 10000 };
+static const int modelCounts[] = { 6, 12, 24 };
+
+#define ARRAY_LENGTH(a) (sizeof(a) / sizeof((a)[0]))
+
+enum System { SYSTEM_MCL, SYSTEM_EKF, SYSTEM_MM_EKF };
+static const char *systemNames[] = { "mcl", "ekf", "mmekf" };
+
+// Every frame of one replay of the log
+struct Replay
+{
+    float noise; // Negative for a recorded log
+    int repeat;
+    vector<PoseEst> poses;
+    vector<MotionModel> odos;
+    vector<vector<Observation> > sightings;
+};
+
+struct Run
+{
+    System system;
+    int param; // Particles or models, 0 for LocEKF
+    const Replay *replay;
+
+    // Results
+    double meanError, rmsError, meanHeadingError;
+    double meanLatency;
+    long p50, p90, p99, worst; // ns
+};
+
+static long nanos()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/**
+ * Makes the frames of a .nav path the way iterateFakerPath() does.
+ */
+static void fakeReplay(const NavPath& path, Replay& replay)
+{
+    srand(replay.repeat + 1);
+
+    PoseEst pose = path.startPos;
+    for (unsigned int i = 0; i < path.myMoves.size(); ++i) {
+        for (int j = 0; j < path.myMoves[i].time; ++j) {
+            pose += path.myMoves[i].move;
+            replay.poses.push_back(pose);
+            replay.odos.push_back(path.myMoves[i].move);
+            replay.sightings.push_back(
+                determineObservedLandmarks(pose, 0.0f, replay.noise));
+        }
+    }
+}
+
+static void readReplay(fstream& file, Replay& replay)
+{
+    vector<BallPose> ballPoses;
+    vector<float> ballDists, ballBearings;
+    readObsInputFile(&file, &replay.poses, &ballPoses, &replay.odos,
+                     &replay.sightings, &ballDists, &ballBearings, BALL_ID);
+}
+
+static long percentile(const vector<long>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[min(sorted.size() - 1,
+                      static_cast<size_t>(p * sorted.size()))];
+}
+
+static void replay(Run& run)
+{
+    LocSystem *loc;
+    switch (run.system) {
+    case SYSTEM_MCL:
+        loc = new MCL(run.param, 1, run.replay->repeat + 1);
+        break;
+    case SYSTEM_MM_EKF:
+        loc = new MMLocEKF(run.param);
+        break;
+    default:
+        loc = new LocEKF();
+        break;
+    }
+
+    const Replay& r = *run.replay;
+    const int frames = r.poses.size();
+    vector<long> latencies(frames);
+    double error = 0, squaredError = 0, headingError = 0;
+
+    for (int f = 0; f < frames; ++f) {
+        const long start = nanos();
+        loc->updateLocalization(r.odos[f], r.sightings[f]);
+        latencies[f] = nanos() - start;
+
+        const float e = hypotf(loc->getXEst() - r.poses[f].x,
+                               loc->getYEst() - r.poses[f].y);
+        error += e;
+        squaredError += e * e;
+        headingError += fabs(NBMath::subPIAngle(loc->getHEst() -
+                                                r.poses[f].h));
+    }
+    delete loc;
+
+    const int n = max(frames, 1);
+    run.meanError = error / n;
+    run.rmsError = sqrt(squaredError / n);
+    run.meanHeadingError = headingError / n * TO_DEG;
+
+    long total = 0;
+    for (int f = 0; f < frames; ++f)
+        total += latencies[f];
+    run.meanLatency = total / static_cast<double>(n);
+
+    sort(latencies.begin(), latencies.end());
+    run.p50 = percentile(latencies, 0.5);
+    run.p90 = percentile(latencies, 0.9);
+    run.p99 = percentile(latencies, 0.99);
+    run.worst = frames > 0 ? latencies.back() : 0;
+}
+
+// The runs, handed out to the workers in order
+static vector<Run> runs;
+static unsigned int nextRun = 0;
+static pthread_mutex_t runMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void* replayWorker(void*)
+{
+    while (true) {
+        pthread_mutex_lock(&runMutex);
+        const unsigned int i = nextRun++;
+        pthread_mutex_unlock(&runMutex);
+
+        if (i >= runs.size())
+            return 0;
+        replay(runs[i]);
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr, "Usage: locReplay [-j workers] [-r repeats] "
+            "[-o out.csv] log.nav|log.obs\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    int workers = sysconf(_SC_NPROCESSORS_ONLN);
+    int repeats = 1;
+    const char *outName = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:r:o:")) != -1) {
+        switch (opt) {
+        case 'j': workers = atoi(optarg); break;
+        case 'r': repeats = atoi(optarg); break;
+        case 'o': outName = optarg; break;
+        default: usage();
+        }
+    }
+    if (optind != argc - 1 || workers < 1 || repeats < 1)
+        usage();
+
+    const string logName = argv[optind];
+    fstream logFile(logName.c_str(), fstream::in);
+    if (!logFile.is_open()) {
+        fprintf(stderr, "Could not open %s\n", logName.c_str());
+        return 1;
+    }
+
+    // Read or fake every replay of the log.  The field's landmarks are
+    // built here too, before any worker could race to build them.
+    const bool isNav = logName.size() > 4 &&
+        logName.compare(logName.size() - 4, 4, ".nav") == 0;
+    vector<Replay> replays;
+    if (isNav) {
+        NavPath path;
+        readNavInputFile(&logFile, &path);
+        replays.resize(ARRAY_LENGTH(noiseLevels) * repeats);
+        for (unsigned int n = 0; n < ARRAY_LENGTH(noiseLevels); ++n) {
+            for (int r = 0; r < repeats; ++r) {
+                Replay& replay = replays[n * repeats + r];
+                replay.noise = noiseLevels[n];
+                replay.repeat = r;
+                fakeReplay(path, replay);
+            }
+        }
+    } else {
+        // A recorded log is the same every time, only MCL's seed changes
+        replays.resize(repeats);
+        readReplay(logFile, replays[0]);
+        for (int r = 0; r < repeats; ++r) {
+            replays[r] = replays[0];
+            replays[r].noise = -1.0f;
+            replays[r].repeat = r;
+        }
+    }
+    logFile.close();
+
+    for (unsigned int i = 0; i < replays.size(); ++i) {
+        Run run;
+        run.replay = &replays[i];
+        run.system = SYSTEM_MCL;
+        for (unsigned int p = 0; p < ARRAY_LENGTH(particleCounts); ++p) {
+            run.param = particleCounts[p];
+            runs.push_back(run);
+        }
+        run.system = SYSTEM_EKF;
+        run.param = 0;
+        runs.push_back(run);
+        run.system = SYSTEM_MM_EKF;
+        for (unsigned int m = 0; m < ARRAY_LENGTH(modelCounts); ++m) {
+            run.param = modelCounts[m];
+            runs.push_back(run);
+        }
+    }
+
+    workers = min(workers, static_cast<int>(runs.size()));
+    fprintf(stderr, "%d frames, %u runs on %d workers\n",
+            static_cast<int>(replays[0].poses.size()),
+            static_cast<unsigned int>(runs.size()), workers);
+
+    const long start = nanos();
+    vector<pthread_t> threads(workers);
+    for (int t = 0; t < workers; ++t)
+        pthread_create(&threads[t], 0, replayWorker, 0);
+    for (int t = 0; t < workers; ++t)
+        pthread_join(threads[t], 0);
+    fprintf(stderr, "Took %.2f s\n", (nanos() - start) * 1e-9);
+
+    FILE *out = outName ? fopen(outName, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Could not open %s\n", outName);
+        return 1;
+    }
+    fprintf(out, "system,param,noise,repeat,frames,mean_error_cm,"
+            "rms_error_cm,mean_heading_error_deg,mean_us,p50_us,p90_us,"
+            "p99_us,max_us\n");
+    for (unsigned int i = 0; i < runs.size(); ++i) {
+        const Run& run = runs[i];
+        fprintf(out, "%s,%d,%.2f,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,"
+                "%.2f,%.2f\n",
+                systemNames[run.system], run.param, run.replay->noise,
+                run.replay->repeat,
+                static_cast<int>(run.replay->poses.size()),
+                run.meanError, run.rmsError, run.meanHeadingError,
+                run.meanLatency * 1e-3, run.p50 * 1e-3, run.p90 * 1e-3,
+                run.p99 * 1e-3, run.worst * 1e-3);
+    }
+    if (outName)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,446 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#include <vector>
+#include <sys/time.h>
+
+#include "MCL.h"
+#include "MCLKernels.h"
+#include "LikelihoodField.h"
+
+/**
+ * Times MCL::updateLocalization() at a few particle counts.  The robot
+ * stands still in front of the yellow goal and sees both posts, an
+ * ambiguous corner and an ambiguous line every frame, about what a striker
+ * sees on a good frame.  Every other frame it sees only the corner and the
+ * line.  Besides the time per frame and particles per millisecond it
+ * counts calls to operator new during the timed frames, which should stay
+ * at zero.
+ *
+ * Before that it checks the fast atan2 and exp against libm and the vector
+ * measurement kernels against the scalar ones, and times the measurement
+ * kernel on its own against the libm version it replaced, and the
+ * likelihood field against the kernel for a corner that could be any L
+ * corner.  After it, runs a KLD-sampling filter from lost to converged,
+ * through a reset and back, and prints how many particles it kept and what
+ * each frame cost, then the largest filter again with the likelihood field.
+ *
+ * Usage: mclBench [frames] [threads]
+ */
+
+static long allocations = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+    ++allocations;
+    void *p = malloc(size ? size : 1);
+    if (p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+static long micros()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+static Observation sightPoint(const PoseEst& pose, int id, float x, float y)
+{
+    Observation z(id, hypotf(x - pose.x, y - pose.y),
+                  NBMath::subPIAngle(atan2f(y - pose.y, x - pose.x) - pose.h),
+                  20.0f, 0.1f, false);
+    z.addPointPossibility(PointLandmark(x, y));
+    return z;
+}
+
+static void makeObservations(const PoseEst& pose, std::vector<Observation>& z)
+{
+    z.clear();
+    z.push_back(sightPoint(pose, 0, LANDMARK_YELLOW_GOAL_TOP_POST_X,
+                           LANDMARK_YELLOW_GOAL_TOP_POST_Y));
+    z.push_back(sightPoint(pose, 1, LANDMARK_YELLOW_GOAL_BOTTOM_POST_X,
+                           LANDMARK_YELLOW_GOAL_BOTTOM_POST_Y));
+
+    // A corner that could be any of the four field corners
+    Observation corner = sightPoint(pose, 2, FIELD_WHITE_RIGHT_SIDELINE_X,
+                                    FIELD_WHITE_TOP_SIDELINE_Y);
+    corner.addPointPossibility(PointLandmark(FIELD_WHITE_RIGHT_SIDELINE_X,
+                                             FIELD_WHITE_BOTTOM_SIDELINE_Y));
+    corner.addPointPossibility(PointLandmark(FIELD_WHITE_LEFT_SIDELINE_X,
+                                             FIELD_WHITE_TOP_SIDELINE_Y));
+    corner.addPointPossibility(PointLandmark(FIELD_WHITE_LEFT_SIDELINE_X,
+                                             FIELD_WHITE_BOTTOM_SIDELINE_Y));
+    z.push_back(corner);
+
+    // The goal line, or the other one
+    const float dist = FIELD_WHITE_RIGHT_SIDELINE_X - pose.x;
+    Observation line(50, dist, 0.0f, 20.0f, 0.1f, true);
+    line.addLinePossibility(LineLandmark(FIELD_WHITE_RIGHT_SIDELINE_X,
+                                         FIELD_WHITE_BOTTOM_SIDELINE_Y,
+                                         FIELD_WHITE_RIGHT_SIDELINE_X,
+                                         FIELD_WHITE_TOP_SIDELINE_Y));
+    line.addLinePossibility(LineLandmark(FIELD_WHITE_LEFT_SIDELINE_X,
+                                         FIELD_WHITE_BOTTOM_SIDELINE_Y,
+                                         FIELD_WHITE_LEFT_SIDELINE_X,
+                                         FIELD_WHITE_TOP_SIDELINE_Y));
+    z.push_back(line);
+}
+
+static float uniform(float lo, float hi)
+{
+    return lo + (hi - lo) * (rand() / (RAND_MAX + 1.0f));
+}
+
+/**
+ * The point weight MCL computed before MCLKernels, with libm.
+ */
+static float libmPointWeight(const MCLKernels::Measurement& z,
+                             float x, float y, float h,
+                             const PointLandmark& pt)
+{
+    const float d_hat = static_cast<float>(hypot(pt.x - x, pt.y - y));
+    const float a_hat = atan2(pt.y - y, pt.x - x) - h;
+    const float r_d = z.dist - d_hat;
+    const float r_a = z.bearing - a_hat;
+    const float s = exp(-(r_d*r_d) * z.invVarD - (r_a*r_a) * z.invVarA);
+    return s < z.minSimilarity ? z.minSimilarity : s;
+}
+
+static MCLKernels::Measurement measurement(const Observation& z)
+{
+    MCLKernels::Measurement meas;
+    meas.dist = z.getVisDistance();
+    meas.bearing = z.getVisBearing();
+    meas.invVarD = 1.0f / (z.getDistanceSD() * z.getDistanceSD());
+    meas.invVarA = 1.0f / (z.getBearingSD() * z.getBearingSD());
+    meas.minSimilarity = MIN_SIMILARITY;
+    return meas;
+}
+
+/**
+ * Checks the approximations against libm and the build's kernels against
+ * the scalar ones, then times the point kernel against the libm model.
+ * Returns false if anything is outside the bounds MCLKernels.h promises.
+ */
+static bool checkKernels()
+{
+    float atanErr = 0, expErr = 0;
+    for (int i = 0; i < 1000000; ++i) {
+        const float y = uniform(-1000.0f, 1000.0f);
+        const float x = uniform(-1000.0f, 1000.0f);
+        atanErr = std::max(atanErr, fabsf(MCLKernels::fastAtan2(y, x) -
+                                          atan2f(y, x)));
+        const float e = uniform(-87.0f, 0.0f);
+        expErr = std::max(expErr, fabsf(MCLKernels::fastExp(e) - expf(e)) /
+                          expf(e));
+    }
+
+    // Random particles, in aligned arrays like MCL's
+    const int n = 1001;
+    const int stride = (n + 3) & ~3;
+    float *x;
+    if (posix_memalign(reinterpret_cast<void**>(&x), 16,
+                       5 * stride * sizeof(float))) {
+        return false;
+    }
+    float *y = x + stride, *h = y + stride;
+    float *w = h + stride, *wScalar = w + stride;
+    for (int i = 0; i < n; ++i) {
+        x[i] = uniform(0, FIELD_WIDTH);
+        y[i] = uniform(0, FIELD_HEIGHT);
+        h[i] = uniform(-M_PI_FLOAT, M_PI_FLOAT);
+        w[i] = wScalar[i] = 1.0f;
+    }
+
+    // Every observation of the benchmark, through both kernels
+    std::vector<Observation> z;
+    makeObservations(PoseEst(300.0f, 200.0f, 0.5f), z);
+    for (unsigned k = 0; k < z.size(); ++k) {
+        const MCLKernels::Measurement meas = measurement(z[k]);
+        if (z[k].isLine()) {
+            const std::vector<LineLandmark>& lines =
+                z[k].getLinePossibilities();
+            MCLKernels::LineSegment segs[2];
+            for (unsigned j = 0; j < lines.size(); ++j) {
+                MCLKernels::makeSegment(lines[j], segs[j]);
+            }
+            MCLKernels::lineWeightsScalar(x, y, h, wScalar, 0, n,
+                                          meas, segs, lines.size());
+            MCLKernels::lineWeights(x, y, h, w, n, meas, segs, lines.size());
+        } else {
+            const std::vector<PointLandmark>& pts =
+                z[k].getPointPossibilities();
+            MCLKernels::pointWeightsScalar(x, y, h, wScalar, 0, n,
+                                           meas, &pts[0], pts.size());
+            MCLKernels::pointWeights(x, y, h, w, n, meas,
+                                     &pts[0], pts.size());
+        }
+    }
+    float kernelErr = 0;
+    for (int i = 0; i < n; ++i) {
+        kernelErr = std::max(kernelErr, fabsf(w[i] - wScalar[i]) / wScalar[i]);
+    }
+
+    // The four corner possibilities, libm against the kernel
+    const MCLKernels::Measurement corner = measurement(z[2]);
+    const std::vector<PointLandmark>& corners = z[2].getPointPossibilities();
+    const int reps = 200;
+    long start = micros();
+    for (int r = 0; r < reps; ++r) {
+        for (int i = 0; i < n; ++i) {
+            float pMax = -1;
+            for (unsigned j = 0; j < corners.size(); ++j) {
+                pMax = std::max(pMax, libmPointWeight(corner, x[i], y[i], h[i],
+                                                      corners[j]));
+            }
+            wScalar[i] = pMax;
+        }
+    }
+    const double libmTime = micros() - start;
+    start = micros();
+    for (int r = 0; r < reps; ++r) {
+        std::fill(w, w + n, 1.0f);
+        MCLKernels::pointWeights(x, y, h, w, n, corner,
+                                 &corners[0], corners.size());
+    }
+    const double kernelTime = micros() - start;
+    float modelErr = 0;
+    for (int i = 0; i < n; ++i) {
+        modelErr = std::max(modelErr, fabsf(w[i] - wScalar[i]) / wScalar[i]);
+    }
+    free(x);
+
+    printf("kernel %s: atan2 error %.2g rad, exp error %.2g, "
+           "vs scalar %.2g\n", MCLKernels::name(), atanErr, expErr,
+           kernelErr);
+    printf("4 possibility point weight: libm %.1f ns/particle, "
+           "%s %.1f ns/particle, max relative difference %.2g\n",
+           1000.0 * libmTime / (reps * n), MCLKernels::name(),
+           1000.0 * kernelTime / (reps * n), modelErr);
+    return atanErr < 2e-5f && expErr < 1e-5f && kernelErr < 1e-3f;
+}
+
+/**
+ * Checks a likelihood field mapped in from a file matches a generated one,
+ * and compares field weights with kernel weights for a corner that could
+ * be any L corner, over particles near the robot and all over the field.
+ * Returns false if the mapped field differs or the two models disagree by
+ * more than MCLKernels' approximations can explain near the robot.
+ */
+static bool checkLikelihoodField(const char *cacheFile)
+{
+    remove(cacheFile);
+    long start = micros();
+    LikelihoodField written(cacheFile);
+    const long generateTime = micros() - start;
+    start = micros();
+    LikelihoodField mapped(cacheFile);
+    const long mapTime = micros() - start;
+    if (written.isMapped() || !mapped.isMapped()) {
+        printf("likelihood field was not written and mapped back in\n");
+        return false;
+    }
+    for (int i = 0; i < 10000; ++i) {
+        const int t = i % written.getNumTables();
+        const float x = uniform(-200.0f, FIELD_WIDTH + 200.0f);
+        const float y = uniform(-200.0f, FIELD_HEIGHT + 200.0f);
+        float ax, ay, bx, by;
+        written.nearest(t, x, y, ax, ay);
+        mapped.nearest(t, x, y, bx, by);
+        if (ax != bx || ay != by) {
+            printf("mapped likelihood field differs in %s\n",
+                   written.getTableName(t));
+            return false;
+        }
+    }
+
+    const PoseEst truth(FIELD_WHITE_RIGHT_SIDELINE_X - 150.0f,
+                        CENTER_FIELD_Y + 100.0f, 0.3f);
+    Observation corner = sightPoint(truth, 2, FIELD_WHITE_RIGHT_SIDELINE_X,
+                                    FIELD_WHITE_TOP_SIDELINE_Y);
+    const std::vector<const ConcreteCorner*>& l = ConcreteCorner::lCorners();
+    std::vector<PointLandmark> possible;
+    for (unsigned i = 0; i < l.size(); ++i) {
+        possible.push_back(PointLandmark(l[i]->getFieldX(),
+                                         l[i]->getFieldY()));
+    }
+    const int table = mapped.findTable(possible);
+    if (table < 0) {
+        printf("no likelihood field for the L corners\n");
+        return false;
+    }
+    const MCLKernels::Measurement meas = measurement(corner);
+
+    // Half the particles near the robot, the rest anywhere
+    const int n = 10000;
+    const int stride = (n + 3) & ~3;
+    float *x;
+    if (posix_memalign(reinterpret_cast<void**>(&x), 16,
+                       5 * stride * sizeof(float))) {
+        return false;
+    }
+    float *y = x + stride, *h = y + stride;
+    float *w = h + stride, *wKernel = w + stride;
+    for (int i = 0; i < n; ++i) {
+        const bool near = i < n / 2;
+        x[i] = near ? truth.x + uniform(-30.0f, 30.0f) : uniform(0, FIELD_WIDTH);
+        y[i] = near ? truth.y + uniform(-30.0f, 30.0f) :
+            uniform(0, FIELD_HEIGHT);
+        h[i] = near ? truth.h + uniform(-0.2f, 0.2f) :
+            uniform(-M_PI_FLOAT, M_PI_FLOAT);
+    }
+
+    const int reps = 50;
+    start = micros();
+    for (int r = 0; r < reps; ++r) {
+        std::fill(wKernel, wKernel + n, 1.0f);
+        MCLKernels::pointWeights(x, y, h, wKernel, n, meas,
+                                 &possible[0], possible.size());
+    }
+    const double kernelTime = micros() - start;
+    start = micros();
+    for (int r = 0; r < reps; ++r) {
+        std::fill(w, w + n, 1.0f);
+        mapped.weigh(table, x, y, h, w, 0, n, meas);
+    }
+    const double fieldTime = micros() - start;
+
+    // Both models agree to first order in the errors, so compare the
+    // weights of the particles they both find likely
+    float nearErr = 0;
+    for (int i = 0; i < n / 2; ++i) {
+        if (wKernel[i] > 0.1f) {
+            nearErr = std::max(nearErr, fabsf(w[i] - wKernel[i]));
+        }
+    }
+    free(x);
+
+    printf("likelihood field: generated in %ld us, mapped in %ld us\n",
+           generateTime, mapTime);
+    printf("8 possibility point weight: %s %.1f ns/particle, field "
+           "%.1f ns/particle, max difference near the robot %.3f\n",
+           MCLKernels::name(), 1000.0 * kernelTime / (reps * n),
+           1000.0 * fieldTime / (reps * n), nearErr);
+    return nearErr < 0.1f;
+}
+
+int main(int argc, char** argv)
+{
+    if (!checkKernels()) {
+        printf("MCL kernels out of bounds\n");
+        return 1;
+    }
+    if (!checkLikelihoodField("/tmp/mclBench.field")) {
+        printf("likelihood field check failed\n");
+        return 1;
+    }
+
+    const int frames = argc > 1 ? atoi(argv[1]) : 100;
+    const int threads = argc > 2 ? atoi(argv[2]) : 1;
+    const int sizes[] = { 100, 1000, 10000 };
+
+    const PoseEst truth(FIELD_WHITE_RIGHT_SIDELINE_X - 200.0f,
+                        CENTER_FIELD_Y, 0.0f);
+    std::vector<Observation> z;
+    makeObservations(truth, z);
+    // The posts go out of view, so the count changes every frame
+    const std::vector<Observation> zFewer(z.begin() + 2, z.end());
+    const MotionModel still(0.0f, 0.0f, 0.0f);
+
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        const int M = sizes[s];
+        MCL mcl(M, threads, 1);
+
+        // Let the filter settle, and let lastObservations grow
+        for (int f = 0; f < 10; ++f) {
+            mcl.updateLocalization(still, f % 2 ? zFewer : z);
+        }
+
+        const long allocsBefore = allocations;
+        const long start = micros();
+        for (int f = 0; f < frames; ++f) {
+            mcl.updateLocalization(still, f % 2 ? zFewer : z);
+        }
+        const double perFrame = (micros() - start) / (double)frames;
+
+        printf("M=%5d, %d threads: %9.1f us/frame %9.1f particles/ms "
+               "%ld allocs  est (%.0f, %.0f) truth (%.0f, %.0f)\n",
+               M, threads, perFrame, M * 1000.0 / perFrame,
+               allocations - allocsBefore,
+               mcl.getXEst(), mcl.getYEst(), truth.x, truth.y);
+    }
+
+    // KLD-sampling with up to the largest size: lost, found, reset, found
+    MCL kld(sizes[sizeof(sizes) / sizeof(sizes[0]) - 1], threads, 1);
+    kld.setKLDSampling(true);
+    for (int f = 0; f < 2 * frames; ++f) {
+        if (f == frames) {
+            kld.reset();
+            printf("reset\n");
+        }
+        const int before = kld.getNumParticles();
+        const long start = micros();
+        kld.updateLocalization(still, z);
+        const long took = micros() - start;
+        const int g = f % frames;
+        if (g < 5 || g == 10 || g == 20 || g == frames - 1) {
+            printf("KLD frame %3d: %5d -> %5d particles %9ld us  "
+                   "est (%.0f, %.0f)\n", f, before, kld.getNumParticles(),
+                   took, kld.getXEst(), kld.getYEst());
+        }
+    }
+
+    // The largest filter again, with an L corner and a line that could be
+    // any line, from the likelihood field
+    const int largest = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    std::vector<Observation> zField(z.begin(), z.begin() + 2);
+    Observation lCorner = sightPoint(truth, 2, FIELD_WHITE_RIGHT_SIDELINE_X,
+                                     FIELD_WHITE_TOP_SIDELINE_Y);
+    const std::vector<const ConcreteCorner*>& l = ConcreteCorner::lCorners();
+    for (unsigned i = 0; i < l.size(); ++i) {
+        if (l[i]->getFieldX() != FIELD_WHITE_RIGHT_SIDELINE_X ||
+            l[i]->getFieldY() != FIELD_WHITE_TOP_SIDELINE_Y) {
+            lCorner.addPointPossibility(PointLandmark(l[i]->getFieldX(),
+                                                      l[i]->getFieldY()));
+        }
+    }
+    zField.push_back(lCorner);
+    Observation anyLine(50, FIELD_WHITE_RIGHT_SIDELINE_X - truth.x, 0.0f,
+                        20.0f, 0.1f, true);
+    const std::vector<const ConcreteLine*>& lines =
+        ConcreteLine::concreteLines();
+    for (unsigned i = 0; i < lines.size(); ++i) {
+        anyLine.addLinePossibility(LineLandmark(lines[i]->getFieldX1(),
+                                                lines[i]->getFieldY1(),
+                                                lines[i]->getFieldX2(),
+                                                lines[i]->getFieldY2()));
+    }
+    zField.push_back(anyLine);
+
+    for (int field = 0; field < 2; ++field) {
+        MCL mcl(largest, threads, 1);
+        mcl.setLikelihoodField(field != 0, "/tmp/mclBench.field");
+        for (int f = 0; f < 10; ++f) {
+            mcl.updateLocalization(still, zField);
+        }
+        const long start = micros();
+        for (int f = 0; f < frames; ++f) {
+            mcl.updateLocalization(still, zField);
+        }
+        const double perFrame = (micros() - start) / (double)frames;
+        printf("M=%5d, any L corner and any line, %s: %9.1f us/frame "
+               "est (%.0f, %.0f) truth (%.0f, %.0f)\n", largest,
+               field ? "likelihood field" : MCLKernels::name(), perFrame,
+               mcl.getXEst(), mcl.getYEst(), truth.x, truth.y);
+    }
+    return 0;
+}
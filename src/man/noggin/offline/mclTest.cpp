@@ -1,34 +1,195 @@
 #include <vector>
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 using namespace std;
 
 #include "Observation.h"
 #include "MCL.h"
 
-int main()
+/**
+ * Checks that MCL is reproducible: the same seed has to give bit for bit
+ * the same particles however many threads update them.  Walks a robot
+ * around the field seeing goal posts and runs one filter with --threads
+ * threads and one with a single thread, both with --seed, then compares a
+ * hash of their particles every frame.  With --kld 1 both use KLD-sampling
+ * and the particle count has to shrink once the robot is found.  Also
+ * checks the Philox generator against the Random123 known answers, and
+ * that a frame of sightings no particle can explain doesn't leave the
+ * estimate NaN.
+ *
+ * Usage: mclTest [--seed n] [--threads n] [--particles n] [--frames n]
+ *                [--kld 0|1]
+ */
+
+static bool checkPhilox()
+{
+    static const uint32_t expected[3][4] = {
+        { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u },
+        { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu },
+        { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u }
+    };
+    uint32_t out[3][4];
+    Philox(0, 0)(0, 0, 0, 0, out[0]);
+    Philox(0xffffffffu, 0xffffffffu)(0xffffffffu, 0xffffffffu,
+                                     0xffffffffu, 0xffffffffu, out[1]);
+    Philox(0xa4093822u, 0x299f31d0u)(0x243f6a88u, 0x85a308d3u,
+                                     0x13198a2eu, 0x03707344u, out[2]);
+    return memcmp(expected, out, sizeof(out)) == 0;
+}
+
+// FNV-1a over the particles' bits
+static uint32_t hashParticles(const MCL& mcl)
+{
+    const vector<Particle> particles = mcl.getParticles();
+    uint32_t hash = 2166136261u;
+    for (unsigned int i = 0; i < particles.size(); ++i) {
+        const float f[4] = { particles[i].pose.x, particles[i].pose.y,
+                             particles[i].pose.h, particles[i].weight };
+        const unsigned char *b = reinterpret_cast<const unsigned char*>(f);
+        for (unsigned int k = 0; k < sizeof(f); ++k) {
+            hash = (hash ^ b[k]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static Observation sightPost(const PoseEst& pose, int id, float x, float y)
+{
+    Observation z(id, hypotf(x - pose.x, y - pose.y),
+                  NBMath::subPIAngle(atan2f(y - pose.y, x - pose.x) - pose.h),
+                  20.0f, 0.1f, false);
+    z.addPointPossibility(PointLandmark(x, y));
+    return z;
+}
+
+/**
+ * Six posts, each seen where it can't be from anywhere on the field, make
+ * every particle's weight underflow to zero.  The filter has to come
+ * through that with finite estimates and recover on good frames.
+ */
+static bool checkImpossibleFrame(int particles, int threads, uint32_t seed,
+                                 bool kld)
 {
-    // Testing the observation class stuff
-    vector<Observation> obs;
-    VisualLine* vl1 = new VisualLine();
-    VisualLine* vl2 = new VisualLine();
-    VisualCorner vc(100, 200, 200.0f,
-                    50.0f, *vl1, *vl2, 200.1f, 300.0f);
-    FieldObjects* fo = new FieldObjects(YELLOW_GOAL_RIGHT_POST);
-    (*fo).setX(1000);
-    (*fo).setY(200);
-    obs.push_back(*(new Observation(vc)));
-    obs.push_back(*(new Observation(*vl1)));
-    obs.push_back(*(new Observation(*vl2)));
-    obs.push_back(*(new Observation(*fo)));
-
-
-    MCL* myLoc = new MCL();
-
-    for(unsigned short i = 0; i < obs.size(); ++i) {
-        cout << "(" << obs[i].getVisDist() << ", " << obs[i].getVisBearing() << ")"
-             << endl;
-    }
-
-    // // Clean everything up
-    delete vl1, vl2, fo;
+    MCL mcl(particles, threads, seed);
+    mcl.setKLDSampling(kld);
+    const PoseEst truth(CENTER_FIELD_X, CENTER_FIELD_Y, 0.0f);
+    const MotionModel still(0.0f, 0.0f, 0.0f);
+
+    vector<Observation> z;
+    for (int i = 0; i < 6; ++i) {
+        Observation far(i, 20000.0f, 0.0f, 20.0f, 0.1f, false);
+        far.addPointPossibility(PointLandmark(LANDMARK_YELLOW_GOAL_TOP_POST_X,
+                                              LANDMARK_YELLOW_GOAL_TOP_POST_Y));
+        z.push_back(far);
+    }
+    mcl.updateLocalization(still, z);
+
+    z.clear();
+    z.push_back(sightPost(truth, 0, LANDMARK_YELLOW_GOAL_TOP_POST_X,
+                          LANDMARK_YELLOW_GOAL_TOP_POST_Y));
+    z.push_back(sightPost(truth, 1, LANDMARK_BLUE_GOAL_BOTTOM_POST_X,
+                          LANDMARK_BLUE_GOAL_BOTTOM_POST_Y));
+    for (int f = 0; f < 10; ++f) {
+        mcl.updateLocalization(still, z);
+    }
+
+    const float x = mcl.getXEst(), y = mcl.getYEst(), h = mcl.getHEst();
+    if (x != x || y != y || h != h) {
+        printf("estimate (%.1f, %.1f, %.2f) after an impossible frame\n",
+               x, y, h);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t seed = 1;
+    int threads = 4;
+    int particles = 1000;
+    int frames = 100;
+    bool kld = false;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoul(argv[i + 1], 0, 0);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--particles") == 0) {
+            particles = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--kld") == 0) {
+            kld = atoi(argv[i + 1]) != 0;
+        } else {
+            break;
+        }
+    }
+    if (seed == 0 || threads < 1 || particles < 1) {
+        cerr << "usage: " << argv[0] << " [--seed n (not 0)] [--threads n]"
+             << " [--particles n] [--frames n] [--kld 0|1]" << endl;
+        return 1;
+    }
+
+    if (!checkPhilox()) {
+        cout << "Philox does not match the known answers" << endl;
+        return 1;
+    }
+    if (!checkImpossibleFrame(particles, threads, seed, kld)) {
+        return 1;
+    }
+
+    MCL parallel(particles, threads, seed);
+    MCL serial(particles, 1, seed);
+    parallel.setKLDSampling(kld);
+    serial.setKLDSampling(kld);
+
+    // Circle the center of the field, half a degree and 2cm a frame
+    PoseEst truth(CENTER_FIELD_X, CENTER_FIELD_Y - 100.0f, 0.0f);
+    const MotionModel step(2.0f, 0.0f, 0.5f * TO_RAD);
+    vector<Observation> z;
+
+    for (int f = 0; f < frames; ++f) {
+        truth += step;
+        truth.h = NBMath::subPIAngle(truth.h);
+
+        z.clear();
+        z.push_back(sightPost(truth, 0, LANDMARK_YELLOW_GOAL_TOP_POST_X,
+                              LANDMARK_YELLOW_GOAL_TOP_POST_Y));
+        z.push_back(sightPost(truth, 1, LANDMARK_BLUE_GOAL_BOTTOM_POST_X,
+                              LANDMARK_BLUE_GOAL_BOTTOM_POST_Y));
+
+        parallel.updateLocalization(step, z);
+        serial.updateLocalization(step, z);
+
+        if (parallel.getNumParticles() != serial.getNumParticles()) {
+            printf("frame %d: %d threads kept %d particles, 1 thread %d\n",
+                   f, threads, parallel.getNumParticles(),
+                   serial.getNumParticles());
+            return 1;
+        }
+        const uint32_t a = hashParticles(parallel);
+        const uint32_t b = hashParticles(serial);
+        if (a != b) {
+            printf("frame %d: %d threads %08x, 1 thread %08x\n",
+                   f, threads, a, b);
+            return 1;
+        }
+    }
+
+    if (kld && parallel.getNumParticles() >= particles) {
+        printf("KLD-sampling kept all %d particles after %d frames\n",
+               particles, frames);
+        return 1;
+    }
+
+    printf("seed %u, %d particles%s, %d frames: %d threads match 1 thread "
+           "(%08x)\n", seed, particles, kld ? " (KLD)" : "", frames, threads,
+           hashParticles(parallel));
+    printf("%d particles at the end\n", parallel.getNumParticles());
+    printf("estimate (%.1f, %.1f, %.2f) truth (%.1f, %.1f, %.2f)\n",
+           parallel.getXEst(), parallel.getYEst(), parallel.getHEst(),
+           truth.x, truth.y, truth.h);
+    return 0;
 }
@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <sys/time.h>
+
+#include "MMLocEKF.h"
+
+/**
+ * Times MMLocEKF::updateLocalization() with corners everywhere.  The robot
+ * circles the center of the field and every frame sees a corner that could
+ * be any of the eight L corners on the field, and now and then a goal post.
+ * Every corner splits every model up to eight ways, so the filter runs at
+ * its limit on active models most of the time.  Prints the time per frame, the models
+ * left active after each frame and how far the estimate is from the truth,
+ * for a few limits on active models.
+ *
+ * Usage: mmlocBench [frames]
+ */
+
+static long micros()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+static Observation sightPoint(const PoseEst& pose, int id, float x, float y,
+                              float distSD = 20.0f, float bearingSD = 0.1f)
+{
+    Observation z(id, hypotf(x - pose.x, y - pose.y),
+                  NBMath::subPIAngle(atan2f(y - pose.y, x - pose.x) - pose.h),
+                  distSD, bearingSD, false);
+    z.addPointPossibility(PointLandmark(x, y));
+    return z;
+}
+
+static void makeObservations(const PoseEst& pose, int frame,
+                             std::vector<Observation>& z)
+{
+    // The field's L corners: its own four and the inner ones of the boxes
+    static const float corners[][2] = {
+        { FIELD_WHITE_RIGHT_SIDELINE_X, FIELD_WHITE_TOP_SIDELINE_Y },
+        { FIELD_WHITE_RIGHT_SIDELINE_X, FIELD_WHITE_BOTTOM_SIDELINE_Y },
+        { FIELD_WHITE_LEFT_SIDELINE_X, FIELD_WHITE_TOP_SIDELINE_Y },
+        { FIELD_WHITE_LEFT_SIDELINE_X, FIELD_WHITE_BOTTOM_SIDELINE_Y },
+        { BLUE_GOALBOX_RIGHT_X, BLUE_GOALBOX_TOP_Y },
+        { BLUE_GOALBOX_RIGHT_X, BLUE_GOALBOX_BOTTOM_Y },
+        { YELLOW_GOALBOX_LEFT_X, YELLOW_GOALBOX_TOP_Y },
+        { YELLOW_GOALBOX_LEFT_X, YELLOW_GOALBOX_BOTTOM_Y }
+    };
+    const int numCorners = sizeof(corners) / sizeof(corners[0]);
+
+    // A far away corner, seen badly, that could be any of them
+    z.clear();
+    const int seen = frame % numCorners;
+    Observation corner = sightPoint(pose, 2, corners[seen][0],
+                                    corners[seen][1], 100.0f, 0.5f);
+    for (int i = 0; i < numCorners; ++i) {
+        if (i != seen) {
+            corner.addPointPossibility(PointLandmark(corners[i][0],
+                                                     corners[i][1]));
+        }
+    }
+    z.push_back(corner);
+
+    if (frame % 5 == 0) {
+        z.push_back(sightPoint(pose, 0, LANDMARK_YELLOW_GOAL_TOP_POST_X,
+                               LANDMARK_YELLOW_GOAL_TOP_POST_Y));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? atoi(argv[1]) : 1000;
+    const int limits[] = { 6, 12, 24, 32 };
+
+    for (unsigned l = 0; l < sizeof(limits) / sizeof(limits[0]); ++l) {
+        MMLocEKF loc(limits[l]);
+        PoseEst truth(CENTER_FIELD_X, CENTER_FIELD_Y - 100.0f, 0.0f);
+        const MotionModel step(1.0f, 0.0f, 1.0f * TO_RAD);
+        std::vector<Observation> z;
+
+        long took = 0, worst = 0;
+        double active = 0, error = 0;
+        for (int f = 0; f < frames; ++f) {
+            truth += step;
+            truth.h = NBMath::subPIAngle(truth.h);
+            makeObservations(truth, f, z);
+
+            const long start = micros();
+            loc.updateLocalization(step, z);
+            const long t = micros() - start;
+            took += t;
+            worst = std::max(worst, t);
+
+            active += loc.getNumActiveModels();
+            error += hypotf(loc.getXEst() - truth.x, loc.getYEst() - truth.y);
+        }
+
+        printf("max %2d models: %8.1f us/frame (worst %6ld us) "
+               "%5.1f models active, %6.1f cm mean error\n",
+               loc.getMaxActiveModels(), took / (double)frames, worst,
+               active / frames, error / frames);
+    }
+    return 0;
+}
@@ -9,29 +9,8 @@
  * NAVIGATION LINES
  * deltaForward deltaLateral deltaRotation
  *
- * Format of the log output file (*.mcl):
- *
- * PARTICLE INFO
- * x y h weight (for M particles)
- *
- * Colon signifying end of section
- *
- * DEBUG INFO
- * team_color player_number
- * x-estimate y-estimate heading-estimate deg
- * x-uncertinty y-uncert heading-uncert
- * ball-x ball-y
- * ball-uncert-x ball-uncert-y
- * ball-vel-x ball-vel-y
- * ball-vel-uncert-x ball-vel-uncert-y
- * odometery-lateral odometery-forward odometery-rotational
- *
- * ROBOT REAL INFO
- * x y h (as given by the system)
- *
- * LANDMARK INFO
- * ID dist bearing (for all landmarks observed in the frame)
- *
+ * The log output files (*.mcl.noise.*, *.ekf.noise.*) are binary
+ * localization logs, as described in LocLog.h.
  */
 #include "fakerIO.h"
 #include "fakerIterators.h"
@@ -57,10 +36,8 @@ int main(int argc, char** argv)
         cerr << "usage: " << argv[0] << " input-file" << endl;
         return 1;
     }
-    try {
-        inputFile.open(argv[1], ios::in);
-
-    } catch (const exception& e) {
+    inputFile.open(argv[1], ios::in);
+    if (!inputFile.is_open()) {
         cout << "Failed to open input file" << argv[1] << endl;
         return 1;
     }
@@ -83,10 +60,9 @@ void runFaker(char * inputName, NavPath * letsGo, float noiseLevel)
 {
     for(int i = 0; i < 10; ++i) {
         // Open output files
-        fstream mclFile;
-        fstream ekfFile;
         string mclFileName(inputName);
         string ekfFileName(inputName);
+        string ekfDiffFileName(inputName);
 
         mclFileName.replace(mclFileName.end()-3, mclFileName.end(),
                             "mcl.noise");
@@ -94,6 +70,8 @@ void runFaker(char * inputName, NavPath * letsGo, float noiseLevel)
         ekfFileName.replace(ekfFileName.end()-3, ekfFileName.end(),
                             "ekf.noise");
 
+        ekfDiffFileName.replace(ekfDiffFileName.end()-3,
+                                ekfDiffFileName.end(), "ekf.diff.noise");
 
         stringstream st;
         st << "." << noiseLevel;
@@ -103,18 +81,20 @@ void runFaker(char * inputName, NavPath * letsGo, float noiseLevel)
         st << "." << i;
 
         mclFileName += st.str();
-        mclFile.open(mclFileName.c_str(), ios::out);
-        ekfFile.open(ekfFileName.c_str(), ios::out);
+        ekfDiffFileName += st.str();
+        LocLogWriter mclLog(mclFileName.c_str(), TEAM_COLOR, PLAYER_NUMBER);
+        LocLogWriter ekfLog(ekfFileName.c_str(), TEAM_COLOR, PLAYER_NUMBER);
+        fstream ekfDiffFile(ekfDiffFileName.c_str(), ios::out);
+        printOutPoseDiffHeader(&ekfDiffFile);
 
         cout << "Making file " << ekfFileName << endl;
         cout << "Making mcl file " << mclFileName << endl;
 
         // Iterate through the path
         cout << "Running loc systems for the " << i << "th time" << endl;
-        iterateFakerPath(&mclFile, &ekfFile, letsGo, noiseLevel);
+        iterateFakerPath(&mclLog, &ekfLog, &ekfDiffFile, letsGo, noiseLevel);
 
-        // Close the output files
-        mclFile.close();
-        ekfFile.close();
+        // The logs are closed as they go out of scope
+        ekfDiffFile.close();
     }
 }
@@ -75,7 +75,7 @@ static const int DIST_POINT_FUDGE = 5;
 Ball::Ball(Vision* vis, Threshold* thr, Field* fie, int _color)
 : vision(vis), thresh(thr), field(fie), color(_color), runsize(1)
 {
-	blobs = new Blobs(MAX_BALLS);
+	blobs = new Blobs(MAX_BALLS, BALL_RUNS_MALLOC_SIZE);
 	init(0.0);
 	allocateColorRuns();
 }
@@ -483,7 +483,7 @@ void Ball::checkForReflections(int h, int w, VisualBall * thisBall,
                  i++) {
                 for (int j = topBlob->getLeftTopY();
                      j < topBlob->getLeftBottomY(); j++) {
-                    if (thresh->thresholded[j][i] == ORANGE) {
+                    if (thresh->getColor(i, j) == ORANGE) {
                         topBlob->setRightTopX(i);
                         j = IMAGE_HEIGHT;
                         i = IMAGE_WIDTH;
@@ -496,7 +496,7 @@ void Ball::checkForReflections(int h, int w, VisualBall * thisBall,
             for (int i = topBlob->getLeftTopX() + h; i > -1; i--) {
                 for (int j = topBlob->getLeftTopY();
                      j < topBlob->getLeftBottomY(); j++) {
-                    if (thresh->thresholded[j][i] == ORANGE) {
+                    if (thresh->getColor(i, j) == ORANGE) {
                         topBlob->setRightTopX(i);
                         j = IMAGE_HEIGHT;
                         i = -1;
@@ -648,7 +648,7 @@ float Ball::rightHalfColor(Blob tempobj)
 	int pix;
 	for (int i = spanY / 2; i < spanY; i++) {
 		for (int j = 0; j < spanX; j++) {
-			pix = thresh->thresholded[y + i][x + j];
+			pix = thresh->getColor(x + j, y + i);
 			if (y + i > -1 && x + j > -1 && (y + i) < IMAGE_HEIGHT &&
 					x + j < IMAGE_WIDTH && (pix == ORANGE || pix == ORANGERED ||
 							pix == ORANGEYELLOW)) {
@@ -658,7 +658,7 @@ float Ball::rightHalfColor(Blob tempobj)
 	}
 	for (int i = 0; i < spanY; i++) {
 		for (int j = 0; j < spanX / 2; j++) {
-			pix = thresh->thresholded[y + i][x + j];
+			pix = thresh->getColor(x + j, y + i);
 			if (y + i > -1 && x + j > -1 && (y + i) < IMAGE_HEIGHT &&
 					x + j < IMAGE_WIDTH && (pix == ORANGE || pix == ORANGERED ||
 							pix == ORANGEYELLOW)) {
@@ -668,7 +668,7 @@ float Ball::rightHalfColor(Blob tempobj)
 	}
 	for (int i = 0; i < spanY; i++) {
 		for (int j = spanX / 2; j < spanX; j++) {
-			pix = thresh->thresholded[y + i][x + j];
+			pix = thresh->getColor(x + j, y + i);
 			if (y + i > -1 && x + j > -1 && (y + i) < IMAGE_HEIGHT &&
 					x + j < IMAGE_WIDTH && (pix == ORANGE || pix == ORANGERED ||
 							pix == ORANGEYELLOW)) {
@@ -810,14 +810,14 @@ pair<int, int> Ball::scanMidlinesForRoundnessInformation(Blob b) {
     int pix;
     int goodPix = 0, badPix = 0;
     for (int i = 0; i < h; i++) {
-        pix = thresh->thresholded[y+i][x + w/2];
+        pix = thresh->getColor(x + w/2, y+i);
         if (pix == ORANGE || pix == ORANGERED || pix == ORANGEYELLOW) {
             goodPix++;
         } else if (pix != GREY)
             badPix++;
     }
     for (int i = 0; i < w; i++) {
-        pix = thresh->thresholded[y+h/2][x + i];
+        pix = thresh->getColor(x + i, y+h/2);
         if (pix == ORANGE || pix == ORANGERED || pix == ORANGEYELLOW) {
             goodPix++;
         } else if (pix != GREY) {
@@ -849,7 +849,7 @@ pair<int, int> Ball::scanDiagonalsForRoundnessInformation(Blob b) {
     int d3 = min(w, h);
     pair<int, int> info;
     for (int i = 0; i < d3; i++) {
-        pix = thresh->thresholded[y+i][x+i];
+        pix = thresh->getColor(x+i, y+i);
         if (i < d || (i > d3 - d)) {
             if (pix == ORANGE || pix == ORANGERED) {
                 //drawPoint(x+i, y+i, BLACK);
@@ -865,7 +865,7 @@ pair<int, int> Ball::scanDiagonalsForRoundnessInformation(Blob b) {
                 //drawPoint(x+i, y+i, PINK);
             }
         }
-        pix = thresh->thresholded[y+i][x+w-i];
+        pix = thresh->getColor(x+w-i, y+i);
         if (i < d || (i > d3 - d)) {
             if (pix == ORANGE || pix == ORANGERED) {
                 //drawPoint(x+w-i, y+i, BLACK);
@@ -917,7 +917,7 @@ bool Ball::badSurround(Blob b) {
 	h = h + surround * 2;
 	for (int i = 0; i < w && x + i < IMAGE_WIDTH; i++) {
 		for (int j = 0; j < h && y + j < IMAGE_HEIGHT; j++) {
-			pix = thresh->thresholded[y + j][x + i];
+			pix = thresh->getColor(x + i, y + j);
 			if (pix == ORANGE || pix == ORANGEYELLOW) {
 				orange++;
                 if (x + i >= b.getLeft() && x + i <= b.getRight() &&
@@ -22,57 +22,86 @@
 */
 
 #include <iostream>
+#include <algorithm>
+#include "VisionDef.h"
 #include "Blob.h"
 #include "Blobs.h"
 
 //using namespace std;
 
-Blobs::Blobs(int howMany) {
-	total = howMany;
-	blobs = (Blob*)malloc(sizeof(Blob) * howMany);
-	for (int i = 0; i < howMany; i++) {
-		blobs[i] = Blob();
-	}
+static const int WHAT_IS_CONTIGUOUS = 4;  // fudge factor for juding contiguity
+
+/*
+ * @param howMany     the most blobs we will hand out, if there are more
+ *                    components than this the smallest ones are dropped
+ * @param maxRuns     the most runs that will be fed to blobIt per frame
+ */
+Blobs::Blobs(int howMany, int maxRuns)
+	: total(howMany), runCapacity(maxRuns), numberOfRuns(0),
+	  droppedRuns(0), firstColumn(IMAGE_WIDTH), lastColumn(-1), dirty(false), numBlobs(0), droppedBlobs(0)
+{
+	runs = new BlobRun[runCapacity];
+	byColumn = new int[runCapacity];
+	spans = new Span[runCapacity];
+	columnStart = new int[IMAGE_WIDTH + 1];
+	spanStart = new int[IMAGE_WIDTH + 1];
+	rootPixels = new int[runCapacity];
+	blobs = new Blob[total];
 	init();
 }
 
+Blobs::~Blobs()
+{
+	delete [] runs;
+	delete [] byColumn;
+	delete [] spans;
+	delete [] columnStart;
+	delete [] spanStart;
+	delete [] rootPixels;
+	delete [] blobs;
+}
 
 void Blobs::init() {
-	for (int i = 0; i < total; i++) {
+	// only the blobs we handed out last frame can be dirty
+	for (int i = 0; i < numBlobs; i++) {
 		blobs[i].init();
 	}
 	numBlobs = 0;
+	droppedBlobs = 0;
+	numberOfRuns = 0;
+	droppedRuns = 0;
+	firstColumn = IMAGE_WIDTH;
+	lastColumn = -1;
+	dirty = false;
 }
 
 void Blobs::setLeft(int i, int x) {
+	build();
 	blobs[i].setLeftTopX(x);
 	blobs[i].setLeftBottomX(x);
 }
 
 void Blobs::setRight(int i, int x) {
+	build();
 	blobs[i].setRightTopX(x);
 	blobs[i].setRightBottomX(x);
 }
 
 void Blobs::setTop(int i, int y) {
+	build();
 	blobs[i].setLeftTopY(y);
 	blobs[i].setRightTopY(y);
 }
 
 void Blobs::setBottom(int i, int y) {
+	build();
 	blobs[i].setLeftBottomY(y);
 	blobs[i].setRightBottomY(y);
 }
 
 /*
- * Pseudo-blobbing used for goal recognition.  Since the goals are rectangles we
- * should be able to just paste the new runs in to a main blob directly.
- * This uses the huge hack that our objects (except the ball) are square - so we
- * can just keep a bounding box.
- *
- * Basically we are collecting runs.  Everytime we get one we either add it to
- * an existing run or create a new run. In theory we can fragment runs this way.
- * In fact, we should probably check on that.
+ * Collect a run.  It is joined with its neighbors when the blobs are next
+ * built, see join().
  *
  * @param x        x value of run
  * @param y        y value of run
@@ -80,92 +109,241 @@ void Blobs::setBottom(int i, int y) {
 */
 void Blobs::blobIt(int x, int y, int h)
 {
-    const int WHAT_IS_CONTIGUOUS = 4;  // fudge factor for juding contiguity
-    const int MIN_BLOB_SIZE = 20;      // number of blobs before changing standard
-
-    // start out deciding to make a new blob
-    // the loop will decide not to run it
-    bool newBlob = true;
-    int contig = WHAT_IS_CONTIGUOUS;
-
-    //cout << x << " " << y << " " << h << endl;
-    // sanity check: too many blobs on screen
-    if (numBlobs >= total) {
-        //cout << "Ran out of blob space " << color << endl;
-        // We're seeing too many blobs -it is unlikely we can do anything
-        // useful with this color
-        numBlobs = 0;
-        numberOfRuns = 0;
+    if (numberOfRuns >= runCapacity || x < 0 || x >= IMAGE_WIDTH) {
+        // shouldn't happen with the capacities the callers give us, but
+        // count it rather than losing it without a trace
+        droppedRuns++;
         return;
-    } else if (numBlobs > MIN_BLOB_SIZE) {
-        contig = WHAT_IS_CONTIGUOUS;
     }
 
-    // is this run contiguous with any previous blob?
-    for (int i = 0; i < numBlobs; i++) {
+    const int r = numberOfRuns++;
+    BlobRun& run = runs[r];
+    run.x = x;
+    run.y = y;
+    run.h = h;
+    run.parent = r;
+    run.size = 1;
+    run.left = x;
+    run.right = x;
+    run.top = y;
+    run.bottom = y + h;
+    run.pixels = h;
+    run.built = false;
+    firstColumn = std::min(firstColumn, x);
+    lastColumn = std::max(lastColumn, x);
+    dirty = true;
+}
+
+/*
+ * Join every pair of runs less than WHAT_IS_CONTIGUOUS columns apart whose
+ * vertical extents come within WHAT_IS_CONTIGUOUS pixels of each other.
+ *
+ * The runs are counting sorted into columns and each column is sorted by y;
+ * the scanners hand them over one column at a time, top to bottom or bottom
+ * to top, so that is a reverse at most.  Touching runs within a column are
+ * joined and merged into a span.  A column's spans are then at least
+ * WHAT_IS_CONTIGUOUS apart, and a run touches a span exactly when it
+ * touches one of the span's runs, so two columns can be joined by walking
+ * down both span lists together, as in a merge, rather than comparing every
+ * run with every other.
+ */
+void Blobs::join() const
+{
+    const int contig = WHAT_IS_CONTIGUOUS;
+    // only columns first to last - 1 are used
+    const int first = firstColumn;
+    const int last = lastColumn + 1;
+
+    for (int c = first; c <= last; c++) {
+        columnStart[c] = 0;
+    }
+    for (int i = 0; i < numberOfRuns; i++) {
+        columnStart[runs[i].x + 1]++;
+    }
+    for (int c = first; c < last; c++) {
+        columnStart[c + 1] += columnStart[c];
+        spanStart[c] = columnStart[c];
+    }
+    // spanStart is each column's next free slot for now
+    for (int i = 0; i < numberOfRuns; i++) {
+        byColumn[spanStart[runs[i].x]++] = i;
+    }
 
-        // first check: if currentBlob x is greater than blob left and less than
-        // a little bit more than the blob right.
-        // AND
-        // second check: currentBlob y is within fits within current blob
-        // OR
-        // currentBlob's bottom is within blob and height makes it higher
-        if ((x > blobs[i].getLeftTopX()  && x < blobs[i].getRightTopX()
-			 + contig) && ((y >= blobs[i].getLeftTopY() - contig &&
-							y < blobs[i].getLeftBottomY() + contig) ||
-						   (y < blobs[i].getLeftTopY() &&
-							y+h+contig > blobs[i].getLeftTopY()))) {
-
-            /* BOUNDING BOX CHECKS
-             * if current x or y increases the size of the box, do so and keep
-             * track of the corresponding x or y value
-             */
-            //assign the right, if it is better
-            if (x > blobs[i].getRightTopX()) {
-                blobs[i].setRightTopX(x);
-                blobs[i].setRightBottomX(x);
+    RunTop byTop = { runs };
+
+    int numSpans = 0;
+    for (int c = first; c < last; c++) {
+        int* begin = byColumn + columnStart[c];
+        int* end = byColumn + columnStart[c + 1];
+        spanStart[c] = numSpans;
+        if (begin == end) {
+            continue;
+        }
+        if (runs[*begin].y > runs[*(end - 1)].y) {
+            std::reverse(begin, end);
+        }
+        for (int* i = begin + 1; i < end; ++i) {
+            if (runs[*(i - 1)].y > runs[*i].y) {
+                std::sort(begin, end, byTop);
+                break;
             }
+        }
 
-            //assign the top, if it is better
-            if (blobs[i].getLeftTopY() > y) {
-                blobs[i].setLeftTopY(y);
-                blobs[i].setRightTopY(y);
+        Span span = { runs[*begin].y, runs[*begin].y + runs[*begin].h,
+                      *begin };
+        for (int* i = begin + 1; i < end; ++i) {
+            const BlobRun& run = runs[*i];
+            if (run.y < span.bottom + contig) {
+                unite(span.run, *i);
+                span.bottom = std::max(span.bottom, run.y + run.h);
+            } else {
+                spans[numSpans++] = span;
+                span.top = run.y;
+                span.bottom = run.y + run.h;
+                span.run = *i;
             }
+        }
+        spans[numSpans++] = span;
+    }
+    spanStart[last] = numSpans;
 
-            // assign the bottom, if it is better
-            if (y+h > blobs[i].getLeftBottomY()) {
-                blobs[i].setLeftBottomY(y+h);
-                blobs[i].setRightBottomY(y + h);
+    for (int c = first; c < last; c++) {
+        const Span* a = spans + spanStart[c];
+        const Span* aEnd = spans + spanStart[c + 1];
+        if (a == aEnd) {
+            continue;
+        }
+        for (int d = 1; d < contig && c + d < last; d++) {
+            const Span* i = a;
+            const Span* j = spans + spanStart[c + d];
+            const Span* jEnd = spans + spanStart[c + d + 1];
+            while (i < aEnd && j < jEnd) {
+                if (i->top < j->bottom + contig &&
+                    j->top < i->bottom + contig) {
+                    unite(i->run, j->run);
+                }
+                if (i->bottom < j->bottom) {
+                    ++i;
+                } else {
+                    ++j;
+                }
             }
+        }
+    }
+}
 
-            //add the run length to the number of real pixels in the blob
-            //calculate the area of this blob under consideration
-            int s = (blobs[i].getRightTopX() - blobs[i].getLeftTopX() + 1) *
-                (blobs[i].getLeftBottomY() - blobs[i].getLeftTopY() + 1);
-            blobs[i].setArea(s); //store the area for later.
-            blobs[i].setPixels(blobs[i].getPixels() + h);
+/* Find the root of a run's set, halving the path on the way up.
+ */
+int Blobs::find(int i) const
+{
+    while (runs[i].parent != i) {
+        runs[i].parent = runs[runs[i].parent].parent;
+        i = runs[i].parent;
+    }
+    return i;
+}
+
+/* Join the sets of two runs, the smaller set goes under the larger.
+ */
+void Blobs::unite(int a, int b) const
+{
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return;
+    }
+    if (runs[a].size < runs[b].size) {
+        std::swap(a, b);
+    }
+    BlobRun& root = runs[a];
+    const BlobRun& other = runs[b];
+    runs[b].parent = a;
+    root.size += other.size;
+    root.left = std::min(root.left, other.left);
+    root.right = std::max(root.right, other.right);
+    root.top = std::min(root.top, other.top);
+    root.bottom = std::max(root.bottom, other.bottom);
+    root.pixels += other.pixels;
+}
+
+/*
+ * Turn the run sets into blobs, one per set, in the order each set's first
+ * run came in (left to right, as the scanners go).  Union by size picks
+ * the roots, so we go by the runs rather than the roots.  Nothing happens
+ * unless runs were added since the last build, so anything the callers do
+ * to the blobs afterwards (init, setLeft, mergeBlobs, ...) sticks.  If
+ * there are more components than blob slots we keep the ones with the
+ * most pixels and remember how many we dropped.
+ */
+void Blobs::build() const
+{
+    if (!dirty) {
+        return;
+    }
+    dirty = false;
+    join();
 
-            // don't create a blob
-            newBlob = false;
-            break;
+    int roots = 0;
+    for (int i = 0; i < numberOfRuns; i++) {
+        if (runs[i].parent == i) {
+            rootPixels[roots++] = runs[i].pixels;
+            runs[i].built = false;
+        }
+    }
+
+    // smallest pixel count that still makes the cut
+    int cutoff = 0;
+    int atCutoff = total;
+    droppedBlobs = 0;
+    if (roots > total) {
+        droppedBlobs = roots - total;
+        std::nth_element(rootPixels, rootPixels + droppedBlobs,
+                         rootPixels + roots);
+        cutoff = rootPixels[droppedBlobs];
+        // how many of the blobs with exactly cutoff pixels we can keep
+        atCutoff = 0;
+        for (int i = droppedBlobs; i < roots; i++) {
+            if (rootPixels[i] == cutoff) {
+                atCutoff++;
+            }
+        }
+    }
+
+    for (int i = 0; i < numBlobs; i++) {
+        blobs[i].init();
+    }
+    numBlobs = 0;
+    for (int i = 0; i < numberOfRuns && numBlobs < total; i++) {
+        BlobRun& root = runs[find(i)];
+        if (root.built) {
+            continue;
+        }
+        root.built = true;
+        if (root.pixels < cutoff) {
+            continue;
+        }
+        if (root.pixels == cutoff) {
+            if (atCutoff == 0) {
+                continue;
+            }
+            atCutoff--;
+        }
+        Blob& blob = blobs[numBlobs++];
+        blob.setLeftTopX(root.left);
+        blob.setLeftTopY(root.top);
+        blob.setRightTopX(root.right);
+        blob.setRightTopY(root.top);
+        blob.setLeftBottomX(root.left);
+        blob.setLeftBottomY(root.bottom);
+        blob.setRightBottomX(root.right);
+        blob.setRightBottomY(root.bottom);
+        blob.setPixels(root.pixels);
+        if (root.size == 1) {
+            blob.setArea(root.h);
+        } else {
+            blob.setArea((root.right - root.left + 1) *
+                         (root.bottom - root.top + 1));
         }
-        // no else
-    } // END blob for loop
-
-    // create newBlob
-    if (newBlob) {
-        // bounding box
-        blobs[numBlobs].setLeftTopX(x);
-        blobs[numBlobs].setLeftTopY(y);
-        blobs[numBlobs].setRightTopX(x);
-        blobs[numBlobs].setRightTopY(y);
-        blobs[numBlobs].setLeftBottomX(x);
-        blobs[numBlobs].setLeftBottomY(y + h);
-        blobs[numBlobs].setRightBottomX(x);
-        blobs[numBlobs].setRightBottomY(y + h);
-        blobs[numBlobs].setPixels(h);
-        blobs[numBlobs].setArea(h);
-        numBlobs++;
     }
 }
 
@@ -178,6 +356,7 @@ void Blobs::blobIt(int x, int y, int h)
 */
 Blob* Blobs::getTopAndMerge(int maxY)
 {
+    build();
     Blob* topBlob = NULL;
     int size = 0;
     //check each blob in the array
@@ -195,6 +374,7 @@ Blob* Blobs::getTopAndMerge(int maxY)
 */
 Blob* Blobs::getWidest()
 {
+    build();
     Blob* topBlob = NULL;
     int size = 0;
     int width = 0;
@@ -215,6 +395,7 @@ Blob* Blobs::getWidest()
 
 void Blobs::zeroTheBlob(int which)
 {
+	build();
 	blobs[which].init();
     blobs[which].setLeftTopX(BADONE);
 }
@@ -226,6 +407,7 @@ void Blobs::zeroTheBlob(int which)
 */
 void Blobs::mergeBlobs(int first, int second)
 {
+	build();
 	blobs[first].merge(blobs[second]);
 	zeroTheBlob(second);
 }
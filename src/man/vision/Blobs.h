@@ -10,13 +10,25 @@ using namespace std;
 
 static const int BADONE = -10000;
 
+/*
+ * Connected components over runs.  Every run handed to blobIt() goes into a
+ * preallocated run arena.  When someone finally asks for the blobs, the runs
+ * are bucketed by column and sorted by y, each column's touching runs are
+ * merged into spans, and spans in columns close enough to touch are joined
+ * (union-find) in one sweep down each pair of columns.  Each set keeps its
+ * bounding box and pixel count at its root, so the blobs can then be read
+ * straight off the roots.
+ *
+ * Runs may come in any order, and the whole thing is linear in the number
+ * of runs.
+ */
 class Blobs {
 public:
-    Blobs(int howMany);
-    virtual ~Blobs() {}
+    Blobs(int howMany, int maxRuns);
+    virtual ~Blobs();
 
 	void init();
-	void init(int which) {blobs[which].init();}
+	void init(int which) {build(); blobs[which].init();}
 	void blobIt(int x, int y, int h);
 	void setLeft(int which, int a);
 	void setRight(int which, int a);
@@ -28,19 +40,58 @@ public:
 	void mergeBlobs(int first, int second);
 
 // getters
-	int number() const {return numBlobs;}
-	Blob get(int which) const {return blobs[which];}
+	int number() const {build(); return numBlobs;}
+	Blob get(int which) const {build(); return blobs[which];}
+	int dropped() const {build(); return droppedBlobs + droppedRuns;}
 
 private:
+	struct BlobRun {
+		int x, y, h;
+		int parent;
+		int size;
+		// component data, only valid at a root
+		int left, right, top, bottom;
+		int pixels;
+		bool built;
+	};
+
+	// A column's runs that touch one another, top to bottom + 1
+	struct Span {
+		int top, bottom;
+		int run;
+	};
+
+	// Orders run indices by y
+	struct RunTop {
+		const BlobRun* runs;
+		bool operator()(int a, int b) const { return runs[a].y < runs[b].y; }
+	};
+
+	int find(int i) const;
+	void unite(int a, int b) const;
+	void join() const;
+	void build() const;
+
 	int total;
-    int runsize;
-    int biggestRun;
-    int maxHeight;
-    int maxOfBiggestRun;
-    int numberOfRuns;
-    int indexOfBiggestRun;
-    int numBlobs;
-    //blob checker, obj, pole, leftBox, rightBox;
-    Blob* blobs;
+	int runCapacity;
+	int numberOfRuns;
+	int droppedRuns;
+	// the columns runs have come in
+	int firstColumn, lastColumn;
+	BlobRun* runs;
+
+	// the runs by column then y, each column's spans, and where each
+	// column starts in both
+	int* byColumn;
+	Span* spans;
+	int* columnStart;
+	int* spanStart;
+
+	// built on demand from the run sets
+	mutable bool dirty;
+	mutable int numBlobs;
+	mutable int droppedBlobs;
+	mutable int* rootPixels;
+	Blob* blobs;
 };
 #endif
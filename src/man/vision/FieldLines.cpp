@@ -171,7 +171,10 @@ void FieldLines::lineLoop()
     // unusedPoints is used by vision to draw points on the screen
 	PROF_ENTER(profiler,P_FIT_UNUSED);
     unusedPointsList = linePoints;
-	fitUnusedPoints(linesList, unusedPointsList);
+    // Nice to have, but it's the first thing to go when we're running late
+    if (!vision->frameBudget->degraded(FrameBudget::SKIP_FIT_UNUSED)) {
+        fitUnusedPoints(linesList, unusedPointsList);
+    }
 	PROF_EXIT(profiler,P_FIT_UNUSED);
 
 	removeDuplicateLines();
@@ -235,9 +238,14 @@ void FieldLines::findVerticalLinePoints(vector <linePoint> &points)
     }
 
 
+    // Late frames only look at every other column
+    const int colSkip =
+        vision->frameBudget->degraded(FrameBudget::COARSE_COLUMNS) ?
+        2 * COL_SKIP : COL_SKIP;
+
     // We ensure that we scan the last column of the image; often very valuable
     // information there
-    for (int x = 0; x < IMAGE_WIDTH + COL_SKIP - 1; x += COL_SKIP) {
+    for (int x = 0; x < IMAGE_WIDTH + colSkip - 1; x += colSkip) {
         if (x > IMAGE_WIDTH - 1) {
             x = IMAGE_WIDTH - 1;
         }
@@ -263,7 +271,7 @@ void FieldLines::findVerticalLinePoints(vector <linePoint> &points)
 
 
             const int current_y_value = vision->thresh->getY(x,y);
-            const int thresholdedColor = vision->thresh->thresholded[y][x];
+            const int thresholdedColor = vision->thresh->getColor(x, y);
 
             const bool isAtAnUphillEdge = isUphillEdge(current_y_value, last_y_value,
                                                        VERTICAL);
@@ -468,7 +476,7 @@ void FieldLines::findHorizontalLinePoints(vector <linePoint> &points)
         // starting edge value
         for (int x = 1; x < IMAGE_WIDTH - 1; x++) {
             const int current_y_value = vision->thresh->getY(x,y);
-            const int thresholdedColor = vision->thresh->thresholded[y][x];
+            const int thresholdedColor = vision->thresh->getColor(x, y);
 
             const bool isAtAnUphillEdge = isUphillEdge(current_y_value,
                                                        last_y_value,
@@ -1626,7 +1634,7 @@ void FieldLines::extendLineVertScan(ExtendDirection _testDir,
         // lastX, lastY, curX, curY
         if (shouldStopExtendingLine(lastPoint.x, lastPoint.y, curX, curY)) {
             break;
-        } else if (!isLineColor(vision->thresh->thresholded[curY][curX])) {
+        } else if (!isLineColor(vision->thresh->getColor(curX, curY))) {
             continue;
         }
         // Since we are scanning top to bottom, we are looking for HORIZONTAL
@@ -1736,7 +1744,7 @@ void FieldLines::extendLineHorizScan(ExtendDirection _testDir,
         // lastX, lastY, curX, curY
         if (shouldStopExtendingLine(lastX, lastY, curX, curY)) {
             break;
-        } else if (!isLineColor(vision->thresh->thresholded[curY][curX])) {
+        } else if (!isLineColor(vision->thresh->getColor(curX, curY))) {
             continue;
         }
         // Since we are scanning top to bottom, we are looking for VERTICAL
@@ -1970,8 +1978,8 @@ const int FieldLines::findEdgeFromMiddleOfLine(int x, int y,
                 return j;
             }
             // We're in the field but we didn't see an edge.  No good.
-            else if (!isLineColor(vision->thresh->thresholded[j][x])) {
-                //      else if (vision->thresh->thresholded[j][x] == GREEN) {
+            else if (!isLineColor(vision->thresh->getColor(x, j))) {
+                //      else if (vision->thresh->getColor(x, j) == GREEN) {
                 return NO_EDGE;
             }
             oldYChannel = newYChannel;
@@ -2005,7 +2013,7 @@ const int FieldLines::findEdgeFromMiddleOfLine(int x, int y,
                 return i;
             }
             // We're in the field but we didn't see an edge.  No good.
-            else if (vision->thresh->thresholded[y][i] == GREEN) {
+            else if (vision->thresh->getColor(i, y) == GREEN) {
                 return NO_EDGE;
             }
             oldYChannel = newYChannel;
@@ -3057,7 +3065,7 @@ const bool FieldLines::dangerousEdgeCorner(const VisualCorner& corner,
     int numPixelsSeen = 0;
 	for (int dy = startY; dy < endY ; dy+=PIXELS_TO_SKIP){
 		for (int dx = startX; dx < endX ; dx+=PIXELS_TO_SKIP){
-			if (vision->thresh->thresholded[dy][dx] != GREEN)
+			if (vision->thresh->getColor(dx, dy) != GREEN)
 				nonGreenCount++;
             numPixelsSeen++;
 		}
@@ -3745,7 +3753,7 @@ int FieldLines::numPixelsToHitColor(const int x, const int y,
 
         while (Utility::isPointOnScreen(x, y + (sign * count))) {
             for (int j = 0; j < numColors; ++j) {
-                if (vision->thresh->thresholded[y + sign * count][x] ==
+                if (vision->thresh->getColor(x, y + sign * count) ==
                     colors[j]) {
                     // We found it
                     return count;
@@ -3766,7 +3774,7 @@ int FieldLines::numPixelsToHitColor(const int x, const int y,
 
         while (Utility::isPointOnScreen(x + (sign * count), y)) {
             for (int j = 0; j < numColors; ++j) {
-                if (vision->thresh->thresholded[y][x + sign * count] ==
+                if (vision->thresh->getColor(x + sign * count, y) ==
                     colors[j]) {
                     // We found it
                     return count;
@@ -3858,7 +3866,7 @@ void FieldLines::printThresholdedImage()
 
         for(int x = 0; x < IMAGE_WIDTH; x++) {
             fprintf(stream, "%03d%s\t", vision->thresh->getY(x,y),
-                    Threshold::getShortColor(vision->thresh->thresholded[y][x]));
+                    Threshold::getShortColor(vision->thresh->getColor(x, y)));
             // we're done this row, skip down
             if (x >= IMAGE_WIDTH - 1) { fprintf(stream, "\n"); }
         }
@@ -4348,7 +4356,7 @@ const float FieldLines::percentSurrounding(const int x, const int y,
             // Search for the color at that pixel within the vector of
             // acceptable colors
             for (int k = 0; k < numColors; ++k) {
-                if (colors[k] == vision->thresh->thresholded[j][i]) {
+                if (colors[k] == vision->thresh->getColor(i, j)) {
                     ++numFound;
                     break;
                 }
@@ -4419,7 +4427,7 @@ const float FieldLines::percentColorBetween(const int x1, const int y1,
         if (y2 < y1)
             sign = -1;
         for (int j = y1; j != y2; j += sign, ++totalPixels) {
-            if (Utility::isElementInArray(vision->thresh->thresholded[j][x2],
+            if (Utility::isElementInArray(vision->thresh->getColor(x2, j),
                                           colors, numColors)) {
                 ++numFound;
             }
@@ -4440,7 +4448,7 @@ const float FieldLines::percentColorBetween(const int x1, const int y1,
 					static_cast<int>( (slope * static_cast<float>(i - y1)) );
 
                 if (Utility::isElementInArray(vision->thresh->
-                                              thresholded[i][newx],
+                                              getColor(newx, i),
                                               colors, numColors))
                     ++numFound;
             }
@@ -4454,7 +4462,7 @@ const float FieldLines::percentColorBetween(const int x1, const int y1,
                 int newy = y1 +
 					static_cast<int>( (slope * static_cast<float>(i - x1)) );
                 if (Utility::isElementInArray(vision->thresh->
-                                              thresholded[newy][i],
+                                              getColor(i, newy),
                                               colors, numColors))
                     ++numFound;
             }
@@ -4466,7 +4474,7 @@ const float FieldLines::percentColorBetween(const int x1, const int y1,
             for (int i = startX; i <= endX; ++i) {
                 ++totalPixels;
                 if (Utility::isElementInArray(vision->thresh->
-                                              thresholded[y2][i],
+                                              getColor(i, y2),
                                               colors, numColors))
                     ++numFound;
             }
@@ -4503,7 +4511,7 @@ const bool FieldLines::isColorBetween(const int x1, const int y1,
         for (int j = y1; j != y2; j += sign) {
             bool foundInLine = false;
             for (int testX = x2 - SCAN_RADIUS; testX <= x2 + SCAN_RADIUS; ++testX){
-                if (Utility::isElementInArray(vision->thresh->thresholded[j][x2],
+                if (Utility::isElementInArray(vision->thresh->getColor(x2, j),
                                               colors, numColors)) {
                     foundInLine = true;
                 }
@@ -4541,7 +4549,7 @@ const bool FieldLines::isColorBetween(const int x1, const int y1,
                 for (int testX = newX - SCAN_RADIUS; testX <= newX + SCAN_RADIUS; ++testX){
 
                     if (Utility::isElementInArray(vision->thresh->
-                                                  thresholded[i][testX],
+                                                  getColor(testX, i),
                                                   colors, numColors)){
                         foundInLine = true;
                         break;
@@ -4568,7 +4576,7 @@ const bool FieldLines::isColorBetween(const int x1, const int y1,
 					static_cast<int>( (slope * static_cast<float>(i - x1)) );
                 for (int testY = newY - SCAN_RADIUS; testY <= newY + SCAN_RADIUS; ++testY){
                     if (Utility::isElementInArray(vision->thresh->
-                                              thresholded[testY][i],
+                                              getColor(i, testY),
                                                   colors, numColors)){
                         foundInLine = true;
                         break;
@@ -4595,7 +4603,7 @@ const bool FieldLines::isColorBetween(const int x1, const int y1,
                 bool foundInLine = false;
                 for (int testY = y2 - SCAN_RADIUS; testY <= y2 + SCAN_RADIUS; ++testY){
                     if (Utility::isElementInArray(vision->thresh->
-                                                  thresholded[testY][i],
+                                                  getColor(i, testY),
                                                   colors, numColors)){
                         foundInLine = true;
                         break;
@@ -4644,7 +4652,7 @@ const float FieldLines::percentColor(const int x, const int y,
         for (int i = y + sign; numTotal < numPixels &&
                  i < IMAGE_HEIGHT && i >= 0; i += sign, ++numTotal) {
             for (int j = 0; j < numColors; ++j) {
-                if (colors[j] == vision->thresh->thresholded[i][x]) {
+                if (colors[j] == vision->thresh->getColor(x, i)) {
                     ++numFound;
                     break;
                 }
@@ -4660,7 +4668,7 @@ const float FieldLines::percentColor(const int x, const int y,
         for (int i = x + sign; numTotal < numPixels &&
                  i < IMAGE_WIDTH && i >= 0; i += sign, ++numTotal) {
             for (int j = 0; j < numColors; ++j) {
-                if (colors[j] == vision->thresh->thresholded[y][i]) {
+                if (colors[j] == vision->thresh->getColor(i, y)) {
                     ++numFound;
                     break;
                 }
@@ -0,0 +1,157 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+
+#include "FrameBudget.h"
+
+static const char* TIER_NAMES[FrameBudget::NUM_TIERS] = {
+    "full quality",
+    "skip fitUnusedPoints",
+    "coarse line columns"
+};
+
+FrameBudget::FrameBudget(long long (*f)(), long long _budget)
+    : timeFunction(f), budget(_budget), enabled(true),
+      tier(FULL_QUALITY), startTier(FULL_QUALITY), frameStart(0),
+      lastFrameTime(0), onTimeStreak(0)
+{
+    pthread_mutex_init(&countsMutex, NULL);
+    resetCounts();
+}
+
+FrameBudget::~FrameBudget()
+{
+    pthread_mutex_destroy(&countsMutex);
+}
+
+void FrameBudget::startFrame()
+{
+    frameStart = timeFunction();
+    tier = startTier;
+}
+
+void FrameBudget::checkpoint(float expectedFraction)
+{
+    if (!enabled) {
+        return;
+    }
+    const long long elapsed = timeFunction() - frameStart;
+    if (elapsed > static_cast<long long>(expectedFraction * budget)) {
+        lower();
+    }
+}
+
+/* Tally up the frame and decide what the next one starts at.  An overrun
+ * sticks for the next frame since cluttered scenes tend to stay cluttered
+ * for a while; coming back up is slower so we don't flap between tiers.
+ */
+void FrameBudget::endFrame()
+{
+    lastFrameTime = timeFunction() - frameStart;
+    const bool late = enabled && lastFrameTime > budget;
+
+    pthread_mutex_lock(&countsMutex);
+    frames++;
+    tierFrames[tier]++;
+    if (late) {
+        lateFrames++;
+    }
+    pthread_mutex_unlock(&countsMutex);
+
+    if (!enabled) {
+        return;
+    }
+
+    if (late) {
+        onTimeStreak = 0;
+        startTier = tier < NUM_TIERS - 1 ? static_cast<Tier>(tier + 1) : tier;
+    } else if (lastFrameTime * 100 < budget * (100 - RECOVER_SLACK_PERCENT)) {
+        onTimeStreak++;
+        if (onTimeStreak >= RECOVER_FRAMES && startTier > FULL_QUALITY) {
+            startTier = static_cast<Tier>(startTier - 1);
+            onTimeStreak = 0;
+        }
+    } else {
+        onTimeStreak = 0;
+    }
+}
+
+void FrameBudget::lower()
+{
+    if (tier < NUM_TIERS - 1) {
+        tier = static_cast<Tier>(tier + 1);
+    }
+}
+
+void FrameBudget::resetCounts()
+{
+    pthread_mutex_lock(&countsMutex);
+    frames = 0;
+    lateFrames = 0;
+    for (int i = 0; i < NUM_TIERS; i++) {
+        tierFrames[i] = 0;
+    }
+    pthread_mutex_unlock(&countsMutex);
+}
+
+int FrameBudget::getFrames() const
+{
+    pthread_mutex_lock(&countsMutex);
+    const int n = frames;
+    pthread_mutex_unlock(&countsMutex);
+    return n;
+}
+
+int FrameBudget::getLateFrames() const
+{
+    pthread_mutex_lock(&countsMutex);
+    const int n = lateFrames;
+    pthread_mutex_unlock(&countsMutex);
+    return n;
+}
+
+int FrameBudget::getTierFrames(Tier t) const
+{
+    pthread_mutex_lock(&countsMutex);
+    const int n = tierFrames[t];
+    pthread_mutex_unlock(&countsMutex);
+    return n;
+}
+
+void FrameBudget::printSummary() const
+{
+    // copy the counts so they add up, vision keeps counting meanwhile
+    pthread_mutex_lock(&countsMutex);
+    const int n = frames;
+    const int late = lateFrames;
+    int perTier[NUM_TIERS];
+    for (int i = 0; i < NUM_TIERS; i++) {
+        perTier[i] = tierFrames[i];
+    }
+    pthread_mutex_unlock(&countsMutex);
+
+    printf("Vision frame budget: %lldus, %s\n", budget,
+           enabled ? "enabled" : "disabled");
+    printf("  %i frames, %i over budget\n", n, late);
+    for (int i = 0; i < NUM_TIERS; i++) {
+        printf("  %-22s: %6i frames (%5.1f%%)\n", TIER_NAMES[i], perTier[i],
+               n > 0 ? 100.0f * perTier[i] / n : 0.0f);
+    }
+}
@@ -0,0 +1,106 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Per-frame time budget for the vision loop.
+ *
+ * Threshold::visionLoop() checks in with the budget between its stages.  If
+ * a stage finishes later than its share of the budget the rest of the frame
+ * runs at a cheaper quality tier, and a frame that overruns the whole budget
+ * starts the next one a tier down as well.  After enough frames with time to
+ * spare we climb back up, one tier at a time.
+ *
+ * The tiers are cumulative, each one drops everything the ones before it
+ * dropped:
+ *   SKIP_FIT_UNUSED   FieldLines skips fitUnusedPoints()
+ *   COARSE_COLUMNS    FieldLines scans every other vertical line column
+ *
+ * The number of frames each tier was in effect for is kept so the accuracy
+ * we give up is something we choose, not something that just happens.  The
+ * counts are written by vision and reset and read from Python, so they sit
+ * behind a mutex; the tiers themselves are only touched by vision.
+ */
+
+#ifndef FrameBudget_h_DEFINED
+#define FrameBudget_h_DEFINED
+
+#include <pthread.h>
+
+class FrameBudget
+{
+public:
+    enum Tier {
+        FULL_QUALITY = 0,
+        SKIP_FIT_UNUSED,
+        COARSE_COLUMNS,
+        NUM_TIERS
+    };
+
+    // Vision's share of a 30fps frame, the brain needs the rest
+    static const long long DEFAULT_BUDGET = 20000;
+    // On time frames, with this much slack, before going up a tier
+    static const int RECOVER_FRAMES = 30;
+    static const int RECOVER_SLACK_PERCENT = 30;
+
+    FrameBudget(long long (*f)(), long long budget = DEFAULT_BUDGET);
+    ~FrameBudget();
+
+    void startFrame();
+    // The stage that just finished should have been done by this fraction
+    // of the budget; if it wasn't, drop a tier for the rest of the frame.
+    void checkpoint(float expectedFraction);
+    void endFrame();
+
+    // Is the given tier (or a cheaper one) in effect this frame?
+    bool degraded(Tier t) const { return enabled && tier >= t; }
+
+    Tier getTier() const { return tier; }
+    long long getBudget() const { return budget; }
+    void setBudget(long long b) { budget = b; }
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool e) { enabled = e; }
+
+    int getFrames() const;
+    int getLateFrames() const;
+    int getTierFrames(Tier t) const;
+    long long getLastFrameTime() const { return lastFrameTime; }
+
+    void resetCounts();
+    void printSummary() const;
+
+private:
+    void lower();
+
+    long long (*timeFunction)();
+    long long budget;
+    bool enabled;
+
+    Tier tier;          // in effect for the current frame
+    Tier startTier;     // what the next frame starts at
+    long long frameStart;
+    long long lastFrameTime;
+    int onTimeStreak;
+
+    mutable pthread_mutex_t countsMutex;
+    int frames;
+    int lateFrames;
+    int tierFrames[NUM_TIERS];
+};
+
+#endif /* FrameBudget_h_DEFINED */
@@ -2,6 +2,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <sched.h>
+#include <unistd.h>
 
 #include "Profiler.h"
 
@@ -88,8 +90,8 @@ static const ProfiledComponent PCOMPONENT_SUB_ORDER[] = {
  *
  * After initialization, or a call to reset(), all times are 0, the current
  * frame is 0, and num_profile_frames is -1.  When profiling is on (true), a
- * call to nextFrame() will increase the current_frame counter and add the
- * times recorded for the last frames to the running sums.  If
+ * call to nextFrame() will increase the current_frame counter and fold the
+ * events recorded since the last frame into the statistics.  If
  * num_profile_frames is -1, this will continue forever.  Otherwise, once
  * num_profile_frames frames have been profiled (nextFrame() called that many
  * times, or current_frame == num_total_frames - 1 upon entry to nextFrame()),
@@ -104,30 +106,107 @@ static const ProfiledComponent PCOMPONENT_SUB_ORDER[] = {
  * When automatically stopped by the frame counter in nextFrame(),
  * current_frame is not incremented.  Thus when profiling is manually turned
  * off or when automatically over, current_frame represents THE LAST FRAME
- * profiled (indexing is zero-based).  If this weren't the case, it would be
- * much more difficult to accurately present the current and total frame count
- * in the printing methods.  printSummary() should be called after profiling is
- * false, whether manual or automatic, while current_frame has not been
- * incremented.  printCurrent() should be called before the call to nextFrame()
- * at the end of the desired frame, as nextFrame() resets the lastTime array to
- * all zeros, in order to make sure mid-frame stoppages only result in a
- * lastTime of 0, instead of some wildly large value.
+ * profiled (indexing is zero-based).  printSummary() should be called after
+ * profiling is false, whether manual or automatic.
  *
- * Some of this could probably be made easier by adding individual frame
- * counters for each component, but I think it's overhead and anything more
- * complicated should just use actual C++/gcc/gdb profiling.
+ * Vision, motion and the brain all profile into the same Profiler from their
+ * own threads, so nothing on the PROF_ENTER/PROF_EXIT path is shared between
+ * threads.  Each thread gets its own ring of timestamped events the first
+ * time it records one (or when it calls registerThread()), and the ring is
+ * only ever written by that thread.  aggregate() walks the rings, pairs up
+ * enters and exits per thread, and keeps count, sum, max and a log-linear
+ * histogram for every component on every thread.  Percentiles come from the
+ * histogram, so they are accurate to within a quarter of a power of two;
+ * the max is exact.  Only one aggregate() runs at a time: a caller that
+ * finds another one running just skips its turn.
+ *
+ * Readers (percentile(), maxTime(), the summaries and dumpStats()) never
+ * wait for the aggregator either.  After draining a thread, aggregate()
+ * publishes that thread's statistics into the spare half of its
+ * ProfileSnapshot and bumps the snapshot's seq; readers copy the published
+ * half and only copy it again if the aggregator published while they were
+ * copying, which with one aggregate a frame is next to never.  Only reset() and the trace
+ * calls, which change the aggregator's own state, wait for a running
+ * aggregate().
+ *
+ * Between startTrace() and stopTrace() aggregate() also writes every event
+ * it drains to a Chrome trace-event file, one track per thread, with the
+ * frame number on each span.  A span is written as one complete event when
+ * its exit is drained, so events dropped from a full ring lose whole spans
+ * instead of unbalancing the timeline.  Vision spans longer than
+ * VISION_FRAME_BUDGET get an extra marker so the overruns stand out.  The file
+ * is written from whichever thread aggregates (normally vision, once a
+ * frame), through stdio's buffer.
  *
  * That's all for now, folks.
  */
 
+// Values below this get their own bucket, above it each power of two is split
+// into PROFILE_SUB_BUCKETS buckets (2 bits below the leading one)
+static const int PROFILE_SUB_BITS = 2;
+static const int PROFILE_LINEAR = 2 * PROFILE_SUB_BUCKETS;
+
+static int bucketFor (long long t)
+{
+  if (t < PROFILE_LINEAR)
+    return t < 0 ? 0 : (int)t;
+
+  int exp = 0;
+  while ((t >> (exp + 1)) != 0)
+    exp++;
+  const int sub = (int)(t >> (exp - PROFILE_SUB_BITS)) & (PROFILE_SUB_BUCKETS-1);
+  const int b = PROFILE_LINEAR + (exp - PROFILE_SUB_BITS - 1) *
+    PROFILE_SUB_BUCKETS + sub;
+  return b < PROFILE_BUCKETS ? b : PROFILE_BUCKETS - 1;
+}
+
+// Largest value that lands in bucket b
+static long long bucketTop (int b)
+{
+  if (b < PROFILE_LINEAR)
+    return b;
+  const int exp = (b - PROFILE_LINEAR) / PROFILE_SUB_BUCKETS +
+    PROFILE_SUB_BITS + 1;
+  const int sub = (b - PROFILE_LINEAR) % PROFILE_SUB_BUCKETS;
+  return ((long long)(PROFILE_SUB_BUCKETS + sub + 1) <<
+          (exp - PROFILE_SUB_BITS)) - 1;
+}
+
+static long long statsPercentile (const ProfileStats &s, float p)
+{
+  if (s.count == 0)
+    return 0;
+  const long long rank = (long long)(p * (s.count - 1));
+  long long seen = 0;
+  for (int b = 0; b < PROFILE_BUCKETS; b++) {
+    seen += s.buckets[b];
+    if (seen > rank)
+      return bucketTop(b) < s.max ? bucketTop(b) : s.max;
+  }
+  return s.max;
+}
+
 Profiler::Profiler (long long (*f) ())
-  : timeFunction(f)
+  : timeFunction(f), num_threads(0), aggregating(0), trace_file(NULL),
+    trace_pid(getpid())
 {
+  pthread_key_create(&thread_key, NULL);
+  threads = new ProfileThread[MAX_PROFILE_THREADS];
+  snapshots = new ProfileSnapshot[MAX_PROFILE_THREADS];
+  for (int i = 0; i < MAX_PROFILE_THREADS; i++) {
+    snprintf(threads[i].name, PROFILE_NAME_LENGTH, "thread %i", i);
+    threads[i].head = threads[i].tail = threads[i].dropped = 0;
+    snapshots[i].seq = 0;
+  }
   reset();
 }
 
 Profiler::~Profiler ()
 {
+  stopTrace();
+  pthread_key_delete(thread_key);
+  delete [] threads;
+  delete [] snapshots;
 }
 
 void
@@ -145,11 +224,204 @@ Profiler::reset ()
   num_profile_frames = -1;
   current_frame = 0;
 
-  for (int i = 0; i < NUM_PCOMPONENTS; i++) {
-    enterTime[i] = 0;
-    lastTime[i] = 0;
-    sumTime[i] = 0;
+  // Wait out a running aggregate, then throw away whatever is queued
+  lockStats();
+
+  for (int t = 0; t < MAX_PROFILE_THREADS; t++) {
+    threads[t].tail = threads[t].head;
+    threads[t].dropped = 0;
+    for (int i = 0; i < NUM_PCOMPONENTS; i++) {
+      enterTime[t][i] = -1;
+      memset(&stats[t][i], 0, sizeof(ProfileStats));
+      stale[t][i] = 2;
+    }
+    // through both halves, so readers never see one being cleared
+    publish(t);
+    publish(t);
   }
+
+  unlockStats();
+}
+
+void
+Profiler::lockStats ()
+{
+  while (__sync_lock_test_and_set(&aggregating, 1))
+    sched_yield();
+}
+
+void
+Profiler::unlockStats ()
+{
+  __sync_lock_release(&aggregating);
+}
+
+void
+Profiler::registerThread (const char *name)
+{
+  ProfileThread *t = static_cast<ProfileThread*>(pthread_getspecific(thread_key));
+  if (t == 0)
+    t = claimThread(name);
+  else
+    snprintf(t->name, PROFILE_NAME_LENGTH, "%s", name);
+}
+
+ProfileThread*
+Profiler::currentThread ()
+{
+  ProfileThread *t = static_cast<ProfileThread*>(pthread_getspecific(thread_key));
+  if (t == 0)
+    t = claimThread(NULL);
+  return t;
+}
+
+ProfileThread*
+Profiler::claimThread (const char *name)
+{
+  int n;
+  do {
+    n = num_threads;
+    if (n >= MAX_PROFILE_THREADS)
+      return 0;
+  } while (!__sync_bool_compare_and_swap(&num_threads, n, n + 1));
+
+  ProfileThread *t = &threads[n];
+  if (name != NULL)
+    snprintf(t->name, PROFILE_NAME_LENGTH, "%s", name);
+  pthread_setspecific(thread_key, t);
+  return t;
+}
+
+void
+Profiler::aggregate ()
+{
+  if (__sync_lock_test_and_set(&aggregating, 1))
+    return;
+
+  const int n = num_threads;
+  for (int t = 0; t < n; t++) {
+    ProfileThread &thread = threads[t];
+    const unsigned int head = thread.head;
+    // don't read events before we've read the head that published them
+    __sync_synchronize();
+
+    for (unsigned int i = thread.tail; i != head; i++) {
+      const ProfileEvent &e = thread.events[i & (PROFILE_RING_SIZE - 1)];
+      if (trace_file != NULL)
+        traceEvent(t, e);
+      if (!e.exit) {
+        enterTime[t][e.component] = e.time;
+      } else if (enterTime[t][e.component] >= 0) {
+        addSample(t, e.component, e.time - enterTime[t][e.component]);
+        enterTime[t][e.component] = -1;
+      }
+    }
+
+    __sync_synchronize();
+    thread.tail = head;
+    publish(t);
+  }
+
+  __sync_lock_release(&aggregating);
+}
+
+void
+Profiler::addSample (int thread, int component, long long time)
+{
+  ProfileStats &s = stats[thread][component];
+  s.count++;
+  s.sum += time;
+  s.last = time;
+  if (time > s.max)
+    s.max = time;
+  s.buckets[bucketFor(time)]++;
+  stale[thread][component] = 2;
+}
+
+/**
+ * Copies the thread's changed statistics into the half of its snapshot that
+ * readers aren't on, then makes that half the published one.  The other
+ * half is brought up to date on the next publish, hence stale counting down
+ * from 2.  Only called holding aggregating.
+ */
+void
+Profiler::publish (int thread)
+{
+  ProfileSnapshot &snap = snapshots[thread];
+  const unsigned int next = snap.seq + 1;
+  for (int c = 0; c < NUM_PCOMPONENTS; c++) {
+    if (stale[thread][c] > 0) {
+      snap.stats[next & 1][c] = stats[thread][c];
+      stale[thread][c]--;
+    }
+  }
+  // the copy has to be visible before the new seq is
+  __sync_synchronize();
+  snap.seq = next;
+}
+
+/**
+ * Copies the published statistics of one component on one thread.  The
+ * aggregator only writes the half readers are on after publishing the other
+ * one, so if seq hasn't moved the copy is whole.
+ */
+void
+Profiler::readStats (int thread, ProfiledComponent c, ProfileStats &out)
+{
+  const ProfileSnapshot &snap = snapshots[thread];
+  unsigned int seq;
+  do {
+    seq = snap.seq;
+    __sync_synchronize();
+    out = snap.stats[seq & 1][c];
+    __sync_synchronize();
+  } while (snap.seq != seq);
+}
+
+void
+Profiler::mergedStats (ProfiledComponent c, ProfileStats &out)
+{
+  memset(&out, 0, sizeof(ProfileStats));
+  ProfileStats s;
+  for (int t = 0; t < num_threads; t++) {
+    readStats(t, c, s);
+    out.count += s.count;
+    out.sum += s.sum;
+    if (s.count > 0)
+      out.last = s.last;
+    if (s.max > out.max)
+      out.max = s.max;
+    for (int b = 0; b < PROFILE_BUCKETS; b++)
+      out.buckets[b] += s.buckets[b];
+  }
+}
+
+long long
+Profiler::percentile (ProfiledComponent c, float p)
+{
+  ProfileStats s;
+  mergedStats(c, s);
+  return statsPercentile(s, p);
+}
+
+long long
+Profiler::maxTime (ProfiledComponent c)
+{
+  ProfileStats s;
+  mergedStats(c, s);
+  return s.max;
+}
+
+const char*
+Profiler::componentName (ProfiledComponent c)
+{
+  return PCOMPONENT_NAMES[c];
+}
+
+ProfiledComponent
+Profiler::componentParent (ProfiledComponent c)
+{
+  return PCOMPONENT_SUB_ORDER[c];
 }
 
 bool
@@ -162,6 +434,7 @@ Profiler::nextFrame() {
 
   // still currently profiling
   if (profiling) {
+    aggregate();
     // reached end of preset profile frames
     if (num_profile_frames >= 0 && current_frame >= num_profile_frames - 1) {
       // at finish, stop profiling
@@ -171,11 +444,6 @@ Profiler::nextFrame() {
 #endif
       return false;
     }else {
-      // add this frame's times to the sums
-      for (int i = 0; i < NUM_PCOMPONENTS; i++) {
-        sumTime[i] += lastTime[i];
-        lastTime[i] = 0;
-      }
       // continue to the next frame
       current_frame++;
       return true;
@@ -187,16 +455,20 @@ Profiler::nextFrame() {
 void
 Profiler::printCurrent ()
 {
+  aggregate();
   printf("Profiler Data: Frame %i:\n", (current_frame-1));
+  ProfileStats s;
   for (int i = 0; i < NUM_PCOMPONENTS; i++) {
+    mergedStats(static_cast<ProfiledComponent>(i), s);
     printf("%-13s: %.6llu last, %.10llu total\n", PCOMPONENT_NAMES[i],
-        lastTime[i], sumTime[i]);
+        s.last, s.sum);
   }
 }
 
 void
 Profiler::printSummary ()
 {
+  aggregate();
   printf("Profiler Summary: %i Frames\n", (current_frame+1));
 
   // Calculate depths of sub-components, for indented display
@@ -217,26 +489,164 @@ Profiler::printSummary ()
     max_length = max_length > length ? max_length : length;
   }
 
+  ProfileStats merged[NUM_PCOMPONENTS];
+  for (int i = 0; i < NUM_PCOMPONENTS; i++)
+    mergedStats(static_cast<ProfiledComponent>(i), merged[i]);
+
   // Calculate and display the percentages (and totals) for each component
   float parent_sum;
   for (int i = 0; i < NUM_PCOMPONENTS; i++) {
+    const ProfileStats &s = merged[i];
     comp = PCOMPONENT_SUB_ORDER[i];
-    parent_sum = (float)sumTime[comp];
+    parent_sum = (float)merged[comp].sum;
     // depth-based indentation
     printf("%*s", depths[i]*2, "");
-    if (sumTime[i] == 0)
+    if (s.sum == 0)
       printf("  %-*s:      0%% (0000000000us total, 000000us avg.)\n",
           (max_length-depths[i]*2), PCOMPONENT_NAMES[i]);
     else if (parent_sum == 0)
-      printf("  %-*s: 100.00%% (%.10llu total, %.6llu avg.)\n",
-          (max_length-depths[i]*2), PCOMPONENT_NAMES[i], sumTime[i],
-          (sumTime[i] / (current_frame+1)));
+      printf("  %-*s: 100.00%% (%.10llu total, %.6llu avg., "
+             "%.6llu p50, %.6llu p99, %.6llu max)\n",
+          (max_length-depths[i]*2), PCOMPONENT_NAMES[i], s.sum,
+          (s.sum / (current_frame+1)), statsPercentile(s, 0.5f),
+          statsPercentile(s, 0.99f), s.max);
     else
-      printf("  %-*s: %6.2f%% (%.10llu total, %.6llu avg.)\n",
+      printf("  %-*s: %6.2f%% (%.10llu total, %.6llu avg., "
+             "%.6llu p50, %.6llu p99, %.6llu max)\n",
           (max_length-depths[i]*2), PCOMPONENT_NAMES[i],
-          ((float)sumTime[i] / parent_sum * 100), sumTime[i],
-          (sumTime[i] / (current_frame+1)));
+          ((float)s.sum / parent_sum * 100), s.sum,
+          (s.sum / (current_frame+1)), statsPercentile(s, 0.5f),
+          statsPercentile(s, 0.99f), s.max);
+  }
+
+  for (int t = 0; t < num_threads; t++)
+    if (threads[t].dropped > 0)
+      printf("  %s dropped %u events, the summary is incomplete\n",
+             threads[t].name, threads[t].dropped);
+}
+
+/**
+ * Starts writing every recorded span to a Chrome trace-event JSON file.
+ * Profiling still has to be turned on (profileFrames()) for there to be
+ * anything in it.  Load the file in chrome://tracing or ui.perfetto.dev.
+ *
+ * @param path    file to write, an existing one is replaced
+ * @return        false if the file couldn't be opened
+ */
+bool
+Profiler::startTrace (const char *path)
+{
+  stopTrace();
+
+  FILE *f = fopen(path, "w");
+  if (f == NULL) {
+    printf("Profiler: couldn't open %s for the trace\n", path);
+    return false;
+  }
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%i,"
+          "\"tid\":0,\"args\":{\"name\":\"man\"}}", trace_pid);
+
+  lockStats();
+  for (int t = 0; t < MAX_PROFILE_THREADS; t++)
+    trace_named[t] = false;
+  trace_file = f;
+  unlockStats();
+  return true;
+}
+
+/**
+ * Flushes what's left of the events and closes the trace file.
+ */
+void
+Profiler::stopTrace ()
+{
+  if (trace_file == NULL)
+    return;
+
+  aggregate();
+  lockStats();
+  FILE *f = trace_file;
+  trace_file = NULL;
+  unlockStats();
+
+  if (f != NULL) {
+    fprintf(f, "\n]}\n");
+    fclose(f);
   }
 }
 
+void
+Profiler::traceEvent (int thread, const ProfileEvent &e)
+{
+  if (!trace_named[thread]) {
+    fprintf(trace_file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\","
+            "\"pid\":%i,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+            trace_pid, thread, threads[thread].name);
+    trace_named[thread] = true;
+  }
 
+  // Spans go out whole when they close, so an enter or exit lost to a full
+  // ring costs that span and never leaves a B without its E
+  if (!e.exit || enterTime[thread][e.component] < 0)
+    return;
+
+  const long long start = enterTime[thread][e.component];
+  const long long dur = e.time - start;
+  fprintf(trace_file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+          "\"ts\":%lld,\"dur\":%lld,\"pid\":%i,\"tid\":%i,"
+          "\"args\":{\"frame\":%i}}",
+          PCOMPONENT_NAMES[e.component],
+          PCOMPONENT_NAMES[PCOMPONENT_SUB_ORDER[e.component]],
+          start, dur, trace_pid, thread, e.frame);
+
+  if (e.component == P_VISION && dur > VISION_FRAME_BUDGET)
+    fprintf(trace_file, ",\n{\"name\":\"Vision over budget\",\"ph\":\"i\","
+            "\"s\":\"t\",\"ts\":%lld,\"pid\":%i,\"tid\":%i,"
+            "\"args\":{\"frame\":%i,\"us\":%lld}}",
+            e.time, trace_pid, thread, e.frame, dur);
+}
+
+/**
+ * Writes the statistics as tab separated text, one line per component per
+ * thread that ran it, so they can be loaded offline (numpy.genfromtxt,
+ * a spreadsheet, ...).  Times are in the units of the time function,
+ * microseconds on the robot.  The trailing columns are the histogram
+ * buckets as upper_bound:count pairs.
+ *
+ * @param path    file to write
+ * @return        false if the file couldn't be opened
+ */
+bool
+Profiler::dumpStats (const char *path)
+{
+  FILE *f = fopen(path, "w");
+  if (f == NULL) {
+    printf("Profiler: couldn't open %s for the stats dump\n", path);
+    return false;
+  }
+
+  aggregate();
+  fprintf(f, "# nbites profile, %i frames\n", current_frame + 1);
+  fprintf(f, "thread\tcomponent\tparent\tcount\ttotal\tmean\tp50\tp99\tmax"
+          "\tdropped\thistogram\n");
+  ProfileStats s;
+  for (int t = 0; t < num_threads; t++) {
+    for (int i = 0; i < NUM_PCOMPONENTS; i++) {
+      readStats(t, static_cast<ProfiledComponent>(i), s);
+      if (s.count == 0)
+        continue;
+      fprintf(f, "%s\t%s\t%s\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%u\t",
+              threads[t].name, PCOMPONENT_NAMES[i],
+              PCOMPONENT_NAMES[PCOMPONENT_SUB_ORDER[i]], s.count, s.sum,
+              s.sum / s.count, statsPercentile(s, 0.5f),
+              statsPercentile(s, 0.99f), s.max, threads[t].dropped);
+      for (int b = 0; b < PROFILE_BUCKETS; b++)
+        if (s.buckets[b] > 0)
+          fprintf(f, " %lld:%u", bucketTop(b), s.buckets[b]);
+      fprintf(f, "\n");
+    }
+  }
+  fclose(f);
+  return true;
+}
@@ -2,6 +2,9 @@
 #ifndef _Profiler_h_DEFINED
 #define _Profiler_h_DEFINED
 
+#include <cstdio>
+#include <pthread.h>
+
 #include "profileconfig.h"
 
 
@@ -54,6 +57,62 @@ enum ProfiledComponent {
 };
 static const int NUM_PCOMPONENTS = P_FINAL + 1;
 
+// Most threads that will ever profile into one Profiler
+static const int MAX_PROFILE_THREADS = 8;
+// Events each thread can have outstanding before the aggregator drains them
+// (must be a power of two)
+static const int PROFILE_RING_SIZE = 4096;
+// Log-linear latency histogram: PROFILE_SUB_BUCKETS per power of two
+static const int PROFILE_SUB_BUCKETS = 4;
+static const int PROFILE_BUCKETS = 32 * PROFILE_SUB_BUCKETS;
+static const int PROFILE_NAME_LENGTH = 24;
+// Vision runs longer than this have missed the camera's frame (30fps)
+static const long long VISION_FRAME_BUDGET = 33333;
+
+/**
+ * One PROF_ENTER or PROF_EXIT, as recorded by the thread that ran it.
+ */
+struct ProfileEvent {
+  long long time;
+  int frame;
+  short component;
+  short exit;          // 0 on enter, 1 on exit
+};
+
+/**
+ * The events of one thread.  Only the owning thread writes events and head,
+ * only the aggregator moves tail, so neither side ever takes a lock.  When
+ * the ring is full new events are counted in dropped and thrown away.
+ */
+struct ProfileThread {
+  char name[PROFILE_NAME_LENGTH];
+  volatile unsigned int head;
+  volatile unsigned int tail;
+  volatile unsigned int dropped;
+  ProfileEvent events[PROFILE_RING_SIZE];
+};
+
+/**
+ * Aggregated timings of one component on one thread.
+ */
+struct ProfileStats {
+  long long count;
+  long long sum;
+  long long max;
+  long long last;
+  unsigned int buckets[PROFILE_BUCKETS];
+};
+
+/**
+ * What readers see of one thread's statistics.  The aggregator fills in the
+ * copy readers aren't on and then bumps seq, so the published copy is
+ * stats[seq & 1] and readers never wait for the aggregator.
+ */
+struct ProfileSnapshot {
+  volatile unsigned int seq;
+  ProfileStats stats[2][NUM_PCOMPONENTS];
+};
+
 class Profiler {
   public:
 
@@ -65,15 +124,35 @@ class Profiler {
 
     void printCurrent();
     void printSummary();
+    bool dumpStats(const char *path);
+
+    // Chrome trace-event JSON export of every PROF_ENTER/PROF_EXIT pair,
+    // for chrome://tracing or ui.perfetto.dev
+    bool startTrace(const char *path);
+    void stopTrace();
 
     bool nextFrame();
 
+    // Names the calling thread in summaries and dumps.  Threads that never
+    // call this get registered on their first event.
+    void registerThread(const char *name);
+
+    // Drains every thread's events into the statistics.  Called once per
+    // frame by nextFrame(), safe to call from any thread.
+    void aggregate();
+
+    long long percentile(ProfiledComponent c, float p);
+    long long maxTime(ProfiledComponent c);
+
+    static const char* componentName(ProfiledComponent c);
+    static ProfiledComponent componentParent(ProfiledComponent c);
+
     inline bool enterComponent(ProfiledComponent c) {
-      enterTime[c] = timeFunction();
+      record(c, 0);
       return profiling;
     }
     inline bool exitComponent(ProfiledComponent c) {
-      lastTime[c] = timeFunction() - enterTime[c];
+      record(c, 1);
       return profiling;
     }
 
@@ -81,15 +160,62 @@ class Profiler {
     bool profiling;
 
   private:
+    inline void record(ProfiledComponent c, short exit) {
+      ProfileThread *t = currentThread();
+      if (t == 0)
+        return;
+      const unsigned int h = t->head;
+      if (h - t->tail >= (unsigned int)PROFILE_RING_SIZE) {
+        t->dropped++;
+        return;
+      }
+      ProfileEvent &e = t->events[h & (PROFILE_RING_SIZE - 1)];
+      e.time = timeFunction();
+      e.frame = current_frame;
+      e.component = (short)c;
+      e.exit = exit;
+      // the event has to be visible before the new head is
+      __sync_synchronize();
+      t->head = h + 1;
+    }
+
+    ProfileThread* currentThread();
+    ProfileThread* claimThread(const char *name);
+    void lockStats();
+    void unlockStats();
+    void addSample(int thread, int component, long long time);
+    void publish(int thread);
+    void readStats(int thread, ProfiledComponent c, ProfileStats &out);
+    void mergedStats(ProfiledComponent c, ProfileStats &out);
+    void traceEvent(int thread, const ProfileEvent &e);
+
     long long (*timeFunction) ();
 
     bool start_next_frame;
     int num_profile_frames;
     int current_frame;
-    long long enterTime[NUM_PCOMPONENTS];
-    long long lastTime[NUM_PCOMPONENTS];
-    long long sumTime[NUM_PCOMPONENTS];
+
+    // per-thread event rings, claimed in order
+    pthread_key_t thread_key;
+    volatile int num_threads;
+    ProfileThread *threads;
+
+    // aggregator state, only touched while holding aggregating, which
+    // aggregate() skips the frame for and reset() and the trace calls wait
+    // for (lockStats())
+    volatile int aggregating;
+    long long enterTime[MAX_PROFILE_THREADS][NUM_PCOMPONENTS];
+    ProfileStats stats[MAX_PROFILE_THREADS][NUM_PCOMPONENTS];
+    // how many of a thread's two snapshot copies are behind stats
+    unsigned char stale[MAX_PROFILE_THREADS][NUM_PCOMPONENTS];
+
+    // published statistics, one per thread, read without any lock
+    ProfileSnapshot *snapshots;
+
+    // trace export, also only touched while holding aggregating
+    FILE *trace_file;
+    bool trace_named[MAX_PROFILE_THREADS];
+    int trace_pid;
 };
 
 #endif
-
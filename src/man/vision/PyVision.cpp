@@ -174,23 +174,31 @@ PyPose_new (NaoPose *p)
 
 extern void
 PyPose_update (PyPose *self)
+{
+    HorizonResult h;
+    fillResult(h, *self->pose, 0);
+    PoseResult p;
+    fillResult(p, *self->pose);
+    PyPose_update(self, h, p);
+}
+
+extern void
+PyPose_update (PyPose *self, const HorizonResult &h, const PoseResult &p)
 {
     Py_XDECREF(self->leftHorizonY);
-    self->leftHorizonY = PyInt_FromLong(self->pose->getLeftHorizonY());
+    self->leftHorizonY = PyInt_FromLong(h.leftY);
 
     Py_XDECREF(self->rightHorizonY);
-    self->rightHorizonY = PyInt_FromLong(self->pose->getRightHorizonY());
+    self->rightHorizonY = PyInt_FromLong(h.rightY);
 
     Py_XDECREF(self->horizonSlope);
-    self->horizonSlope = PyFloat_FromDouble(self->pose->getHorizonSlope());
+    self->horizonSlope = PyFloat_FromDouble(h.slope);
 
 	Py_XDECREF(self->cameraInWorldFrameZ);
-	self->cameraInWorldFrameZ =
-		PyFloat_FromDouble(self->pose->getFocalPointInWorldFrameZ());
+	self->cameraInWorldFrameZ = PyFloat_FromDouble(p.focalPointZ);
 
     Py_XDECREF(self->bodyCenterHeight);
-    self->bodyCenterHeight = PyFloat_FromDouble(
-        self->pose->getBodyCenterHeight());
+    self->bodyCenterHeight = PyFloat_FromDouble(p.bodyCenterHeight);
 
     //Py_XDECREF(self->panAngle);
     //self->panAngle = PyFloat_FromDouble(self->pose->getPan());
@@ -246,6 +254,14 @@ PyPose_update (PyObject *self, PyObject *args)
 
 extern PyObject *
 PyVisualCorner_new (PyFieldLines *fl, int i, const VisualCorner &corner)
+{
+    CornerResult r;
+    fillResult(r, corner);
+    return PyVisualCorner_new(fl, i, r);
+}
+
+extern PyObject *
+PyVisualCorner_new (PyFieldLines *fl, int i, const CornerResult &corner)
 {
     PyVisualCorner *self;
 
@@ -254,18 +270,15 @@ PyVisualCorner_new (PyFieldLines *fl, int i, const VisualCorner &corner)
         self->fl = fl;
         self->i = i;
 
-        list<const ConcreteCorner*> possibilities = corner.getPossibleCorners();
-
-        self->dist = PyFloat_FromDouble(corner.getDistance());
-        self->bearing = PyFloat_FromDouble(corner.getBearingDeg());
+        self->dist = PyFloat_FromDouble(corner.d.distance);
+        self->bearing = PyFloat_FromDouble(corner.d.bearing*TO_DEG);
 
-        self->possibilities = PyList_New(possibilities.size());
+        self->possibilities = PyList_New(corner.numPossible);
         if (self->possibilities != NULL) {
-            int c_i = 0;
-            for (list<const ConcreteCorner*>::const_iterator c =
-                     possibilities.begin(); c != possibilities.end(); c_i++, c++) {
-                Py_INCREF(py_concrete_corners[*c]);
-                PyList_SetItem(self->possibilities, c_i, py_concrete_corners[*c]);
+            for (int c_i = 0; c_i < corner.numPossible; c_i++) {
+                PyObject *c = py_concrete_corners[corner.possible[c_i]];
+                Py_INCREF(c);
+                PyList_SetItem(self->possibilities, c_i, c);
             }
         }
 
@@ -290,26 +303,33 @@ PyVisualCorner_new (PyFieldLines *fl, int i, const VisualCorner &corner)
 
 extern void
 PyVisualCorner_update (PyVisualCorner *self, const VisualCorner &corner)
+{
+    CornerResult r;
+    fillResult(r, corner);
+    PyVisualCorner_update(self, r);
+}
+
+extern void
+PyVisualCorner_update (PyVisualCorner *self, const CornerResult &corner)
 {
     Py_XDECREF(self->dist);
-    self->dist = PyFloat_FromDouble(corner.getDistance());
+    self->dist = PyFloat_FromDouble(corner.d.distance);
 
     Py_XDECREF(self->bearing);
-    self->bearing = PyFloat_FromDouble(corner.getBearingDeg());
+    self->bearing = PyFloat_FromDouble(corner.d.bearing*TO_DEG);
 
-    list<const ConcreteCorner*> possibilities = corner.getPossibleCorners();
     if (self->possibilities == NULL)
-        self->possibilities = PyList_New(possibilities.size());
+        self->possibilities = PyList_New(corner.numPossible);
 
     if (self->possibilities != NULL) {
         int c_i = 0;
-        for (list<const ConcreteCorner*>::const_iterator c =
-                 possibilities.begin(); c != possibilities.end(); c_i++, c++) {
-            Py_INCREF(py_concrete_corners[*c]);
+        for (; c_i < corner.numPossible; c_i++) {
+            PyObject *c = py_concrete_corners[corner.possible[c_i]];
+            Py_INCREF(c);
             if (c_i < PyList_Size(self->possibilities))
-                PyList_SetItem(self->possibilities, c_i, py_concrete_corners[*c]);
+                PyList_SetItem(self->possibilities, c_i, c);
             else
-                PyList_Append(self->possibilities, py_concrete_corners[*c]);
+                PyList_Append(self->possibilities, c);
         }
         if (c_i >= PyList_Size(self->possibilities))
             PySequence_DelSlice(self->possibilities, c_i,
@@ -419,6 +439,14 @@ PyVisualLine_new (PyFieldLines *fl, int i)
 
 extern PyObject *
 PyVisualLine_new (PyFieldLines *fl, int i, shared_ptr<VisualLine> line)
+{
+    LineResult r;
+    fillResult(r, *line);
+    return PyVisualLine_new(fl, i, r);
+}
+
+extern PyObject *
+PyVisualLine_new (PyFieldLines *fl, int i, const LineResult &line)
 {
     PyVisualLine *self;
 
@@ -427,12 +455,12 @@ PyVisualLine_new (PyFieldLines *fl, int i, shared_ptr<VisualLine> line)
         self->fl = fl;
         self->i = i;
 
-        self->x1 = PyInt_FromLong(line->getStartpoint().x);
-        self->y1 = PyInt_FromLong(line->getStartpoint().y);
-        self->x2 = PyInt_FromLong(line->getEndpoint().x);
-        self->y2 = PyInt_FromLong(line->getEndpoint().y);
-        self->slope = PyFloat_FromDouble(line->getSlope());
-        self->length = PyFloat_FromDouble(line->getLength());
+        self->x1 = PyInt_FromLong(line.x1);
+        self->y1 = PyInt_FromLong(line.y1);
+        self->x2 = PyInt_FromLong(line.x2);
+        self->y2 = PyInt_FromLong(line.y2);
+        self->slope = PyFloat_FromDouble(line.slope);
+        self->length = PyFloat_FromDouble(line.length);
 
         if (self->x1 == NULL || self->y1 == NULL || self->x2 == NULL ||
             self->y2 == NULL || self->slope == NULL || self->length == NULL) {
@@ -453,24 +481,32 @@ PyVisualLine_update (PyVisualLine *self)
 
 extern void
 PyVisualLine_update (PyVisualLine *self, shared_ptr<VisualLine> line)
+{
+    LineResult r;
+    fillResult(r, *line);
+    PyVisualLine_update(self, r);
+}
+
+extern void
+PyVisualLine_update (PyVisualLine *self, const LineResult &line)
 {
     Py_XDECREF(self->x1);
-    self->x1 = PyInt_FromLong(line->getStartpoint().x);
+    self->x1 = PyInt_FromLong(line.x1);
 
     Py_XDECREF(self->y1);
-    self->y1 = PyInt_FromLong(line->getStartpoint().y);
+    self->y1 = PyInt_FromLong(line.y1);
 
     Py_XDECREF(self->x2);
-    self->x2 = PyInt_FromLong(line->getEndpoint().x);
+    self->x2 = PyInt_FromLong(line.x2);
 
     Py_XDECREF(self->y2);
-    self->y2 = PyInt_FromLong(line->getEndpoint().y);
+    self->y2 = PyInt_FromLong(line.y2);
 
     Py_XDECREF(self->slope);
-    self->slope = PyFloat_FromDouble(line->getSlope());
+    self->slope = PyFloat_FromDouble(line.slope);
 
     Py_XDECREF(self->length);
-    self->length = PyFloat_FromDouble(line->getLength());
+    self->length = PyFloat_FromDouble(line.length);
 }
 
 // backend methods
@@ -581,24 +617,26 @@ PyFieldLines_new (shared_ptr<FieldLines> fl)
     return (PyObject *)self;
 }
 
-extern void
-PyFieldLines_update (PyFieldLines *self)
+/*
+ * Points the corner and line wrappers at the given results, adding new
+ * wrappers if there are more than last time.
+ */
+static void
+PyFieldLines_set (PyFieldLines *self,
+                  const CornerResult *corners, unsigned int numCorners,
+                  const LineResult *lines, unsigned int numLines)
 {
-    const list<VisualCorner> *corners = self->fl->getCorners();
-    const vector< shared_ptr<VisualLine> > *lines = self->fl->getLines();
-
     Py_XDECREF(self->numCorners);
-    self->numCorners = PyInt_FromLong(corners->size());
+    self->numCorners = PyInt_FromLong(numCorners);
     Py_XDECREF(self->numLines);
-    self->numLines = PyInt_FromLong(lines->size());
+    self->numLines = PyInt_FromLong(numLines);
 
     // Update all the corners, adding new ones if necessary
-    unsigned int i = 0;
-    for (list<VisualCorner>::const_iterator c = corners->begin();
-         c != corners->end(); i++, c++) {
+    unsigned int i;
+    for (i = 0; i < numCorners; i++) {
         if (i >= self->raw_corners.size()) {
             // add a new VisualCorner
-            PyObject *o = PyVisualCorner_new(self, i, *c);
+            PyObject *o = PyVisualCorner_new(self, i, corners[i]);
             if (o == NULL)
                 break;
             self->raw_corners.push_back(o);
@@ -606,14 +644,15 @@ PyFieldLines_update (PyFieldLines *self)
             PyList_Append(self->corners, o);
         }else
             // update the visual corner
-            PyVisualCorner_update((PyVisualCorner*)self->raw_corners[i], *c);
+            PyVisualCorner_update((PyVisualCorner*)self->raw_corners[i],
+                                  corners[i]);
     }
 
     // Update all the lines, adding new ones if necessary
-    for (i = 0; i < lines->size(); i++) {
+    for (i = 0; i < numLines; i++) {
         if (i >= self->raw_lines.size()) {
             // add a new VisualLine
-            PyObject *l = PyVisualLine_new(self, i, lines->at(i));
+            PyObject *l = PyVisualLine_new(self, i, lines[i]);
             if (l == NULL)
                 break;
             self->raw_lines.push_back(l);
@@ -621,10 +660,40 @@ PyFieldLines_update (PyFieldLines *self)
             PyList_Append(self->lines, l);
         }else
             // update the visual line
-            PyVisualLine_update((PyVisualLine*)self->raw_lines[i], lines->at(i));
+            PyVisualLine_update((PyVisualLine*)self->raw_lines[i], lines[i]);
     }
 }
 
+extern void
+PyFieldLines_update (PyFieldLines *self)
+{
+    const list<VisualCorner> *corners = self->fl->getCorners();
+    const vector< shared_ptr<VisualLine> > *lines = self->fl->getLines();
+
+    vector<CornerResult> cornerResults(corners->size());
+    unsigned int i = 0;
+    for (list<VisualCorner>::const_iterator c = corners->begin();
+         c != corners->end(); i++, c++)
+        fillResult(cornerResults[i], *c);
+
+    vector<LineResult> lineResults(lines->size());
+    for (i = 0; i < lines->size(); i++)
+        fillResult(lineResults[i], *lines->at(i));
+
+    PyFieldLines_set(self,
+                     cornerResults.empty() ? NULL : &cornerResults[0],
+                     cornerResults.size(),
+                     lineResults.empty() ? NULL : &lineResults[0],
+                     lineResults.size());
+}
+
+extern void
+PyFieldLines_update (PyFieldLines *self, const VisionFrameResult &frame)
+{
+    PyFieldLines_set(self, frame.corners, frame.numCorners,
+                     frame.lines, frame.numLines);
+}
+
 // backend methods
 extern PyObject *
 PyFieldLines_new (PyTypeObject *type, PyObject *args, PyObject *kwds)
@@ -676,20 +745,6 @@ PyThreshold_new (Threshold *t)
         self->width = PyInt_FromLong(IMAGE_WIDTH);
         self->height = PyInt_FromLong(IMAGE_HEIGHT);
 
-#if 0//ROBOT(NAO)
-        npy_intp dims[] = { IMAGE_HEIGHT, IMAGE_WIDTH };
-        self->thresholded = PyArray_NewFromDescr(
-            &PyArray_Type,
-            PyArray_DescrFromType(PyArray_BYTE),
-            2,
-            &dims[0],
-            NULL,
-            &self->thresh->thresholded[0],
-            NPY_CARRAY_RO,
-            NULL
-            );
-#endif
-
         if (self->width == NULL || self->height == NULL) {
             PyThreshold_dealloc(self);
             self = NULL;
@@ -701,12 +756,20 @@ PyThreshold_new (Threshold *t)
 
 extern void
 PyThreshold_update (PyThreshold *self)
+{
+    ThresholdResult r;
+    fillResult(r);
+    PyThreshold_update(self, r);
+}
+
+extern void
+PyThreshold_update (PyThreshold *self, const ThresholdResult &t)
 {
     Py_XDECREF(self->width);
-    self->width = PyInt_FromLong(IMAGE_WIDTH);
+    self->width = PyInt_FromLong(t.width);
 
     Py_XDECREF(self->height);
-    self->height = PyInt_FromLong(IMAGE_HEIGHT);
+    self->height = PyInt_FromLong(t.height);
 }
 
 // backend methods
@@ -724,10 +787,6 @@ PyThreshold_dealloc (PyThreshold *self)
     Py_XDECREF(self->width);
     Py_XDECREF(self->height);
 
-#if 0//ROBOT(NAO)
-    Py_XDECREF(self->thresholded);
-#endif
-
     self->ob_type->tp_free((PyObject*)self);
 }
 
@@ -812,33 +871,41 @@ PyBall_new (VisualBall *b)
 
 extern void
 PyBall_update (PyBall *self)
+{
+    BallResult r;
+    fillResult(r, *self->ball);
+    PyBall_update(self, r);
+}
+
+extern void
+PyBall_update (PyBall *self, const BallResult &b)
 {
     Py_XDECREF(self->centerX);
-    self->centerX = PyInt_FromLong(self->ball->getCenterX());
+    self->centerX = PyInt_FromLong(b.d.centerX);
 
     Py_XDECREF(self->centerY);
-    self->centerY = PyInt_FromLong(self->ball->getCenterY());
+    self->centerY = PyInt_FromLong(b.d.centerY);
 
     Py_XDECREF(self->width);
-    self->width = PyFloat_FromDouble(self->ball->getWidth());
+    self->width = PyFloat_FromDouble(b.d.width);
 
     Py_XDECREF(self->height);
-    self->height = PyFloat_FromDouble(self->ball->getHeight());
+    self->height = PyFloat_FromDouble(b.d.height);
 
     Py_XDECREF(self->focDist);
-    self->focDist = PyFloat_FromDouble(self->ball->getFocDist());
+    self->focDist = PyFloat_FromDouble(b.d.focDist);
 
     Py_XDECREF(self->dist);
-    self->dist = PyFloat_FromDouble(self->ball->getDistance());
+    self->dist = PyFloat_FromDouble(b.d.distance);
 
     Py_XDECREF(self->bearing);
-    self->bearing = PyFloat_FromDouble(self->ball->getBearingDeg());
+    self->bearing = PyFloat_FromDouble(b.d.bearing*TO_DEG);
 
     Py_XDECREF(self->elevation);
-    self->elevation = PyFloat_FromDouble(self->ball->getElevationDeg());
+    self->elevation = PyFloat_FromDouble(b.d.elevation*TO_DEG);
 
     Py_XDECREF(self->confidence);
-    self->confidence = PyInt_FromLong(self->ball->getConfidence());
+    self->confidence = PyInt_FromLong(b.confidence);
 }
 
 // backend methods
@@ -921,33 +988,41 @@ PyFieldObject_new (VisualFieldObject *o)
 
 extern void
 PyFieldObject_update (PyFieldObject *self)
+{
+    FieldObjectResult r;
+    fillResult(r, *self->object);
+    PyFieldObject_update(self, r);
+}
+
+extern void
+PyFieldObject_update (PyFieldObject *self, const FieldObjectResult &o)
 {
     Py_XDECREF(self->centerX);
-    self->centerX = PyInt_FromLong(self->object->getCenterX());
+    self->centerX = PyInt_FromLong(o.d.centerX);
 
     Py_XDECREF(self->centerY);
-    self->centerY = PyInt_FromLong(self->object->getCenterY());
+    self->centerY = PyInt_FromLong(o.d.centerY);
 
     Py_XDECREF(self->width);
-    self->width = PyFloat_FromDouble(self->object->getWidth());
+    self->width = PyFloat_FromDouble(o.d.width);
 
     Py_XDECREF(self->height);
-    self->height = PyFloat_FromDouble(self->object->getHeight());
+    self->height = PyFloat_FromDouble(o.d.height);
 
     Py_XDECREF(self->focDist);
-    self->focDist = PyFloat_FromDouble(self->object->getFocDist());
+    self->focDist = PyFloat_FromDouble(o.d.focDist);
 
     Py_XDECREF(self->dist);
-    self->dist = PyFloat_FromDouble(self->object->getDistance());
+    self->dist = PyFloat_FromDouble(o.d.distance);
 
     Py_XDECREF(self->bearing);
-    self->bearing = PyFloat_FromDouble(self->object->getBearingDeg());
+    self->bearing = PyFloat_FromDouble(o.d.bearing*TO_DEG);
 
     Py_XDECREF(self->certainty);
-    self->certainty = PyInt_FromLong(self->object->getIDCertainty());
+    self->certainty = PyInt_FromLong(o.idCertainty);
 
     Py_XDECREF(self->distCertainty);
-    self->distCertainty = PyInt_FromLong(self->object->getDistanceCertainty());
+    self->distCertainty = PyInt_FromLong(o.distCertainty);
 }
 
 // backend methods
@@ -1000,6 +1075,7 @@ PyVision_new (Vision *v)
     self = (PyVision *)PyVisionType.tp_alloc(&PyVisionType, 0);
     if (self != NULL) {
         self->vision = v;
+        self->frame = NULL;
 
         //self->width = PyInt_FromLong(v->getWidth());
         //self->height = PyInt_FromLong(v->getHeight());
@@ -1073,6 +1149,31 @@ PyVision_update (PyVision *self)
     PyPose_update((PyPose *)self->pose);
 }
 
+extern void
+PyVision_update (PyVision *self, const VisionFrameResult &frame)
+{
+    self->frame = &frame;
+
+    PyFieldObject_update((PyFieldObject *)self->bgrp, frame.bgrp);
+    PyFieldObject_update((PyFieldObject *)self->bglp, frame.bglp);
+    PyFieldObject_update((PyFieldObject *)self->ygrp, frame.ygrp);
+    PyFieldObject_update((PyFieldObject *)self->yglp, frame.yglp);
+
+    PyCrossbar_update((PyCrossbar *)self->bgCrossbar, frame.bgCrossbar);
+    PyCrossbar_update((PyCrossbar *)self->ygCrossbar, frame.ygCrossbar);
+
+    PyVisualRobot_update((PyVisualRobot *)self->red1, frame.red1);
+    PyVisualRobot_update((PyVisualRobot *)self->red2, frame.red2);
+    PyVisualRobot_update((PyVisualRobot *)self->navy1, frame.navy1);
+    PyVisualRobot_update((PyVisualRobot *)self->navy2, frame.navy2);
+    PyBall_update((PyBall *)self->ball, frame.ball);
+
+    PyFieldLines_update((PyFieldLines *)self->fieldLines, frame);
+
+    PyThreshold_update((PyThreshold *)self->thresh, frame.thresh);
+    PyPose_update((PyPose *)self->pose, frame.horizon, frame.pose);
+}
+
 // backend methods
 extern PyObject *
 PyVision_new (PyTypeObject *type, PyObject *args, PyObject *kwds)
@@ -1209,6 +1310,7 @@ PyVision_startProfiling (PyObject *self, PyObject *args)
     if (PyArg_ParseTuple(args, "|i:startProfiling", &nframes)) {
         ((PyVision*)self)->vision->profiler->reset();
         ((PyVision*)self)->vision->profiler->profileFrames(nframes);
+        ((PyVision*)self)->vision->frameBudget->resetCounts();
         Py_INCREF(Py_None);
         result = Py_None;
     }
@@ -1221,15 +1323,58 @@ PyVision_stopProfiling (PyObject *self, PyObject *args)
 {
     ((PyVision*)self)->vision->profiler->profiling = false;
     ((PyVision*)self)->vision->profiler->printSummary();
+    ((PyVision*)self)->vision->frameBudget->printSummary();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+
+extern PyObject *
+PyVision_startTrace (PyObject *self, PyObject *args)
+{
+    char *path;
+
+    if (!PyArg_ParseTuple(args, "s:startTrace", &path))
+        return NULL;
+    if (!((PyVision*)self)->vision->profiler->startTrace(path)) {
+        PyErr_Format(PyExc_IOError, "Could not open trace file %s", path);
+        return NULL;
+    }
     Py_INCREF(Py_None);
     return Py_None;
 }
 
+extern PyObject *
+PyVision_stopTrace (PyObject *self, PyObject *args)
+{
+    ((PyVision*)self)->vision->profiler->stopTrace();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+extern PyObject *
+PyVision_dumpProfile (PyObject *self, PyObject *args)
+{
+    char *path;
+
+    if (!PyArg_ParseTuple(args, "s:dumpProfile", &path))
+        return NULL;
+    if (!((PyVision*)self)->vision->profiler->dumpStats(path)) {
+        PyErr_Format(PyExc_IOError, "Could not open stats file %s", path);
+        return NULL;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
 
 extern PyObject *
 PyVision_update (PyObject *self, PyObject *args)
 {
-    PyVision_update((PyVision *)self);
+    PyVision *v = (PyVision *)self;
+    if (v->frame != NULL)
+        PyVision_update(v, *v->frame);
+    else
+        PyVision_update(v);
 
     Py_INCREF(Py_None);
     return Py_None;
@@ -1277,10 +1422,6 @@ vision_createNew (PyObject *self, PyObject *args)
 PyMODINIT_FUNC
 MODULE_INIT(vision) (void)
 {
-#if 0// ROBOT(NAO)
-    import_array();
-#endif
-
     if (PyType_Ready(&PyVisionType) < 0 ||
         PyType_Ready(&PyFieldObjectType) < 0 ||
         PyType_Ready(&PyBallType) < 0 ||
@@ -1415,51 +1556,58 @@ extern PyObject * PyCrossbar_new (VisualCrossbar *b)
 }
 
 extern void PyCrossbar_update (PyCrossbar *self)
+{
+    CrossbarResult r;
+    fillResult(r, *self->crossbar);
+    PyCrossbar_update(self, r);
+}
+
+extern void PyCrossbar_update (PyCrossbar *self, const CrossbarResult &c)
 {
     Py_XDECREF(self->x);
-    self->x = PyInt_FromLong(self->crossbar->getX());
+    self->x = PyInt_FromLong(c.d.x);
 
     Py_XDECREF(self->y);
-    self->y = PyInt_FromLong(self->crossbar->getY());
+    self->y = PyInt_FromLong(c.d.y);
 
     Py_XDECREF(self->centerX);
-    self->centerX = PyInt_FromLong(self->crossbar->getCenterX());
+    self->centerX = PyInt_FromLong(c.d.centerX);
 
     Py_XDECREF(self->centerY);
-    self->centerY = PyInt_FromLong(self->crossbar->getCenterY());
+    self->centerY = PyInt_FromLong(c.d.centerY);
 
     Py_XDECREF(self->angleX);
-    self->angleX = PyFloat_FromDouble(self->crossbar->getAngleXDeg());
+    self->angleX = PyFloat_FromDouble(c.d.angleX*TO_DEG);
 
     Py_XDECREF(self->angleX);
-    self->angleY = PyFloat_FromDouble(self->crossbar->getAngleYDeg());
+    self->angleY = PyFloat_FromDouble(c.d.angleY*TO_DEG);
 
     Py_XDECREF(self->width);
-    self->width = PyFloat_FromDouble(self->crossbar->getWidth());
+    self->width = PyFloat_FromDouble(c.d.width);
 
     Py_XDECREF(self->height);
-    self->height = PyFloat_FromDouble(self->crossbar->getHeight());
+    self->height = PyFloat_FromDouble(c.d.height);
 
     Py_XDECREF(self->focDist);
-    self->focDist = PyFloat_FromDouble(self->crossbar->getFocDist());
+    self->focDist = PyFloat_FromDouble(c.d.focDist);
 
     Py_XDECREF(self->dist);
-    self->dist = PyFloat_FromDouble(self->crossbar->getDistance());
+    self->dist = PyFloat_FromDouble(c.d.distance);
 
     Py_XDECREF(self->bearing);
-    self->bearing = PyFloat_FromDouble(self->crossbar->getBearingDeg());
+    self->bearing = PyFloat_FromDouble(c.d.bearing*TO_DEG);
 
     Py_XDECREF(self->elevation);
-    self->elevation = PyFloat_FromDouble(self->crossbar->getElevationDeg());
+    self->elevation = PyFloat_FromDouble(c.d.elevation*TO_DEG);
 
     Py_XDECREF(self->leftOpening);
-    self->leftOpening = PyInt_FromLong(self->crossbar->getLeftOpening());
+    self->leftOpening = PyInt_FromLong(c.leftOpening);
 
     Py_XDECREF(self->rightOpening);
-    self->rightOpening = PyInt_FromLong(self->crossbar->getRightOpening());
+    self->rightOpening = PyInt_FromLong(c.rightOpening);
 
     Py_XDECREF(self->shoot);
-    self->shoot = PyInt_FromLong(self->crossbar->shotAvailable());
+    self->shoot = PyInt_FromLong(c.shoot);
 
 }
 
@@ -1531,42 +1679,50 @@ extern PyObject * PyVisualRobot_new (VisualRobot *b)
 }
 
 extern void PyVisualRobot_update (PyVisualRobot *self)
+{
+    DetectionResult r;
+    fillResult(r, *self->robot);
+    PyVisualRobot_update(self, r);
+}
+
+extern void PyVisualRobot_update (PyVisualRobot *self,
+                                  const DetectionResult &r)
 {
     Py_XDECREF(self->x);
-    self->x = PyInt_FromLong(self->robot->getX());
+    self->x = PyInt_FromLong(r.x);
 
     Py_XDECREF(self->y);
-    self->y = PyInt_FromLong(self->robot->getY());
+    self->y = PyInt_FromLong(r.y);
 
     Py_XDECREF(self->centerX);
-    self->centerX = PyInt_FromLong(self->robot->getCenterX());
+    self->centerX = PyInt_FromLong(r.centerX);
 
     Py_XDECREF(self->centerY);
-    self->centerY = PyInt_FromLong(self->robot->getCenterY());
+    self->centerY = PyInt_FromLong(r.centerY);
 
     Py_XDECREF(self->angleX);
-    self->angleX = PyFloat_FromDouble(self->robot->getAngleXDeg());
+    self->angleX = PyFloat_FromDouble(r.angleX*TO_DEG);
 
     Py_XDECREF(self->angleX);
-    self->angleY = PyFloat_FromDouble(self->robot->getAngleYDeg());
+    self->angleY = PyFloat_FromDouble(r.angleY*TO_DEG);
 
     Py_XDECREF(self->width);
-    self->width = PyFloat_FromDouble(self->robot->getWidth());
+    self->width = PyFloat_FromDouble(r.width);
 
     Py_XDECREF(self->height);
-    self->height = PyFloat_FromDouble(self->robot->getHeight());
+    self->height = PyFloat_FromDouble(r.height);
 
     Py_XDECREF(self->focDist);
-    self->focDist = PyFloat_FromDouble(self->robot->getFocDist());
+    self->focDist = PyFloat_FromDouble(r.focDist);
 
     Py_XDECREF(self->dist);
-    self->dist = PyFloat_FromDouble(self->robot->getDistance());
+    self->dist = PyFloat_FromDouble(r.distance);
 
     Py_XDECREF(self->bearing);
-    self->bearing = PyFloat_FromDouble(self->robot->getBearingDeg());
+    self->bearing = PyFloat_FromDouble(r.bearing*TO_DEG);
 
     Py_XDECREF(self->elevation);
-    self->elevation = PyFloat_FromDouble(self->robot->getElevationDeg());
+    self->elevation = PyFloat_FromDouble(r.elevation*TO_DEG);
 }
 
 // backend methods
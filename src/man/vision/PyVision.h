@@ -55,6 +55,8 @@ typedef struct PyPose_t {
 // C++ - accessible interface
 extern PyObject *PyPose_new    (NaoPose *p);
 extern void      PyPose_update (PyPose *p);
+extern void      PyPose_update (PyPose *p, const HorizonResult &h,
+                                const PoseResult &r);
 // backend methods
 extern PyObject *PyPose_new    (PyTypeObject *type, PyObject *args,
                                 PyObject *kwds);
@@ -176,6 +178,8 @@ static PyFieldLines dummy_fieldlines;
 // C++ - accessible interface
 extern PyObject *PyFieldLines_new    (boost::shared_ptr<FieldLines> fl);
 extern void      PyFieldLines_update (PyFieldLines *fl);
+extern void      PyFieldLines_update (PyFieldLines *fl,
+                                      const VisionFrameResult &frame);
 // backend methods
 extern PyObject *PyFieldLines_new    (PyTypeObject *type, PyObject *args,
                                       PyObject *kwds);
@@ -288,9 +292,13 @@ typedef struct PyVisualCorner_t {
 extern PyObject *PyVisualCorner_new    (PyFieldLines *fl, int i);
 extern PyObject *PyVisualCorner_new    (PyFieldLines *fl, int i,
                                         const VisualCorner &corner);
+extern PyObject *PyVisualCorner_new    (PyFieldLines *fl, int i,
+                                        const CornerResult &corner);
 //jf- extern void      PyVisualCorner_update (PyVisualCorner *self);
 extern void      PyVisualCorner_update (PyVisualCorner *self,
                                         const VisualCorner &corner);
+extern void      PyVisualCorner_update (PyVisualCorner *self,
+                                        const CornerResult &corner);
 // backend methods
 extern PyObject *PyVisualCorner_new    (PyTypeObject *type, PyObject *args,
                                         PyObject *kwds);
@@ -477,9 +485,13 @@ typedef struct PyVisualLine_t {
 extern PyObject *PyVisualLine_new    (PyFieldLines *fl, int i);
 extern PyObject *PyVisualLine_new    (PyFieldLines *fl, int i,
                                       boost::shared_ptr<VisualLine> line);
+extern PyObject *PyVisualLine_new    (PyFieldLines *fl, int i,
+                                      const LineResult &line);
 //jf- extern void      PyVisualLine_update (PyVisualLine *self);
 extern void      PyVisualLine_update (PyVisualLine *self,
                                       boost::shared_ptr<VisualLine> line);
+extern void      PyVisualLine_update (PyVisualLine *self,
+                                      const LineResult &line);
 // backend methods
 extern PyObject *PyVisualLine_new    (PyTypeObject *type, PyObject *args,
                                       PyObject *kwds);
@@ -578,14 +590,13 @@ typedef struct PyThreshold_t {
     Threshold *thresh;
     PyObject *width;
     PyObject *height;
-#if ROBOT(NAO)
-    PyObject *thresholded;
-#endif
 } PyThreshold;
 
 // C++ - accessible interface
 extern PyObject *PyThreshold_new    (Threshold *t);
 extern void      PyThreshold_update (PyThreshold *t);
+extern void      PyThreshold_update (PyThreshold *t,
+                                     const ThresholdResult &r);
 // backend methods
 extern PyObject *PyThreshold_new    (PyTypeObject *type, PyObject *args,
                                      PyObject *kwds);
@@ -594,6 +605,7 @@ extern void      PyThreshold_dealloc(PyThreshold *t);
 extern PyObject *PyThreshold_visionLoop       (PyObject *self, PyObject *args);
 extern PyObject *PyThreshold_thresholdAndRuns (PyObject *self, PyObject *args);
 extern PyObject *PyThreshold_objectRecognition(PyObject *self, PyObject *args);
+extern PyObject *PyThreshold_update           (PyObject *self, PyObject *args);
 
 // Method list
 static PyMethodDef PyThreshold_methods[] = {
@@ -620,10 +632,6 @@ static PyMemberDef PyThreshold_members[] = {
      "Image width"},
     {"height", T_OBJECT_EX, offsetof(PyThreshold, height), READONLY,
      "Image height"},
-#if ROBOT(NAO)
-    {"thresholded", T_OBJECT_EX, offsetof(PyThreshold, thresholded), READONLY,
-     "Thresholded image"},
-#endif
 
     /* Sentinel */
     { NULL }
@@ -696,10 +704,13 @@ typedef struct PyBall_t {
 // C++ - accessible interface
 extern PyObject *PyBall_new    (VisualBall *b);
 extern void      PyBall_update (PyBall *b);
+extern void      PyBall_update (PyBall *b, const BallResult &r);
 // backend methods
 extern PyObject *PyBall_new    (PyTypeObject *type, PyObject *args,
                                 PyObject *kwds);
 extern void      PyBall_dealloc(PyBall *b);
+// Python - accessible interface
+extern PyObject *PyBall_update (PyObject *self, PyObject *args);
 
 // Method list
 static PyMethodDef PyBall_methods[] = {
@@ -806,6 +817,8 @@ typedef struct PyFieldObject_t {
 // C++ - accessible inteface
 extern PyObject *PyFieldObject_new    (VisualFieldObject *o);
 extern void      PyFieldObject_update (PyFieldObject *o);
+extern void      PyFieldObject_update (PyFieldObject *o,
+                                       const FieldObjectResult &r);
 // backend methods
 extern PyObject *PyFieldObject_new    (PyTypeObject *type, PyObject *args,
                                        PyObject *kwds);
@@ -925,11 +938,20 @@ typedef struct PyVision_t {
     // Orange ball
     PyObject *ball;
 
+    // The frame Noggin last updated from, so update() from Python never
+    // reads the live objects vision may be writing
+    const VisionFrameResult *frame;
+
 } PyVision;
 
 // C++ - accessible interface
 extern PyObject *PyVision_new      (Vision *v);
 extern void      PyVision_update   (PyVision *self);
+// Updates the wrappers from a published frame instead of the live Vision
+// objects, pose and thresh included.  The frame has to outlive the PyVision,
+// later update() calls from Python reuse it.
+extern void      PyVision_update   (PyVision *self,
+                                    const VisionFrameResult &frame);
 // backend methods, 
 extern PyObject *PyVision_new      (PyTypeObject *type, PyObject *args, 
                                     PyObject *kwds);
@@ -943,6 +965,9 @@ extern PyObject *PyVision_getColorTablePath(PyObject *self, PyObject *args);
 extern PyObject *PyVision_setColorTablePath(PyObject *self, PyObject *args);
 extern PyObject *PyVision_startProfiling(PyObject *self, PyObject *args);
 extern PyObject *PyVision_stopProfiling(PyObject *self, PyObject *args);
+extern PyObject *PyVision_startTrace(PyObject *self, PyObject *args);
+extern PyObject *PyVision_stopTrace(PyObject *self, PyObject *args);
+extern PyObject *PyVision_dumpProfile(PyObject *self, PyObject *args);
 
 // Method list
 static PyMethodDef PyVision_methods[] = {
@@ -964,7 +989,15 @@ static PyMethodDef PyVision_methods[] = {
      "frames."},
     {"stopProfiling", (PyCFunction)PyVision_stopProfiling, METH_NOARGS,
      "stopProfiling() --> None.  Stop profiling, if still running, and print\n"
-     "profiling results."},
+     "profiling results and how often each frame budget tier was used."},
+    {"startTrace", (PyCFunction)PyVision_startTrace, METH_VARARGS,
+     "startTrace(path) --> None.  Write every profiled span to path as a\n"
+     "Chrome trace (chrome://tracing, ui.perfetto.dev) while profiling."},
+    {"stopTrace", (PyCFunction)PyVision_stopTrace, METH_NOARGS,
+     "stopTrace() --> None.  Finish and close the trace file."},
+    {"dumpProfile", (PyCFunction)PyVision_dumpProfile, METH_VARARGS,
+     "dumpProfile(path) --> None.  Write the profiling statistics to path as\n"
+     "tab separated text, one line per component per thread."},
     {"update", (PyCFunction)PyVision_update, METH_NOARGS,
      "Update all the built Python objects to reflect the current state of the "
      "backend C++ objects.  Recurses down the variable references to update "
@@ -1013,7 +1046,7 @@ static PyMemberDef PyVision_members[] = {
      "Orange ball"},
 
     {"thresh", T_OBJECT_EX, offsetof(PyVision, thresh), READONLY,
-     "Threshold class.  Access to thresholded image, and control method to "
+     "Threshold class.  Control methods to "
      "run thresholding processing."},
 
     {"fieldLines", T_OBJECT_EX, offsetof(PyVision, fieldLines), READONLY,
@@ -1119,10 +1152,13 @@ typedef struct PyCrossbar_t {
 // C++ - accessible interface
 extern PyObject *PyCrossbar_new    (VisualCrossbar *b);
 extern void      PyCrossbar_update (PyCrossbar *b);
+extern void      PyCrossbar_update (PyCrossbar *b, const CrossbarResult &r);
 // backend methods
 extern PyObject *PyCrossbar_new    (PyTypeObject *type, PyObject *args,
                                     PyObject *kwds);
 extern void      PyCrossbar_dealloc(PyCrossbar *b);
+// Python - accessible interface
+extern PyObject *PyCrossbar_update (PyObject *self, PyObject *args);
 
 // Method list
 static PyMethodDef PyCrossbar_methods[] = {
@@ -1242,10 +1278,14 @@ typedef struct PyVisualRobot_t {
 // C++ - accessible interface
 extern PyObject *PyVisualRobot_new    (VisualRobot *b);
 extern void      PyVisualRobot_update (PyVisualRobot *b);
+extern void      PyVisualRobot_update (PyVisualRobot *b,
+                                       const DetectionResult &r);
 // backend methods
 extern PyObject *PyVisualRobot_new    (PyTypeObject *type, PyObject *args,
                                        PyObject *kwds);
 extern void      PyVisualRobot_dealloc(PyVisualRobot *b);
+// Python - accessible interface
+extern PyObject *PyVisualRobot_update (PyObject *self, PyObject *args);
 
 // Method list
 static PyMethodDef PyVisualRobot_methods[] = {
@@ -66,7 +66,7 @@ using boost::shared_ptr;
 
 // Constructor for Threshold class. passed an instance of Vision and Pose
 Threshold::Threshold(Vision* vis, shared_ptr<NaoPose> posPtr)
-: vision(vis), pose(posPtr)
+: vision(vis), pose(posPtr), lazyThresholding(true)
 {
 
     // loads the color table on the MS into memory
@@ -97,15 +97,22 @@ Threshold::Threshold(Vision* vis, shared_ptr<NaoPose> posPtr)
     cross = new Cross(vision, this, field);
     for (int i = 0; i < IMAGE_WIDTH; i++) {
         lowerBound[i] = IMAGE_HEIGHT - 1;
+        thresholdedTop[i] = 0;
     }
 }
 
 /* Main vision loop, called by Vision.cc
  */
 void Threshold::visionLoop() {
+    // Fraction of the frame budget that should be used up by the runs.  Only
+    // the lines get cheaper with the tiers, so that's the last place to check.
+    const float RUNS_SHARE = 0.4f;
+
+    vision->frameBudget->startFrame();
 
     // threshold image and create runs
     thresholdAndRuns();
+    vision->frameBudget->checkpoint(RUNS_SHARE);
 
 
     // do line recognition (in FieldLines.cc)
@@ -131,7 +138,11 @@ void Threshold::visionLoop() {
     // for now we also don't use open field information
     //field->openDirection(horizon, pose.get());
 
+    vision->frameBudget->endFrame();
+
 #ifdef OFFLINE
+    // the TOOL wants to see the whole image, not just what we looked at
+    thresholdRemaining();
     if (visualHorizonDebug) {
         drawVisualHorizon();
     }
@@ -152,9 +163,23 @@ void Threshold::visionLoop() {
 void Threshold::thresholdAndRuns() {
     PROF_ENTER(vision->profiler, P_THRESHRUNS); // profiling
 
-    // Perform image thresholding
+    // Perform image thresholding.  In lazy mode nothing is thresholded
+    // yet; columns are filled in as the scans below reach them.
     PROF_ENTER(vision->profiler, P_THRESHOLD);
+#ifndef USE_EDGES
+    if (lazyThresholding) {
+        for (int i = 0; i < IMAGE_WIDTH; i++) {
+            thresholdedTop[i] = IMAGE_HEIGHT;
+        }
+    } else {
+        threshold();
+        for (int i = 0; i < IMAGE_WIDTH; i++) {
+            thresholdedTop[i] = 0;
+        }
+    }
+#else
     threshold();
+#endif
     PROF_EXIT(vision->profiler, P_THRESHOLD);
 
     initColors();
@@ -182,43 +207,108 @@ void Threshold::thresholdAndRuns() {
 void Threshold::threshold() {
 
 #ifndef USE_EDGES
-    unsigned char *tPtr, *tEnd; // pointers into thresholded array
-    const unsigned char *yPtr; // pointers into image array
-
-    // My loop variable initializations
-    yPtr = &yplane[0];
-
-    tPtr = &thresholded[0][0];
-    tEnd = &thresholded[IMAGE_HEIGHT-1][IMAGE_WIDTH-1] + 1;
-
-    // Loop optimizations thanks to Bill Silver. Uses constant offesets to
-    // speed up the table lookups. Operates on bigTable in UVY order for
-    // more optimizations.
-    while (tPtr < tEnd)
-    {
-        unsigned char* p = bigTable[yPtr[UOFFSET] >> 1][yPtr[VOFFSET] >> 1];
-        *tPtr++ = p[yPtr[YOFFSET1] >> 1];
-        *tPtr++ = p[yPtr[YOFFSET2] >> 1];
-        yPtr += 4;
+    // The table lookup loop lives in ThresholdKernels.h, which picks a
+    // vectorized version of it when the target has one.
+#ifdef COLUMN_MAJOR_THRESHOLD
+    // The kernels work along rows, so threshold a band of rows at a time
+    // and copy the band into the columns.  A band is small enough that
+    // both sides of the copy stay in cache.
+    static const int BAND_ROWS = 8;
+    unsigned char band[BAND_ROWS][IMAGE_WIDTH];
+    for (int top = 0; top < IMAGE_HEIGHT; top += BAND_ROWS) {
+        const int rows = min(BAND_ROWS, IMAGE_HEIGHT - top);
+        ThresholdKernels::threshold(&yplane[top * IMAGE_ROW_OFFSET],
+                                    &bigTable[0][0][0], &band[0][0],
+                                    rows * IMAGE_WIDTH);
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            unsigned char* column = &thresholded[x][top];
+            for (int r = 0; r < rows; r++) {
+                column[r] = band[r][x];
+            }
+        }
     }
+#else
+    ThresholdKernels::threshold(&yplane[0], &bigTable[0][0][0],
+                                &thresholded[0][0],
+                                IMAGE_WIDTH * IMAGE_HEIGHT);
+#endif
 #else
 #ifdef OFFLINE
     // this makes looking at images in the TOOL tolerable
     for (int i = 0; i < IMAGE_HEIGHT; i++) {
         for (int j = 0; j < IMAGE_WIDTH; j++) {
-            thresholded[i][j] = GREY;
+            setColor(j, i, GREY);
         }
     }
 #endif
 #endif
 }
 
-/*  Returns the color at the sent in point.  If we aren't using color tables
-	it does a lookup in the big table, otherwise it just gets the thresholded
-	value.
+/* Thresholds column x from row top down to where the column was already
+ * thresholded and moves the column's watermark up to top.  Columns off the
+ * image are ignored.
+ * @param x      the column
+ * @param top    the highest row that needs to be valid
  */
-unsigned char Threshold::getColor(int x1, int y1) {
-#ifdef USE_EDGES
+void Threshold::thresholdColumn(int x, int top) {
+    if (x < 0 || x >= IMAGE_WIDTH) {
+        return;
+    }
+    if (top < 0) {
+        top = 0;
+    }
+    const int yOffset = (x & 1) ? YOFFSET2 : YOFFSET1;
+    const uchar* yPtr = yplane + top * IMAGE_ROW_OFFSET + 4 * (x / 2);
+    for (int y = top; y < thresholdedTop[x]; y++) {
+        pixelAt(x, y) = bigTable[yPtr[UOFFSET] >> USHIFT]
+            [yPtr[VOFFSET] >> VSHIFT][yPtr[yOffset] >> YSHIFT];
+        yPtr += IMAGE_ROW_OFFSET;
+    }
+    if (top < thresholdedTop[x]) {
+        thresholdedTop[x] = top;
+    }
+}
+
+/* Copies the thresholded image into out in row major order, which is what
+ * the TOOL and anything else outside of vision expects.
+ * @param out    IMAGE_WIDTH * IMAGE_HEIGHT bytes
+ */
+void Threshold::getThresholdedImage(unsigned char* out) {
+    for (int y = 0; y < IMAGE_HEIGHT; y++) {
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            *out++ = pixelAt(x, y);
+        }
+    }
+}
+
+/* Fills in everything lazy thresholding skipped, for when someone wants the
+ * entire thresholded image (e.g. the TOOL).
+ */
+void Threshold::thresholdRemaining() {
+    for (int i = 0; i < IMAGE_WIDTH; i++) {
+        if (thresholdedTop[i] > 0) {
+            thresholdColumn(i, 0);
+        }
+    }
+}
+
+/* getColor() for a pixel above its column's thresholded span.  Pixels just
+ * above the span are most likely part of a scan working its way up, so we
+ * grow the span to cover them.  Isolated pixels further away (e.g. the
+ * horizon scans) are looked up directly.
+ */
+unsigned char Threshold::lazyColor(int x, int y) {
+    if (thresholdedTop[x] - y <= LAZY_GROW_ROWS) {
+        thresholdColumn(x, y);
+        return pixelAt(x, y);
+    }
+    return lookupColor(x, y);
+}
+
+/*  Returns the color at the sent in point using the YUV cutoffs instead of
+    the color table.  Only used when USE_EDGES is on.
+ */
+unsigned char Threshold::getEdgeColor(int x1, int y1) {
     const unsigned char *yPtr = &yplane[0] +y1*IMAGE_ROW_OFFSET+2*x1;
     int u = yPtr[UOFFSET + 2*(x1%2)];
     if (u  > ORANGEU) {
@@ -240,9 +330,6 @@ unsigned char Threshold::getColor(int x1, int y1) {
         return GREEN;
     }
     return GREY;
-#else
-    return thresholded[y1][x1];
-#endif
 }
 
 /*  When we have identified a possible post we open up the color spectrum a
@@ -324,6 +411,10 @@ void Threshold::runs() {
     // split up the loops
     for (int i = 0; i < IMAGE_WIDTH; i += 1) {
         int topEdge = max(0, field->horizonAt(i));
+        // everything below the field edge gets read by somebody
+        if (thresholdedTop[i] > topEdge) {
+            thresholdColumn(i, topEdge);
+        }
         findBallsCrosses(i, topEdge);
         findGoals(i, topEdge);
     }
@@ -354,9 +445,10 @@ void Threshold::findGoals(int column, int topEdge) {
     for (int j = topEdge; bad < BADSIZE && j >= 0; j--) {
         // get the next pixel
 #ifdef USE_EDGES
-        thresholded[j][column] = getColor(column, j);
+        pixelAt(column, j) = getColor(column, j);
 #endif
-        unsigned char pixel = thresholded[j][column];
+        // above the field edge, so this may not be thresholded yet
+        unsigned char pixel = getColor(column, j);
         switch (pixel) {
         case BLUE:
             lastBlue = j;
@@ -381,7 +473,7 @@ void Threshold::findGoals(int column, int topEdge) {
     bad = 0;
     for (int j = topEdge + 1; bad < BADSIZE && j < lowerBound[column]; j++) {
         // note:  These were thresholded in the findBallsCrosses loop
-        unsigned char pixel = thresholded[j][column];
+        unsigned char pixel = pixelAt(column, j);
         switch (pixel) {
         case BLUE:
             firstBlue = j;
@@ -442,10 +534,10 @@ void Threshold::findBallsCrosses(int column, int topEdge) {
     // scan down the column looking for ORANGE and WHITE
     for (int j = bound; j >= topEdge; j--) {
 #ifdef USE_EDGES
-        thresholded[j][column] = getColor(column, j);
+        pixelAt(column, j) = getColor(column, j);
 #endif
         // get the next pixel
-        unsigned char pixel = thresholded[j][column];
+        unsigned char pixel = pixelAt(column, j);
         // for simplicity treat ORANGERED as ORANGE - we'll look
         // more carefully when we check whether or not it is a ball
         if (pixel == ORANGERED) {
@@ -464,7 +556,7 @@ void Threshold::findBallsCrosses(int column, int topEdge) {
             case ORANGE:
                 // add to Ball data structure
                 if (j == topEdge) {
-                    while (j > 0 && thresholded[j][column] == ORANGE) {
+                    while (j > 0 && getColor(column, j) == ORANGE) {
                         currentRun++;
                         j--;
                     }
@@ -526,7 +618,7 @@ void Threshold::findBallsCrosses(int column, int topEdge) {
                 currentRun++;
                 j--;
 #ifdef USE_EDGES
-                thresholded[j][column] = getColor(column, j);
+                pixelAt(column, j) = getColor(column, j);
 #endif
             }
             currentRun--;
@@ -1502,7 +1594,7 @@ void Threshold::transposeDebugImage(){
     for(int x = 0 ; x < IMAGE_WIDTH;x++)
         for(int y = 0; y < IMAGE_HEIGHT;y++)
             if(debugImage[y][x]!=GREY){
-                thresholded[y][x] = debugImage[y][x];}
+                setColor(x, y, debugImage[y][x]);}
 #endif
 }
 
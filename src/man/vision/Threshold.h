@@ -20,30 +20,19 @@ class Threshold;  // forward reference
 #endif
 #include "Profiler.h"
 #include "NaoPose.h"
-//
-// COLOR TABLE CONSTANTS
-// remember to change both values when chaning the color tables
-
-//these must be changed everytime we load a new table
-#ifdef SMALL_TABLES
-#define YSHIFT  3
-#define USHIFT  2
-#define VSHIFT  2
-#define YMAX  32
-#define UMAX  64
-#define VMAX  64
-#else
-#define YSHIFT  1
-#define USHIFT  1
-#define VSHIFT  1
-#define YMAX  128
-#define UMAX  128
-#define VMAX  128
-#endif
+// Color table constants and the YUV422 byte offsets live with the
+// thresholding kernels
+#include "ThresholdKernels.h"
 
 //#define SHOULDERS
 
 //#define USE_EDGES
+
+// Store the thresholded image column by column, the way all of our scans
+// walk it.  It's off because it doesn't pay: a column walk of the row major
+// image touches the same cache lines as the next 63 columns' walks, so it
+// mostly hits L1 anyway.  See debug/visionBench and debug/scanBench.
+//#define COLUMN_MAJOR_THRESHOLD
 //#define ROOM223
 #ifdef ROOM223
 #define BLUEV 141
@@ -91,6 +80,10 @@ class Threshold;  // forward reference
 // Constants pertaining to object detection and horizon detection
 static const int MIN_RUN_SIZE = 5;
 
+// Lazy thresholding: a getColor() this close above a column's thresholded
+// span grows the span, anything further up is looked up on its own
+static const int LAZY_GROW_ROWS = 16;
+
 /* The following two constants are used in the traversal of the image
    inside thresholdAndRuns. We start at the bottom left of the image which
    is (IMAGE_HEIGHT-1)*IMAGE_ROW_OFFSET. ADDRESS_JUMP means we want to move to
@@ -103,11 +96,6 @@ static const int MIN_X_OPEN = 40;
 
 static const int VISUAL_HORIZON_COLOR = BROWN;
 
-static const int UOFFSET=3;
-static const int VOFFSET=1;
-static const int YOFFSET1=0;
-static const int YOFFSET2=2;
-
 static const int NUMBLOCKS = 3;
 
 //
@@ -132,10 +120,16 @@ public:
     void visionLoop();
     inline void threshold();
     inline void runs();
-    unsigned char getColor(int x, int y);
+    inline unsigned char getColor(int x, int y);
+    inline void setColor(int x, int y, unsigned char c);
+    void getThresholdedImage(unsigned char* out);
     unsigned char getExpandedColor(int x, int y, unsigned char col);
     int getHorizontalEdge(int x1, int y1, int dir);
     void thresholdAndRuns();
+    void thresholdColumn(int x, int top);
+    void thresholdRemaining();
+    void setLazyThresholding(bool lazy) { lazyThresholding = lazy; }
+    bool getLazyThresholding() { return lazyThresholding; }
     void findGoals(int column, int top);
     void findBallsCrosses(int column, int top);
     void detectSelf();
@@ -214,6 +208,14 @@ public:
 
     int getVisionHorizon() { return horizon; }
 
+    // Looks up the color of a single pixel without storing it.  (x, y) has
+    // to be on the image, getColor() checks that for you.
+    inline uchar lookupColor(int x, int y) {
+        const uchar* p = yplane + y*IMAGE_ROW_OFFSET + 4*(x/2);
+        return bigTable[p[UOFFSET] >> USHIFT][p[VOFFSET] >> VSHIFT]
+            [p[(x & 1) ? YOFFSET2 : YOFFSET1] >> YSHIFT];
+    }
+
     inline static int ROUND(float x) {
         return static_cast<int>( std::floor(x + 0.5f) );
     }
@@ -225,8 +227,14 @@ public:
     Robots *red, *navyblue;
     Ball* orange;
     Cross* cross;
-    // main array
+    // main array.  Its layout depends on COLUMN_MAJOR_THRESHOLD, so go
+    // through getColor()/setColor() (or getThresholdedImage() for a row
+    // major copy) rather than indexing it directly.
+#ifdef COLUMN_MAJOR_THRESHOLD
+    unsigned char thresholded[IMAGE_WIDTH][IMAGE_HEIGHT];
+#else
     unsigned char thresholded[IMAGE_HEIGHT][IMAGE_WIDTH];
+#endif
 	Field* field;
 
 #ifdef OFFLINE
@@ -269,6 +277,23 @@ private:
 
     // thresholding variables
     int horizon;
+
+    // Lazy thresholding state.  Column x of thresholded is valid from row
+    // thresholdedTop[x] down to the bottom of the image.  Everything above
+    // is filled in on demand by getColor().
+    bool lazyThresholding;
+    int thresholdedTop[IMAGE_WIDTH];
+    uchar lazyColor(int x, int y);
+
+    // The thresholded pixel at (x, y), whether or not it is valid yet
+    inline uchar& pixelAt(int x, int y) {
+#ifdef COLUMN_MAJOR_THRESHOLD
+        return thresholded[x][y];
+#else
+        return thresholded[y][x];
+#endif
+    }
+    uchar getEdgeColor(int x, int y);
     int lastPixel;
     int currentRun;
     int previousRun;
@@ -287,4 +312,30 @@ private:
 #endif
 };
 
+/*  Returns the color at the sent in point.  If we aren't using color tables
+    it does a lookup in the big table, otherwise it just gets the thresholded
+    value, thresholding it first if lazy thresholding hasn't got there yet.
+    Points off the image are GREY, since some scans step off it before they
+    check where they are.
+ */
+inline unsigned char Threshold::getColor(int x, int y) {
+    if (x < 0 || x >= IMAGE_WIDTH || y < 0 || y >= IMAGE_HEIGHT) {
+        return GREY;
+    }
+#ifdef USE_EDGES
+    return getEdgeColor(x, y);
+#else
+    if (y < thresholdedTop[x]) {
+        return lazyColor(x, y);
+    }
+    return pixelAt(x, y);
+#endif
+}
+
+/*  Overwrites the thresholded color at the sent in point (debug drawing).
+ */
+inline void Threshold::setColor(int x, int y, unsigned char c) {
+    pixelAt(x, y) = c;
+}
+
 #endif // RLE_h_DEFINED
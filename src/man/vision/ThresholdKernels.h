@@ -0,0 +1,281 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Color table lookup kernels used by Threshold::threshold().
+ *
+ * The image comes in as interleaved YUV422 macropixels (4 bytes, 2 pixels)
+ * and every pixel is looked up in the UVY ordered color table.  The scalar
+ * loop is the original one from Threshold.cpp.  The vector versions split
+ * the work in two: the YUYV deinterleaving, shifting and index arithmetic
+ * is done 16 pixels at a time in vector registers, then the 16 indices are
+ * gathered from the table (none of our targets have a byte gather, so this
+ * half stays scalar).  Both paths read the same table with the same
+ * indices, so their output is byte-identical.
+ *
+ * Which kernel threshold() uses is picked at build time: the SSE2 path on
+ * x86 builds with SSE2 (Atom bodies, dev boxes), NEON on ARM, and the plain
+ * loop everywhere else (the Geode has neither).  Define NO_SIMD_THRESHOLD
+ * to force the scalar loop.
+ *
+ * The color table geometry and the YUV422 byte offsets are defined here
+ * as well, so the kernels can be used (and benchmarked) without the rest
+ * of vision.
+ */
+
+#ifndef ThresholdKernels_h_DEFINED
+#define ThresholdKernels_h_DEFINED
+
+//
+// COLOR TABLE CONSTANTS
+// remember to change both values when changing the color tables
+
+//these must be changed everytime we load a new table
+#ifdef SMALL_TABLES
+#define YSHIFT  3
+#define USHIFT  2
+#define VSHIFT  2
+#define YMAX  32
+#define UMAX  64
+#define VMAX  64
+#else
+#define YSHIFT  1
+#define USHIFT  1
+#define VSHIFT  1
+#define YMAX  128
+#define UMAX  128
+#define VMAX  128
+#endif
+
+// Byte offsets of each channel in a YUV422 macropixel
+static const int UOFFSET=3;
+static const int VOFFSET=1;
+static const int YOFFSET1=0;
+static const int YOFFSET2=2;
+
+#ifndef NO_SIMD_THRESHOLD
+#  if defined(__SSE2__)
+#    include <emmintrin.h>
+#    define THRESHOLD_KERNEL_SSE2
+#  elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#    include <arm_neon.h>
+#    define THRESHOLD_KERNEL_NEON
+#  endif
+#endif
+
+namespace ThresholdKernels {
+
+    // Number of pixels handled per vector step (8 macropixels)
+    static const int PIXELS_PER_STEP = 16;
+
+    // log2 of the table dimensions, the tables are always powers of two
+    static const int YMAX_BITS = (YMAX == 128 ? 7 : YMAX == 64 ? 6 : 5);
+    static const int VMAX_BITS = (VMAX == 128 ? 7 : VMAX == 64 ? 6 : 5);
+
+    /**
+     * The original thresholding loop.  Walks the image two pixels at a
+     * time, looking up the U,V row once for both Y values.
+     *
+     * @param yuv     start of the YUV422 image
+     * @param table   the UVY color table, UMAX*VMAX*YMAX bytes
+     * @param out     destination, one byte per pixel
+     * @param pixels  number of pixels to threshold (must be even)
+     */
+    inline void thresholdScalar(const unsigned char* yuv,
+                                const unsigned char* table,
+                                unsigned char* out, int pixels)
+    {
+        const unsigned char* yPtr = yuv;
+        unsigned char* tPtr = out;
+        unsigned char* const tEnd = out + pixels;
+
+        // Loop optimizations thanks to Bill Silver. Uses constant offesets
+        // to speed up the table lookups. Operates on bigTable in UVY order
+        // for more optimizations.
+        while (tPtr < tEnd)
+        {
+            const unsigned char* p = table +
+                (((yPtr[UOFFSET] >> USHIFT) << VMAX_BITS) +
+                 (yPtr[VOFFSET] >> VSHIFT)) * YMAX;
+            *tPtr++ = p[yPtr[YOFFSET1] >> YSHIFT];
+            *tPtr++ = p[yPtr[YOFFSET2] >> YSHIFT];
+            yPtr += 4;
+        }
+    }
+
+    /**
+     * Looks up 16 precomputed table indices.  Unrolled by hand since gcc
+     * 4.2 won't do it for us.
+     */
+    inline void gather16(const unsigned char* table, const int* idx,
+                         unsigned char* out)
+    {
+        out[0]  = table[idx[0]];  out[1]  = table[idx[1]];
+        out[2]  = table[idx[2]];  out[3]  = table[idx[3]];
+        out[4]  = table[idx[4]];  out[5]  = table[idx[5]];
+        out[6]  = table[idx[6]];  out[7]  = table[idx[7]];
+        out[8]  = table[idx[8]];  out[9]  = table[idx[9]];
+        out[10] = table[idx[10]]; out[11] = table[idx[11]];
+        out[12] = table[idx[12]]; out[13] = table[idx[13]];
+        out[14] = table[idx[14]]; out[15] = table[idx[15]];
+    }
+
+#ifdef THRESHOLD_KERNEL_SSE2
+    /**
+     * Computes the table indices of the 8 pixels in 4 macropixels.  Each
+     * 32 bit lane of the input holds Y0 V Y1 U, which is the layout that
+     * YOFFSET1, VOFFSET, YOFFSET2 and UOFFSET describe; if those ever change
+     * this needs to change with them.  The results come back with the first
+     * pixel of each macropixel in first and the second one in second.
+     */
+    inline void sse2Indices(__m128i pix, __m128i& first, __m128i& second)
+    {
+        const __m128i lowByte = _mm_set1_epi16(0x00ff);
+        const __m128i lowWord = _mm_set1_epi32(0x0000ffff);
+
+        // Even bytes are luma, odd bytes are chroma
+        const __m128i y = _mm_srli_epi16(_mm_and_si128(pix, lowByte), YSHIFT);
+        const __m128i c = _mm_srli_epi16(pix, 8);
+
+        // Chroma words alternate V, U within every macropixel
+        const __m128i v = _mm_srli_epi32(_mm_and_si128(c, lowWord), VSHIFT);
+        const __m128i u = _mm_srli_epi32(c, 16 + USHIFT);
+
+        const __m128i row =
+            _mm_slli_epi32(_mm_add_epi32(_mm_slli_epi32(u, VMAX_BITS), v),
+                           YMAX_BITS);
+
+        first = _mm_add_epi32(row, _mm_and_si128(y, lowWord));
+        second = _mm_add_epi32(row, _mm_srli_epi32(y, 16));
+    }
+
+    inline void thresholdSSE2(const unsigned char* yuv,
+                              const unsigned char* table,
+                              unsigned char* out, int pixels)
+    {
+        const int vectorPixels = pixels - pixels % PIXELS_PER_STEP;
+        int idx[PIXELS_PER_STEP] __attribute__((aligned(16)));
+        int i;
+
+        for (i = 0; i < vectorPixels; i += PIXELS_PER_STEP) {
+            const __m128i a =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(yuv));
+            const __m128i b =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(yuv + 16));
+            __m128i a1, a2, b1, b2;
+            sse2Indices(a, a1, a2);
+            sse2Indices(b, b1, b2);
+
+            // Interleave back to pixel order: p0 p1 p2 p3 ...
+            _mm_store_si128(reinterpret_cast<__m128i*>(idx),
+                            _mm_unpacklo_epi32(a1, a2));
+            _mm_store_si128(reinterpret_cast<__m128i*>(idx + 4),
+                            _mm_unpackhi_epi32(a1, a2));
+            _mm_store_si128(reinterpret_cast<__m128i*>(idx + 8),
+                            _mm_unpacklo_epi32(b1, b2));
+            _mm_store_si128(reinterpret_cast<__m128i*>(idx + 12),
+                            _mm_unpackhi_epi32(b1, b2));
+
+            gather16(table, idx, out + i);
+            yuv += 2 * PIXELS_PER_STEP;
+        }
+        thresholdScalar(yuv, table, out + i, pixels - i);
+    }
+#endif /* THRESHOLD_KERNEL_SSE2 */
+
+#ifdef THRESHOLD_KERNEL_NEON
+    inline void thresholdNEON(const unsigned char* yuv,
+                              const unsigned char* table,
+                              unsigned char* out, int pixels)
+    {
+        const int vectorPixels = pixels - pixels % PIXELS_PER_STEP;
+        int idx0[8] __attribute__((aligned(16)));
+        int idx1[8] __attribute__((aligned(16)));
+        int i;
+
+        for (i = 0; i < vectorPixels; i += PIXELS_PER_STEP) {
+            // vld4 does the deinterleaving for us: Y0, V, Y1, U
+            const uint8x8x4_t pix = vld4_u8(yuv);
+            const uint8x8_t y0 = pix.val[YOFFSET1];
+            const uint8x8_t v  = vshr_n_u8(pix.val[VOFFSET], VSHIFT);
+            const uint8x8_t y1 = pix.val[YOFFSET2];
+            const uint8x8_t u  = vshr_n_u8(pix.val[UOFFSET], USHIFT);
+
+            // (u * VMAX + v) needs at most 14 bits, shift by YMAX_BITS
+            // after widening to 32 bits
+            const uint16x8_t uv =
+                vaddw_u8(vshll_n_u8(u, VMAX_BITS), v);
+
+            const uint32x4_t rowLo =
+                vshlq_n_u32(vmovl_u16(vget_low_u16(uv)), YMAX_BITS);
+            const uint32x4_t rowHi =
+                vshlq_n_u32(vmovl_u16(vget_high_u16(uv)), YMAX_BITS);
+            const uint16x8_t y0w = vmovl_u8(vshr_n_u8(y0, YSHIFT));
+            const uint16x8_t y1w = vmovl_u8(vshr_n_u8(y1, YSHIFT));
+
+            vst1q_u32(reinterpret_cast<uint32_t*>(idx0),
+                      vaddw_u16(rowLo, vget_low_u16(y0w)));
+            vst1q_u32(reinterpret_cast<uint32_t*>(idx0 + 4),
+                      vaddw_u16(rowHi, vget_high_u16(y0w)));
+            vst1q_u32(reinterpret_cast<uint32_t*>(idx1),
+                      vaddw_u16(rowLo, vget_low_u16(y1w)));
+            vst1q_u32(reinterpret_cast<uint32_t*>(idx1 + 4),
+                      vaddw_u16(rowHi, vget_high_u16(y1w)));
+
+            unsigned char* o = out + i;
+            for (int k = 0; k < 8; ++k) {
+                o[2*k]     = table[idx0[k]];
+                o[2*k + 1] = table[idx1[k]];
+            }
+            yuv += 2 * PIXELS_PER_STEP;
+        }
+        thresholdScalar(yuv, table, out + i, pixels - i);
+    }
+#endif /* THRESHOLD_KERNEL_NEON */
+
+    /**
+     * The kernel Threshold::threshold() runs, chosen at build time.
+     */
+    inline void threshold(const unsigned char* yuv,
+                          const unsigned char* table,
+                          unsigned char* out, int pixels)
+    {
+#if defined(THRESHOLD_KERNEL_SSE2)
+        thresholdSSE2(yuv, table, out, pixels);
+#elif defined(THRESHOLD_KERNEL_NEON)
+        thresholdNEON(yuv, table, out, pixels);
+#else
+        thresholdScalar(yuv, table, out, pixels);
+#endif
+    }
+
+    // Name of the kernel in use, for the benchmark and startup printouts
+    inline const char* name()
+    {
+#if defined(THRESHOLD_KERNEL_SSE2)
+        return "sse2";
+#elif defined(THRESHOLD_KERNEL_NEON)
+        return "neon";
+#else
+        return "scalar";
+#endif
+    }
+}
+
+#endif /* ThresholdKernels_h_DEFINED */
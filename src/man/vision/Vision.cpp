@@ -32,6 +32,7 @@
  * notifyImage(), which performs all the vision processing.
  */
 
+#include <unistd.h>
 #include <boost/shared_ptr.hpp>
 #include "Vision.h" // Vision Class Header File
 
@@ -44,7 +45,10 @@ static byte global_image[IMAGE_BYTE_SIZE];
 // Vision Class Constructor
 Vision::Vision(shared_ptr<NaoPose> _pose, shared_ptr<Profiler> _prof)
     : pose(_pose), profiler(_prof),
-      frameNumber(0), id(-1), name(), player(1), colorTable("table.mtb")
+      frameNumber(0), publishedFrames(0), thresholdedVersion(0),
+      fullThresholdRequests(0), fullThresholdRequestsDone(0),
+      fullThresholdedVersion(0),
+      id(-1), name(), player(1), colorTable("table.mtb")
 {
     // variable initialization
 
@@ -63,6 +67,12 @@ Vision::Vision(shared_ptr<NaoPose> _pose, shared_ptr<Profiler> _prof)
 	cross = new VisualCross();
 	fieldEdge = new VisualFieldEdge();
 
+    frameBudget = new FrameBudget(&micro_time);
+#ifdef OFFLINE
+    // the TOOL should always show what the full pipeline sees
+    frameBudget->setEnabled(false);
+#endif
+
     thresh = new Threshold(this, pose);
     fieldLines = shared_ptr<FieldLines>(new FieldLines(this, pose, profiler));
     thresh->setYUV(&global_image[0]);
@@ -72,6 +82,7 @@ Vision::Vision(shared_ptr<NaoPose> _pose, shared_ptr<Profiler> _prof)
 Vision::~Vision()
 {
     delete thresh;
+    delete frameBudget;
     delete navy2;
     delete navy1;
     delete red2;
@@ -127,7 +138,102 @@ void Vision::notifyImage() {
     PROF_EXIT(profiler, P_TRANSFORM);
 
     // Perform image correction, thresholding, and object recognition
+    const unsigned int requests = fullThresholdRequests;
+    const bool thresholdAll = requests != fullThresholdRequestsDone;
+    ++thresholdedVersion;
+    __sync_synchronize();
     thresh->visionLoop();
+    // Someone (e.g. the TOOL) wants the whole image, not just what lazy
+    // thresholding got to
+    if (thresholdAll)
+        thresh->thresholdRemaining();
+    __sync_synchronize();
+    ++thresholdedVersion;
+    if (thresholdAll) {
+        fullThresholdedVersion = thresholdedVersion;
+        __sync_synchronize();
+        fullThresholdRequestsDone = requests;
+    }
+
+    publishResults();
+}
+
+bool Vision::copyThresholdedImage(byte* out) {
+    static const int MAX_TRIES = 50;
+    static const useconds_t RETRY_WAIT_uS = 2000;
+
+    unsigned int request = __sync_add_and_fetch(&fullThresholdRequests, 1);
+    for (int i = 0; i < MAX_TRIES; ++i) {
+        // Wait for a frame thresholded in full since we asked, and for
+        // vision not to have started on the next one
+        if (static_cast<int>(fullThresholdRequestsDone - request) < 0) {
+            usleep(RETRY_WAIT_uS);
+            continue;
+        }
+        __sync_synchronize();
+        const unsigned int before = thresholdedVersion;
+        if (before != fullThresholdedVersion) {
+            // Missed it; ask for another
+            request = __sync_add_and_fetch(&fullThresholdRequests, 1);
+            usleep(RETRY_WAIT_uS);
+            continue;
+        }
+        __sync_synchronize();
+        thresh->getThresholdedImage(out);
+        __sync_synchronize();
+        if (thresholdedVersion == before)
+            return true;
+    }
+    return false;
+}
+
+void Vision::publishResults() {
+    VisionFrameResult& r = frameResults.writeBuffer();
+
+    r.version = VISION_FRAME_RESULT_VERSION;
+    r.sequence = ++publishedFrames;
+    r.timestamp = micro_time();
+    r.frameNumber = frameNumber;
+
+    fillResult(r.bgrp, *bgrp);
+    fillResult(r.bglp, *bglp);
+    fillResult(r.ygrp, *ygrp);
+    fillResult(r.yglp, *yglp);
+    fillResult(r.bgCrossbar, *bgCrossbar);
+    fillResult(r.ygCrossbar, *ygCrossbar);
+    fillResult(r.red1, *red1);
+    fillResult(r.red2, *red2);
+    fillResult(r.navy1, *navy1);
+    fillResult(r.navy2, *navy2);
+    fillResult(r.ball, *ball);
+    fillResult(r.cross, *cross);
+    fillResult(r.horizon, *pose, thresh->getVisionHorizon());
+    fillResult(r.pose, *pose);
+    fillResult(r.thresh);
+
+    const list<VisualCorner>* corners = fieldLines->getCorners();
+    r.numCorners = 0;
+    r.droppedCorners = 0;
+    for (list<VisualCorner>::const_iterator i = corners->begin();
+         i != corners->end(); ++i) {
+        if (r.numCorners < MAX_RESULT_CORNERS)
+            fillResult(r.corners[r.numCorners++], *i);
+        else
+            ++r.droppedCorners;
+    }
+
+    const vector< shared_ptr<VisualLine> >* lines = fieldLines->getLines();
+    r.numLines = 0;
+    r.droppedLines = 0;
+    for (vector< shared_ptr<VisualLine> >::const_iterator i = lines->begin();
+         i != lines->end(); ++i) {
+        if (r.numLines < MAX_RESULT_LINES)
+            fillResult(r.lines[r.numLines++], **i);
+        else
+            ++r.droppedLines;
+    }
+
+    frameResults.publish();
 }
 
 void Vision::setImage(const byte *image) {
@@ -250,13 +356,13 @@ void Vision::drawBox(int left, int right, int bottom, int top, int c) {
             top < IMAGE_HEIGHT &&
             i >= 0 &&
             i < IMAGE_WIDTH) {
-            thresh->thresholded[top][i] = static_cast<unsigned char>(c);
+            thresh->setColor(i, top, static_cast<unsigned char>(c));
         }
         if ((top + height) >= 0 &&
             (top + height) < IMAGE_HEIGHT &&
             i >= 0 &&
             i < IMAGE_WIDTH) {
-            thresh->thresholded[top + height][i] = static_cast<unsigned char>(c);
+            thresh->setColor(i, top + height, static_cast<unsigned char>(c));
         }
     }
     for (int i = top; i < top + height; i++) {
@@ -264,13 +370,13 @@ void Vision::drawBox(int left, int right, int bottom, int top, int c) {
             i < IMAGE_HEIGHT &&
             left >= 0 &&
             left < IMAGE_WIDTH) {
-            thresh->thresholded[i][left] = static_cast<unsigned char>(c);
+            thresh->setColor(left, i, static_cast<unsigned char>(c));
         }
         if (i >= 0 &&
             i < IMAGE_HEIGHT &&
             (left+width) >= 0 &&
             (left+width) < IMAGE_WIDTH) {
-            thresh->thresholded[i][left + width] = static_cast<unsigned char>(c);
+            thresh->setColor(left + width, i, static_cast<unsigned char>(c));
         }
     }
 } // drawBox
@@ -316,13 +422,13 @@ void Vision::drawRect(int left, int top, int width, int height, int c) {
 
     for (int i = left; i < left + width; i++) {
         if (top >= 0 && top < IMAGE_HEIGHT && i >= 0 && i < IMAGE_WIDTH) {
-            thresh->thresholded[top][i] = static_cast<unsigned char>(c);
+            thresh->setColor(i, top, static_cast<unsigned char>(c));
         }
         if ((top + height) >= 0 &&
             (top + height) < IMAGE_HEIGHT &&
             i >= 0 &&
             i < IMAGE_WIDTH) {
-            thresh->thresholded[top + height][i] = static_cast<unsigned char>(c);
+            thresh->setColor(i, top + height, static_cast<unsigned char>(c));
         }
     }
     for (int i = top; i < top + height; i++) {
@@ -330,13 +436,13 @@ void Vision::drawRect(int left, int top, int width, int height, int c) {
             i < IMAGE_HEIGHT &&
             left >= 0 &&
             left < IMAGE_WIDTH) {
-            thresh->thresholded[i][left] = static_cast<unsigned char>(c);
+            thresh->setColor(left, i, static_cast<unsigned char>(c));
         }
         if (i >= 0 &&
             i < IMAGE_HEIGHT &&
             (left+width) >= 0 &&
             (left+width) < IMAGE_WIDTH) {
-            thresh->thresholded[i][left + width] = static_cast<unsigned char>(c);
+            thresh->setColor(left + width, i, static_cast<unsigned char>(c));
         }
     }
 #if ROBOT(NAO)
@@ -354,13 +460,13 @@ void Vision::drawRect(int left, int top, int width, int height, int c) {
     }
     for (int i = left; i < left + width; i++) {
         if (top >= 0 && top < IMAGE_HEIGHT && i >= 0 && i < IMAGE_WIDTH) {
-            thresh->thresholded[top][i] = static_cast<unsigned char>(c);
+            thresh->setColor(i, top, static_cast<unsigned char>(c));
         }
         if ((top + height) >= 0 &&
             (top + height) < IMAGE_HEIGHT &&
             i >= 0 &&
             i < IMAGE_WIDTH) {
-            thresh->thresholded[top + height][i] = static_cast<unsigned char>(c);
+            thresh->setColor(i, top + height, static_cast<unsigned char>(c));
         }
     }
     for (int i = top; i < top + height; i++) {
@@ -368,13 +474,13 @@ void Vision::drawRect(int left, int top, int width, int height, int c) {
             i < IMAGE_HEIGHT &&
             left >= 0 &&
             left < IMAGE_WIDTH) {
-            thresh->thresholded[i][left] = static_cast<unsigned char>(c);
+            thresh->setColor(left, i, static_cast<unsigned char>(c));
         }
         if (i >= 0 &&
             i < IMAGE_HEIGHT &&
             (left+width) >= 0 &&
             (left+width) < IMAGE_WIDTH) {
-            thresh->thresholded[i][left + width] = static_cast<unsigned char>(c);
+            thresh->setColor(left + width, i, static_cast<unsigned char>(c));
         }
     }
 #endif
@@ -392,7 +498,7 @@ void Vision::drawLine(int x, int y, int x1, int y1, int c) {
         for (int i = y; i != y1; i += sign) {
             int newx = x + static_cast<int>(slope * static_cast<float>(i - y) );
             if (newx >= 0 && newx < IMAGE_WIDTH && i >= 0 && i < IMAGE_HEIGHT)
-                thresh->thresholded[i][newx] = static_cast<unsigned char>(c);
+                thresh->setColor(newx, i, static_cast<unsigned char>(c));
         }
     } else if (slope != 0) {
         //slope = 1.0 / slope;
@@ -400,7 +506,7 @@ void Vision::drawLine(int x, int y, int x1, int y1, int c) {
         for (int i = x; i != x1; i += sign) {
             int newy = y + static_cast<int>(slope * static_cast<float>(i - x));
             if (newy >= 0 && newy < IMAGE_HEIGHT && i >= 0 && i < IMAGE_WIDTH)
-                thresh->thresholded[newy][i] = static_cast<unsigned char>(c);
+                thresh->setColor(i, newy, static_cast<unsigned char>(c));
         }
     }
     else if (slope == 0) {
@@ -408,7 +514,7 @@ void Vision::drawLine(int x, int y, int x1, int y1, int c) {
         int endX = max(x, x1);
         for (int i = startX; i <= endX; i++) {
             if (y >= 0 && y < IMAGE_HEIGHT && i >= 0 && i < IMAGE_WIDTH) {
-                thresh->thresholded[y][i] = static_cast<unsigned char>(c);
+                thresh->setColor(i, y, static_cast<unsigned char>(c));
             }
         }
     }
@@ -428,7 +534,7 @@ void Vision::drawLine(int x, int y, int x1, int y1, int c) {
         for (int i = y; i != y1; i += sign) {
             int newx = x + (int)(slope * (i - y));
             if (newx >= 0 && newx < IMAGE_WIDTH && i >= 0 && i < IMAGE_HEIGHT)
-                thresh->thresholded[i][newx] = c;
+                thresh->setColor(newx, i, c);
         }
     } else if (slope != 0) {
         //slope = 1.0 / slope;
@@ -436,7 +542,7 @@ void Vision::drawLine(int x, int y, int x1, int y1, int c) {
         for (int i = x; i != x1; i += sign) {
             int newy = y + (int)(slope * (i - x));
             if (newy >= 0 && newy < IMAGE_HEIGHT && i >= 0 && i < IMAGE_WIDTH)
-                thresh->thresholded[newy][i] = c;
+                thresh->setColor(i, newy, c);
         }
     }
     else if (slope == 0) {
@@ -444,7 +550,7 @@ void Vision::drawLine(int x, int y, int x1, int y1, int c) {
         int endX = max(x, x1);
         for (int i = startX; i <= endX; i++) {
             if (y >= 0 && y < IMAGE_HEIGHT && i >= 0 && i < IMAGE_WIDTH) {
-                thresh->thresholded[y][i] = c;
+                thresh->setColor(i, y, c);
             }
         }
     }
@@ -462,23 +568,23 @@ void Vision::drawLine(boost::shared_ptr<VisualLine> line, const int color) {
 */
 void Vision::drawPoint(int x, int y, int c) {
     if (y > 0 && x > 0 && y < (IMAGE_HEIGHT) && x < (IMAGE_WIDTH)) {
-        thresh->thresholded[y][x] = static_cast<unsigned char>(c);
+        thresh->setColor(x, y, static_cast<unsigned char>(c));
     }if (y+1 > 0 && x > 0 && y+1 < (IMAGE_HEIGHT) && x < (IMAGE_WIDTH)) {
-        thresh->thresholded[y+1][x] = static_cast<unsigned char>(c);
+        thresh->setColor(x, y+1, static_cast<unsigned char>(c));
     }if (y+2 > 0 && x > 0 && y+2 < (IMAGE_HEIGHT) && x < (IMAGE_WIDTH)) {
-        thresh->thresholded[y+2][x] = static_cast<unsigned char>(c);
+        thresh->setColor(x, y+2, static_cast<unsigned char>(c));
     }if (y-1 > 0 && x > 0 && y-1 < (IMAGE_HEIGHT) && x < (IMAGE_WIDTH)) {
-        thresh->thresholded[y-1][x] = static_cast<unsigned char>(c);
+        thresh->setColor(x, y-1, static_cast<unsigned char>(c));
     }if (y-2 > 0 && x > 0 && y-2 < (IMAGE_HEIGHT) && x < (IMAGE_WIDTH)) {
-        thresh->thresholded[y-2][x] = static_cast<unsigned char>(c);
+        thresh->setColor(x, y-2, static_cast<unsigned char>(c));
     }if (y > 0 && x+1 > 0 && y < (IMAGE_HEIGHT) && x+1 < (IMAGE_WIDTH)) {
-        thresh->thresholded[y][x+1] = static_cast<unsigned char>(c);
+        thresh->setColor(x+1, y, static_cast<unsigned char>(c));
     }if (y > 0 && x+2 > 0 && y < (IMAGE_HEIGHT) && x+2 < (IMAGE_WIDTH)) {
-        thresh->thresholded[y][x+2] = static_cast<unsigned char>(c);
+        thresh->setColor(x+2, y, static_cast<unsigned char>(c));
     }if (y > 0 && x-1 > 0 && y < (IMAGE_HEIGHT) && x-1 < (IMAGE_WIDTH)) {
-        thresh->thresholded[y][x-1] = static_cast<unsigned char>(c);
+        thresh->setColor(x-1, y, static_cast<unsigned char>(c));
     }if (y > 0 && x-2 > 0 && y < (IMAGE_HEIGHT) && x-2 < (IMAGE_WIDTH)) {
-        thresh->thresholded[y][x-2] = static_cast<unsigned char>(c);
+        thresh->setColor(x-2, y, static_cast<unsigned char>(c));
     }
 }
 
@@ -498,7 +604,7 @@ void Vision::drawPoint(const VisualCorner &c, const int color) {
 void Vision::drawVerticalLine(int x, int c) {
     if (x >= 0 && x < IMAGE_WIDTH) {
         for (int i = 0; i < IMAGE_HEIGHT; i++) {
-            thresh->thresholded[i][x] = static_cast<unsigned char>(c);
+            thresh->setColor(x, i, static_cast<unsigned char>(c));
         }
     }
 }
@@ -510,9 +616,9 @@ void Vision::drawVerticalLine(int x, int c) {
 void Vision::drawHorizontalLine(int y, int c) {
     if (y >= 0 && y < IMAGE_HEIGHT) {
         for (int i = 0; i < IMAGE_WIDTH; i++) {
-            thresh->thresholded[y][i] = static_cast<unsigned char>(c);
+            thresh->setColor(i, y, static_cast<unsigned char>(c));
             if (y + 1 < IMAGE_HEIGHT - 1) {
-                thresh->thresholded[y+1][i] = static_cast<unsigned char>(c);
+                thresh->setColor(i, y+1, static_cast<unsigned char>(c));
             }
         }
     }
@@ -532,7 +638,7 @@ void Vision::drawCrossHairs(int x, int y, int c) {
 */
 void Vision::drawDot(int x, int y, int c) {
     if (y > 0 && x > 0 && y < (IMAGE_HEIGHT) && x < (IMAGE_WIDTH)) {
-        thresh->thresholded[y][x] = static_cast<unsigned char>(c);
+        thresh->setColor(x, y, static_cast<unsigned char>(c));
     }
 }
 
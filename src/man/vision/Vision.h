@@ -33,6 +33,8 @@
 #include "VisionDef.h"
 #include "CortexDef.h"
 #include "Profiler.h"
+#include "FrameBudget.h"
+#include "TripleBuffer.h"
 #if defined(OFFLINE) || !ROBOT(NAO_RL)
 #  include "MotionDef.h"
 #endif
@@ -51,6 +53,7 @@ class Vision;   // forward reference
 #include "NaoPose.h"
 #include "FieldLines.h"
 #include "VisualCorner.h"
+#include "VisionFrameResult.h"
 
 class Vision
 {
@@ -80,6 +83,26 @@ public:
     // set the current image pointer to the given pointer
     virtual void setImage(const byte* image);
 
+    // Copies this frame's objects into the published VisionFrameResult,
+    // called at the end of notifyImage()
+    void publishResults();
+    // Copies out the newest published frame, or the one copied last time
+    // if there's nothing newer.  Only one thread may read them (Noggin's),
+    // and it never waits on vision.  Returns the frame's sequence number
+    // (0 until the first frame).
+    unsigned int getFrameResult(VisionFrameResult& out) {
+        frameResults.update();
+        out = frameResults.readBuffer();
+        return out.sequence;
+    }
+    // Copies the thresholded image out in row major order, from any
+    // thread.  Asks vision to threshold the whole of its next frame, not
+    // just what lazy thresholding gets to, and waits for vision to be
+    // between that frame and the next so the whole image is from the same
+    // one.  Returns false if it gave up waiting, out may then hold a torn
+    // image and shouldn't be used.
+    bool copyThresholdedImage(byte* out);
+
     // visualization methods
     virtual void drawBoxes(void);
     virtual void drawFieldObject(VisualFieldObject* obj, int color);
@@ -158,6 +181,9 @@ public:
     // Profiling
     boost::shared_ptr<Profiler> profiler;
 
+    // Quality tiers for frames that run late
+    FrameBudget *frameBudget;
+
 protected:
     //
     // Protected Variable
@@ -198,6 +224,19 @@ private:
     // Random Vision Variables
     long int frameNumber;
 
+    // The finished frames, for Noggin.  publishResults() fills in the
+    // write buffer, which no reader can see until it's published.
+    TripleBuffer<VisionFrameResult> frameResults;
+    unsigned int publishedFrames;
+    // Odd while thresh->visionLoop() is writing the thresholded image
+    volatile unsigned int thresholdedVersion;
+    // Requests for a whole thresholded image, bumped by readers, and how
+    // many vision has seen to.  fullThresholdedVersion is the
+    // thresholdedVersion of the last frame thresholded in full.
+    volatile unsigned int fullThresholdRequests;
+    volatile unsigned int fullThresholdRequestsDone;
+    volatile unsigned int fullThresholdedVersion;
+
     // information
     int id;
     std::string name;
@@ -0,0 +1,158 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+#include <list>
+
+#include "VisionFrameResult.h"
+#include "VisualDetection.h"
+#include "VisualFieldObject.h"
+#include "VisualCrossbar.h"
+#include "VisualBall.h"
+#include "VisualCross.h"
+#include "VisualCorner.h"
+#include "VisualLine.h"
+#include "NaoPose.h"
+#include "VisionDef.h"
+
+using namespace std;
+
+/*
+ * Copies up to max entries of a possibility list into a fixed array and
+ * returns how many were copied.
+ */
+template <class T>
+static int copyPossible(const list<const T*>& from, const T** to, int max)
+{
+    int n = 0;
+    for (typename list<const T*>::const_iterator i = from.begin();
+         i != from.end() && n < max; ++i) {
+        to[n++] = *i;
+    }
+    return n;
+}
+
+void fillResult(DetectionResult& r, const VisualDetection& d)
+{
+    r.x = d.getX();
+    r.y = d.getY();
+    r.centerX = d.getCenterX();
+    r.centerY = d.getCenterY();
+    r.width = d.getWidth();
+    r.height = d.getHeight();
+    r.angleX = d.getAngleX();
+    r.angleY = d.getAngleY();
+    r.focDist = d.getFocDist();
+    r.distance = d.getDistance();
+    r.bearing = d.getBearing();
+    r.elevation = d.getElevation();
+    r.distanceSD = d.getDistanceSD();
+    r.bearingSD = d.getBearingSD();
+}
+
+void fillResult(FieldObjectResult& r, const VisualFieldObject& o)
+{
+    fillResult(r.d, o);
+    r.id = o.getID();
+    r.idCertainty = o.getIDCertainty();
+    r.distCertainty = o.getDistanceCertainty();
+
+    const list<const ConcreteFieldObject*>* possible =
+        o.getPossibleFieldObjects();
+    r.numPossible = (possible == NULL) ? 0 :
+        copyPossible(*possible, r.possible,
+                     ConcreteFieldObject::NUM_FIELD_OBJECTS);
+}
+
+void fillResult(CrossbarResult& r, const VisualCrossbar& c)
+{
+    fillResult(r.d, c);
+    r.leftOpening = c.getLeftOpening();
+    r.rightOpening = c.getRightOpening();
+    r.shoot = c.shotAvailable();
+}
+
+void fillResult(BallResult& r, const VisualBall& b)
+{
+    fillResult(r.d, b);
+    r.radius = b.getRadius();
+    r.confidence = b.getConfidence();
+}
+
+void fillResult(CrossResult& r, const VisualCross& c)
+{
+    fillResult(r.d, c);
+    r.id = c.getID();
+    r.idCertainty = c.getIDCertainty();
+    r.distCertainty = c.getDistanceCertainty();
+
+    const list<const ConcreteCross*>* possible = c.getPossibleCrosses();
+    r.numPossible = (possible == NULL) ? 0 :
+        copyPossible(*possible, r.possible, ConcreteCross::NUM_FIELD_CROSSES);
+}
+
+void fillResult(CornerResult& r, const VisualCorner& c)
+{
+    fillResult(r.d, c);
+    r.id = c.getID();
+    r.idCertainty = c.getIDCertainty();
+    r.distCertainty = c.getDistanceCertainty();
+    r.shape = c.getShape();
+    r.numPossible = copyPossible(c.getPossibleCorners(), r.possible,
+                                 ConcreteCorner::NUM_CORNERS);
+}
+
+void fillResult(LineResult& r, const VisualLine& l)
+{
+    r.x1 = l.getStartpoint().x;
+    r.y1 = l.getStartpoint().y;
+    r.x2 = l.getEndpoint().x;
+    r.y2 = l.getEndpoint().y;
+    r.slope = l.getSlope();
+    r.length = l.getLength();
+    r.distance = l.getDistance();
+    r.bearing = l.getBearing();
+    r.distanceSD = l.getDistanceSD();
+    r.bearingSD = l.getBearingSD();
+    r.id = l.getID();
+    r.ccLine = l.getCCLine();
+    r.numPossible = copyPossible(l.getPossibleLines(), r.possible,
+                                 ConcreteLine::NUM_LINES);
+}
+
+void fillResult(HorizonResult& r, const NaoPose& pose, int visionHorizon)
+{
+    r.leftX = pose.getLeftHorizon().x;
+    r.leftY = pose.getLeftHorizon().y;
+    r.rightX = pose.getRightHorizon().x;
+    r.rightY = pose.getRightHorizon().y;
+    r.slope = pose.getHorizonSlope();
+    r.visionHorizon = visionHorizon;
+}
+
+void fillResult(PoseResult& r, const NaoPose& pose)
+{
+    r.focalPointZ = pose.getFocalPointInWorldFrameZ();
+    r.bodyCenterHeight = pose.getBodyCenterHeight();
+}
+
+void fillResult(ThresholdResult& r)
+{
+    r.width = IMAGE_WIDTH;
+    r.height = IMAGE_HEIGHT;
+}
@@ -0,0 +1,197 @@
+// This file is part of Man, a robotic perception, locomotion, and
+// team strategy application created by the Northern Bites RoboCup
+// team of Bowdoin College in Brunswick, Maine, for the Aldebaran
+// Nao robot.
+//
+// Man is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Man is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and the GNU Lesser Public License along with Man.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/**
+ * Everything vision found in one frame, as plain old data.
+ *
+ * Vision fills one of these in at the end of every frame and publishes it
+ * through a TripleBuffer (see Vision::getFrameResult()), so Noggin can
+ * take a consistent frame from its own thread without a lock and without
+ * ever waiting on vision.  A TripleBuffer allows exactly one reader, and
+ * that reader is Noggin: nothing else may call getFrameResult().  PyVision
+ * and localization work from Noggin's copy.
+ *
+ * Copying through the buffer only works because the struct is POD: no
+ * lists, strings or shared_ptrs, just fixed size arrays with counts.  The
+ * possibility lists point at the static Concrete* objects, which never
+ * move.
+ *
+ * Bump VISION_FRAME_RESULT_VERSION whenever the layout changes, anything
+ * that stores or sends these raw checks it.
+ */
+
+#ifndef VisionFrameResult_h_DEFINED
+#define VisionFrameResult_h_DEFINED
+
+#include "ConcreteFieldObject.h"
+#include "ConcreteCorner.h"
+#include "ConcreteCross.h"
+#include "ConcreteLine.h"
+
+static const int VISION_FRAME_RESULT_VERSION = 2;
+
+// More than FieldLines has ever found in one frame; extras are counted
+// in droppedCorners/droppedLines
+static const int MAX_RESULT_CORNERS = 16;
+static const int MAX_RESULT_LINES = 16;
+
+/*
+ * The fields of a VisualDetection.  Robots are nothing more than this.
+ */
+struct DetectionResult
+{
+    int x, y;
+    int centerX, centerY;
+    float width, height;
+    float angleX, angleY;
+    float focDist;
+    float distance, bearing, elevation;
+    float distanceSD, bearingSD;
+};
+
+struct FieldObjectResult
+{
+    DetectionResult d;
+    int id;
+    int idCertainty;
+    int distCertainty;
+    int numPossible;
+    const ConcreteFieldObject *
+    possible[ConcreteFieldObject::NUM_FIELD_OBJECTS];
+};
+
+struct CrossbarResult
+{
+    DetectionResult d;
+    int leftOpening;
+    int rightOpening;
+    bool shoot;
+};
+
+struct BallResult
+{
+    DetectionResult d;
+    float radius;
+    int confidence;
+};
+
+struct CrossResult
+{
+    DetectionResult d;
+    int id;
+    int idCertainty;
+    int distCertainty;
+    int numPossible;
+    const ConcreteCross *possible[ConcreteCross::NUM_FIELD_CROSSES];
+};
+
+struct CornerResult
+{
+    DetectionResult d;
+    int id;
+    int idCertainty;
+    int distCertainty;
+    int shape;
+    int numPossible;
+    const ConcreteCorner *possible[ConcreteCorner::NUM_CORNERS];
+};
+
+struct LineResult
+{
+    int x1, y1, x2, y2;     // start and end points
+    float slope, length;
+    float distance, bearing;
+    float distanceSD, bearingSD;
+    int id;
+    bool ccLine;
+    int numPossible;
+    const ConcreteLine *possible[ConcreteLine::NUM_LINES];
+};
+
+struct HorizonResult
+{
+    int leftX, leftY;       // pose horizon at the image edges
+    int rightX, rightY;
+    float slope;
+    int visionHorizon;      // where Threshold found the field to end
+};
+
+struct PoseResult
+{
+    float focalPointZ;      // camera height above the ground
+    float bodyCenterHeight;
+};
+
+struct ThresholdResult
+{
+    int width, height;      // of the thresholded image
+};
+
+struct VisionFrameResult
+{
+    int version;            // VISION_FRAME_RESULT_VERSION
+    unsigned int sequence;  // one per published frame, starting at 1
+    long long timestamp;    // micro_time() at publication
+    long int frameNumber;
+
+    FieldObjectResult bgrp, bglp;
+    FieldObjectResult ygrp, yglp;
+    CrossbarResult bgCrossbar, ygCrossbar;
+    DetectionResult red1, red2;
+    DetectionResult navy1, navy2;
+    BallResult ball;
+    CrossResult cross;
+    HorizonResult horizon;
+    PoseResult pose;
+    ThresholdResult thresh;
+
+    int numCorners;
+    int droppedCorners;
+    CornerResult corners[MAX_RESULT_CORNERS];
+
+    int numLines;
+    int droppedLines;
+    LineResult lines[MAX_RESULT_LINES];
+};
+
+/*
+ * Conversions from the live vision objects, used by Vision to build the
+ * frame and by the PyVision wrappers that still point at live objects.
+ */
+class VisualDetection;
+class VisualFieldObject;
+class VisualCrossbar;
+class VisualBall;
+class VisualCross;
+class VisualCorner;
+class VisualLine;
+class NaoPose;
+
+void fillResult(DetectionResult& r, const VisualDetection& d);
+void fillResult(FieldObjectResult& r, const VisualFieldObject& o);
+void fillResult(CrossbarResult& r, const VisualCrossbar& c);
+void fillResult(BallResult& r, const VisualBall& b);
+void fillResult(CrossResult& r, const VisualCross& c);
+void fillResult(CornerResult& r, const VisualCorner& c);
+void fillResult(LineResult& r, const VisualLine& l);
+void fillResult(HorizonResult& r, const NaoPose& pose, int visionHorizon);
+void fillResult(PoseResult& r, const NaoPose& pose);
+void fillResult(ThresholdResult& r);
+
+#endif /* VisionFrameResult_h_DEFINED */
@@ -57,10 +57,10 @@ public:
     const int getConfidence() const { return confidence;}
 
     // Member functions
-    const float ballDistanceToSD(float _distance) const {
+    static const float ballDistanceToSD(float _distance) {
         return static_cast<float>(sqrt(10.f + _distance * 0.2f));
     }
-    const float ballBearingToSD(float _bearing) const {
+    static const float ballBearingToSD(float _bearing) {
         return static_cast<float>(sqrt(static_cast<float>(M_PI) / 4.0f));
     }
 
@@ -0,0 +1,188 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <sys/time.h>
+
+#include "VisionDef.h"
+#include "Blobs.h"
+
+/**
+ * Feeds Blobs a frame's worth of random runs, in column order like the
+ * scanners produce them, and times blobIt() plus building the blobs.  The
+ * run count doubles each round by packing more runs into every column.  The
+ * joining is linear in the runs, so the time per run should stay flat.
+ *
+ * The blobs are checked against a brute force labelling that uses the same
+ * contiguity rule, in number and, blob by blob, in extent and order (that
+ * of each blob's first run), so a change to the merging shows up here
+ * first.
+ * It is checked again with the runs shuffled and with overlapping runs
+ * added, as Robots' gap filling makes.
+ *
+ * Usage: blobBench [frames]
+ */
+
+static const int CONTIG = 4;    // must match WHAT_IS_CONTIGUOUS in Blobs.cpp
+
+struct TestRun { int x, y, h; };
+struct Box { int left, right, top, bottom; };
+
+static long micros()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+static void makeRuns(std::vector<TestRun>& runs, int count)
+{
+    runs.clear();
+    const int perColumn = count / IMAGE_WIDTH + 1;
+    for (int x = 0; x < IMAGE_WIDTH && (int)runs.size() < count; x++) {
+        int y = IMAGE_HEIGHT;
+        for (int k = 0; k < perColumn && (int)runs.size() < count; k++) {
+            const int gap = 1 + rand() % 12;
+            const int h = 1 + rand() % 8;
+            y -= gap + h;
+            if (y < 0) {
+                break;
+            }
+            TestRun r = {x, y, h};
+            runs.push_back(r);
+        }
+    }
+}
+
+// Runs anywhere, overlapping each other, in no particular order
+static void makeMessyRuns(std::vector<TestRun>& runs, int count)
+{
+    runs.clear();
+    for (int i = 0; i < count; i++) {
+        const int h = 1 + rand() % 20;
+        TestRun r = {rand() % IMAGE_WIDTH, rand() % (IMAGE_HEIGHT - h), h};
+        runs.push_back(r);
+    }
+}
+
+static bool touching(const TestRun& a, const TestRun& b)
+{
+    return abs(a.x - b.x) < CONTIG &&
+        a.y < b.y + b.h + CONTIG && b.y < a.y + a.h + CONTIG;
+}
+
+// Labels the runs' components in the order of their first runs, and puts
+// each one's extent in boxes
+static int bruteForce(const std::vector<TestRun>& runs,
+                      std::vector<Box>* boxes = 0)
+{
+    const int n = runs.size();
+    std::vector<int> label(n, -1);
+    std::vector<int> stack;
+    int components = 0;
+    for (int i = 0; i < n; i++) {
+        if (label[i] != -1) {
+            continue;
+        }
+        label[i] = components;
+        stack.push_back(i);
+        while (!stack.empty()) {
+            const int j = stack.back();
+            stack.pop_back();
+            for (int k = 0; k < n; k++) {
+                if (label[k] == -1 && touching(runs[j], runs[k])) {
+                    label[k] = components;
+                    stack.push_back(k);
+                }
+            }
+        }
+        components++;
+    }
+    if (boxes) {
+        boxes->clear();
+        for (int c = 0; c < components; c++) {
+            Box b = {IMAGE_WIDTH, -1, IMAGE_HEIGHT, -1};
+            boxes->push_back(b);
+        }
+        for (int i = 0; i < n; i++) {
+            Box& b = (*boxes)[label[i]];
+            b.left = std::min(b.left, runs[i].x);
+            b.right = std::max(b.right, runs[i].x);
+            b.top = std::min(b.top, runs[i].y);
+            b.bottom = std::max(b.bottom, runs[i].y + runs[i].h);
+        }
+    }
+    return components;
+}
+
+static bool check(Blobs& blobs, const std::vector<TestRun>& runs,
+                  const char* what)
+{
+    blobs.init();
+    for (unsigned i = 0; i < runs.size(); i++) {
+        blobs.blobIt(runs[i].x, runs[i].y, runs[i].h);
+    }
+    std::vector<Box> boxes;
+    const int expected = bruteForce(runs, &boxes);
+    if (blobs.number() != expected) {
+        printf("MISMATCH at %d %s runs: %d blobs, expected %d\n",
+               (int)runs.size(), what, blobs.number(), expected);
+        return false;
+    }
+    for (int c = 0; c < expected; c++) {
+        const Blob blob = blobs.get(c);
+        const Box& b = boxes[c];
+        if (blob.getLeft() != b.left || blob.getRight() != b.right ||
+            blob.getTop() != b.top || blob.getBottom() != b.bottom) {
+            printf("MISMATCH at %d %s runs: blob %d is %d-%d x %d-%d, "
+                   "expected %d-%d x %d-%d\n", (int)runs.size(), what, c,
+                   blob.getLeft(), blob.getRight(), blob.getTop(),
+                   blob.getBottom(), b.left, b.right, b.top, b.bottom);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? atoi(argv[1]) : 200;
+    const int maxRuns = IMAGE_WIDTH * 16;
+    Blobs blobs(maxRuns, maxRuns);
+    std::vector<TestRun> runs;
+
+    for (int count = 50; count <= 3200; count *= 2) {
+        makeMessyRuns(runs, count);
+        if (!check(blobs, runs, "messy")) {
+            return 1;
+        }
+    }
+
+    for (int count = 250; count <= maxRuns; count *= 2) {
+        makeRuns(runs, count);
+        const int expected = bruteForce(runs);
+
+        std::vector<TestRun> shuffled(runs);
+        std::random_shuffle(shuffled.begin(), shuffled.end());
+        if (!check(blobs, runs, "ordered") ||
+            !check(blobs, shuffled, "shuffled")) {
+            return 1;
+        }
+
+        const long start = micros();
+        int sum = 0;
+        for (int f = 0; f < frames; f++) {
+            blobs.init();
+            for (unsigned i = 0; i < runs.size(); i++) {
+                blobs.blobIt(runs[i].x, runs[i].y, runs[i].h);
+            }
+            sum += blobs.number();
+        }
+        const double perFrame = (micros() - start) / (double)frames;
+        printf("%5d runs %5d blobs: %8.2f us/frame %6.1f ns/run (%d)\n",
+               (int)runs.size(), expected, perFrame,
+               1000.0 * perFrame / runs.size(), sum / frames);
+    }
+    return 0;
+}
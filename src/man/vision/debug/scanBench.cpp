@@ -0,0 +1,185 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+#include "VisionDef.h"
+
+/**
+ * Compares the vertical scans vision does (see Threshold::findBallsCrosses
+ * and FieldLines::findVerticalLinePoints) over a row major and a column
+ * major thresholded image.  Each scan walks every column from the bottom
+ * of the image up to a fake field edge and counts color transitions, which
+ * is about all the work the real scans do per pixel.
+ *
+ * It also replays each scan's reads through a model of the robot's L1 data
+ * cache (the Atom Z530's: 24K, 6 way, 64 byte lines, LRU), for cache miss
+ * numbers where perf can't count them.  On the robot, run it under
+ * perf stat -e L1-dcache-load-misses as well.
+ *
+ * Usage: scanBench [frames]
+ */
+
+static unsigned char rowMajor[IMAGE_HEIGHT][IMAGE_WIDTH];
+static unsigned char columnMajor[IMAGE_WIDTH][IMAGE_HEIGHT];
+static int fieldEdge[IMAGE_WIDTH];
+
+static const int CACHE_LINE = 64;
+static const int CACHE_WAYS = 6;
+static const int CACHE_SETS = 24 * 1024 / (CACHE_LINE * CACHE_WAYS);
+
+/**
+ * A set associative, least recently used cache, counting misses.
+ */
+class CacheModel
+{
+public:
+    CacheModel() : clock(0), misses(0), reads(0) {
+        for (int s = 0; s < CACHE_SETS; s++) {
+            for (int w = 0; w < CACHE_WAYS; w++) {
+                tags[s][w] = -1;
+                used[s][w] = 0;
+            }
+        }
+    }
+
+    void read(const void* p) {
+        const long line = reinterpret_cast<long>(p) / CACHE_LINE;
+        const int set = static_cast<int>(line % CACHE_SETS);
+        reads++;
+        clock++;
+        int oldest = 0;
+        for (int w = 0; w < CACHE_WAYS; w++) {
+            if (tags[set][w] == line) {
+                used[set][w] = clock;
+                return;
+            }
+            if (used[set][w] < used[set][oldest]) {
+                oldest = w;
+            }
+        }
+        misses++;
+        tags[set][oldest] = line;
+        used[set][oldest] = clock;
+    }
+
+    long long clock, misses, reads;
+
+private:
+    long tags[CACHE_SETS][CACHE_WAYS];
+    long long used[CACHE_SETS][CACHE_WAYS];
+};
+
+// The reads of scanRows() and scanColumns(), in the same order
+void modelRows(CacheModel& cache)
+{
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+        cache.read(&rowMajor[IMAGE_HEIGHT - 1][x]);
+        for (int y = IMAGE_HEIGHT - 2; y >= fieldEdge[x]; y--) {
+            cache.read(&rowMajor[y][x]);
+        }
+    }
+}
+
+void modelColumns(CacheModel& cache)
+{
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+        cache.read(&columnMajor[x][IMAGE_HEIGHT - 1]);
+        for (int y = IMAGE_HEIGHT - 2; y >= fieldEdge[x]; y--) {
+            cache.read(&columnMajor[x][y]);
+        }
+    }
+}
+
+// Misses per frame once the cache is warm, and reads per frame
+void modelScan(void (*scan)(CacheModel&), long long& misses,
+               long long& reads)
+{
+    CacheModel cache;
+    scan(cache);
+    const long long warmMisses = cache.misses, warmReads = cache.reads;
+    scan(cache);
+    misses = cache.misses - warmMisses;
+    reads = cache.reads - warmReads;
+}
+
+int scanRows()
+{
+    int runs = 0;
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+        unsigned char last = rowMajor[IMAGE_HEIGHT - 1][x];
+        for (int y = IMAGE_HEIGHT - 2; y >= fieldEdge[x]; y--) {
+            const unsigned char pixel = rowMajor[y][x];
+            if (pixel != last) {
+                runs++;
+                last = pixel;
+            }
+        }
+    }
+    return runs;
+}
+
+int scanColumns()
+{
+    int runs = 0;
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+        const unsigned char* column = columnMajor[x];
+        unsigned char last = column[IMAGE_HEIGHT - 1];
+        for (int y = IMAGE_HEIGHT - 2; y >= fieldEdge[x]; y--) {
+            const unsigned char pixel = column[y];
+            if (pixel != last) {
+                runs++;
+                last = pixel;
+            }
+        }
+    }
+    return runs;
+}
+
+int main(int argc, char* argv[])
+{
+    const int frames = argc > 1 ? atoi(argv[1]) : 5000;
+    srand(42);
+
+    // Mostly GREEN with some lines and noise
+    for (int y = 0; y < IMAGE_HEIGHT; y++) {
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            unsigned char c = GREEN;
+            if (rand() % 16 == 0) {
+                c = static_cast<unsigned char>(rand() % 6);
+            }
+            rowMajor[y][x] = columnMajor[x][y] = c;
+        }
+    }
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+        fieldEdge[x] = IMAGE_HEIGHT / 4 + x % 20;
+    }
+
+    int check = 0;
+    long long start = micro_time();
+    for (int f = 0; f < frames; f++)
+        check += scanRows();
+    const long long rowTime = micro_time() - start;
+
+    start = micro_time();
+    for (int f = 0; f < frames; f++)
+        check -= scanColumns();
+    const long long columnTime = micro_time() - start;
+
+    if (check != 0) {
+        std::cerr << "Scans disagree" << std::endl;
+        return 1;
+    }
+
+    long long rowMisses, rowReads, columnMisses, columnReads;
+    modelScan(modelRows, rowMisses, rowReads);
+    modelScan(modelColumns, columnMisses, columnReads);
+
+    printf("%d frames of %dx%d\n", frames, IMAGE_WIDTH, IMAGE_HEIGHT);
+    printf("row major    : %10.0f ns/frame, %6lld of %lld reads miss L1\n",
+           static_cast<double>(rowTime) * 1000.0 / frames,
+           rowMisses, rowReads);
+    printf("column major : %10.0f ns/frame, %6lld of %lld reads miss L1\n",
+           static_cast<double>(columnTime) * 1000.0 / frames,
+           columnMisses, columnReads);
+    return 0;
+}
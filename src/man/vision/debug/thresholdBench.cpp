@@ -0,0 +1,128 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "VisionDef.h"
+// Always build the vector kernel here
+#undef NO_SIMD_THRESHOLD
+#include "ThresholdKernels.h"
+
+using namespace std;
+
+/**
+ * Microbenchmark for the thresholding kernels.  Runs the original
+ * Threshold::threshold() loop and the kernel selected in ThresholdKernels.h
+ * over the same images with the same color table, checks that their output
+ * is byte-identical and prints the ns/frame of each.
+ *
+ * Usage: thresholdBench [table.mtb] [frames]
+ * Without a table a random one is used, which is a worst case for the
+ * table cache since every lookup lands on a random line.
+ */
+
+static const int NUM_IMAGES = 8;
+
+static unsigned char bigTable[UMAX][VMAX][YMAX];
+static unsigned char scalarOut[IMAGE_HEIGHT][IMAGE_WIDTH];
+static unsigned char kernelOut[IMAGE_HEIGHT][IMAGE_WIDTH];
+
+// Verbatim copy of the loop Threshold::threshold() used to run
+void oldThreshold(const unsigned char* yplane)
+{
+    unsigned char *tPtr, *tEnd;
+    const unsigned char *yPtr;
+
+    yPtr = &yplane[0];
+
+    tPtr = &scalarOut[0][0];
+    tEnd = &scalarOut[IMAGE_HEIGHT-1][IMAGE_WIDTH-1] + 1;
+
+    while (tPtr < tEnd)
+    {
+        unsigned char* p = bigTable[yPtr[UOFFSET] >> 1][yPtr[VOFFSET] >> 1];
+        *tPtr++ = p[yPtr[YOFFSET1] >> 1];
+        *tPtr++ = p[yPtr[YOFFSET2] >> 1];
+        yPtr += 4;
+    }
+}
+
+void newThreshold(const unsigned char* yplane)
+{
+    ThresholdKernels::threshold(yplane, &bigTable[0][0][0],
+                                &kernelOut[0][0],
+                                IMAGE_WIDTH * IMAGE_HEIGHT);
+}
+
+void loadTable(const char* filename)
+{
+    FILE* fp = fopen(filename, "r");
+    if (fp == NULL) {
+        cerr << "Could not open table " << filename << endl;
+        exit(1);
+    }
+    for (int i = 0; i < UMAX; i++)
+        for (int j = 0; j < VMAX; j++)
+            if (fread(bigTable[i][j], sizeof(unsigned char), YMAX, fp) !=
+                static_cast<size_t>(YMAX)) {
+                cerr << "Table " << filename << " is too short" << endl;
+                exit(1);
+            }
+    fclose(fp);
+}
+
+int main(int argc, char* argv[])
+{
+    int frames = 2000;
+    srand(42);
+
+    if (argc > 1) {
+        loadTable(argv[1]);
+    } else {
+        unsigned char* t = &bigTable[0][0][0];
+        for (int i = 0; i < UMAX * VMAX * YMAX; ++i)
+            t[i] = static_cast<unsigned char>(rand() % 16);
+    }
+    if (argc > 2) {
+        frames = atoi(argv[2]);
+    }
+
+    // Fake images: a smooth-ish field with noise, so U,V rows get reused
+    // about as often as in a real frame
+    static unsigned char images[NUM_IMAGES][IMAGE_BYTE_SIZE];
+    for (int n = 0; n < NUM_IMAGES; ++n) {
+        for (int i = 0; i < IMAGE_BYTE_SIZE; ++i) {
+            const int base = (i % 4 == YOFFSET1 || i % 4 == YOFFSET2) ?
+                80 + (i / IMAGE_ROW_OFFSET) / 2 : 100 + (i % 4) * 10;
+            images[n][i] = static_cast<unsigned char>(base + rand() % 24);
+        }
+    }
+
+    // Correctness first
+    for (int n = 0; n < NUM_IMAGES; ++n) {
+        oldThreshold(images[n]);
+        newThreshold(images[n]);
+        if (memcmp(scalarOut, kernelOut, sizeof(scalarOut)) != 0) {
+            cerr << "Kernel output differs from the scalar loop on image "
+                 << n << endl;
+            return 1;
+        }
+    }
+
+    long long start = micro_time();
+    for (int f = 0; f < frames; ++f)
+        oldThreshold(images[f % NUM_IMAGES]);
+    const long long oldTime = micro_time() - start;
+
+    start = micro_time();
+    for (int f = 0; f < frames; ++f)
+        newThreshold(images[f % NUM_IMAGES]);
+    const long long newTime = micro_time() - start;
+
+    printf("%d frames of %dx%d\n", frames, IMAGE_WIDTH, IMAGE_HEIGHT);
+    printf("scalar loop : %10.0f ns/frame\n",
+           static_cast<double>(oldTime) * 1000.0 / frames);
+    printf("%-11s : %10.0f ns/frame\n", ThresholdKernels::name(),
+           static_cast<double>(newTime) * 1000.0 / frames);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <boost/shared_ptr.hpp>
+
+#include "Vision.h"
+#include "NaoPose.h"
+#include "Sensors.h"
+#include "Profiler.h"
+
+using namespace std;
+using boost::shared_ptr;
+
+/**
+ * Checks Threshold::getColor() on every pixel along the edges of the image
+ * and just off them, before and after lazy thresholding has filled in the
+ * columns.  The color table makes every pixel GREEN, so anything on the
+ * image has to come back GREEN and anything off it GREY.
+ *
+ * Usage: thresholdTest
+ */
+
+static byte table[UMAX * VMAX * YMAX];
+static uchar image[IMAGE_BYTE_SIZE];
+
+static int failures = 0;
+
+static void expect(Threshold* thresh, int x, int y, unsigned char color)
+{
+    const unsigned char got = thresh->getColor(x, y);
+    if (got != color) {
+        if (failures < 10) {
+            fprintf(stderr, "getColor(%d, %d) = %d, wanted %d\n",
+                    x, y, got, color);
+        }
+        failures++;
+    }
+}
+
+static void checkEdges(Threshold* thresh)
+{
+    for (int x = -1; x <= IMAGE_WIDTH; x++) {
+        const bool onImage = x >= 0 && x < IMAGE_WIDTH;
+        expect(thresh, x, -1, GREY);
+        expect(thresh, x, 0, onImage ? GREEN : GREY);
+        expect(thresh, x, IMAGE_HEIGHT - 1, onImage ? GREEN : GREY);
+        expect(thresh, x, IMAGE_HEIGHT, GREY);
+    }
+    for (int y = -1; y <= IMAGE_HEIGHT; y++) {
+        const bool onImage = y >= 0 && y < IMAGE_HEIGHT;
+        expect(thresh, -1, y, GREY);
+        expect(thresh, 0, y, onImage ? GREEN : GREY);
+        expect(thresh, IMAGE_WIDTH - 1, y, onImage ? GREEN : GREY);
+        expect(thresh, IMAGE_WIDTH, y, GREY);
+    }
+    // Far enough off that a stray read would leave the object
+    expect(thresh, -IMAGE_WIDTH, IMAGE_HEIGHT / 2, GREY);
+    expect(thresh, IMAGE_WIDTH / 2, -IMAGE_HEIGHT, GREY);
+    expect(thresh, 2 * IMAGE_WIDTH, 2 * IMAGE_HEIGHT, GREY);
+}
+
+int main()
+{
+    shared_ptr<Sensors> sensors(new Sensors());
+    shared_ptr<NaoPose> pose(new NaoPose(sensors));
+    shared_ptr<Profiler> profiler(new Profiler(&micro_time));
+    Vision vision(pose, profiler);
+    Threshold* thresh = vision.thresh;
+
+    memset(table, GREEN, sizeof(table));
+    thresh->initTableFromBuffer(table);
+    memset(image, 128, sizeof(image));
+    thresh->setYUV(image);
+
+    // Lazily, so most of each column is still waiting to be thresholded
+    thresh->setLazyThresholding(true);
+    thresh->thresholdAndRuns();
+    checkEdges(thresh);
+
+    // Off the image columns are ignored
+    thresh->thresholdColumn(-1, -IMAGE_HEIGHT);
+    thresh->thresholdColumn(IMAGE_WIDTH, 0);
+    thresh->thresholdRemaining();
+    checkEdges(thresh);
+
+    if (failures > 0) {
+        cerr << failures << " edge pixels wrong" << endl;
+        return 1;
+    }
+    cout << "PASSED" << endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <boost/shared_ptr.hpp>
+
+#include "Vision.h"
+#include "NaoPose.h"
+#include "Sensors.h"
+#include "Profiler.h"
+
+using namespace std;
+using boost::shared_ptr;
+
+/**
+ * Runs the whole vision loop over a synthetic field and prints the
+ * Profiler's summary, so P_RUNS, P_VERT_LINES and the rest can be compared
+ * between builds, e.g. visionBench (row major thresholded image) and
+ * visionBenchColumns (built with COLUMN_MAJOR_THRESHOLD).
+ *
+ * The image is grey above a wavy field edge and green below it, with a
+ * few white lines, an orange ball and one pixel in sixteen of noise.  The
+ * color table is made up to match.
+ *
+ * Usage: visionBench [frames]
+ */
+
+static byte table[UMAX * VMAX * YMAX];
+static uchar image[IMAGE_BYTE_SIZE];
+
+static void setPixel(int x, int y, uchar py, uchar pu, uchar pv)
+{
+    uchar* p = image + y * IMAGE_ROW_OFFSET + 4 * (x / 2);
+    p[(x & 1) ? YOFFSET2 : YOFFSET1] = py;
+    p[UOFFSET] = pu;
+    p[VOFFSET] = pv;
+}
+
+static void makeTable()
+{
+    for (int u = 0; u < UMAX; u++) {
+        for (int v = 0; v < VMAX; v++) {
+            for (int y = 0; y < YMAX; y++) {
+                byte c = GREEN;
+                if (y < YMAX / 8) {
+                    c = GREY;
+                } else if (y > YMAX * 3 / 4) {
+                    c = WHITE;
+                } else if (u > UMAX * 3 / 4) {
+                    c = ORANGE;
+                }
+                table[(u * VMAX + v) * YMAX + y] = c;
+            }
+        }
+    }
+}
+
+static void makeImage()
+{
+    srand(42);
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+        const int edge = IMAGE_HEIGHT / 4 + x % 20;
+        for (int y = 0; y < IMAGE_HEIGHT; y++) {
+            if (y < edge) {
+                setPixel(x, y, 20, 128, 128);
+            } else {
+                setPixel(x, y, 100, 100, 100);
+            }
+            if (rand() % 16 == 0) {
+                setPixel(x, y, rand() % 256, rand() % 256, rand() % 256);
+            }
+        }
+    }
+
+    // Lines, a few pixels thick, across the field
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+        const int lines[3] = { IMAGE_HEIGHT * 3 / 4 + x / 8,
+                               IMAGE_HEIGHT / 2 - x / 6,
+                               IMAGE_HEIGHT / 3 + x / 16 };
+        for (int l = 0; l < 3; l++) {
+            for (int y = lines[l]; y < lines[l] + 4; y++) {
+                if (y > IMAGE_HEIGHT / 4 + x % 20 && y < IMAGE_HEIGHT) {
+                    setPixel(x, y, 240, 128, 128);
+                }
+            }
+        }
+    }
+
+    // and a ball
+    const int ballX = IMAGE_WIDTH * 2 / 3, ballY = IMAGE_HEIGHT * 2 / 3;
+    for (int y = ballY - 12; y <= ballY + 12; y++) {
+        for (int x = ballX - 12; x <= ballX + 12; x++) {
+            if ((x - ballX) * (x - ballX) + (y - ballY) * (y - ballY) <= 144) {
+                setPixel(x, y, 120, 240, 128);
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int frames = argc > 1 ? atoi(argv[1]) : 2000;
+
+    shared_ptr<Sensors> sensors(new Sensors());
+    shared_ptr<NaoPose> pose(new NaoPose(sensors));
+    shared_ptr<Profiler> profiler(new Profiler(&micro_time));
+    Vision vision(pose, profiler);
+
+    makeTable();
+    vision.thresh->initTableFromBuffer(table);
+    makeImage();
+
+#ifdef COLUMN_MAJOR_THRESHOLD
+    printf("column major, %d frames\n", frames);
+#else
+    printf("row major, %d frames\n", frames);
+#endif
+
+    // A few frames to warm up, then profile the rest
+    for (int f = 0; f < 10; f++) {
+        vision.notifyImage(image);
+    }
+    profiler->profileFrames(frames);
+    for (int f = 0; f <= frames; f++) {
+        PROF_NFRAME(profiler);
+        PROF_ENTER(profiler, P_VISION);
+        vision.notifyImage(image);
+        PROF_EXIT(profiler, P_VISION);
+    }
+    profiler->printSummary();
+    return 0;
+}
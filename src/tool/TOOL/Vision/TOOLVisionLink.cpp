@@ -156,7 +156,7 @@ JNIEXPORT void JNICALL Java_TOOL_Vision_TOOLVisionLink_cppProcessImage
         jbyte* row = env->GetByteArrayElements(row_target,0);
 
         for(int j = 0; j < IMAGE_WIDTH; j++) {
-            row[j]= vision.thresh->thresholded[i][j];
+            row[j]= vision.thresh->getColor(j, i);
 #ifdef OFFLINE
             if (vision.thresh->debugImage[i][j] != GREY) {
                 row[j]= vision.thresh->debugImage[i][j];
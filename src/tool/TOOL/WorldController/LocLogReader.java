@@ -0,0 +1,241 @@
+package TOOL.WorldController;
+
+import java.io.BufferedInputStream;
+import java.io.DataInputStream;
+import java.io.EOFException;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.BufferUnderflowException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Vector;
+
+/**
+ * Streams frames out of a binary localization log, as written by
+ * LocLogWriter in man/noggin/LocLog.cpp.  See LocLog.h for the format.
+ */
+public class LocLogReader
+{
+    public final static byte[] MAGIC = { 'N', 'B', 'L', 'L' };
+    public final static int MAJOR_VERSION = 1;
+
+    // Record types
+    public final static int HEADER = 1;
+    public final static int FRAME = 2;
+
+    // Frame flags
+    public final static int HAS_TRUTH = 1;
+    public final static int HAS_PARTICLES = 2;
+
+    // Larger records are taken to be a corrupt length
+    private final static int MAX_RECORD_BYTES = 16 * 1024 * 1024;
+
+    /**
+     * A landmark sighting and the landmarks it could be.  Each possibility
+     * is x, y for points and x1, y1, x2, y2 for lines.
+     */
+    public static class Observation
+    {
+        public int id;
+        public float dist, bearing, distSD, bearingSD;
+        public boolean isLine;
+        public float[][] possibilities;
+    }
+
+    public static class Frame
+    {
+        public int frame;
+        public float odoF, odoL, odoR;
+        public float ballDist, ballBearing, ballDistSD, ballBearingSD;
+        public Observation[] observations;
+        // x, y, h, x uncert, y uncert, h uncert of the filter, then of each
+        // of its models
+        public float[][] estimates;
+        // x, y, x uncert, y uncert, x vel, y vel, x vel uncert, y vel uncert
+        public float[] ball;
+        public boolean hasTruth;
+        // x, y, h, ball x, ball y, ball x vel, ball y vel
+        public float[] truth;
+        public Vector<MCLParticle> particles;
+    }
+
+    private DataInputStream in;
+    private int teamColor, playerNumber, minorVersion;
+    private int recordType;
+    private byte[] record = new byte[0];
+
+    /**
+     * @throws IOException If the stream is not a log this can read.
+     */
+    public LocLogReader(InputStream stream) throws IOException
+    {
+        in = new DataInputStream(new BufferedInputStream(stream));
+
+        byte[] magic = new byte[MAGIC.length];
+        in.readFully(magic);
+        for (int i = 0; i < MAGIC.length; ++i) {
+            if (magic[i] != MAGIC[i]) {
+                throw new IOException("Not a localization log");
+            }
+        }
+
+        ByteBuffer version = readBytes(4);
+        int major = version.getShort() & 0xffff;
+        minorVersion = version.getShort() & 0xffff;
+        if (major != MAJOR_VERSION) {
+            throw new IOException("Localization log version " + major +
+                                  " is not supported");
+        }
+
+        ByteBuffer header = readRecord();
+        if (header == null || recordType != HEADER) {
+            throw new IOException("Localization log has no header");
+        }
+        teamColor = header.getInt();
+        playerNumber = header.getInt();
+    }
+
+    public int getTeamColor() { return teamColor; }
+    public int getPlayerNumber() { return playerNumber; }
+    public int getMinorVersion() { return minorVersion; }
+
+    /**
+     * @return True if the file starts like a binary localization log
+     */
+    public static boolean isLocLog(String path)
+    {
+        try {
+            DataInputStream file =
+                new DataInputStream(new FileInputStream(path));
+            byte[] magic = new byte[MAGIC.length];
+            try {
+                file.readFully(magic);
+            } finally {
+                file.close();
+            }
+            for (int i = 0; i < MAGIC.length; ++i) {
+                if (magic[i] != MAGIC[i])
+                    return false;
+            }
+            return true;
+        } catch (IOException e) {
+            return false;
+        }
+    }
+
+    public void close() throws IOException
+    {
+        in.close();
+    }
+
+    /**
+     * @return The next frame, or null at the end of the log or at a frame
+     *         cut short
+     */
+    public Frame readFrame() throws IOException
+    {
+        ByteBuffer r;
+        do {
+            r = readRecord();
+            if (r == null)
+                return null;
+        } while (recordType != FRAME);
+
+        try {
+            Frame f = new Frame();
+            f.frame = r.getInt();
+            int flags = r.get() & 0xff;
+
+            f.odoF = r.getFloat();
+            f.odoL = r.getFloat();
+            f.odoR = r.getFloat();
+
+            f.ballDist = r.getFloat();
+            f.ballBearing = r.getFloat();
+            f.ballDistSD = r.getFloat();
+            f.ballBearingSD = r.getFloat();
+
+            f.observations = new Observation[r.getShort() & 0xffff];
+            for (int i = 0; i < f.observations.length; ++i) {
+                Observation z = new Observation();
+                z.id = r.getInt();
+                z.dist = r.getFloat();
+                z.bearing = r.getFloat();
+                z.distSD = r.getFloat();
+                z.bearingSD = r.getFloat();
+                z.isLine = r.get() != 0;
+                z.possibilities = readFloats(r, r.getShort() & 0xffff,
+                                             z.isLine ? 4 : 2);
+                f.observations[i] = z;
+            }
+
+            f.estimates = readFloats(r, r.getShort() & 0xffff, 6);
+            f.ball = readFloats(r, 1, 8)[0];
+
+            f.hasTruth = (flags & HAS_TRUTH) != 0;
+            if (f.hasTruth) {
+                f.truth = readFloats(r, 1, 7)[0];
+            }
+
+            f.particles = new Vector<MCLParticle>();
+            if ((flags & HAS_PARTICLES) != 0) {
+                int numParticles = r.getInt();
+                if (numParticles < 0 || numParticles > r.remaining() / 16)
+                    return null;
+                f.particles.ensureCapacity(numParticles);
+                for (int i = 0; i < numParticles; ++i) {
+                    f.particles.add(new MCLParticle(r.getFloat(),
+                                                    r.getFloat(),
+                                                    r.getFloat(),
+                                                    r.getFloat()));
+                }
+            }
+            return f;
+        } catch (BufferUnderflowException e) {
+            return null;
+        }
+    }
+
+    private static float[][] readFloats(ByteBuffer r, int rows, int columns)
+    {
+        if (rows * columns * 4 > r.remaining())
+            throw new BufferUnderflowException();
+
+        float[][] values = new float[rows][columns];
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < columns; ++j) {
+                values[i][j] = r.getFloat();
+            }
+        }
+        return values;
+    }
+
+    /**
+     * Reads the next record, setting recordType.
+     *
+     * @return Its body, or null at the end of the stream
+     */
+    private ByteBuffer readRecord() throws IOException
+    {
+        try {
+            int length = readBytes(4).getInt();
+            if (length < 1 || length > MAX_RECORD_BYTES)
+                return null;
+            recordType = in.readUnsignedByte();
+            return readBytes(length - 1);
+        } catch (EOFException e) {
+            return null;
+        }
+    }
+
+    private ByteBuffer readBytes(int length) throws IOException
+    {
+        if (record.length < length)
+            record = new byte[length];
+        in.readFully(record, 0, length);
+        ByteBuffer bytes = ByteBuffer.wrap(record, 0, length).slice();
+        bytes.order(ByteOrder.LITTLE_ENDIAN);
+        return bytes;
+    }
+}
@@ -3,6 +3,7 @@ package TOOL.WorldController;
 import java.io.BufferedReader;
 import java.io.BufferedWriter;
 import java.io.IOException;
+import java.io.FileInputStream;
 import java.io.FileReader;
 import java.io.FileNotFoundException;
 import java.util.Iterator;
@@ -68,6 +69,8 @@ public class LogHandler
     private String logFile;
     private long log_playback_fps;
     private Vector<String> log_strings;
+    // Frames of a binary log, which are used instead of log_strings
+    private Vector<LocLogReader.Frame> log_frames;
     private Vector<String> log_debug_strings;
     private boolean log_pause, log_played, log_last_frame, log_next_frame;
     private int log_marker, last_log_marker;
@@ -98,6 +101,7 @@ public class LogHandler
         // Variable initialization
         log_marker = 1;
         log_strings = new Vector<String>();
+        log_frames = new Vector<LocLogReader.Frame>();
         log_playback_fps = wc.ROBOT_FPS;
 
         // create the timer that will automatically grab the next log
@@ -288,6 +292,11 @@ public class LogHandler
             System.out.println("Loading EKF log file: " + logFile + "... ");
         }
         log_strings.clear();
+        log_frames.clear();
+
+        if (LocLogReader.isLocLog(logFile)) {
+            return loadBinaryLog(logFile);
+        }
 
         // Read in the passed in file
         try {
@@ -321,6 +330,36 @@ public class LogHandler
         }
     }
 
+    /**
+     * Method to load in a binary localization log
+     *
+     * @return True if succesfully loads the log, otherwise false
+     */
+    private boolean loadBinaryLog(String logFile)
+    {
+        try {
+            LocLogReader reader =
+                new LocLogReader(new FileInputStream(logFile));
+            try {
+                team_color = reader.getTeamColor();
+                player_number = reader.getPlayerNumber();
+                LocLogReader.Frame frame;
+                while ((frame = reader.readFrame()) != null) {
+                    log_frames.add(frame);
+                }
+            } finally {
+                reader.close();
+            }
+        } catch (IOException e) {
+            System.err.println(e.getMessage());
+            return false;
+        }
+
+        log_num_frames = log_frames.size();
+        logBox.setLogName(logFile);
+        return true;
+    }
+
     /**
      * Creates a vector of particles from the given line of an MCL log file
      *
@@ -379,6 +418,11 @@ public class LogHandler
         String particleInfo, debugInfo, landmarkInfo, realPoseInfo;
         StringTokenizer t;
 
+        if (!log_frames.isEmpty()) {
+            viewFromBinaryLog();
+            return;
+        }
+
         // Make sure the line is not blank
         if (!log_strings.isEmpty()) {
             // set frame total in the log box
@@ -449,6 +493,130 @@ public class LogHandler
         }
     }
 
+    /**
+     * View the current frame of a binary log.  MCL logs have the particles
+     * and EKF logs the filter's models.
+     */
+    private void viewFromBinaryLog()
+    {
+        logBox.frameTotal.setText("" + log_num_frames);
+        debugViewer.frameTotal.setText("" + log_num_frames);
+        logBox.frameNumber.setText("" + log_marker);
+        debugViewer.frameNumber.setText("" + log_marker);
+
+        if (log_marker < 1 || log_marker > log_frames.size()) {
+            return;
+        }
+        LocLogReader.Frame frame = log_frames.get(log_marker - 1);
+
+        Vector<LocalizationPacket> locModels =
+            new Vector<LocalizationPacket>();
+        for (float[] e : frame.estimates) {
+            locModels.add(LocalizationPacket.
+                          makeEstimateAndUncertPacket(e[0], e[1], e[2],
+                                                      e[3], e[4], e[5]));
+        }
+        if (locModels.isEmpty()) {
+            return;
+        }
+        showEstimates(locModels);
+
+        float[] b = frame.ball;
+        showBallInfo(b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7],
+                     Float.toString(frame.odoF), Float.toString(frame.odoL),
+                     Float.toString(frame.odoR));
+
+        LocalizationPacket actualEst = locModels.get(0);
+        locModels.remove(0);
+        if (frame.particles.isEmpty()) {
+            painter.updateEstPoseInfo((float)actualEst.getXEst(),
+                                      (float)actualEst.getYEst(),
+                                      (float)actualEst.getHeadingEst());
+        }
+        painter.updateUncertainytInfo(actualEst.getXEst(),
+                                      actualEst.getYEst(),
+                                      actualEst.getHeadingEst(),
+                                      actualEst.getXUncert(),
+                                      actualEst.getYUncert(),
+                                      actualEst.getHUncert());
+        painter.updateModels(locModels, team_color);
+
+        if (frame.hasTruth) {
+            float[] t = frame.truth;
+            showRobotPose(t[0], t[1], t[2], t[3], t[4], t[5], t[6]);
+        } else {
+            painter.updateRealPoseInfo(painter.NO_DATA_VALUE,
+                                       painter.NO_DATA_VALUE,
+                                       painter.NO_DATA_VALUE);
+        }
+
+        debugViewer.removeLandmarks();
+        ambiguousLandmarkCount = 0;
+        for (LocLogReader.Observation z : frame.observations) {
+            debugViewer.addLandmark(z.id, z.dist, z.bearing);
+            decodeAndDisplayLandmark(z.id);
+        }
+        if (frame.ballDist > 0) {
+            debugViewer.addLandmark(debugViewer.BALL_ID, frame.ballDist,
+                                    frame.ballBearing);
+        }
+
+        painter.updateParticleSet(frame.particles, team_color,
+                                  player_number);
+        painter.reportEndFrame();
+    }
+
+    /**
+     * Shows the filter's estimate in the debug viewer
+     *
+     * @param modelPackets The filter's estimate, then each of its models
+     */
+    private void showEstimates(Vector<LocalizationPacket> modelPackets)
+    {
+        LocalizationPacket robotLoc = modelPackets.get(0);
+        debugViewer.myX.setText(Double.toString(robotLoc.getXEst()));
+        debugViewer.myY.setText(Double.toString(robotLoc.getYEst()));
+        debugViewer.myH.setText(Double.toString(robotLoc.getHeadingEst()));
+        debugViewer.myUncertX.setText(Double.toString(robotLoc.getXUncert()));
+        debugViewer.myUncertY.setText(Double.toString(robotLoc.getYUncert()));
+        debugViewer.myUncertH.setText(Double.toString(robotLoc.getHUncert()));
+    }
+
+    /**
+     * Shows the ball estimate and the odometry in the debug viewer, and
+     * draws the ball on the field
+     */
+    private void showBallInfo(double ball_x, double ball_y,
+                              double ball_uncert_x, double ball_uncert_y,
+                              double ball_vel_x, double ball_vel_y,
+                              double ball_vel_uncert_x,
+                              double ball_vel_uncert_y,
+                              String odo_x, String odo_y, String odo_h)
+    {
+        debugViewer.ballX.setText(Double.toString(ball_x));
+        debugViewer.ballY.setText(Double.toString(ball_y));
+        debugViewer.ballUncertX.setText(Double.toString(ball_uncert_x));
+        debugViewer.ballUncertY.setText(Double.toString(ball_uncert_y));
+        debugViewer.ballVelX.setText(Double.toString(ball_vel_x));
+        debugViewer.ballVelY.setText(Double.toString(ball_vel_y));
+
+        double absBallVelocity = Math.sqrt(ball_vel_x * ball_vel_x +
+                                           ball_vel_y * ball_vel_y);
+        debugViewer.ballVelAbs.setText("" + absBallVelocity);
+        debugViewer.ballVelUncertX.setText(Double.toString(ball_vel_uncert_x));
+        debugViewer.ballVelUncertY.setText(Double.toString(ball_vel_uncert_y));
+        debugViewer.odoX.setText(odo_x);
+        debugViewer.odoY.setText(odo_y);
+        debugViewer.odoH.setText(odo_h);
+
+        LocalizationPacket ball_loc_info = LocalizationPacket.
+            makeBallEstimateAndUncertPacket(ball_x, ball_y,
+                                            ball_uncert_x, ball_uncert_y,
+                                            ball_vel_x, ball_vel_y);
+        painter.reportUpdatedBallLocalization(ball_loc_info, team_color,
+                                              player_number);
+    }
+
     /**
      * Method to print data to the debug viewer from an MCL log file
      *
@@ -492,55 +660,22 @@ public class LogHandler
         // put all the loc values into debugViewer
 
 		// First locpacket is best model
-		LocalizationPacket robotLoc = modelPackets.get(0);
-        debugViewer.myX.setText(Double.toString(robotLoc.getXEst()));
-		debugViewer.myY.setText(Double.toString(robotLoc.getYEst()));
-        debugViewer.myH.setText(Double.toString(robotLoc.getHeadingEst()));
-        debugViewer.myUncertX.setText(Double.toString(robotLoc.getXUncert()));
-        debugViewer.myUncertY.setText(Double.toString(robotLoc.getYUncert()));
-        debugViewer.myUncertH.setText(Double.toString(robotLoc.getHUncert()));
+        showEstimates(modelPackets);
 
         String[] updateInfos = obsInfo.split(" ");
-        Double ball_velocity_x, ball_velocity_y, ball_thinks_x,
-            ball_thinks_y, ball_uncert_x, ball_uncert_y;
-        LocalizationPacket ball_loc_info;
-
-        // Ball information
-        ball_thinks_x = new Double(updateInfos[MCL_BALL_X_INDEX]);
-        ball_thinks_y = new Double(updateInfos[MCL_BALL_Y_INDEX]);
-        ball_uncert_x = new Double(updateInfos[MCL_BALL_UNCERT_X_INDEX]);
-        ball_uncert_y = new Double(updateInfos[MCL_BALL_UNCERT_Y_INDEX]);
-        ball_velocity_x = new Double(updateInfos[MCL_BALL_VELOCITY_X_INDEX]);
-        ball_velocity_y = new Double(updateInfos[MCL_BALL_VELOCITY_Y_INDEX]);
-
-        debugViewer.ballX.setText(ball_thinks_x.toString());
-        debugViewer.ballY.setText(ball_thinks_y.toString());
-        debugViewer.ballUncertX.setText(ball_uncert_x.toString());
-        debugViewer.ballUncertY.setText(ball_uncert_y.toString());
-        debugViewer.ballVelX.setText(ball_velocity_x.toString());
-        debugViewer.ballVelY.setText(ball_velocity_y.toString());
-
-        double absBallVelocity =
-            Math.sqrt( Math.pow(ball_velocity_x.doubleValue(),2.0)
-                       + Math.pow(ball_velocity_y.doubleValue(),2.0));
-	    debugViewer.ballVelAbs.setText(""+absBallVelocity);
-        debugViewer.ballVelUncertX.
-            setText(updateInfos[MCL_BALL_VELOCITY_UNCERT_X_INDEX]);
-        debugViewer.ballVelUncertY.
-            setText(updateInfos[MCL_BALL_VELOCITY_UNCERT_Y_INDEX]);
-        debugViewer.odoX.setText(updateInfos[MCL_ODO_X_INDEX]);
-        debugViewer.odoY.setText(updateInfos[MCL_ODO_Y_INDEX]);
-        debugViewer.odoH.setText(updateInfos[MCL_ODO_H_INDEX]);
-
-        ball_loc_info = LocalizationPacket.
-            makeBallEstimateAndUncertPacket(ball_thinks_x.doubleValue(),
-                                            ball_thinks_y.doubleValue(),
-                                            ball_uncert_x.doubleValue(),
-                                            ball_uncert_y.doubleValue(),
-                                            ball_velocity_x.doubleValue(),
-                                            ball_velocity_y.doubleValue());
-        painter.reportUpdatedBallLocalization(ball_loc_info, team_color,
-                                              player_number);
+        showBallInfo(Double.parseDouble(updateInfos[MCL_BALL_X_INDEX]),
+                     Double.parseDouble(updateInfos[MCL_BALL_Y_INDEX]),
+                     Double.parseDouble(updateInfos[MCL_BALL_UNCERT_X_INDEX]),
+                     Double.parseDouble(updateInfos[MCL_BALL_UNCERT_Y_INDEX]),
+                     Double.parseDouble(updateInfos[MCL_BALL_VELOCITY_X_INDEX]),
+                     Double.parseDouble(updateInfos[MCL_BALL_VELOCITY_Y_INDEX]),
+                     Double.parseDouble(
+                         updateInfos[MCL_BALL_VELOCITY_UNCERT_X_INDEX]),
+                     Double.parseDouble(
+                         updateInfos[MCL_BALL_VELOCITY_UNCERT_Y_INDEX]),
+                     updateInfos[MCL_ODO_X_INDEX],
+                     updateInfos[MCL_ODO_Y_INDEX],
+                     updateInfos[MCL_ODO_H_INDEX]);
 
 		return modelPackets;
     }
@@ -577,20 +712,25 @@ public class LogHandler
      */
     private void processRobotPose(String realPoseInfo)
     {
-        float x, y, h, ballX, ballY, ballVelX, ballVelY;
         String[] infos = realPoseInfo.split(" ");
-        x = Float.parseFloat(infos[0]);
-        debugViewer.knownX.setText(infos[0]);
-        y = Float.parseFloat(infos[1]);
-        debugViewer.knownY.setText(infos[1]);
-        h = Float.parseFloat(infos[2]);
-        debugViewer.knownH.setText(infos[2]);
-        ballX = Float.parseFloat(infos[3]);
-        debugViewer.knownBallX.setText(infos[3]);
-        ballY = Float.parseFloat(infos[4]);
-        debugViewer.knownBallY.setText(infos[4]);
-        ballVelX = Float.parseFloat(infos[5]);
-        ballVelY = Float.parseFloat(infos[6]);
+        showRobotPose(Float.parseFloat(infos[0]), Float.parseFloat(infos[1]),
+                      Float.parseFloat(infos[2]), Float.parseFloat(infos[3]),
+                      Float.parseFloat(infos[4]), Float.parseFloat(infos[5]),
+                      Float.parseFloat(infos[6]));
+    }
+
+    /**
+     * Draw a known pose of the robot and the ball on the field
+     */
+    private void showRobotPose(float x, float y, float h,
+                               float ballX, float ballY,
+                               float ballVelX, float ballVelY)
+    {
+        debugViewer.knownX.setText(Float.toString(x));
+        debugViewer.knownY.setText(Float.toString(y));
+        debugViewer.knownH.setText(Float.toString(h));
+        debugViewer.knownBallX.setText(Float.toString(ballX));
+        debugViewer.knownBallY.setText(Float.toString(ballY));
         painter.updateRealPoseInfo(x, y, h);
         painter.updateRealBallInfo(ballX, ballY, ballVelX, ballVelY);
     }